@@ -85,6 +85,24 @@ css_error css_computed_style_compose(
 		const css_unit_ctx *unit_ctx,
 		css_computed_style **restrict result);
 
+/**
+ * Context for composing many computed styles
+ *
+ * A composition context keeps memory and results from one composition to
+ * the next.  It may be used with styles from any selection context, but
+ * not from more than one thread at once.
+ */
+typedef struct css_compose_ctx css_compose_ctx;
+
+css_error css_compose_ctx_create(css_compose_ctx **result);
+css_error css_compose_ctx_destroy(css_compose_ctx *ctx);
+
+css_error css_computed_style_compose_ctx(css_compose_ctx *ctx,
+		const css_computed_style *restrict parent,
+		const css_computed_style *restrict child,
+		const css_unit_ctx *unit_ctx,
+		css_computed_style **restrict result);
+
 /******************************************************************************
  * speciality formatters                                                      *
  ******************************************************************************/
@@ -150,6 +150,65 @@ typedef struct css_select_handler {
 			void **libcss_node_data);
 } css_select_handler;
 
+typedef enum css_select_subtree_handler_version {
+	CSS_SELECT_SUBTREE_HANDLER_VERSION_1 = 1
+} css_select_subtree_handler_version;
+
+/**
+ * Subtree traversal callbacks for css_select_style_subtree
+ *
+ * These are used alongside the css_select_handler, and are passed the
+ * same client private data.
+ */
+typedef struct css_select_subtree_handler {
+	/** ABI version of this structure */
+	uint32_t handler_version;
+
+	/**
+	 * Get the first element child of a node.
+	 *
+	 * \param pw     Client data
+	 * \param node   DOM node to get first child of
+	 * \param child  Updated to first element child, or NULL if none
+	 * \return CSS_OK on success, or appropriate error otherwise
+	 */
+	css_error (*first_child_node)(void *pw, void *node, void **child);
+	/**
+	 * Get the next element sibling of a node.
+	 *
+	 * \param pw       Client data
+	 * \param node     DOM node to get next sibling of
+	 * \param sibling  Updated to next element sibling, or NULL if none
+	 * \return CSS_OK on success, or appropriate error otherwise
+	 */
+	css_error (*next_sibling_node)(void *pw, void *node, void **sibling);
+	/**
+	 * Get the inline style for a node.
+	 *
+	 * \param pw            Client data
+	 * \param node          DOM node to get inline style of
+	 * \param inline_style  Updated to node's inline style, or NULL if none.
+	 *                      Ownership is retained by the client.
+	 * \return CSS_OK on success, or appropriate error otherwise
+	 */
+	css_error (*node_inline_style)(void *pw, void *node,
+			const css_stylesheet **inline_style);
+	/**
+	 * Receive the selection results for a node.
+	 *
+	 * Called for each node in the subtree, parents before children,
+	 * and siblings in document order.
+	 *
+	 * \param pw       Client data
+	 * \param node     DOM node that has been selected for
+	 * \param results  Selection results for node.  Ownership passed to
+	 *                 client.
+	 * \return CSS_OK on success, or appropriate error otherwise
+	 */
+	css_error (*node_selected)(void *pw, void *node,
+			css_select_results *results);
+} css_select_subtree_handler;
+
 /**
  * Font face selection result set
  */
@@ -161,6 +220,75 @@ typedef struct css_select_font_faces_results {
 	uint32_t n_font_faces;
 } css_select_font_faces_results;
 
+/**
+ * Style sharing arena statistics
+ *
+ * Each selection context interns the computed styles it produces into an
+ * arena, so that nodes with identical styles share one copy.
+ */
+typedef struct css_select_arena_stats {
+	uint32_t styles;	/**< Number of distinct styles interned */
+	uint32_t bins;		/**< Number of hash table bins */
+	uint32_t used_bins;	/**< Number of non-empty hash table bins */
+	uint32_t longest_chain;	/**< Length of longest hash chain */
+
+	uint64_t lookups;	/**< Number of styles looked up */
+	uint64_t hits;		/**< Lookups which found an existing style */
+	uint64_t probes;	/**< Hash chain entries visited by lookups */
+	uint64_t compares;	/**< Full style comparisons performed */
+} css_select_arena_stats;
+
+/**
+ * Bloom filter statistics for a selection context
+ *
+ * Before a selector chain is matched against a node, the chain's bloom
+ * filter is tested against the node's ancestor bloom filter.  Chains that
+ * cannot match are rejected without querying the client.
+ */
+typedef struct css_select_bloom_stats {
+	uint32_t bits;		/**< Width of the bloom filters, in bits */
+
+	uint64_t tests;		/**< Selector chains tested against a node */
+	uint64_t rejects;	/**< Chains rejected by the bloom filter */
+} css_select_bloom_stats;
+
+/**
+ * Style sharing statistics for a selection context
+ *
+ * Before selecting a style for a node, the styles of earlier nodes with
+ * the same element name and classes are considered for reuse: first the
+ * node's siblings, then, when selecting for a subtree, its cousins and
+ * second cousins.
+ */
+typedef struct css_select_sharing_stats {
+	uint64_t nodes;		/**< Nodes styles were selected for */
+	uint64_t candidates;	/**< Candidate nodes considered */
+	uint64_t siblings;	/**< Nodes sharing a sibling's style */
+	uint64_t cousins;	/**< Nodes sharing a cousin's style */
+	uint64_t second_cousins; /**< Nodes sharing a second cousin's style */
+} css_select_sharing_stats;
+
+/**
+ * Kinds of change to a node that may affect selector matching
+ */
+typedef enum css_select_change {
+	CSS_SELECT_CHANGE_CLASS,	/**< A class was added or removed */
+	CSS_SELECT_CHANGE_ID,		/**< The id was set or removed */
+	CSS_SELECT_CHANGE_ATTRIBUTE,	/**< An attribute was changed */
+	CSS_SELECT_CHANGE_PSEUDO_CLASS	/**< A dynamic pseudo class changed */
+} css_select_change;
+
+/**
+ * Nodes to restyle after a change to a node
+ */
+typedef enum css_select_restyle {
+	CSS_SELECT_RESTYLE_NONE		= 0,
+	CSS_SELECT_RESTYLE_SELF		= (1 << 0), /**< The node itself */
+	CSS_SELECT_RESTYLE_DESCENDANTS	= (1 << 1), /**< Its descendants */
+	CSS_SELECT_RESTYLE_SIBLINGS	= (1 << 2)  /**< Its later siblings
+						     * and their descendants */
+} css_select_restyle;
+
 typedef enum {
 	CSS_NODE_DELETED,
 	CSS_NODE_MODIFIED,
@@ -212,6 +340,16 @@ css_error css_select_ctx_remove_sheet(css_select_ctx *ctx,
 		const css_stylesheet *sheet);
 
 css_error css_select_ctx_count_sheets(css_select_ctx *ctx, uint32_t *count);
+css_error css_select_ctx_enable_index(css_select_ctx *ctx, bool enable);
+css_error css_select_ctx_get_arena_stats(css_select_ctx *ctx,
+		css_select_arena_stats *stats);
+css_error css_select_ctx_get_bloom_stats(css_select_ctx *ctx,
+		css_select_bloom_stats *stats);
+css_error css_select_ctx_get_sharing_stats(css_select_ctx *ctx,
+		css_select_sharing_stats *stats);
+css_error css_select_ctx_get_restyle(css_select_ctx *ctx,
+		css_select_change change, lwc_string *name,
+		uint32_t *restyle);
 css_error css_select_ctx_get_sheet(css_select_ctx *ctx, uint32_t index,
 		const css_stylesheet **sheet);
 
@@ -223,6 +361,18 @@ css_error css_select_style(css_select_ctx *ctx, void *node,
 		const css_media *media, const css_stylesheet *inline_style,
 		css_select_handler *handler, void *pw,
 		css_select_results **result);
+css_error css_select_style_siblings(css_select_ctx *ctx, void *parent,
+		void **nodes, const css_stylesheet **inline_styles,
+		uint32_t n_nodes,
+		const css_unit_ctx *unit_ctx,
+		const css_media *media,
+		css_select_handler *handler, void *pw,
+		css_select_results **results);
+css_error css_select_style_subtree(css_select_ctx *ctx, void *root,
+		const css_unit_ctx *unit_ctx,
+		const css_media *media,
+		css_select_handler *handler,
+		css_select_subtree_handler *subtree, void *pw);
 css_error css_select_results_destroy(css_select_results *results);
 
 css_error css_select_font_faces(css_select_ctx *ctx,
@@ -142,6 +142,20 @@ css_error css_stylesheet_destroy(css_stylesheet *sheet);
 css_error css_stylesheet_append_data(css_stylesheet *sheet,
 		const uint8_t *data, size_t len);
 css_error css_stylesheet_data_done(css_stylesheet *sheet);
+css_error css_stylesheet_parse_buffer(css_stylesheet *sheet,
+		const uint8_t *data, size_t len);
+
+css_error css_stylesheet_serialise(const css_stylesheet *sheet,
+		uint8_t *buffer, size_t *len);
+css_error css_stylesheet_load_serialised(css_stylesheet *sheet,
+		const uint8_t *data, size_t len);
+
+css_error css_stylesheet_get_generation(css_stylesheet *sheet,
+		uint32_t *generation);
+
+css_error css_stylesheet_freeze(css_stylesheet *sheet);
+css_error css_stylesheet_ref(css_stylesheet *sheet);
+css_error css_stylesheet_is_frozen(css_stylesheet *sheet, bool *frozen);
 
 css_error css_stylesheet_next_pending_import(css_stylesheet *parent,
 		lwc_string **url);
@@ -36,6 +36,17 @@
 #include "utils/parserutilserror.h"
 #include "utils/utils.h"
 
+/* Vector paths for scanning runs of input bytes.  AVX2 scans 32 bytes at a
+ * time, and SSE2 16 bytes, falling back to portable C for the remainder. */
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define CSS_LEX_AVX2
+#define CSS_LEX_SSE2
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define CSS_LEX_SSE2
+#endif
+
 /** \todo Optimisation -- we're currently revisiting a bunch of input
  *	  characters (Currently, we're calling parserutils_inputstream_peek
  *	  about 1.5x the number of characters in the input stream). Ideally,
@@ -66,6 +77,21 @@ enum {
 	sUCR		= 14
 };
 
+/**
+ * Classes of input byte that may be consumed in bulk by scanRun()
+ *
+ * Each is a subset of the characters accepted by the corresponding consume
+ * routine, limited to ASCII and excluding escapes and anything that needs
+ * further state to be tracked, such as newlines.
+ */
+typedef enum {
+	SCAN_BLANK,		/**< ' ' | '\t' */
+	SCAN_NMCHAR,		/**< [a-zA-Z0-9_-] */
+	SCAN_STRINGCHAR,	/**< [\t !#-&(-[\]-~] */
+	SCAN_URLCHAR,		/**< [\t!#-&(*-[\]-~] */
+	SCAN_COMMENT		/**< ASCII, less '*', '\n', '\r' and '\f' */
+} scan_class;
+
 /**
  * CSS lexer object
  */
@@ -73,6 +99,13 @@ struct css_lexer
 {
 	parserutils_inputstream *input;	/**< Inputstream containing CSS */
 
+	const uint8_t *buffer;		/**< Caller-owned UTF-8 input, read
+					 * in place of the inputstream, or
+					 * NULL */
+	size_t bufferLen;		/**< Length of buffer, in bytes */
+	size_t bufferPos;		/**< Offset of the current token's
+					 * start in buffer */
+
 	size_t bytesReadForToken;	/**< Total bytes read from the
 					 * inputstream for the current token */
 
@@ -121,6 +154,9 @@ do {									\
 	(lexer)->currentCol += (len);					\
 } while(0)								\
 
+static inline parserutils_error peekInput(css_lexer *lexer, size_t offset,
+		const uint8_t **ptr, size_t *length);
+static inline void advanceInput(css_lexer *lexer, size_t bytes);
 static css_error appendToTokenData(css_lexer *lexer,
 		const uint8_t *data, size_t len);
 static css_error emitToken(css_lexer *lexer, css_token_type type,
@@ -161,6 +197,8 @@ static inline bool startNMStart(uint8_t c);
 static inline bool startStringChar(uint8_t c);
 static inline bool startURLChar(uint8_t c);
 static inline bool isSpace(uint8_t c);
+static inline bool isScanClass(uint8_t c, scan_class cls);
+static size_t scanRun(css_lexer *lexer, scan_class cls, const uint8_t **ptr);
 
 /**
  * Create a lexer instance
@@ -183,6 +221,9 @@ css_error css__lexer_create(parserutils_inputstream *input, css_lexer **lexer)
 		return CSS_NOMEM;
 
 	lex->input = input;
+	lex->buffer = NULL;
+	lex->bufferLen = 0;
+	lex->bufferPos = 0;
 	lex->bytesReadForToken = 0;
 	lex->token.type = CSS_TOKEN_EOF;
 	lex->token.data.data = NULL;
@@ -237,6 +278,16 @@ css_error css__lexer_setopt(css_lexer *lexer, css_lexer_opttype type,
 	case CSS_LEXER_EMIT_COMMENTS:
 		lexer->emit_comments = params->emit_comments;
 		break;
+	case CSS_LEXER_BUFFER:
+		/* Only permitted before any input has been read */
+		if (lexer->bytesReadForToken > 0 ||
+				lexer->input->utf8->length > 0)
+			return CSS_INVALID;
+
+		lexer->buffer = params->buffer.data;
+		lexer->bufferLen = params->buffer.len;
+		lexer->bufferPos = 0;
+		break;
 	default:
 		return CSS_BADPARM;
 	}
@@ -294,7 +345,7 @@ css_error css__lexer_get_token(css_lexer *lexer, css_token **token)
 	case sMATCH:
 		return Match(lexer, token);
 	case sURI:
-		return URI(lexer, token);
+		return URIOrUnicodeRangeOrIdentOrFunction(lexer, token);
 	case sIDENT:
 		return IdentOrFunction(lexer, token);
 	case sESCAPEDIDENT:
@@ -315,6 +366,56 @@ css_error css__lexer_get_token(css_lexer *lexer, css_token **token)
  * Utility routines                                                           *
  ******************************************************************************/
 
+/**
+ * Peek at a character of input
+ *
+ * \param lexer   The lexer instance
+ * \param offset  Offset, in bytes, from the start of the current token
+ * \param ptr     Pointer to location to receive pointer to character
+ * \param length  Pointer to location to receive character length, in bytes
+ * \return PARSERUTILS_OK on success,
+ *         PARSERUTILS_EOF at the end of the input,
+ *         appropriate error otherwise
+ *
+ * Reads the caller-owned buffer, if there is one, which is known to hold
+ * the whole of the input as valid UTF-8. Otherwise, reads the inputstream.
+ */
+parserutils_error peekInput(css_lexer *lexer, size_t offset,
+		const uint8_t **ptr, size_t *length)
+{
+	size_t off;
+	uint8_t c;
+
+	if (lexer->buffer == NULL)
+		return parserutils_inputstream_peek(lexer->input, offset,
+				ptr, length);
+
+	off = lexer->bufferPos + offset;
+	if (off >= lexer->bufferLen)
+		return PARSERUTILS_EOF;
+
+	c = lexer->buffer[off];
+
+	*ptr = lexer->buffer + off;
+	*length = (c < 0x80) ? 1 : (c < 0xE0) ? 2 : (c < 0xF0) ? 3 : 4;
+
+	return PARSERUTILS_OK;
+}
+
+/**
+ * Advance past input
+ *
+ * \param lexer  The lexer instance
+ * \param bytes  Number of bytes to advance past
+ */
+void advanceInput(css_lexer *lexer, size_t bytes)
+{
+	if (lexer->buffer != NULL)
+		lexer->bufferPos += bytes;
+	else
+		parserutils_inputstream_advance(lexer->input, bytes);
+}
+
 /**
  * Append some data to the current token
  *
@@ -362,12 +463,16 @@ css_error emitToken(css_lexer *lexer, css_token_type type,
 	 * the inputstream's buffer may have moved under us. */
 	if (lexer->escapeSeen) {
 		t->data.data = lexer->unescapedTokenData->data;
+	} else if (lexer->buffer != NULL) {
+		/* Caller-owned buffers never move */
+		t->data.data = (type == CSS_TOKEN_EOF) ? NULL :
+				(uint8_t *) lexer->buffer + lexer->bufferPos;
 	} else {
 		size_t clen;
 		const uint8_t *data;
 		parserutils_error error;
 
-		error = parserutils_inputstream_peek(lexer->input, 0,
+		error = peekInput(lexer, 0,
 				&data, &clen);
 
 #ifndef NDEBUG
@@ -494,7 +599,7 @@ css_error AtKeyword(css_lexer *lexer, css_token **token)
 
 	switch (lexer->substate) {
 	case Initial:
-		perror = parserutils_inputstream_peek(lexer->input,
+		perror = peekInput(lexer,
 				lexer->bytesReadForToken, &cptr, &clen);
 		if (perror != PARSERUTILS_OK && perror != PARSERUTILS_EOF)
 			return css_error_from_parserutils_error(perror);
@@ -569,7 +674,7 @@ css_error CDCOrIdentOrFunctionOrNPD(css_lexer *lexer, css_token **token)
 
 	switch (lexer->substate) {
 	case Initial:
-		perror = parserutils_inputstream_peek(lexer->input,
+		perror = peekInput(lexer,
 				lexer->bytesReadForToken, &cptr, &clen);
 		if (perror != PARSERUTILS_OK && perror != PARSERUTILS_EOF)
 			return css_error_from_parserutils_error(perror);
@@ -617,7 +722,7 @@ css_error CDCOrIdentOrFunctionOrNPD(css_lexer *lexer, css_token **token)
 		lexer->substate = Gt;
 
 		/* Ok, so we're dealing with CDC. Expect a '>' */
-		perror = parserutils_inputstream_peek(lexer->input,
+		perror = peekInput(lexer,
 				lexer->bytesReadForToken, &cptr, &clen);
 		if (perror != PARSERUTILS_OK && perror != PARSERUTILS_EOF)
 			return css_error_from_parserutils_error(perror);
@@ -684,7 +789,7 @@ css_error CDO(css_lexer *lexer, css_token **token)
 	switch (lexer->substate) {
 	case Initial:
 		/* Expect '!' */
-		perror = parserutils_inputstream_peek(lexer->input,
+		perror = peekInput(lexer,
 				lexer->bytesReadForToken, &cptr, &clen);
 		if (perror != PARSERUTILS_OK && perror != PARSERUTILS_EOF)
 			return css_error_from_parserutils_error(perror);
@@ -712,7 +817,7 @@ css_error CDO(css_lexer *lexer, css_token **token)
 		lexer->substate = Dash1;
 
 		/* Expect '-' */
-		perror = parserutils_inputstream_peek(lexer->input,
+		perror = peekInput(lexer,
 				lexer->bytesReadForToken, &cptr, &clen);
 		if (perror != PARSERUTILS_OK && perror != PARSERUTILS_EOF)
 			return css_error_from_parserutils_error(perror);
@@ -741,7 +846,7 @@ css_error CDO(css_lexer *lexer, css_token **token)
 		lexer->substate = Dash2;
 
 		/* Expect '-' */
-		perror = parserutils_inputstream_peek(lexer->input,
+		perror = peekInput(lexer,
 				lexer->bytesReadForToken, &cptr, &clen);
 		if (perror != PARSERUTILS_OK && perror != PARSERUTILS_EOF)
 			return css_error_from_parserutils_error(perror);
@@ -783,7 +888,7 @@ css_error Comment(css_lexer *lexer, css_token **token)
 	 */
 	switch (lexer->substate) {
 	case Initial:
-		perror = parserutils_inputstream_peek(lexer->input,
+		perror = peekInput(lexer,
 				lexer->bytesReadForToken, &cptr, &clen);
 		if (perror != PARSERUTILS_OK && perror != PARSERUTILS_EOF)
 			return css_error_from_parserutils_error(perror);
@@ -803,7 +908,15 @@ css_error Comment(css_lexer *lexer, css_token **token)
 		lexer->substate = InComment;
 
 		while (1) {
-			perror = parserutils_inputstream_peek(lexer->input,
+			/* Consume plain comment text in bulk */
+			if (lexer->context.lastWasStar == false &&
+					lexer->context.lastWasCR == false) {
+				clen = scanRun(lexer, SCAN_COMMENT, &cptr);
+				if (clen > 0)
+					APPEND(lexer, cptr, clen);
+			}
+
+			perror = peekInput(lexer,
 					lexer->bytesReadForToken, &cptr, &clen);
 			if (perror != PARSERUTILS_OK &&
 					perror != PARSERUTILS_EOF)
@@ -914,7 +1027,7 @@ css_error IdentOrFunction(css_lexer *lexer, css_token **token)
 	case Bracket:
 		lexer->substate = Bracket;
 
-		perror = parserutils_inputstream_peek(lexer->input,
+		perror = peekInput(lexer,
 				lexer->bytesReadForToken, &cptr, &clen);
 		if (perror != PARSERUTILS_OK && perror != PARSERUTILS_EOF)
 			return css_error_from_parserutils_error(perror);
@@ -955,7 +1068,7 @@ css_error Match(css_lexer *lexer, css_token **token)
 	 * The first character has been consumed.
 	 */
 
-	perror = parserutils_inputstream_peek(lexer->input,
+	perror = peekInput(lexer,
 			lexer->bytesReadForToken, &cptr, &clen);
 	if (perror != PARSERUTILS_OK && perror != PARSERUTILS_EOF)
 		return css_error_from_parserutils_error(perror);
@@ -1022,7 +1135,7 @@ css_error NumberOrPercentageOrDimension(css_lexer *lexer, css_token **token)
 	case Dot:
 		lexer->substate = Dot;
 
-		perror = parserutils_inputstream_peek(lexer->input,
+		perror = peekInput(lexer,
 				lexer->bytesReadForToken, &cptr, &clen);
 		if (perror != PARSERUTILS_OK && perror != PARSERUTILS_EOF)
 			return css_error_from_parserutils_error(perror);
@@ -1067,7 +1180,7 @@ css_error NumberOrPercentageOrDimension(css_lexer *lexer, css_token **token)
 	suffix:
 		lexer->substate = Suffix;
 
-		perror = parserutils_inputstream_peek(lexer->input,
+		perror = peekInput(lexer,
 				lexer->bytesReadForToken, &cptr, &clen);
 		if (perror != PARSERUTILS_OK && perror != PARSERUTILS_EOF)
 			return css_error_from_parserutils_error(perror);
@@ -1166,8 +1279,7 @@ start:
 
 	/* Advance past the input read for the previous token */
 	if (lexer->bytesReadForToken > 0) {
-		parserutils_inputstream_advance(
-				lexer->input, lexer->bytesReadForToken);
+		advanceInput(lexer, lexer->bytesReadForToken);
 		lexer->bytesReadForToken = 0;
 	}
 
@@ -1182,7 +1294,7 @@ start:
 	if (lexer->unescapedTokenData != NULL)
 		lexer->unescapedTokenData->length = 0;
 
-	perror = parserutils_inputstream_peek(lexer->input, 0, &cptr, &clen);
+	perror = peekInput(lexer, 0, &cptr, &clen);
 	if (perror != PARSERUTILS_OK && perror != PARSERUTILS_EOF)
 		return css_error_from_parserutils_error(perror);
 
@@ -1277,7 +1389,7 @@ start:
 		return EscapedIdentOrFunction(lexer, token);
 	case '>':
 		/* Check for >= */
-		perror = parserutils_inputstream_peek(lexer->input,
+		perror = peekInput(lexer,
 				lexer->bytesReadForToken, &cptr, &clen);
 		if (perror != PARSERUTILS_OK && perror != PARSERUTILS_EOF) {
 			return css_error_from_parserutils_error(perror);
@@ -1334,7 +1446,7 @@ css_error URIOrUnicodeRangeOrIdentOrFunction(css_lexer *lexer,
 	 * The 'u' (or 'U') has been consumed.
 	 */
 
-	perror = parserutils_inputstream_peek(lexer->input,
+	perror = peekInput(lexer,
 			lexer->bytesReadForToken, &cptr, &clen);
 	if (perror != PARSERUTILS_OK && perror != PARSERUTILS_EOF)
 		return css_error_from_parserutils_error(perror);
@@ -1384,7 +1496,7 @@ css_error URI(css_lexer *lexer, css_token **token)
 
 	switch (lexer->substate) {
 	case Initial:
-		perror = parserutils_inputstream_peek(lexer->input,
+		perror = peekInput(lexer,
 				lexer->bytesReadForToken, &cptr, &clen);
 		if (perror != PARSERUTILS_OK && perror != PARSERUTILS_EOF)
 			return css_error_from_parserutils_error(perror);
@@ -1408,7 +1520,7 @@ css_error URI(css_lexer *lexer, css_token **token)
 	case LParen:
 		lexer->substate = LParen;
 
-		perror = parserutils_inputstream_peek(lexer->input,
+		perror = peekInput(lexer,
 				lexer->bytesReadForToken, &cptr, &clen);
 		if (perror != PARSERUTILS_OK && perror != PARSERUTILS_EOF)
 			return css_error_from_parserutils_error(perror);
@@ -1445,7 +1557,7 @@ css_error URI(css_lexer *lexer, css_token **token)
 	case Quote:
 		lexer->substate = Quote;
 
-		perror = parserutils_inputstream_peek(lexer->input,
+		perror = peekInput(lexer,
 				lexer->bytesReadForToken, &cptr, &clen);
 		if (perror != PARSERUTILS_OK && perror != PARSERUTILS_EOF)
 			return css_error_from_parserutils_error(perror);
@@ -1495,7 +1607,7 @@ css_error URI(css_lexer *lexer, css_token **token)
 	case RParen:
 		lexer->substate = RParen;
 
-		perror = parserutils_inputstream_peek(lexer->input,
+		perror = peekInput(lexer,
 				lexer->bytesReadForToken, &cptr, &clen);
 		if (perror != PARSERUTILS_OK && perror != PARSERUTILS_EOF)
 			return css_error_from_parserutils_error(perror);
@@ -1560,7 +1672,7 @@ css_error UnicodeRange(css_lexer *lexer, css_token **token)
 	case Initial:
 		/* Attempt to consume 6 hex digits (or question marks) */
 		for (; lexer->context.hexCount < 6; lexer->context.hexCount++) {
-			perror = parserutils_inputstream_peek(lexer->input,
+			perror = peekInput(lexer,
 					lexer->bytesReadForToken, &cptr, &clen);
 			if (perror != PARSERUTILS_OK &&
 					perror != PARSERUTILS_EOF)
@@ -1600,7 +1712,7 @@ css_error UnicodeRange(css_lexer *lexer, css_token **token)
 
 		if (lexer->context.hexCount == 6) {
 			/* Consumed 6 valid characters. Look for '-' */
-			perror = parserutils_inputstream_peek(lexer->input,
+			perror = peekInput(lexer,
 					lexer->bytesReadForToken, &cptr, &clen);
 			if (perror != PARSERUTILS_OK &&
 					perror != PARSERUTILS_EOF)
@@ -1631,7 +1743,7 @@ css_error UnicodeRange(css_lexer *lexer, css_token **token)
 
 		/* Consume up to 6 hex digits */
 		for (; lexer->context.hexCount < 6; lexer->context.hexCount++) {
-			perror = parserutils_inputstream_peek(lexer->input,
+			perror = peekInput(lexer,
 					lexer->bytesReadForToken, &cptr, &clen);
 			if (perror != PARSERUTILS_OK &&
 					perror != PARSERUTILS_EOF)
@@ -1682,7 +1794,7 @@ css_error consumeDigits(css_lexer *lexer)
 
 	/* Consume all digits */
 	do {
-		perror = parserutils_inputstream_peek(lexer->input,
+		perror = peekInput(lexer,
 				lexer->bytesReadForToken, &cptr, &clen);
 		if (perror != PARSERUTILS_OK && perror != PARSERUTILS_EOF)
 			return css_error_from_parserutils_error(perror);
@@ -1713,7 +1825,7 @@ css_error consumeEscape(css_lexer *lexer, bool nl)
 	 * The '\' has been consumed.
 	 */
 
-	perror = parserutils_inputstream_peek(lexer->input,
+	perror = peekInput(lexer,
 			lexer->bytesReadForToken, &cptr, &clen);
 	if (perror != PARSERUTILS_OK && perror != PARSERUTILS_EOF)
 		return css_error_from_parserutils_error(perror);
@@ -1739,8 +1851,8 @@ css_error consumeEscape(css_lexer *lexer, bool nl)
 	 * we must copy the characters we've read to the unescaped buffer */
 	if (!lexer->escapeSeen) {
 		if (lexer->bytesReadForToken > 1) {
-			perror = parserutils_inputstream_peek(
-					lexer->input, 0, &sdata, &slen);
+			perror = peekInput(lexer, 0,
+					&sdata, &slen);
 
 			assert(perror == PARSERUTILS_OK);
 
@@ -1770,7 +1882,7 @@ css_error consumeEscape(css_lexer *lexer, bool nl)
 
 	/* If we're handling escaped newlines, convert CR(LF)? to LF */
 	if (nl && c == '\r') {
-		perror = parserutils_inputstream_peek(lexer->input,
+		perror = peekInput(lexer,
 				lexer->bytesReadForToken + clen, &cptr, &clen);
 		if (perror != PARSERUTILS_OK && perror != PARSERUTILS_EOF)
 			return css_error_from_parserutils_error(perror);
@@ -1811,7 +1923,12 @@ css_error consumeNMChars(css_lexer *lexer)
 	/* nmchar = [a-zA-Z] | '-' | '_' | nonascii | escape */
 
 	do {
-		perror = parserutils_inputstream_peek(lexer->input,
+		/* Consume runs of ASCII name characters in bulk */
+		clen = scanRun(lexer, SCAN_NMCHAR, &cptr);
+		if (clen > 0)
+			APPEND(lexer, cptr, clen);
+
+		perror = peekInput(lexer,
 				lexer->bytesReadForToken, &cptr, &clen);
 		if (perror != PARSERUTILS_OK && perror != PARSERUTILS_EOF)
 			return css_error_from_parserutils_error(perror);
@@ -1867,7 +1984,7 @@ css_error consumeString(css_lexer *lexer)
 	 */
 
 	do {
-		perror = parserutils_inputstream_peek(lexer->input,
+		perror = peekInput(lexer,
 				lexer->bytesReadForToken, &cptr, &clen);
 		if (perror != PARSERUTILS_OK && perror != PARSERUTILS_EOF)
 			return css_error_from_parserutils_error(perror);
@@ -1906,7 +2023,12 @@ css_error consumeStringChars(css_lexer *lexer)
 	/* stringchar = urlchar | ' ' | ')' | '\' nl */
 
 	do {
-		perror = parserutils_inputstream_peek(lexer->input,
+		/* Consume runs of ASCII string characters in bulk */
+		clen = scanRun(lexer, SCAN_STRINGCHAR, &cptr);
+		if (clen > 0)
+			APPEND(lexer, cptr, clen);
+
+		perror = peekInput(lexer,
 				lexer->bytesReadForToken, &cptr, &clen);
 		if (perror != PARSERUTILS_OK && perror != PARSERUTILS_EOF)
 			return css_error_from_parserutils_error(perror);
@@ -1960,7 +2082,7 @@ css_error consumeUnicode(css_lexer *lexer, uint32_t ucs)
 
 	/* Attempt to consume a further five hex digits */
 	for (count = 0; count < 5; count++) {
-		perror = parserutils_inputstream_peek(lexer->input,
+		perror = peekInput(lexer,
 				lexer->bytesReadForToken, &cptr, &clen);
 		if (perror != PARSERUTILS_OK && perror != PARSERUTILS_EOF) {
 			/* Rewind what we've read */
@@ -1999,7 +2121,7 @@ css_error consumeUnicode(css_lexer *lexer, uint32_t ucs)
 	assert(perror == PARSERUTILS_OK);
 
 	/* Attempt to read a trailing whitespace character */
-	perror = parserutils_inputstream_peek(lexer->input,
+	perror = peekInput(lexer,
 			lexer->bytesReadForToken, &cptr, &clen);
 	if (perror != PARSERUTILS_OK && perror != PARSERUTILS_EOF) {
 		/* Rewind what we've read */
@@ -2011,7 +2133,7 @@ css_error consumeUnicode(css_lexer *lexer, uint32_t ucs)
 		/* Potential CRLF */
 		const uint8_t *pCR = cptr;
 
-		perror = parserutils_inputstream_peek(lexer->input,
+		perror = peekInput(lexer,
 				lexer->bytesReadForToken + 1, &cptr, &clen);
 		if (perror != PARSERUTILS_OK && perror != PARSERUTILS_EOF) {
 			/* Rewind what we've read */
@@ -2074,7 +2196,12 @@ css_error consumeURLChars(css_lexer *lexer)
 	/* urlchar = [\t!#-&(*-~] | nonascii | escape */
 
 	do {
-		perror = parserutils_inputstream_peek(lexer->input,
+		/* Consume runs of ASCII URL characters in bulk */
+		clen = scanRun(lexer, SCAN_URLCHAR, &cptr);
+		if (clen > 0)
+			APPEND(lexer, cptr, clen);
+
+		perror = peekInput(lexer,
 				lexer->bytesReadForToken, &cptr, &clen);
 		if (perror != PARSERUTILS_OK && perror != PARSERUTILS_EOF)
 			return css_error_from_parserutils_error(perror);
@@ -2122,7 +2249,14 @@ css_error consumeWChars(css_lexer *lexer)
 	parserutils_error perror;
 
 	do {
-		perror = parserutils_inputstream_peek(lexer->input,
+		/* Consume runs of blanks in bulk, unless a CR is pending */
+		if (lexer->context.lastWasCR == false) {
+			clen = scanRun(lexer, SCAN_BLANK, &cptr);
+			if (clen > 0)
+				APPEND(lexer, cptr, clen);
+		}
+
+		perror = peekInput(lexer,
 				lexer->bytesReadForToken, &cptr, &clen);
 		if (perror != PARSERUTILS_OK && perror != PARSERUTILS_EOF)
 			return css_error_from_parserutils_error(perror);
@@ -2188,3 +2322,196 @@ bool isSpace(uint8_t c)
 	return c == ' ' || c == '\r' || c == '\n' || c == '\f' || c == '\t';
 }
 
+
+bool isScanClass(uint8_t c, scan_class cls)
+{
+	switch (cls) {
+	case SCAN_BLANK:
+		return c == ' ' || c == '\t';
+	case SCAN_NMCHAR:
+		return startNMChar(c) && c != '\\' && c < 0x80;
+	case SCAN_STRINGCHAR:
+		return startStringChar(c) && c != '\\' && c < 0x80;
+	case SCAN_URLCHAR:
+		return startURLChar(c) && c != '\\' && c < 0x80;
+	case SCAN_COMMENT:
+		return c < 0x80 && c != '*' &&
+				c != '\n' && c != '\r' && c != '\f';
+	}
+
+	return false;
+}
+
+#ifdef CSS_LEX_SSE2
+/**
+ * Classify 16 bytes of input
+ *
+ * \param v    The bytes to classify
+ * \param cls  The class of byte to accept
+ * \return Mask with bit i set iff byte i is in the class
+ *
+ * Bytes >= 0x80 are negative under the signed comparisons used here, so
+ * fall outside every range tested.
+ */
+static inline uint32_t scanClass16(__m128i v, scan_class cls)
+{
+#define B(x) _mm_set1_epi8((char) (x))
+#define EQ(x) _mm_cmpeq_epi8(v, B(x))
+#define IN(lo, hi) _mm_and_si128(_mm_cmpgt_epi8(v, B((lo) - 1)), \
+		_mm_cmplt_epi8(v, B((hi) + 1)))
+	__m128i m;
+
+	switch (cls) {
+	case SCAN_BLANK:
+		m = _mm_or_si128(EQ(' '), EQ('\t'));
+		break;
+	case SCAN_NMCHAR:
+		m = _mm_or_si128(_mm_or_si128(EQ('-'), EQ('_')), IN('0', '9'));
+		v = _mm_or_si128(v, B(0x20));
+		m = _mm_or_si128(m, IN('a', 'z'));
+		break;
+	case SCAN_STRINGCHAR:
+	case SCAN_URLCHAR:
+		m = _mm_or_si128(EQ('"'), EQ('\''));
+		m = _mm_or_si128(m, EQ('\\'));
+		if (cls == SCAN_URLCHAR)
+			m = _mm_or_si128(m, _mm_or_si128(EQ(' '), EQ(')')));
+		m = _mm_andnot_si128(m, IN(' ', '~'));
+		m = _mm_or_si128(m, EQ('\t'));
+		break;
+	case SCAN_COMMENT:
+	default:
+		m = _mm_or_si128(_mm_or_si128(EQ('*'), EQ('\n')),
+				_mm_or_si128(EQ('\r'), EQ('\f')));
+		m = _mm_andnot_si128(m, _mm_cmpgt_epi8(v, B(-1)));
+		break;
+	}
+
+	return (uint32_t) _mm_movemask_epi8(m);
+#undef IN
+#undef EQ
+#undef B
+}
+#endif
+
+#ifdef CSS_LEX_AVX2
+/**
+ * Classify 32 bytes of input
+ *
+ * \param v    The bytes to classify
+ * \param cls  The class of byte to accept
+ * \return Mask with bit i set iff byte i is in the class
+ */
+static inline uint32_t scanClass32(__m256i v, scan_class cls)
+{
+#define B(x) _mm256_set1_epi8((char) (x))
+#define EQ(x) _mm256_cmpeq_epi8(v, B(x))
+#define IN(lo, hi) _mm256_and_si256(_mm256_cmpgt_epi8(v, B((lo) - 1)), \
+		_mm256_cmpgt_epi8(B((hi) + 1), v))
+	__m256i m;
+
+	switch (cls) {
+	case SCAN_BLANK:
+		m = _mm256_or_si256(EQ(' '), EQ('\t'));
+		break;
+	case SCAN_NMCHAR:
+		m = _mm256_or_si256(_mm256_or_si256(EQ('-'), EQ('_')),
+				IN('0', '9'));
+		v = _mm256_or_si256(v, B(0x20));
+		m = _mm256_or_si256(m, IN('a', 'z'));
+		break;
+	case SCAN_STRINGCHAR:
+	case SCAN_URLCHAR:
+		m = _mm256_or_si256(EQ('"'), EQ('\''));
+		m = _mm256_or_si256(m, EQ('\\'));
+		if (cls == SCAN_URLCHAR)
+			m = _mm256_or_si256(m,
+					_mm256_or_si256(EQ(' '), EQ(')')));
+		m = _mm256_andnot_si256(m, IN(' ', '~'));
+		m = _mm256_or_si256(m, EQ('\t'));
+		break;
+	case SCAN_COMMENT:
+	default:
+		m = _mm256_or_si256(_mm256_or_si256(EQ('*'), EQ('\n')),
+				_mm256_or_si256(EQ('\r'), EQ('\f')));
+		m = _mm256_andnot_si256(m, _mm256_cmpgt_epi8(v, B(-1)));
+		break;
+	}
+
+	return (uint32_t) _mm256_movemask_epi8(m);
+#undef IN
+#undef EQ
+#undef B
+}
+#endif
+
+/**
+ * Find a run of input bytes which all belong to a class
+ *
+ * \param lexer  The lexer instance
+ * \param cls    The class of byte to accept
+ * \param ptr    Pointer to location to receive pointer to the run
+ * \return Length of the run, in bytes
+ *
+ * Only input already decoded into the inputstream's UTF-8 buffer, or the
+ * caller-owned buffer, is examined, so this never reads from the stream.
+ * Callers handle anything beyond the run a character at a time, as usual.
+ */
+size_t scanRun(css_lexer *lexer, scan_class cls, const uint8_t **ptr)
+{
+	const uint8_t *data;
+	size_t off, avail, len = 0;
+
+	if (lexer->buffer != NULL) {
+		off = lexer->bufferPos + lexer->bytesReadForToken;
+		if (off >= lexer->bufferLen)
+			return 0;
+
+		data = lexer->buffer + off;
+		avail = lexer->bufferLen - off;
+	} else {
+		const parserutils_buffer *utf8 = lexer->input->utf8;
+
+		off = lexer->input->cursor + lexer->bytesReadForToken;
+		if (off >= utf8->length)
+			return 0;
+
+		data = utf8->data + off;
+		avail = utf8->length - off;
+	}
+
+#ifdef CSS_LEX_AVX2
+	while (len + 32 <= avail) {
+		uint32_t mask = scanClass32(_mm256_loadu_si256(
+				(const __m256i *) (const void *) (data + len)),
+				cls);
+
+		if (mask != 0xffffffff) {
+			*ptr = data;
+			return len + __builtin_ctz(~mask);
+		}
+
+		len += 32;
+	}
+#endif
+#ifdef CSS_LEX_SSE2
+	while (len + 16 <= avail) {
+		uint32_t mask = scanClass16(_mm_loadu_si128(
+				(const __m128i *) (const void *) (data + len)),
+				cls);
+
+		if (mask != 0xffff) {
+			*ptr = data;
+			return len + __builtin_ctz(~mask);
+		}
+
+		len += 16;
+	}
+#endif
+	while (len < avail && isScanClass(data[len], cls))
+		len++;
+
+	*ptr = data;
+
+	return len;
+}
@@ -22,7 +22,8 @@ typedef struct css_lexer css_lexer;
  * Lexer option types
  */
 typedef enum css_lexer_opttype {
-	CSS_LEXER_EMIT_COMMENTS
+	CSS_LEXER_EMIT_COMMENTS,
+	CSS_LEXER_BUFFER
 } css_lexer_opttype;
 
 /**
@@ -30,6 +31,13 @@ typedef enum css_lexer_opttype {
  */
 typedef union css_lexer_optparams {
 	bool emit_comments;
+
+	/** Complete, valid UTF-8 input to read in place of the inputstream.
+	 * Must remain valid for as long as the lexer is used. */
+	struct {
+		const uint8_t *data;
+		size_t len;
+	} buffer;
 } css_lexer_optparams;
 
 /**
@@ -38,12 +46,17 @@ typedef union css_lexer_optparams {
 typedef enum css_token_type {
 	CSS_TOKEN_IDENT, CSS_TOKEN_ATKEYWORD, CSS_TOKEN_HASH,
 	CSS_TOKEN_FUNCTION, CSS_TOKEN_STRING, CSS_TOKEN_INVALID_STRING,
-	CSS_TOKEN_URI, CSS_TOKEN_UNICODE_RANGE, CSS_TOKEN_CHAR,
-	CSS_TOKEN_NUMBER, CSS_TOKEN_PERCENTAGE, CSS_TOKEN_DIMENSION,
+	CSS_TOKEN_URI, CSS_TOKEN_UNICODE_RANGE,
 
 	/* Those tokens that want strings interned appear above */
 	CSS_TOKEN_LAST_INTERN,
 
+	CSS_TOKEN_CHAR, CSS_TOKEN_NUMBER, CSS_TOKEN_PERCENTAGE,
+	CSS_TOKEN_DIMENSION,
+
+	/* Those tokens whose text is read, but never interned, appear above */
+	CSS_TOKEN_LAST_TEXT,
+
 	CSS_TOKEN_CDO, CSS_TOKEN_CDC, CSS_TOKEN_S, CSS_TOKEN_COMMENT,
 	CSS_TOKEN_INCLUDES, CSS_TOKEN_DASHMATCH, CSS_TOKEN_PREFIXMATCH,
 	CSS_TOKEN_SUFFIXMATCH, CSS_TOKEN_SUBSTRINGMATCH, CSS_TOKEN_EOF
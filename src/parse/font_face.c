@@ -41,7 +41,7 @@ static bool font_rule_font_family_reserved(css_language *c,
 }
 
 static css_error font_face_parse_font_family(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_font_face *font_face)
 {
 	css_error error;
@@ -60,7 +60,7 @@ static css_error font_face_parse_font_family(css_language *c,
 }
 
 static css_error font_face_src_parse_format(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_font_face_format *format)
 {
 	bool match;
@@ -76,7 +76,7 @@ static css_error font_face_src_parse_format(css_language *c,
 	do {
 		consumeWhitespace(vector, ctx);
 
-		token = parserutils_vector_iterate(vector, ctx);
+		token = css__token_vector_iterate(vector, ctx);
 		if (token == NULL || token->type != CSS_TOKEN_STRING)
 			return CSS_INVALID;
 
@@ -110,7 +110,7 @@ static css_error font_face_src_parse_format(css_language *c,
 		}
 
 		consumeWhitespace(vector, ctx);
-		token = parserutils_vector_iterate(vector, ctx);
+		token = css__token_vector_iterate(vector, ctx);
 	} while (token != NULL && tokenIsChar(token, ','));
 
 	if (token == NULL || tokenIsChar(token, ')') == false)
@@ -120,7 +120,7 @@ static css_error font_face_src_parse_format(css_language *c,
 }
 
 static css_error font_face_src_parse_spec_or_name(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		lwc_string **location,
 		css_font_face_location_type *location_type,
 		css_font_face_format *format)
@@ -137,7 +137,7 @@ static css_error font_face_src_parse_spec_or_name(css_language *c,
 
 	consumeWhitespace(vector, ctx);
 
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 	if (token == NULL)
 		return CSS_INVALID;
 
@@ -152,12 +152,12 @@ static css_error font_face_src_parse_spec_or_name(css_language *c,
 
 		consumeWhitespace(vector, ctx);
 
-		token = parserutils_vector_peek(vector, *ctx);
+		token = css__token_vector_peek(vector, *ctx);
 		if (token != NULL && token->type == CSS_TOKEN_FUNCTION &&
 				lwc_string_caseless_isequal(token->idata,
 				c->strings[FORMAT], &match) == lwc_error_ok &&
 				match) {
-			parserutils_vector_iterate(vector, ctx);
+			css__token_vector_iterate(vector, ctx);
 
 			error = font_face_src_parse_format(c, vector, ctx,
 					format);
@@ -179,7 +179,7 @@ static css_error font_face_src_parse_spec_or_name(css_language *c,
 
 		consumeWhitespace(vector, ctx);
 
-		token = parserutils_vector_iterate(vector, ctx);
+		token = css__token_vector_iterate(vector, ctx);
 		if (token == NULL || tokenIsChar(token, ')') == false) {
 			lwc_string_unref(*location);
 			return CSS_INVALID;
@@ -194,7 +194,7 @@ static css_error font_face_src_parse_spec_or_name(css_language *c,
 }
 
 static css_error font_face_parse_src(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 	     	css_font_face *font_face)
 {
 	int32_t orig_ctx = *ctx;
@@ -242,7 +242,7 @@ static css_error font_face_parse_src(css_language *c,
 		++n_srcs;
 
 		consumeWhitespace(vector, ctx);
-		token = parserutils_vector_iterate(vector, ctx);
+		token = css__token_vector_iterate(vector, ctx);
 	} while (token != NULL && tokenIsChar(token, ','));
 
 	error = css__font_face_set_srcs(font_face, srcs, n_srcs);
@@ -258,7 +258,7 @@ cleanup:
 }
 
 static css_error font_face_parse_font_style(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_font_face *font_face)
 {
 	int32_t orig_ctx = *ctx;
@@ -269,7 +269,7 @@ static css_error font_face_parse_font_style(css_language *c,
 
 	/* IDENT(normal, italic, oblique) */
 
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 	if ((token == NULL) || ((token->type != CSS_TOKEN_IDENT))) {
 		*ctx = orig_ctx;
 		return CSS_INVALID;
@@ -299,7 +299,7 @@ static css_error font_face_parse_font_style(css_language *c,
 }
 
 static css_error font_face_parse_font_weight(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_font_face *font_face)
 {
 	int32_t orig_ctx = *ctx;
@@ -310,7 +310,7 @@ static css_error font_face_parse_font_weight(css_language *c,
 
 	/* NUMBER (100, 200, 300, 400, 500, 600, 700, 800, 900) |
 	 * IDENT (normal, bold) */
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 	if (token == NULL || (token->type != CSS_TOKEN_IDENT &&
 			token->type != CSS_TOKEN_NUMBER)) {
 		*ctx = orig_ctx;
@@ -319,10 +319,10 @@ static css_error font_face_parse_font_weight(css_language *c,
 
 	if (token->type == CSS_TOKEN_NUMBER) {
 		size_t consumed = 0;
-		css_fixed num = css__number_from_lwc_string(token->idata,
-				true, &consumed);
+		css_fixed num = css__number_from_string(token->data.data,
+				token->data.len, true, &consumed);
 		/* Invalid if there are trailing characters */
-		if (consumed != lwc_string_length(token->idata)) {
+		if (consumed != token->data.len) {
 			*ctx = orig_ctx;
 			return CSS_INVALID;
 		}
@@ -373,7 +373,7 @@ static css_error font_face_parse_font_weight(css_language *c,
  *         CSS_NOMEM on memory exhaustion
  */
 css_error css__parse_font_descriptor(css_language *c,
-		const css_token *descriptor, const parserutils_vector *vector,
+		const css_token *descriptor, const css_token_vector *vector,
 		int32_t *ctx, css_rule_font_face *rule)
 {
 	css_font_face *font_face = rule->font_face;
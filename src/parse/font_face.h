@@ -9,14 +9,12 @@
 #ifndef css_parse_font_face_h_
 #define css_parse_font_face_h_
 
-#include <parserutils/utils/vector.h>
-
 #include "stylesheet.h"
 #include "lex/lex.h"
 #include "parse/language.h"
 
 css_error css__parse_font_descriptor(css_language *c,
-		const css_token *descriptor, const parserutils_vector *vector,
+		const css_token *descriptor, const css_token_vector *vector,
 		int32_t *ctx, struct css_rule_font_face *rule);
 
 #endif
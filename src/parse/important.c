@@ -25,7 +25,7 @@
  *                 If the input is invalid, then \a *ctx remains unchanged.
  */
 css_error css__parse_important(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		uint8_t *result)
 {
 	int32_t orig_ctx = *ctx;
@@ -34,11 +34,11 @@ css_error css__parse_important(css_language *c,
 
 	consumeWhitespace(vector, ctx);
 
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 	if (token != NULL && tokenIsChar(token, '!')) {
 		consumeWhitespace(vector, ctx);
 
-		token = parserutils_vector_iterate(vector, ctx);
+		token = css__token_vector_iterate(vector, ctx);
 		if (token == NULL || token->type != CSS_TOKEN_IDENT) {
 			*ctx = orig_ctx;
 			return CSS_INVALID;
@@ -12,7 +12,7 @@
 #include "parse/language.h"
 
 css_error css__parse_important(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		uint8_t *result);
 
 void css__make_style_important(css_style *style);
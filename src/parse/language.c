@@ -31,29 +31,30 @@ typedef struct context_entry {
 
 /* Event handlers */
 static css_error language_handle_event(css_parser_event type,
-		const parserutils_vector *tokens, void *pw);
+		const css_token_vector *tokens, void *pw);
 static css_error handleStartStylesheet(css_language *c,
-		const parserutils_vector *vector);
+		const css_token_vector *vector);
 static css_error handleEndStylesheet(css_language *c,
-		const parserutils_vector *vector);
+		const css_token_vector *vector);
 static css_error handleStartRuleset(css_language *c,
-		const parserutils_vector *vector);
+		const css_token_vector *vector);
 static css_error handleEndRuleset(css_language *c,
-		const parserutils_vector *vector);
+		const css_token_vector *vector);
 static css_error handleStartAtRule(css_language *c,
-		const parserutils_vector *vector);
+		const css_token_vector *vector);
 static css_error handleEndAtRule(css_language *c,
-		const parserutils_vector *vector);
+		const css_token_vector *vector);
 static css_error handleStartBlock(css_language *c,
-		const parserutils_vector *vector);
+		const css_token_vector *vector);
 static css_error handleEndBlock(css_language *c,
-		const parserutils_vector *vector);
+		const css_token_vector *vector);
 static css_error handleBlockContent(css_language *c,
-		const parserutils_vector *vector);
+		const css_token_vector *vector);
 static css_error handleEndBlockContent(css_language *c,
-		const parserutils_vector *vector);
+		const css_token_vector *vector);
 static css_error handleDeclaration(css_language *c,
-		const parserutils_vector *vector);
+		const css_token_vector *vector);
+static void countCompletedRule(css_language *c);
 
 /* At-rule parsing */
 static css_error addNamespace(css_language *c,
@@ -63,44 +64,44 @@ static css_error lookupNamespace(css_language *c,
 
 /* Selector list parsing */
 static css_error parseClass(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_selector_detail *specific);
 static css_error parseAttrib(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_selector_detail *specific);
 static css_error parseNth(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_selector_detail_value *value);
 static css_error parsePseudo(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		bool in_not, css_selector_detail *specific);
 static css_error parseSpecific(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		bool in_not, css_selector_detail *specific);
 static css_error parseAppendSpecific(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_selector **parent);
 static css_error parseSelectorSpecifics(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_selector **parent);
 static css_error parseTypeSelector(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_qname *qname);
 static css_error parseSimpleSelector(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_selector **result);
 static css_error parseCombinator(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_combinator *result);
 static css_error parseSelector(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_selector **result);
 static css_error parseSelectorList(css_language *c,
-		const parserutils_vector *vector, css_rule *rule);
+		const css_token_vector *vector, css_rule *rule);
 
 /* Declaration parsing */
 static css_error parseProperty(css_language *c,
-		const css_token *property, const parserutils_vector *vector,
+		const css_token *property, const css_token_vector *vector,
 		int32_t *ctx, css_rule *rule);
 
 /**
@@ -197,7 +198,7 @@ css_error css__language_destroy(css_language *language)
  *	   appropriate error otherwise.
  */
 css_error language_handle_event(css_parser_event type,
-		const parserutils_vector *tokens, void *pw)
+		const css_token_vector *tokens, void *pw)
 {
 	css_language *language = (css_language *) pw;
 
@@ -234,7 +235,7 @@ css_error language_handle_event(css_parser_event type,
  ******************************************************************************/
 
 css_error handleStartStylesheet(css_language *c,
-		const parserutils_vector *vector)
+		const css_token_vector *vector)
 {
 	parserutils_error perror;
 	context_entry entry = { CSS_PARSER_START_STYLESHEET, NULL };
@@ -251,7 +252,7 @@ css_error handleStartStylesheet(css_language *c,
 	return CSS_OK;
 }
 
-css_error handleEndStylesheet(css_language *c, const parserutils_vector *vector)
+css_error handleEndStylesheet(css_language *c, const css_token_vector *vector)
 {
 	parserutils_error perror;
 	context_entry *entry;
@@ -272,7 +273,7 @@ css_error handleEndStylesheet(css_language *c, const parserutils_vector *vector)
 	return CSS_OK;
 }
 
-css_error handleStartRuleset(css_language *c, const parserutils_vector *vector)
+css_error handleStartRuleset(css_language *c, const css_token_vector *vector)
 {
 	parserutils_error perror;
 	css_error error;
@@ -325,7 +326,7 @@ css_error handleStartRuleset(css_language *c, const parserutils_vector *vector)
 	return CSS_OK;
 }
 
-css_error handleEndRuleset(css_language *c, const parserutils_vector *vector)
+css_error handleEndRuleset(css_language *c, const css_token_vector *vector)
 {
 	parserutils_error perror;
 	context_entry *entry;
@@ -343,10 +344,12 @@ css_error handleEndRuleset(css_language *c, const parserutils_vector *vector)
 		return css_error_from_parserutils_error(perror);
 	}
 
+	countCompletedRule(c);
+
 	return CSS_OK;
 }
 
-css_error handleStartAtRule(css_language *c, const parserutils_vector *vector)
+css_error handleStartAtRule(css_language *c, const css_token_vector *vector)
 {
 	parserutils_error perror;
 	context_entry entry = { CSS_PARSER_START_ATRULE, NULL };
@@ -361,7 +364,7 @@ css_error handleStartAtRule(css_language *c, const parserutils_vector *vector)
 
 	assert(c != NULL);
 
-	atkeyword = parserutils_vector_iterate(vector, &ctx);
+	atkeyword = css__token_vector_iterate(vector, &ctx);
 
 	consumeWhitespace(vector, &ctx);
 
@@ -378,12 +381,12 @@ css_error handleStartAtRule(css_language *c, const parserutils_vector *vector)
 			if (ctx == 0)
 				return CSS_INVALID;
 
-			charset = parserutils_vector_iterate(vector, &ctx);
+			charset = css__token_vector_iterate(vector, &ctx);
 			if (charset == NULL ||
 					charset->type != CSS_TOKEN_STRING)
 				return CSS_INVALID;
 
-			token = parserutils_vector_iterate(vector, &ctx);
+			token = css__token_vector_iterate(vector, &ctx);
 			if (token != NULL)
 				return CSS_INVALID;
 
@@ -421,7 +424,7 @@ css_error handleStartAtRule(css_language *c, const parserutils_vector *vector)
 
 			/* any0 = (STRING | URI) ws (media query)? */
 			const css_token *uri =
-				parserutils_vector_iterate(vector, &ctx);
+				css__token_vector_iterate(vector, &ctx);
 			if (uri == NULL || (uri->type != CSS_TOKEN_STRING &&
 					uri->type != CSS_TOKEN_URI))
 				return CSS_INVALID;
@@ -507,7 +510,7 @@ css_error handleStartAtRule(css_language *c, const parserutils_vector *vector)
 
 			/* any0 = (IDENT ws)? (STRING | URI) ws */
 
-			token = parserutils_vector_iterate(vector, &ctx);
+			token = css__token_vector_iterate(vector, &ctx);
 			if (token == NULL)
 				return CSS_INVALID;
 
@@ -516,7 +519,7 @@ css_error handleStartAtRule(css_language *c, const parserutils_vector *vector)
 
 				consumeWhitespace(vector, &ctx);
 
-				token = parserutils_vector_iterate(vector,
+				token = css__token_vector_iterate(vector,
 						&ctx);
 			}
 
@@ -605,7 +608,7 @@ css_error handleStartAtRule(css_language *c, const parserutils_vector *vector)
 
 		consumeWhitespace(vector, &ctx);
 
-		token = parserutils_vector_peek(vector, ctx);
+		token = css__token_vector_peek(vector, ctx);
 		if (token != NULL) {
 			css_selector *sel = NULL;
 
@@ -648,7 +651,7 @@ css_error handleStartAtRule(css_language *c, const parserutils_vector *vector)
 	return CSS_OK;
 }
 
-css_error handleEndAtRule(css_language *c, const parserutils_vector *vector)
+css_error handleEndAtRule(css_language *c, const css_token_vector *vector)
 {
 	parserutils_error perror;
 	context_entry *entry;
@@ -666,10 +669,12 @@ css_error handleEndAtRule(css_language *c, const parserutils_vector *vector)
 		return css_error_from_parserutils_error(perror);
 	}
 
+	countCompletedRule(c);
+
 	return CSS_OK;
 }
 
-css_error handleStartBlock(css_language *c, const parserutils_vector *vector)
+css_error handleStartBlock(css_language *c, const css_token_vector *vector)
 {
 	parserutils_error perror;
 	context_entry entry = { CSS_PARSER_START_BLOCK, NULL };
@@ -692,7 +697,7 @@ css_error handleStartBlock(css_language *c, const parserutils_vector *vector)
 	return CSS_OK;
 }
 
-css_error handleEndBlock(css_language *c, const parserutils_vector *vector)
+css_error handleEndBlock(css_language *c, const css_token_vector *vector)
 {
 	parserutils_error perror;
 	context_entry *entry;
@@ -720,7 +725,7 @@ css_error handleEndBlock(css_language *c, const parserutils_vector *vector)
 	return CSS_OK;
 }
 
-css_error handleBlockContent(css_language *c, const parserutils_vector *vector)
+css_error handleBlockContent(css_language *c, const css_token_vector *vector)
 {
 	context_entry *entry;
 	css_rule *rule;
@@ -751,7 +756,7 @@ css_error handleBlockContent(css_language *c, const parserutils_vector *vector)
 	return CSS_OK;
 }
 
-css_error handleEndBlockContent(css_language *c, const parserutils_vector *vector)
+css_error handleEndBlockContent(css_language *c, const css_token_vector *vector)
 {
 	context_entry *entry;
 	parserutils_error perror;
@@ -782,7 +787,7 @@ css_error handleEndBlockContent(css_language *c, const parserutils_vector *vecto
 	return ret;
 }
 
-css_error handleDeclaration(css_language *c, const parserutils_vector *vector)
+css_error handleDeclaration(css_language *c, const css_token_vector *vector)
 {
 	css_error error;
 	const css_token *token, *ident;
@@ -813,13 +818,13 @@ css_error handleDeclaration(css_language *c, const parserutils_vector *vector)
 	 *
 	 * In CSS 2.1, value is any1, so '{' or ATKEYWORD => parse error
 	 */
-	ident = parserutils_vector_iterate(vector, &ctx);
+	ident = css__token_vector_iterate(vector, &ctx);
 	if (ident == NULL || ident->type != CSS_TOKEN_IDENT)
 		return CSS_INVALID;
 
 	consumeWhitespace(vector, &ctx);
 
-	token = parserutils_vector_iterate(vector, &ctx);
+	token = css__token_vector_iterate(vector, &ctx);
 	if (token == NULL || tokenIsChar(token, ':') == false)
 		return CSS_INVALID;
 
@@ -838,6 +843,21 @@ css_error handleDeclaration(css_language *c, const parserutils_vector *vector)
 	return CSS_OK;
 }
 
+/**
+ * Count a rule as completed, if it has just closed at the top level
+ *
+ * \param c  Parsing context
+ *
+ * Rules closing within an @media block are counted when the block is.
+ */
+void countCompletedRule(css_language *c)
+{
+	context_entry *entry = parserutils_stack_get_current(c->context);
+
+	if (entry != NULL && entry->type == CSS_PARSER_START_STYLESHEET)
+		c->sheet->generation++;
+}
+
 /******************************************************************************
  * At-rule parsing functions						      *
  ******************************************************************************/
@@ -938,7 +958,7 @@ css_error lookupNamespace(css_language *c, lwc_string *prefix, lwc_string **uri)
  * Selector list parsing functions					      *
  ******************************************************************************/
 
-css_error parseClass(css_language *c, const parserutils_vector *vector,
+css_error parseClass(css_language *c, const css_token_vector *vector,
 		int32_t *ctx, css_selector_detail *specific)
 {
 	css_qname qname;
@@ -946,11 +966,11 @@ css_error parseClass(css_language *c, const parserutils_vector *vector,
 	const css_token *token;
 
 	/* class     -> '.' IDENT */
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 	if (token == NULL || tokenIsChar(token, '.') == false)
 		return CSS_INVALID;
 
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 	if (token == NULL || token->type != CSS_TOKEN_IDENT)
 		return CSS_INVALID;
 
@@ -969,7 +989,7 @@ css_error parseClass(css_language *c, const parserutils_vector *vector,
 			CSS_SELECTOR_DETAIL_VALUE_STRING, false, specific);
 }
 
-css_error parseAttrib(css_language *c, const parserutils_vector *vector,
+css_error parseAttrib(css_language *c, const css_token_vector *vector,
 		int32_t *ctx, css_selector_detail *specific)
 {
 	css_qname qname;
@@ -990,30 +1010,31 @@ css_error parseAttrib(css_language *c, const parserutils_vector *vector,
 	 *		       [ IDENT | STRING ] ws ]? ']'
 	 * namespace_prefix -> [ IDENT | '*' ]? '|'
 	 */
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 	if (token == NULL || tokenIsChar(token, '[') == false)
 		return CSS_INVALID;
 
 	consumeWhitespace(vector, ctx);
 
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 	if (token == NULL || (token->type != CSS_TOKEN_IDENT &&
 			tokenIsChar(token, '*') == false &&
 			tokenIsChar(token, '|') == false))
 		return CSS_INVALID;
 
 	if (tokenIsChar(token, '|')) {
-		token = parserutils_vector_iterate(vector, ctx);
+		token = css__token_vector_iterate(vector, ctx);
 	} else {
 		const css_token *temp;
 
-		temp = parserutils_vector_peek(vector, *ctx);
+		temp = css__token_vector_peek(vector, *ctx);
 		if (temp != NULL && tokenIsChar(temp, '|')) {
-			prefix = token->idata;
+			prefix = (token->type == CSS_TOKEN_IDENT) ?
+					token->idata : c->strings[UNIVERSAL];
 
-			parserutils_vector_iterate(vector, ctx);
+			css__token_vector_iterate(vector, ctx);
 
-			token = parserutils_vector_iterate(vector, ctx);
+			token = css__token_vector_iterate(vector, ctx);
 		}
 	}
 
@@ -1028,7 +1049,7 @@ css_error parseAttrib(css_language *c, const parserutils_vector *vector,
 
 	consumeWhitespace(vector, ctx);
 
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 	if (token == NULL)
 		return CSS_INVALID;
 
@@ -1050,7 +1071,7 @@ css_error parseAttrib(css_language *c, const parserutils_vector *vector,
 
 		consumeWhitespace(vector, ctx);
 
-		token = parserutils_vector_iterate(vector, ctx);
+		token = css__token_vector_iterate(vector, ctx);
 		if (token == NULL || (token->type != CSS_TOKEN_IDENT &&
 				token->type != CSS_TOKEN_STRING))
 			return CSS_INVALID;
@@ -1059,7 +1080,7 @@ css_error parseAttrib(css_language *c, const parserutils_vector *vector,
 
 		consumeWhitespace(vector, ctx);
 
-		token = parserutils_vector_iterate(vector, ctx);
+		token = css__token_vector_iterate(vector, ctx);
 		if (token == NULL || tokenIsChar(token, ']') == false)
 			return CSS_INVALID;
 	}
@@ -1072,7 +1093,7 @@ css_error parseAttrib(css_language *c, const parserutils_vector *vector,
 }
 
 css_error parseNth(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_selector_detail_value *value)
 {
 	const css_token *token;
@@ -1086,7 +1107,7 @@ css_error parseNth(css_language *c,
 	 *     -> IDENT(even) ws
 	 */
 
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 	if (token == NULL || (token->type != CSS_TOKEN_IDENT &&
 			token->type != CSS_TOKEN_NUMBER &&
 			token->type != CSS_TOKEN_DIMENSION))
@@ -1110,9 +1131,9 @@ css_error parseNth(css_language *c,
 		size_t consumed = 0;
 		css_fixed val = 0;
 
-		val = css__number_from_lwc_string(token->idata,
-				true, &consumed);
-		if (consumed != lwc_string_length(token->idata))
+		val = css__number_from_string(token->data.data,
+				token->data.len, true, &consumed);
+		if (consumed != token->data.len)
 			return CSS_INVALID;
 
 		value->nth.a = 0;
@@ -1129,8 +1150,8 @@ css_error parseNth(css_language *c,
 		int sign = 1;
 		bool had_sign = false, had_b = false;
 
-		len = lwc_string_length(token->idata);
-		data = lwc_string_data(token->idata);
+		len = token->data.len;
+		data = (const char *) token->data.data;
 
 		/* Compute a */
 		if (token->type == CSS_TOKEN_IDENT) {
@@ -1182,8 +1203,8 @@ css_error parseNth(css_language *c,
 			}
 		} else {
 			/* 2n */
-			a = css__number_from_lwc_string(token->idata,
-					true, &consumed);
+			a = css__number_from_string(token->data.data,
+					token->data.len, true, &consumed);
 			if (consumed == 0 || (data[consumed] != 'n' &&
 					data[consumed] != 'N'))
 				return CSS_INVALID;
@@ -1224,12 +1245,12 @@ css_error parseNth(css_language *c,
 			consumeWhitespace(vector, ctx);
 
 			/* Look for optional b : [ [ CHAR ws ]? NUMBER ws ]? */
-			token = parserutils_vector_peek(vector, *ctx);
+			token = css__token_vector_peek(vector, *ctx);
 
 			if (had_sign == false && token != NULL &&
 					(tokenIsChar(token, '-') ||
 					tokenIsChar(token, '+'))) {
-				parserutils_vector_iterate(vector, ctx);
+				css__token_vector_iterate(vector, ctx);
 
 				had_sign = true;
 
@@ -1238,27 +1259,26 @@ css_error parseNth(css_language *c,
 
 				consumeWhitespace(vector, ctx);
 
-				token = parserutils_vector_peek(vector, *ctx);
+				token = css__token_vector_peek(vector, *ctx);
 			}
 
 			/* Expect NUMBER */
 			if (token != NULL && token->type == CSS_TOKEN_NUMBER) {
-				parserutils_vector_iterate(vector, ctx);
+				css__token_vector_iterate(vector, ctx);
 
 				/* If we've already seen a sign, ensure one
 				 * does not occur at the start of this token
 				 */
-				if (had_sign && lwc_string_length(
-						token->idata) > 0) {
-					data = lwc_string_data(token->idata);
+				if (had_sign && token->data.len > 0) {
+					data = (const char *) token->data.data;
 
 					if (data[0] == '-' || data[0] == '+')
 						return CSS_INVALID;
 				}
 
-				b = css__number_from_lwc_string(token->idata,
-						true, &consumed);
-				if (consumed != lwc_string_length(token->idata))
+				b = css__number_from_string(token->data.data,
+						token->data.len, true, &consumed);
+				if (consumed != token->data.len)
 					return CSS_INVALID;
 			}
 		}
@@ -1272,7 +1292,7 @@ css_error parseNth(css_language *c,
 	return CSS_OK;
 }
 
-css_error parsePseudo(css_language *c, const parserutils_vector *vector,
+css_error parsePseudo(css_language *c, const css_token_vector *vector,
 		int32_t *ctx, bool in_not, css_selector_detail *specific)
 {
 	static const struct
@@ -1326,18 +1346,18 @@ css_error parsePseudo(css_language *c, const parserutils_vector *vector,
 
 	detail_value.string = NULL;
 
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 	if (token == NULL || tokenIsChar(token, ':') == false)
 		return CSS_INVALID;
 
 	/* Optional second colon before pseudo element names */
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 	if (token != NULL && tokenIsChar(token, ':')) {
 		/* If present, we require a pseudo element */
 		require_element = true;
 
 		/* Consume subsequent token */
-		token = parserutils_vector_iterate(vector, ctx);
+		token = css__token_vector_iterate(vector, ctx);
 	}
 
 	/* Expect IDENT or FUNCTION */
@@ -1378,7 +1398,7 @@ css_error parsePseudo(css_language *c, const parserutils_vector *vector,
 
 		if (fun_type == LANG) {
 			/* IDENT */
-			token = parserutils_vector_iterate(vector, ctx);
+			token = css__token_vector_iterate(vector, ctx);
 			if (token == NULL || token->type != CSS_TOKEN_IDENT)
 				return CSS_INVALID;
 
@@ -1398,7 +1418,7 @@ css_error parsePseudo(css_language *c, const parserutils_vector *vector,
 			value_type = CSS_SELECTOR_DETAIL_VALUE_NTH;
 		} else if (fun_type == NOT) {
 			/* type_selector | specific */
-			token = parserutils_vector_peek(vector, *ctx);
+			token = css__token_vector_peek(vector, *ctx);
 			if (token == NULL)
 				return CSS_INVALID;
 
@@ -1442,7 +1462,7 @@ css_error parsePseudo(css_language *c, const parserutils_vector *vector,
 			consumeWhitespace(vector, ctx);
 		}
 
-		token = parserutils_vector_iterate(vector, ctx);
+		token = css__token_vector_iterate(vector, ctx);
 		if (token == NULL || tokenIsChar(token, ')') == false)
 			return CSS_INVALID;
 	}
@@ -1453,7 +1473,7 @@ css_error parsePseudo(css_language *c, const parserutils_vector *vector,
 }
 
 css_error parseSpecific(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		bool in_not, css_selector_detail *specific)
 {
 	css_error error;
@@ -1461,7 +1481,7 @@ css_error parseSpecific(css_language *c,
 
 	/* specific  -> [ HASH | class | attrib | pseudo ] */
 
-	token = parserutils_vector_peek(vector, *ctx);
+	token = css__token_vector_peek(vector, *ctx);
 	if (token == NULL)
 		return CSS_INVALID;
 
@@ -1487,7 +1507,7 @@ css_error parseSpecific(css_language *c,
 		if (error != CSS_OK)
 			return error;
 
-		parserutils_vector_iterate(vector, ctx);
+		css__token_vector_iterate(vector, ctx);
 	} else if (tokenIsChar(token, '.')) {
 		error = parseClass(c, vector, ctx, specific);
 		if (error != CSS_OK)
@@ -1508,7 +1528,7 @@ css_error parseSpecific(css_language *c,
 }
 
 css_error parseAppendSpecific(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_selector **parent)
 {
 	css_error error;
@@ -1523,14 +1543,14 @@ css_error parseAppendSpecific(css_language *c,
 }
 
 css_error parseSelectorSpecifics(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_selector **parent)
 {
 	css_error error;
 	const css_token *token;
 
 	/* specifics -> specific* */
-	while ((token = parserutils_vector_peek(vector, *ctx)) != NULL &&
+	while ((token = css__token_vector_peek(vector, *ctx)) != NULL &&
 			token->type != CSS_TOKEN_S &&
 			tokenIsChar(token, '+') == false &&
 			tokenIsChar(token, '>') == false &&
@@ -1544,7 +1564,7 @@ css_error parseSelectorSpecifics(css_language *c,
 	return CSS_OK;
 }
 
-css_error parseTypeSelector(css_language *c, const parserutils_vector *vector,
+css_error parseTypeSelector(css_language *c, const css_token_vector *vector,
 		int32_t *ctx, css_qname *qname)
 {
 	const css_token *token;
@@ -1556,24 +1576,26 @@ css_error parseTypeSelector(css_language *c, const parserutils_vector *vector,
 	 * element_name	    -> IDENT | '*'
 	 */
 
-	token = parserutils_vector_peek(vector, *ctx);
+	token = css__token_vector_peek(vector, *ctx);
 	if (token == NULL)
 		return CSS_INVALID;
 
 	if (tokenIsChar(token, '|') == false) {
-		prefix = token->idata;
+		/* '*' is a CHAR token, so has no interned string of its own */
+		prefix = (token->type == CSS_TOKEN_IDENT) ? token->idata :
+				c->strings[UNIVERSAL];
 
-		parserutils_vector_iterate(vector, ctx);
+		css__token_vector_iterate(vector, ctx);
 
-		token = parserutils_vector_peek(vector, *ctx);
+		token = css__token_vector_peek(vector, *ctx);
 	}
 
 	if (token != NULL && tokenIsChar(token, '|')) {
 		/* Have namespace prefix */
-		parserutils_vector_iterate(vector, ctx);
+		css__token_vector_iterate(vector, ctx);
 
 		/* Expect element_name */
-		token = parserutils_vector_iterate(vector, ctx);
+		token = css__token_vector_iterate(vector, ctx);
 
 		if (token == NULL || (token->type != CSS_TOKEN_IDENT &&
 				tokenIsChar(token, '*') == false)) {
@@ -1584,7 +1606,8 @@ css_error parseTypeSelector(css_language *c, const parserutils_vector *vector,
 		if (error != CSS_OK)
 			return error;
 
-		qname->name = token->idata;
+		qname->name = (token->type == CSS_TOKEN_IDENT) ? token->idata :
+				c->strings[UNIVERSAL];
 	} else {
 		/* No namespace prefix */
 		if (c->default_namespace == NULL) {
@@ -1606,7 +1629,7 @@ css_error parseTypeSelector(css_language *c, const parserutils_vector *vector,
 }
 
 css_error parseSimpleSelector(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_selector **result)
 {
 	int32_t orig_ctx = *ctx;
@@ -1619,7 +1642,7 @@ css_error parseSimpleSelector(css_language *c,
 	 *		    -> specific specifics
 	 */
 
-	token = parserutils_vector_peek(vector, *ctx);
+	token = css__token_vector_peek(vector, *ctx);
 	if (token == NULL)
 		return CSS_INVALID;
 
@@ -1671,7 +1694,7 @@ css_error parseSimpleSelector(css_language *c,
 	return CSS_OK;
 }
 
-css_error parseCombinator(css_language *c, const parserutils_vector *vector,
+css_error parseCombinator(css_language *c, const css_token_vector *vector,
 		int32_t *ctx, css_combinator *result)
 {
 	const css_token *token;
@@ -1681,7 +1704,7 @@ css_error parseCombinator(css_language *c, const parserutils_vector *vector,
 
 	UNUSED(c);
 
-	while ((token = parserutils_vector_peek(vector, *ctx)) != NULL) {
+	while ((token = css__token_vector_peek(vector, *ctx)) != NULL) {
 		if (tokenIsChar(token, '+'))
 			comb = CSS_COMBINATOR_SIBLING;
 		else if (tokenIsChar(token, '>'))
@@ -1693,7 +1716,7 @@ css_error parseCombinator(css_language *c, const parserutils_vector *vector,
 		else
 			break;
 
-		parserutils_vector_iterate(vector, ctx);
+		css__token_vector_iterate(vector, ctx);
 
 		/* If we've seen a '+', '>', or '~', we're done. */
 		if (comb != CSS_COMBINATOR_ANCESTOR)
@@ -1712,7 +1735,7 @@ css_error parseCombinator(css_language *c, const parserutils_vector *vector,
 	return CSS_OK;
 }
 
-css_error parseSelector(css_language *c, const parserutils_vector *vector,
+css_error parseSelector(css_language *c, const css_token_vector *vector,
 		int32_t *ctx, css_selector **result)
 {
 	css_error error;
@@ -1732,7 +1755,7 @@ css_error parseSelector(css_language *c, const parserutils_vector *vector,
 	if (error != CSS_OK)
 		return error;
 
-	while ((token = parserutils_vector_peek(vector, *ctx)) != NULL &&
+	while ((token = css__token_vector_peek(vector, *ctx)) != NULL &&
 			tokenIsChar(token, ',') == false) {
 		css_combinator comb = CSS_COMBINATOR_NONE;
 		css_selector *other = NULL;
@@ -1750,7 +1773,7 @@ css_error parseSelector(css_language *c, const parserutils_vector *vector,
 		 * are no further tokens, or if the next token is a comma,
 		 * we ignore the supposed combinator and continue. */
 		if (comb == CSS_COMBINATOR_ANCESTOR &&
-				((token = parserutils_vector_peek(vector,
+				((token = css__token_vector_peek(vector,
 					*ctx)) == NULL ||
 				tokenIsChar(token, ',')))
 			continue;
@@ -1777,7 +1800,7 @@ css_error parseSelector(css_language *c, const parserutils_vector *vector,
 	return CSS_OK;
 }
 
-css_error parseSelectorList(css_language *c, const parserutils_vector *vector,
+css_error parseSelectorList(css_language *c, const css_token_vector *vector,
 		css_rule *rule)
 {
 	css_error error;
@@ -1805,8 +1828,8 @@ css_error parseSelectorList(css_language *c, const parserutils_vector *vector,
 		return error;
 	}
 
-	while (parserutils_vector_peek(vector, ctx) != NULL) {
-		token = parserutils_vector_iterate(vector, &ctx);
+	while (css__token_vector_peek(vector, ctx) != NULL) {
+		token = css__token_vector_iterate(vector, &ctx);
 		if (tokenIsChar(token, ',') == false)
 			return CSS_INVALID;
 
@@ -1841,7 +1864,7 @@ css_error parseSelectorList(css_language *c, const parserutils_vector *vector,
  ******************************************************************************/
 
 css_error parseProperty(css_language *c, const css_token *property,
-		const parserutils_vector *vector, int32_t *ctx, css_rule *rule)
+		const css_token_vector *vector, int32_t *ctx, css_rule *rule)
 {
 	css_error error;
 	css_prop_handler handler = NULL;
@@ -1851,15 +1874,12 @@ css_error parseProperty(css_language *c, const css_token *property,
 	const css_token *token;
 
 	/* Find property index */
-	/** \todo improve on this linear search */
-	for (i = FIRST_PROP; i <= LAST_PROP; i++) {
-		bool match = false;
+	error = css__propstrings_find(property->idata, FIRST_PROP, LAST_PROP,
+			&i);
+	if (error != CSS_OK)
+		return error;
 
-		if (lwc_string_caseless_isequal(property->idata, c->strings[i],
-				&match) == lwc_error_ok && match)
-			break;
-	}
-	if (i == LAST_PROP + 1)
+	if (i < 0)
 		return CSS_INVALID;
 
 	/* Get handler */
@@ -1889,7 +1909,7 @@ css_error parseProperty(css_language *c, const css_token *property,
 
 	/* Ensure that we've exhausted all the input */
 	consumeWhitespace(vector, ctx);
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 	if (token != NULL) {
 		/* Trailing junk, so discard declaration */
                 css__stylesheet_style_destroy(style);
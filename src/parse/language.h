@@ -9,7 +9,6 @@
 #define css_css__parse_language_h_
 
 #include <parserutils/utils/stack.h>
-#include <parserutils/utils/vector.h>
 
 #include <libcss/functypes.h>
 #include <libcss/types.h>
@@ -64,13 +63,13 @@ css_error css__language_destroy(css_language *language);
  * \param vector  The vector to consume from
  * \param ctx     The vector's context
  */
-static inline void consumeWhitespace(const parserutils_vector *vector, int32_t *ctx)
+static inline void consumeWhitespace(const css_token_vector *vector, int32_t *ctx)
 {
 	const css_token *token = NULL;
 
-	while ((token = parserutils_vector_peek(vector, *ctx)) != NULL &&
+	while ((token = css__token_vector_peek(vector, *ctx)) != NULL &&
 			token->type == CSS_TOKEN_S)
-		parserutils_vector_iterate(vector, ctx);
+		css__token_vector_iterate(vector, ctx);
 }
 
 /**
@@ -85,8 +84,8 @@ static inline bool tokenIsChar(const css_token *token, uint8_t c)
 	bool result = false;
 
 	if (token != NULL && token->type == CSS_TOKEN_CHAR &&
-	                lwc_string_length(token->idata) == 1) {
-		char d = lwc_string_data(token->idata)[0];
+			token->data.len == 1) {
+		char d = token->data.data[0];
 
 		/* Ensure lowercase comparison */
 		if ('A' <= d && d <= 'Z')
@@ -79,11 +79,11 @@ void css__mq_query_destroy(css_mq_query *media)
 }
 
 static css_error mq_parse_condition(lwc_string **strings,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		bool permit_or, css_mq_cond **cond);
 
 static css_error mq_parse_ratio(
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		const css_token *numerator, css_fixed *ratio)
 {
 	const css_token *token;
@@ -94,20 +94,22 @@ static css_error mq_parse_ratio(
 
 	/* numerator, ws* already consumed */
 
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 	if (token == NULL || tokenIsChar(token, '/') == false) {
 		return CSS_INVALID;
 	}
 
 	consumeWhitespace(vector, ctx);
 
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 	if (token == NULL || token->type != CSS_TOKEN_NUMBER) {
 		return CSS_INVALID;
 	}
 
-	num = css__number_from_lwc_string(numerator->idata, true, &num_len);
-	den = css__number_from_lwc_string(token->idata, true, &den_len);
+	num = css__number_from_string(numerator->data.data,
+			numerator->data.len, true, &num_len);
+	den = css__number_from_string(token->data.data, token->data.len,
+			true, &den_len);
 
 	if (num == 0 || den == 0) {
 		return CSS_INVALID;
@@ -147,18 +149,20 @@ static css_error mq_populate_value(css_mq_value *value,
 	if (token->type == CSS_TOKEN_NUMBER) {
 		size_t num_len;
 		value->type = CSS_MQ_VALUE_TYPE_NUM;
-		value->data.num_or_ratio = css__number_from_lwc_string(
-				token->idata, false, &num_len);
+		value->data.num_or_ratio = css__number_from_string(
+				token->data.data, token->data.len,
+				false, &num_len);
 	} else if (token->type == CSS_TOKEN_DIMENSION) {
-		size_t len = lwc_string_length(token->idata);
-		const char *data = lwc_string_data(token->idata);
+		size_t len = token->data.len;
+		const char *data = (const char *) token->data.data;
 		uint32_t unit = UNIT_PX;
 		size_t consumed;
 		css_error error;
 
 		value->type = CSS_MQ_VALUE_TYPE_DIM;
-		value->data.dim.len = css__number_from_lwc_string(
-				token->idata, false, &consumed);
+		value->data.dim.len = css__number_from_string(
+				token->data.data, token->data.len,
+				false, &consumed);
 		error = css__parse_unit_keyword(data + consumed, len - consumed,
 				&unit);
 		if (error != CSS_OK) {
@@ -182,8 +186,8 @@ static css_error mq_parse_op(const css_token *token,
 	if (token == NULL || token->type != CSS_TOKEN_CHAR)
 		return CSS_INVALID;
 
-	len = lwc_string_length(token->idata);
-	data = lwc_string_data(token->idata);
+	len = token->data.len;
+	data = (const char *) token->data.data;
 
 	if (len == 2) {
 		if (strncasecmp(data, "<=", 2) == 0)
@@ -260,7 +264,7 @@ static css_error mq_parse_range__convert_to_level_4(
 }
 
 static css_error mq_parse_range(lwc_string **strings,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		const css_token *name_or_value,
 		css_mq_feature **feature)
 {
@@ -287,7 +291,7 @@ static css_error mq_parse_range(lwc_string **strings,
 
 	/* Name-or-value */
 	if (name_or_value->type == CSS_TOKEN_NUMBER &&
-			tokenIsChar(parserutils_vector_peek(vector, *ctx), '/')) {
+			tokenIsChar(css__token_vector_peek(vector, *ctx), '/')) {
 		/* ratio */
 		error = mq_parse_ratio(vector, ctx, name_or_value, &ratio);
 		if (error != CSS_OK) {
@@ -307,7 +311,7 @@ static css_error mq_parse_range(lwc_string **strings,
 	}
 
 	/* Op */
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 	error = mq_parse_op(token, &op);
 	if (error != CSS_OK) {
 		return error;
@@ -316,7 +320,7 @@ static css_error mq_parse_range(lwc_string **strings,
 	consumeWhitespace(vector, ctx);
 
 	/* Value-or-name */
-	value_or_name = parserutils_vector_iterate(vector, ctx);
+	value_or_name = css__token_vector_iterate(vector, ctx);
 	if (value_or_name == NULL || (value_or_name->type != CSS_TOKEN_NUMBER &&
 			value_or_name->type != CSS_TOKEN_DIMENSION &&
 			value_or_name->type != CSS_TOKEN_IDENT)) {
@@ -334,7 +338,7 @@ static css_error mq_parse_range(lwc_string **strings,
 	consumeWhitespace(vector, ctx);
 
 	if (value_or_name->type == CSS_TOKEN_NUMBER &&
-			tokenIsChar(parserutils_vector_peek(vector, *ctx), '/')) {
+			tokenIsChar(css__token_vector_peek(vector, *ctx), '/')) {
 		/* ratio */
 		error = mq_parse_ratio(vector, ctx, token, &ratio);
 		if (error != CSS_OK) {
@@ -346,10 +350,10 @@ static css_error mq_parse_range(lwc_string **strings,
 		value_is_ratio = true;
 	}
 
-	token = parserutils_vector_peek(vector, *ctx);
+	token = css__token_vector_peek(vector, *ctx);
 	if (name_first == false && token != NULL && tokenIsChar(token, ')') == false) {
 		/* Op2 */
-		token = parserutils_vector_iterate(vector, ctx);
+		token = css__token_vector_iterate(vector, ctx);
 		error = mq_parse_op(token, &op2);
 		if (error != CSS_OK) {
 			return error;
@@ -371,7 +375,7 @@ static css_error mq_parse_range(lwc_string **strings,
 		}
 
 		/* Value2 */
-		value2 = parserutils_vector_iterate(vector, ctx);
+		value2 = css__token_vector_iterate(vector, ctx);
 		if (value2 == NULL || (value2->type != CSS_TOKEN_NUMBER &&
 				value2->type != CSS_TOKEN_DIMENSION &&
 				value2->type != CSS_TOKEN_IDENT)) {
@@ -381,7 +385,7 @@ static css_error mq_parse_range(lwc_string **strings,
 		consumeWhitespace(vector, ctx);
 
 		if (value_or_name->type == CSS_TOKEN_NUMBER &&
-				tokenIsChar(parserutils_vector_peek(vector, *ctx), '/')) {
+				tokenIsChar(css__token_vector_peek(vector, *ctx), '/')) {
 			/* ratio */
 			error = mq_parse_ratio(vector, ctx, token, &ratio2);
 			if (error != CSS_OK) {
@@ -443,7 +447,7 @@ static css_error mq_parse_range(lwc_string **strings,
 }
 
 static css_error mq_parse_media_feature(lwc_string **strings,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_mq_feature **feature)
 {
 	const css_token *name_or_value, *token;
@@ -461,14 +465,14 @@ static css_error mq_parse_media_feature(lwc_string **strings,
 
 	consumeWhitespace(vector, ctx);
 
-	name_or_value = parserutils_vector_iterate(vector, ctx);
+	name_or_value = css__token_vector_iterate(vector, ctx);
 	if (name_or_value == NULL)
 		return CSS_INVALID;
 
 	if (name_or_value->type == CSS_TOKEN_IDENT) {
 		consumeWhitespace(vector, ctx);
 
-		token = parserutils_vector_peek(vector, *ctx);
+		token = css__token_vector_peek(vector, *ctx);
 		if (tokenIsChar(token, ')')) {
 			/* mf-boolean */
 			error = mq_create_feature(name_or_value->idata, &result);
@@ -479,11 +483,11 @@ static css_error mq_parse_media_feature(lwc_string **strings,
 			result->op = CSS_MQ_FEATURE_OP_BOOL;
 		} else if (tokenIsChar(token, ':')) {
 			/* mf-plain */
-			parserutils_vector_iterate(vector, ctx);
+			css__token_vector_iterate(vector, ctx);
 
 			consumeWhitespace(vector, ctx);
 
-			token = parserutils_vector_iterate(vector, ctx);
+			token = css__token_vector_iterate(vector, ctx);
 			if (token == NULL || (token->type != CSS_TOKEN_NUMBER &&
 					token->type != CSS_TOKEN_DIMENSION &&
 					token->type != CSS_TOKEN_IDENT)) {
@@ -499,7 +503,7 @@ static css_error mq_parse_media_feature(lwc_string **strings,
 			result->op = CSS_MQ_FEATURE_OP_EQ;
 
 			if (token->type == CSS_TOKEN_NUMBER &&
-					tokenIsChar(parserutils_vector_peek(vector, *ctx), '/')) {
+					tokenIsChar(css__token_vector_peek(vector, *ctx), '/')) {
 				/* ratio */
 				css_fixed ratio;
 
@@ -548,7 +552,7 @@ static css_error mq_parse_media_feature(lwc_string **strings,
 		consumeWhitespace(vector, ctx);
 	}
 
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 	if (tokenIsChar(token, ')') == false) {
 		css__mq_feature_destroy(result);
 		return CSS_INVALID;
@@ -565,7 +569,7 @@ static css_error mq_parse_media_feature(lwc_string **strings,
  * CSS Syntax Module Level 3: 8.2
  */
 static css_error mq_parse_consume_any_value(lwc_string **strings,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		bool until, const char until_char)
 {
 	const css_token *token;
@@ -574,7 +578,7 @@ static css_error mq_parse_consume_any_value(lwc_string **strings,
 	while (true) {
 		consumeWhitespace(vector, ctx);
 
-		token = parserutils_vector_iterate(vector, ctx);
+		token = css__token_vector_iterate(vector, ctx);
 		if (token == NULL) {
 			return CSS_INVALID;
 		}
@@ -627,7 +631,7 @@ static css_error mq_parse_consume_any_value(lwc_string **strings,
 }
 
 static css_error mq_parse_general_enclosed(lwc_string **strings,
-		const parserutils_vector *vector, int32_t *ctx)
+		const css_token_vector *vector, int32_t *ctx)
 {
 	const css_token *token;
 	css_error error;
@@ -636,7 +640,7 @@ static css_error mq_parse_general_enclosed(lwc_string **strings,
 	 *                    | ( <ident> <any-value> )
 	 */
 
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 	if (token == NULL) {
 		return CSS_INVALID;
 	}
@@ -649,7 +653,7 @@ static css_error mq_parse_general_enclosed(lwc_string **strings,
 			return error;
 		}
 
-		token = parserutils_vector_peek(vector, *ctx);
+		token = css__token_vector_peek(vector, *ctx);
 		if (!tokenIsChar(token, ')')) {
 			return CSS_INVALID;
 		}
@@ -671,7 +675,7 @@ static css_error mq_parse_general_enclosed(lwc_string **strings,
 }
 
 static css_error mq_parse_media_in_parens(lwc_string **strings,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_mq_cond_or_feature **cond_or_feature)
 {
 	const css_token *token;
@@ -687,14 +691,14 @@ static css_error mq_parse_media_in_parens(lwc_string **strings,
 	//	  "not" or LPAREN -> condition
 	//	  IDENT | NUMBER | DIMENSION | RATIO -> feature
 
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 	if (token == NULL || tokenIsChar(token, '(') == false) {
 		return CSS_INVALID;
 	}
 
 	consumeWhitespace(vector, ctx);
 
-	token = parserutils_vector_peek(vector, *ctx);
+	token = css__token_vector_peek(vector, *ctx);
 	if (token == NULL) {
 		return CSS_INVALID;
 	}
@@ -708,7 +712,7 @@ static css_error mq_parse_media_in_parens(lwc_string **strings,
 		css_mq_cond *cond;
 		error = mq_parse_condition(strings, vector, ctx, true, &cond);
 		if (error == CSS_OK) {
-			token = parserutils_vector_iterate(vector, ctx);
+			token = css__token_vector_iterate(vector, ctx);
 			if (tokenIsChar(token, ')') == false) {
 				return CSS_INVALID;
 			}
@@ -754,7 +758,7 @@ static css_error mq_parse_media_in_parens(lwc_string **strings,
 }
 
 static css_error mq_parse_condition(lwc_string **strings,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		bool permit_or, css_mq_cond **cond)
 {
 	const css_token *token;
@@ -771,7 +775,7 @@ static css_error mq_parse_condition(lwc_string **strings,
 	 * <media-or> = or <media-in-parens>
 	 */
 
-	token = parserutils_vector_peek(vector, *ctx);
+	token = css__token_vector_peek(vector, *ctx);
 	if (token == NULL ||
 			(tokenIsChar(token, '(') == false &&
 			token->type != CSS_TOKEN_IDENT &&
@@ -789,7 +793,7 @@ static css_error mq_parse_condition(lwc_string **strings,
 
 	if (tokenIsChar(token, '(') == false) {
 		/* Must be "not" */
-		parserutils_vector_iterate(vector, ctx);
+		css__token_vector_iterate(vector, ctx);
 		consumeWhitespace(vector, ctx);
 
 		error = mq_parse_media_in_parens(strings,
@@ -837,7 +841,7 @@ static css_error mq_parse_condition(lwc_string **strings,
 
 		consumeWhitespace(vector, ctx);
 
-		token = parserutils_vector_peek(vector, *ctx);
+		token = css__token_vector_peek(vector, *ctx);
 		if (token != NULL && tokenIsChar(token, ')') == false &&
 				tokenIsChar(token, ',') == false) {
 			if (token->type != CSS_TOKEN_IDENT) {
@@ -865,7 +869,7 @@ static css_error mq_parse_condition(lwc_string **strings,
 				return CSS_INVALID;
 			}
 
-			parserutils_vector_iterate(vector, ctx);
+			css__token_vector_iterate(vector, ctx);
 			consumeWhitespace(vector, ctx);
 		}
 	}
@@ -959,7 +963,7 @@ static css_error mq_parse_type(lwc_string **strings, lwc_string *type,
 }
 
 static css_error mq_parse_media_query(lwc_string **strings,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_mq_query **query)
 {
 	const css_token *token;
@@ -977,7 +981,7 @@ static css_error mq_parse_media_query(lwc_string **strings,
 
 	consumeWhitespace(vector, ctx);
 
-	token = parserutils_vector_peek(vector, *ctx);
+	token = css__token_vector_peek(vector, *ctx);
 	if (tokenIsChar(token, '(')) {
 		is_condition = true;
 	} else if (token->type == CSS_TOKEN_IDENT &&
@@ -986,10 +990,10 @@ static css_error mq_parse_media_query(lwc_string **strings,
 				match) {
 		int32_t old_ctx = *ctx;
 
-		parserutils_vector_iterate(vector, ctx);
+		css__token_vector_iterate(vector, ctx);
 		consumeWhitespace(vector, ctx);
 
-		token = parserutils_vector_peek(vector, *ctx);
+		token = css__token_vector_peek(vector, *ctx);
 		if (tokenIsChar(token, '(')) {
 			is_condition = true;
 		}
@@ -1016,7 +1020,7 @@ static css_error mq_parse_media_query(lwc_string **strings,
 		goto finished;
 	}
 
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 	if (token == NULL || token->type != CSS_TOKEN_IDENT) {
 		free(result);
 		return CSS_INVALID;
@@ -1026,11 +1030,11 @@ static css_error mq_parse_media_query(lwc_string **strings,
 			strings[NOT], &match) == lwc_error_ok && match) {
 		result->negate_type = 1;
 		consumeWhitespace(vector, ctx);
-		token = parserutils_vector_iterate(vector, ctx);
+		token = css__token_vector_iterate(vector, ctx);
 	} else if (lwc_string_caseless_isequal(token->idata,
 			strings[ONLY], &match) == lwc_error_ok && match) {
 		consumeWhitespace(vector, ctx);
-		token = parserutils_vector_iterate(vector, ctx);
+		token = css__token_vector_iterate(vector, ctx);
 	}
 
 	if (token == NULL || token->type != CSS_TOKEN_IDENT) {
@@ -1046,7 +1050,7 @@ static css_error mq_parse_media_query(lwc_string **strings,
 
 	consumeWhitespace(vector, ctx);
 
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 	if (token != NULL) {
 		if (token->type != CSS_TOKEN_IDENT ||
 				lwc_string_caseless_isequal(token->idata,
@@ -1100,7 +1104,7 @@ static css_error css__mq_parse__create_not_all(
 }
 
 css_error css__mq_parse_media_list(lwc_string **strings,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_mq_query **media)
 {
 	css_mq_query *result = NULL, *last = NULL;
@@ -1116,7 +1120,7 @@ css_error css__mq_parse_media_list(lwc_string **strings,
 	 * if comma, consume, and start again from the next input token
 	 */
 
-	token = parserutils_vector_peek(vector, *ctx);
+	token = css__token_vector_peek(vector, *ctx);
 	while (token != NULL) {
 		css_mq_query *query = NULL;
 
@@ -1140,7 +1144,7 @@ css_error css__mq_parse_media_list(lwc_string **strings,
 
 		consumeWhitespace(vector, ctx);
 
-		token = parserutils_vector_iterate(vector, ctx);
+		token = css__token_vector_iterate(vector, ctx);
 		if (token != NULL && tokenIsChar(token, ',') == false) {
 			/* Give up */
 			break;
@@ -1159,7 +1163,7 @@ typedef struct css_mq_parse_ctx {
 
 static css_error css_parse_media_query_handle_event(
 		css_parser_event type,
-		const parserutils_vector *tokens,
+		const css_token_vector *tokens,
 		void *pw)
 {
 	int32_t idx = 0;
@@ -1172,12 +1176,12 @@ static css_error css_parse_media_query_handle_event(
 	UNUSED(type);
 
 	/* Skip @media */
-	tok = parserutils_vector_iterate(tokens, &idx);
+	tok = css__token_vector_iterate(tokens, &idx);
 	assert(tok->type == CSS_TOKEN_ATKEYWORD);
 	UNUSED(tok);
 
 	/* Skip whitespace */
-	tok = parserutils_vector_iterate(tokens, &idx);
+	tok = css__token_vector_iterate(tokens, &idx);
 	assert(tok->type == CSS_TOKEN_S);
 	UNUSED(tok);
 
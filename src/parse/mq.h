@@ -8,7 +8,6 @@
 #ifndef css_parse_mq_h_
 #define css_parse_mq_h_
 
-#include <parserutils/utils/vector.h>
 #include "parse/language.h"
 
 typedef struct {
@@ -88,7 +87,7 @@ css_error css_parse_media_query(lwc_string **strings,
 		css_mq_query **media_out);
 
 css_error css__mq_parse_media_list(lwc_string **strings,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_mq_query **media);
 
 void css__mq_query_destroy(css_mq_query *media);
@@ -8,12 +8,14 @@
 #include <assert.h>
 #include <ctype.h>
 #include <stdbool.h>
+#include <string.h>
 
 #include <libwapcaplet/libwapcaplet.h>
 
+#include <parserutils/charset/mibenum.h>
+#include <parserutils/charset/utf8.h>
 #include <parserutils/input/inputstream.h>
 #include <parserutils/utils/stack.h>
-#include <parserutils/utils/vector.h>
 
 #include "charset/detect.h"
 #include "lex/lex.h"
@@ -28,13 +30,13 @@
 #include <stdio.h>
 extern void parserutils_stack_dump(parserutils_stack *stack, const char *prefix,
 		void (*printer)(void *item));
-extern void parserutils_vector_dump(parserutils_vector *vector,
-		const char *prefix, void (*printer)(void *item));
 #ifdef DEBUG_STACK
 static void printer(void *item);
 #endif
 #ifdef DEBUG_EVENTS
 static void tprinter(void *token);
+static void dump_tokens(const css_token_vector *vector, const char *prefix,
+		void (*printer)(void *item));
 #endif
 #endif
 
@@ -80,6 +82,17 @@ typedef struct parser_state
 	             substate : 16;
 } parser_state;
 
+/**
+ * Chunk of storage for the text of tokens that are not interned
+ */
+typedef struct token_text
+{
+	struct token_text *next;	/**< Next chunk */
+	size_t used;			/**< Bytes of data in use */
+	size_t size;			/**< Bytes of data allocated */
+	uint8_t data[];			/**< Token text */
+} token_text;
+
 /**
  * CSS parser object
  */
@@ -88,12 +101,18 @@ struct css_parser
 	parserutils_inputstream *stream;	/**< The inputstream */
 	css_lexer *lexer;		/**< The lexer to use */
 
+	bool appended;			/**< Data has been appended to the
+					 * inputstream */
+
 	bool quirks;			/**< Whether to enable parsing quirks */
 
 #define STACK_CHUNK 32
 	parserutils_stack *states;	/**< Stack of states */
 
-	parserutils_vector *tokens;	/**< Vector of pending tokens */
+	css_token_vector tokens;	/**< Vector of pending tokens */
+#define TEXT_CHUNK 1024
+	token_text *text;		/**< Text of pending tokens that are
+					 * not interned */
 
 	const css_token *pushback;	/**< Push back buffer */
 
@@ -110,12 +129,17 @@ static css_error css__parser_create_internal(const char *charset,
 		css_charset_source cs_source, parser_state initial,
 		css_parser **parser);
 
+static bool isValidUTF8(const uint8_t *data, size_t len);
+
 static css_error transition(css_parser *parser, parser_state to,
 		parser_state subsequent);
 static css_error transitionNoRet(css_parser *parser, parser_state to);
 static css_error done(css_parser *parser);
 static css_error expect(css_parser *parser, css_token_type type);
 static css_error getToken(css_parser *parser, const css_token **token);
+static css_error appendToken(css_parser *parser, const css_token *token);
+static css_error keepTokenText(css_parser *parser, css_token *token);
+static void resetTokenText(css_parser *parser);
 static css_error pushBack(css_parser *parser, const css_token *token);
 static css_error eatWS(css_parser *parser);
 
@@ -252,7 +276,14 @@ css_error css__parser_destroy(css_parser *parser)
 
 	parserutils_stack_destroy(parser->open_items);
 
-	parserutils_vector_destroy(parser->tokens);
+	free(parser->tokens.items);
+
+	while (parser->text != NULL) {
+		token_text *next = parser->text->next;
+
+		free(parser->text);
+		parser->text = next;
+	}
 
 	parserutils_stack_destroy(parser->states);
 
@@ -314,6 +345,8 @@ css_error css__parser_parse_chunk(css_parser *parser, const uint8_t *data,
 	if (perror != PARSERUTILS_OK)
 		return css_error_from_parserutils_error(perror);
 
+	parser->appended = true;
+
 	do {
 		state = parserutils_stack_get_current(parser->states);
 		if (state == NULL)
@@ -357,6 +390,92 @@ css_error css__parser_completed(css_parser *parser)
 	return error;
 }
 
+/**
+ * Parse a complete stylesheet held in a single buffer
+ *
+ * \param parser  The parser to use
+ * \param data    Pointer to the data to parse
+ * \param len     Length of data
+ * \return CSS_OK on success, appropriate error otherwise
+ *
+ * This is equivalent to css__parser_parse_chunk() followed by
+ * css__parser_completed(). However, if no data has previously been given
+ * to the parser, and the data is valid UTF-8 and not otherwise labelled,
+ * then the lexer reads it in place, rather than having it copied through
+ * the inputstream. The data need only remain valid until this returns.
+ */
+css_error css__parser_parse_buffer(css_parser *parser, const uint8_t *data,
+		size_t len)
+{
+	css_lexer_optparams params;
+	parserutils_error perror;
+	parser_state *state;
+	const char *charset;
+	uint16_t mibenum = 0;
+	uint32_t source;
+	css_error error = CSS_OK;
+
+	if (parser == NULL || data == NULL)
+		return CSS_BADPARM;
+
+	if (parser->appended)
+		goto copy;
+
+	/* Determine the charset just as the inputstream would */
+	charset = parserutils_inputstream_read_charset(parser->stream,
+			&source);
+	if (charset != NULL)
+		mibenum = parserutils_charset_mibenum_from_name(charset,
+				strlen(charset));
+
+	perror = css__charset_extract(data, len, &mibenum, &source);
+	if (perror != PARSERUTILS_OK || mibenum !=
+			parserutils_charset_mibenum_from_name("UTF-8",
+					SLEN("UTF-8")))
+		goto copy;
+
+	/* The inputstream strips any byte order mark */
+	if (len >= 3 && data[0] == 0xEF && data[1] == 0xBB && data[2] == 0xBF) {
+		data += 3;
+		len -= 3;
+	}
+
+	if (isValidUTF8(data, len) == false)
+		goto copy;
+
+	/* Record the charset for css__parser_read_charset() */
+	perror = parserutils_inputstream_change_charset(parser->stream,
+			"UTF-8", source);
+	if (perror != PARSERUTILS_OK)
+		goto copy;
+
+	params.buffer.data = data;
+	params.buffer.len = len;
+	error = css__lexer_setopt(parser->lexer, CSS_LEXER_BUFFER, &params);
+	if (error != CSS_OK)
+		goto copy;
+
+	parser->appended = true;
+
+	/* The lexer sees EOF at the end of the buffer */
+	do {
+		state = parserutils_stack_get_current(parser->states);
+		if (state == NULL)
+			break;
+
+		error = parseFuncs[state->state](parser);
+	} while (error == CSS_OK);
+
+	return error;
+
+copy:
+	error = css__parser_parse_chunk(parser, data, len);
+	if (error != CSS_OK && error != CSS_NEEDDATA)
+		return error;
+
+	return css__parser_completed(parser);
+}
+
 /**
  * Retrieve document charset information from a CSS parser
  *
@@ -444,20 +563,21 @@ css_error css__parser_create_internal(const char *charset,
 		return css_error_from_parserutils_error(perror);
 	}
 
-	perror = parserutils_vector_create(sizeof(css_token),
-			STACK_CHUNK, &p->tokens);
-	if (perror != PARSERUTILS_OK) {
+	p->tokens.items = malloc(STACK_CHUNK * sizeof(css_token));
+	if (p->tokens.items == NULL) {
 		parserutils_stack_destroy(p->states);
 		css__lexer_destroy(p->lexer);
 		parserutils_inputstream_destroy(p->stream);
 		free(p);
-		return css_error_from_parserutils_error(perror);
+		return CSS_NOMEM;
 	}
+	p->tokens.length = 0;
+	p->tokens.alloc = STACK_CHUNK;
 
 	perror = parserutils_stack_create(sizeof(char),
 			STACK_CHUNK, &p->open_items);
 	if (perror != PARSERUTILS_OK) {
-		parserutils_vector_destroy(p->tokens);
+		free(p->tokens.items);
 		parserutils_stack_destroy(p->states);
 		css__lexer_destroy(p->lexer);
 		parserutils_inputstream_destroy(p->stream);
@@ -468,7 +588,7 @@ css_error css__parser_create_internal(const char *charset,
 	perror = parserutils_stack_push(p->states, (void *) &initial);
 	if (perror != PARSERUTILS_OK) {
 		parserutils_stack_destroy(p->open_items);
-		parserutils_vector_destroy(p->tokens);
+		free(p->tokens.items);
 		parserutils_stack_destroy(p->states);
 		css__lexer_destroy(p->lexer);
 		parserutils_inputstream_destroy(p->stream);
@@ -476,6 +596,8 @@ css_error css__parser_create_internal(const char *charset,
 		return css_error_from_parserutils_error(perror);
 	}
 
+	p->appended = false;
+	p->text = NULL;
 	p->quirks = false;
 	p->pushback = NULL;
 	p->parseError = false;
@@ -492,6 +614,36 @@ css_error css__parser_create_internal(const char *charset,
  * Helper functions                                                           *
  ******************************************************************************/
 
+/**
+ * Determine whether data is valid UTF-8
+ *
+ * \param data  Pointer to data
+ * \param len   Length of data
+ * \return True if the data is entirely valid UTF-8, false otherwise
+ */
+bool isValidUTF8(const uint8_t *data, size_t len)
+{
+	const uint8_t *end = data + len;
+
+	while (data < end) {
+		uint32_t ucs4;
+		size_t clen;
+
+		if (*data < 0x80) {
+			data++;
+			continue;
+		}
+
+		if (parserutils_charset_utf8_to_ucs4(data, end - data,
+				&ucs4, &clen) != PARSERUTILS_OK)
+			return false;
+
+		data += clen;
+	}
+
+	return true;
+}
+
 /**
  * Transition to a new state, ensuring return to the one specified
  *
@@ -608,7 +760,6 @@ css_error expect(css_parser *parser, css_token_type type)
  */
 css_error getToken(css_parser *parser, const css_token **token)
 {
-	parserutils_error perror;
         lwc_error lerror;
 	css_error error;
 
@@ -620,6 +771,10 @@ css_error getToken(css_parser *parser, const css_token **token)
 		/* Otherwise, ask the lexer */
 		css_token *t;
 
+		/* No pending token refers to token text if none remain */
+		if (parser->tokens.length == 0)
+			resetTokenText(parser);
+
 		error = css__lexer_get_token(parser->lexer, &t);
 		if (error != CSS_OK)
 			return error;
@@ -636,11 +791,17 @@ css_error getToken(css_parser *parser, const css_token **token)
 		 *
 		 * CSS_TOKEN_IDENT, CSS_TOKEN_ATKEYWORD, CSS_TOKEN_STRING,
 		 * CSS_TOKEN_INVALID_STRING, CSS_TOKEN_HASH, CSS_TOKEN_URI,
-		 * CSS_TOKEN_UNICODE_RANGE?, CSS_TOKEN_FUNCTION, CSS_TOKEN_CHAR,
-		 * CSS_TOKEN_NUMBER, CSS_TOKEN_PERCENTAGE, CSS_TOKEN_DIMENSION
+		 * CSS_TOKEN_UNICODE_RANGE?, CSS_TOKEN_FUNCTION
 		 *
 		 * These token types all appear before CSS_TOKEN_LAST_INTERN.
-		 * All other token types appear after this magic value.
+		 *
+		 * The text of CSS_TOKEN_CHAR, CSS_TOKEN_NUMBER,
+		 * CSS_TOKEN_PERCENTAGE and CSS_TOKEN_DIMENSION is only ever
+		 * compared or converted to a number, so is copied rather than
+		 * interned. These appear before CSS_TOKEN_LAST_TEXT.
+		 *
+		 * Either way, the token's data then remains valid for as long
+		 * as the token does, regardless of the inputstream.
 		 */
 
 		if (t->type < CSS_TOKEN_LAST_INTERN && t->data.data != NULL) {
@@ -649,6 +810,15 @@ css_error getToken(css_parser *parser, const css_token **token)
                                                     t->data.len, &t->idata);
                         if (lerror != lwc_error_ok)
                                 return css_error_from_lwc_error(lerror);
+
+			t->data.data = (uint8_t *) lwc_string_data(t->idata);
+		} else if (t->type < CSS_TOKEN_LAST_TEXT &&
+				t->data.data != NULL) {
+			t->idata = NULL;
+
+			error = keepTokenText(parser, t);
+			if (error != CSS_OK)
+				return error;
 		} else {
 			t->idata = NULL;
 		}
@@ -657,16 +827,99 @@ css_error getToken(css_parser *parser, const css_token **token)
 	}
 
 	/* Append token to vector */
-	perror = parserutils_vector_append(parser->tokens,
-			(css_token *) (*token));
-	if (perror != PARSERUTILS_OK)
-		return css_error_from_parserutils_error(perror);
+	error = appendToken(parser, *token);
+	if (error != CSS_OK)
+		return error;
 
 	parser->last_was_ws = ((*token)->type == CSS_TOKEN_S);
 
 	return CSS_OK;
 }
 
+/**
+ * Append a token to the vector of pending tokens
+ *
+ * \param parser  The parser instance
+ * \param token   The token to append
+ * \return CSS_OK on success, CSS_NOMEM on memory exhaustion
+ */
+css_error appendToken(css_parser *parser, const css_token *token)
+{
+	css_token_vector *tokens = &parser->tokens;
+
+	if (tokens->length == tokens->alloc) {
+		/* Pushing a token back frees its slot, so the vector is
+		 * never full when the token being appended is a pushed
+		 * back one, and growing it cannot move the token */
+		css_token *items = realloc(tokens->items,
+				tokens->alloc * 2 * sizeof(css_token));
+		if (items == NULL)
+			return CSS_NOMEM;
+
+		tokens->items = items;
+		tokens->alloc *= 2;
+	}
+
+	tokens->items[tokens->length++] = *token;
+
+	return CSS_OK;
+}
+
+/**
+ * Copy a token's text into storage that lasts as long as the token
+ *
+ * \param parser  The parser instance
+ * \param token   The token, updated to refer to the copy of its text
+ * \return CSS_OK on success, CSS_NOMEM on memory exhaustion
+ */
+css_error keepTokenText(css_parser *parser, css_token *token)
+{
+	token_text *text = parser->text;
+
+	if (text == NULL || text->size - text->used < token->data.len) {
+		size_t size = token->data.len > TEXT_CHUNK ?
+				token->data.len : TEXT_CHUNK;
+
+		text = malloc(sizeof(token_text) + size);
+		if (text == NULL)
+			return CSS_NOMEM;
+
+		text->next = parser->text;
+		text->used = 0;
+		text->size = size;
+
+		parser->text = text;
+	}
+
+	memcpy(text->data + text->used, token->data.data, token->data.len);
+	token->data.data = text->data + text->used;
+	text->used += token->data.len;
+
+	return CSS_OK;
+}
+
+/**
+ * Release the text of all pending tokens, keeping one chunk for reuse
+ *
+ * \param parser  The parser instance
+ */
+void resetTokenText(css_parser *parser)
+{
+	token_text *text = parser->text;
+
+	if (text == NULL)
+		return;
+
+	while (text->next != NULL) {
+		token_text *next = text->next;
+
+		text->next = next->next;
+		free(next);
+	}
+
+	text->used = 0;
+}
+
 /**
  * Push a token back on the input
  *
@@ -676,14 +929,13 @@ css_error getToken(css_parser *parser, const css_token **token)
  */
 css_error pushBack(css_parser *parser, const css_token *token)
 {
-	parserutils_error perror;
-
 	/* The pushback buffer depth is 1 token. Assert this. */
 	assert(parser->pushback == NULL);
 
-	perror = parserutils_vector_remove_last(parser->tokens);
-	if (perror != PARSERUTILS_OK)
-		return css_error_from_parserutils_error(perror);
+	if (parser->tokens.length == 0)
+		return CSS_INVALID;
+
+	parser->tokens.length--;
 
 	parser->pushback = token;
 
@@ -724,7 +976,7 @@ css_error eatWS(css_parser *parser)
  * \return CSS_OK on success, appropriate error otherwise
  */
 static css_error emit(css_parser *parser, css_parser_event type,
-		const parserutils_vector *tokens, bool graceful)
+		const css_token_vector *tokens, bool graceful)
 {
 	css_error error = CSS_OK;
 
@@ -782,7 +1034,7 @@ css_error parseStart(css_parser *parser)
 	}
 
 #if !defined(NDEBUG) && defined(DEBUG_EVENTS)
-	parserutils_vector_dump(parser->tokens, __func__, tprinter);
+	dump_tokens(&parser->tokens, __func__, tprinter);
 	printf("End stylesheet\n");
 #endif
 	error = emit(parser, CSS_PARSER_END_STYLESHEET, NULL, true);
@@ -901,8 +1153,8 @@ css_error parseRuleset(css_parser *parser)
 		 * brace. We're going to assume that that won't happen,
 		 * however. */
 		if (token->type == CSS_TOKEN_CHAR &&
-				lwc_string_length(token->idata) == 1 &&
-				lwc_string_data(token->idata)[0] == '{') {
+				token->data.len == 1 &&
+				token->data.data[0] == '{') {
 #if !defined(NDEBUG) && defined(DEBUG_EVENTS)
 			printf("Begin ruleset\n");
 #endif
@@ -942,8 +1194,8 @@ css_error parseRuleset(css_parser *parser)
 			return error;
 
 		if (token->type != CSS_TOKEN_CHAR ||
-				lwc_string_length(token->idata) != 1 ||
-				lwc_string_data(token->idata)[0] != '{') {
+				token->data.len != 1 ||
+				token->data.data[0] != '{') {
 			/* FOLLOW(selector) contains only '{', but we may
 			 * also have seen EOF, which is a parse error. */
 			error = pushBack(parser, token);
@@ -961,11 +1213,11 @@ css_error parseRuleset(css_parser *parser)
 
 #if !defined(NDEBUG) && defined(DEBUG_EVENTS)
 		printf("Begin ruleset\n");
-		parserutils_vector_dump(parser->tokens, __func__, tprinter);
+		dump_tokens(&parser->tokens, __func__, tprinter);
 #endif
 		if (parser->parseError == false) {
 			error = emit(parser, CSS_PARSER_START_RULESET,
-					parser->tokens, false);
+					&parser->tokens, false);
 			if (error == CSS_INVALID) {
 				parser->parseError = true;
 			} else if (error != CSS_OK) {
@@ -1021,9 +1273,9 @@ css_error parseRulesetEnd(css_parser *parser)
 		 * input at this point and read to the start of the next
 		 * declaration. FIRST(decl-list) = (';', '}') */
 		if (token->type != CSS_TOKEN_CHAR ||
-				lwc_string_length(token->idata) != 1 ||
-				(lwc_string_data(token->idata)[0] != '}' &&
-				lwc_string_data(token->idata)[0] != ';')) {
+				token->data.len != 1 ||
+				(token->data.data[0] != '}' &&
+				token->data.data[0] != ';')) {
 			parser_state to = { sDeclaration, Initial };
 			parser_state subsequent = { sRulesetEnd, DeclList };
 
@@ -1053,8 +1305,8 @@ css_error parseRulesetEnd(css_parser *parser)
 		}
 
 		if (token->type != CSS_TOKEN_CHAR ||
-				lwc_string_length(token->idata) != 1 ||
-				lwc_string_data(token->idata)[0] != '}') {
+				token->data.len != 1 ||
+				token->data.data[0] != '}') {
 			/* This should never happen, as FOLLOW(decl-list)
 			 * contains only '}' */
 			assert(0 && "Expected }");
@@ -1131,10 +1383,9 @@ css_error parseAtRule(css_parser *parser)
 		/* Grammar ambiguity: any0 can be followed by '{',';',')',']'.
 		 * at-rule can only be followed by '{' and ';'. */
 		if (token->type == CSS_TOKEN_CHAR &&
-				lwc_string_length(token->idata) == 1) {
-			if (lwc_string_data(token->idata)[0] == ')' ||
-					lwc_string_data(
-						token->idata)[0] == ']') {
+				token->data.len == 1) {
+			if (token->data.data[0] == ')' ||
+					token->data.data[0] == ']') {
 				parser_state to = { sAny0, Initial };
 				parser_state subsequent = { sAtRule, AfterAny };
 
@@ -1167,9 +1418,9 @@ css_error parseAtRuleEnd(css_parser *parser)
 	case Initial:
 #if !defined(NDEBUG) && defined(DEBUG_EVENTS)
 		printf("Begin at-rule\n");
-		parserutils_vector_dump(parser->tokens, __func__, tprinter);
+		dump_tokens(&parser->tokens, __func__, tprinter);
 #endif
-		error = emit(parser, CSS_PARSER_START_ATRULE, parser->tokens,
+		error = emit(parser, CSS_PARSER_START_ATRULE, &parser->tokens,
 				false);
 		if (error == CSS_INVALID) {
 			parser_state to = { sMalformedAtRule, Initial };
@@ -1192,12 +1443,12 @@ css_error parseAtRuleEnd(css_parser *parser)
 		}
 
 		if (token->type != CSS_TOKEN_CHAR ||
-				lwc_string_length(token->idata) != 1) {
+				token->data.len != 1) {
 			/* Should never happen FOLLOW(at-rule) == '{', ';'*/
 			assert(0 && "Expected { or ;");
 		}
 
-		if (lwc_string_data(token->idata)[0] == '{') {
+		if (token->data.data[0] == '{') {
 			parser_state to = { sBlock, Initial };
 			parser_state subsequent = { sAtRuleEnd, AfterBlock };
 
@@ -1206,7 +1457,7 @@ css_error parseAtRuleEnd(css_parser *parser)
 				return error;
 
 			return transition(parser, to, subsequent);
-		} else if (lwc_string_data(token->idata)[0] != ';') {
+		} else if (token->data.data[0] != ';') {
 			/* Again, should never happen */
 			assert(0 && "Expected ;");
 		}
@@ -1258,8 +1509,8 @@ css_error parseBlock(css_parser *parser)
 		}
 
 		if (token->type != CSS_TOKEN_CHAR ||
-				lwc_string_length(token->idata) != 1 ||
-				lwc_string_data(token->idata)[0] != '{') {
+				token->data.len != 1 ||
+				token->data.data[0] != '{') {
 			/* This should never happen, as FIRST(block) == '{' */
 			assert(0 && "Expected {");
 		}
@@ -1296,8 +1547,8 @@ css_error parseBlock(css_parser *parser)
 		}
 
 		if (token->type != CSS_TOKEN_CHAR ||
-				lwc_string_length(token->idata) != 1 ||
-				lwc_string_data(token->idata)[0] != '}') {
+				token->data.len != 1 ||
+				token->data.data[0] != '}') {
 			/* This should never happen, as
 			 * FOLLOW(block-content) == '}' */
 			assert(0 && "Expected }");
@@ -1350,9 +1601,8 @@ css_error parseBlockContent(css_parser *parser)
 			if (token->type == CSS_TOKEN_ATKEYWORD) {
 				state->substate = WS;
 			} else if (token->type == CSS_TOKEN_CHAR) {
-				if (lwc_string_length(token->idata) == 1 &&
-						lwc_string_data(
-						token->idata)[0] == '{') {
+				if (token->data.len == 1 &&
+						token->data.data[0] == '{') {
 					/* Grammar ambiguity. Assume block */
 					parser_state to = { sBlock, Initial };
 					parser_state subsequent =
@@ -1363,12 +1613,12 @@ css_error parseBlockContent(css_parser *parser)
 						return error;
 
 #if !defined(NDEBUG) && defined(DEBUG_EVENTS)
-					parserutils_vector_dump(parser->tokens,
+					dump_tokens(&parser->tokens,
 							__func__, tprinter);
 #endif
 					error = emit(parser,
 							CSS_PARSER_BLOCK_CONTENT,
-							parser->tokens, true);
+							&parser->tokens, true);
 					if (error != CSS_OK) {
 						return error;
 					}
@@ -1377,22 +1627,20 @@ css_error parseBlockContent(css_parser *parser)
 
 					return transition(parser, to,
 							subsequent);
-				} else if (lwc_string_length(
-						token->idata) == 1 &&
-						lwc_string_data(
-						token->idata)[0] == ';') {
+				} else if (token->data.len == 1 &&
+						token->data.data[0] == ';') {
 					/* Grammar ambiguity. Assume semi */
 					error = pushBack(parser, token);
 					if (error != CSS_OK)
 						return error;
 
 #if !defined(NDEBUG) && defined(DEBUG_EVENTS)
-					parserutils_vector_dump(parser->tokens,
+					dump_tokens(&parser->tokens,
 							__func__, tprinter);
 #endif
 					error = emit(parser,
 							CSS_PARSER_BLOCK_CONTENT,
-							parser->tokens, true);
+							&parser->tokens, true);
 					if (error != CSS_OK) {
 						return error;
 					}
@@ -1404,22 +1652,20 @@ css_error parseBlockContent(css_parser *parser)
 					discard_tokens(parser);
 
 					state->substate = WS;
-				} else if (lwc_string_length(
-						token->idata) == 1 &&
-						lwc_string_data(
-						token->idata)[0] == '}') {
+				} else if (token->data.len == 1 &&
+						token->data.data[0] == '}') {
 					/* Grammar ambiguity. Assume end */
 					error = pushBack(parser, token);
 					if (error != CSS_OK)
 						return error;
 
 #if !defined(NDEBUG) && defined(DEBUG_EVENTS)
-					parserutils_vector_dump(parser->tokens,
+					dump_tokens(&parser->tokens,
 							__func__, tprinter);
 #endif
 					error = emit(parser,
 							CSS_PARSER_END_BLOCK_CONTENT,
-							parser->tokens, true);
+							&parser->tokens, true);
 					if (error != CSS_OK) {
 						return error;
 					}
@@ -1434,11 +1680,11 @@ css_error parseBlockContent(css_parser *parser)
 					return error;
 
 #if !defined(NDEBUG) && defined(DEBUG_EVENTS)
-				parserutils_vector_dump(parser->tokens,
+				dump_tokens(&parser->tokens,
 						__func__, tprinter);
 #endif
 				error = emit(parser, CSS_PARSER_BLOCK_CONTENT,
-						parser->tokens, true);
+						&parser->tokens, true);
 				if (error != CSS_OK) {
 					return error;
 				}
@@ -1538,8 +1784,8 @@ css_error parseDeclaration(css_parser *parser)
 		}
 
 		if (token->type != CSS_TOKEN_CHAR ||
-				lwc_string_length(token->idata) != 1 ||
-				lwc_string_data(token->idata)[0] != ':') {
+				token->data.len != 1 ||
+				token->data.data[0] != ':') {
 			/* parse error -- expected : */
 			parser_state to = { sMalformedDecl, Initial };
 
@@ -1573,9 +1819,9 @@ css_error parseDeclaration(css_parser *parser)
 		}
 
 #if !defined(NDEBUG) && defined(DEBUG_EVENTS)
-		parserutils_vector_dump(parser->tokens, __func__, tprinter);
+		dump_tokens(&parser->tokens, __func__, tprinter);
 #endif
-		error = emit(parser, CSS_PARSER_DECLARATION, parser->tokens,
+		error = emit(parser, CSS_PARSER_DECLARATION, &parser->tokens,
 				true);
 		if (error != CSS_OK) {
 			return error;
@@ -1613,14 +1859,14 @@ css_error parseDeclList(css_parser *parser)
 		}
 
 		if (token->type != CSS_TOKEN_CHAR ||
-				lwc_string_length(token->idata) != 1 ||
-				(lwc_string_data(token->idata)[0] != '}' &&
-				lwc_string_data(token->idata)[0] != ';')) {
+				token->data.len != 1 ||
+				(token->data.data[0] != '}' &&
+				token->data.data[0] != ';')) {
 			/* Should never happen */
 			assert(0 && "Expected ; or  }");
 		}
 
-		if (lwc_string_data(token->idata)[0] == '}') {
+		if (token->data.data[0] == '}') {
 			error = pushBack(parser, token);
 			if (error != CSS_OK)
 				return error;
@@ -1662,9 +1908,9 @@ css_error parseDeclListEnd(css_parser *parser)
 			return error;
 
 		if (token->type != CSS_TOKEN_CHAR ||
-				lwc_string_length(token->idata) != 1 ||
-				(lwc_string_data(token->idata)[0] != ';' &&
-				lwc_string_data(token->idata)[0] != '}')) {
+				token->data.len != 1 ||
+				(token->data.data[0] != ';' &&
+				token->data.data[0] != '}')) {
 			parser_state to = { sDeclaration, Initial };
 			parser_state subsequent =
 					{ sDeclListEnd, AfterDeclaration };
@@ -1758,9 +2004,9 @@ css_error parseValue1(css_parser *parser)
 
 		/* Grammar ambiguity -- assume ';' or '}' mark end */
 		if (token->type == CSS_TOKEN_CHAR &&
-				lwc_string_length(token->idata) == 1 &&
-				(lwc_string_data(token->idata)[0] == ';' ||
-				lwc_string_data(token->idata)[0] == '}')) {
+				token->data.len == 1 &&
+				(token->data.data[0] == ';' ||
+				token->data.data[0] == '}')) {
 			/* Parse error */
 			parser->parseError = true;
 
@@ -1809,12 +2055,9 @@ css_error parseValue0(css_parser *parser)
 
 			/* Grammar ambiguity -- assume ';' or '}' mark end */
 			if (token->type == CSS_TOKEN_CHAR &&
-					lwc_string_length(
-						token->idata) == 1 &&
-					(lwc_string_data(
-						token->idata)[0] == ';' ||
-					lwc_string_data(
-						token->idata)[0] == '}')) {
+					token->data.len == 1 &&
+					(token->data.data[0] == ';' ||
+					token->data.data[0] == '}')) {
 				return done(parser);
 			}
 
@@ -1854,8 +2097,8 @@ css_error parseValue(css_parser *parser)
 		if (token->type == CSS_TOKEN_ATKEYWORD) {
 			state->substate = WS;
 		} else if (token->type == CSS_TOKEN_CHAR &&
-				lwc_string_length(token->idata) == 1 &&
-				lwc_string_data(token->idata)[0] == '{') {
+				token->data.len == 1 &&
+				token->data.data[0] == '{') {
 			/* Grammar ambiguity. Assume block. */
 			parser_state to = { sBlock, Initial };
 
@@ -1918,16 +2161,11 @@ css_error parseAny0(css_parser *parser)
 			/* Grammar ambiguity:
 			 * assume '{', ';', ')', ']' mark end */
 			if (token->type == CSS_TOKEN_CHAR &&
-					lwc_string_length(
-						token->idata) == 1 &&
-					(lwc_string_data(
-						token->idata)[0] == '{' ||
-					lwc_string_data(
-						token->idata)[0] == ';' ||
-					lwc_string_data(
-						token->idata)[0] == ')' ||
-					lwc_string_data(
-						token->idata)[0] == ']')) {
+					token->data.len == 1 &&
+					(token->data.data[0] == '{' ||
+					token->data.data[0] == ';' ||
+					token->data.data[0] == ')' ||
+					token->data.data[0] == ']')) {
 				return done(parser);
 			}
 
@@ -1991,17 +2229,15 @@ css_error parseAny1(css_parser *parser)
 		/* Grammar ambiguity: any0 can be followed by
 		 * '{', ';', ')', ']'. any1 can only be followed by '{'. */
 		if (token->type == CSS_TOKEN_CHAR &&
-				lwc_string_length(token->idata) == 1) {
-			if (lwc_string_data(token->idata)[0] == ';' ||
-					lwc_string_data(
-						token->idata)[0] == ')' ||
-					lwc_string_data(
-						token->idata)[0] == ']') {
+				token->data.len == 1) {
+			if (token->data.data[0] == ';' ||
+					token->data.data[0] == ')' ||
+					token->data.data[0] == ']') {
 				parser_state to = { sAny, Initial };
 				parser_state subsequent = { sAny1, AfterAny };
 
 				return transition(parser, to, subsequent);
-			} else if (lwc_string_data(token->idata)[0] != '{') {
+			} else if (token->data.data[0] != '{') {
 				/* parse error */
 				parser->parseError = true;
 			}
@@ -2071,12 +2307,11 @@ css_error parseAny(css_parser *parser)
 			parserutils_stack_push(parser->open_items, &")"[0]);
 			state->substate = WS;
 		} else if (token->type == CSS_TOKEN_CHAR &&
-				lwc_string_length(token->idata) == 1 &&
-				(lwc_string_data(token->idata)[0] == '(' ||
-				lwc_string_data(token->idata)[0] == '[')) {
+				token->data.len == 1 &&
+				(token->data.data[0] == '(' ||
+				token->data.data[0] == '[')) {
 			parserutils_stack_push(parser->open_items,
-					&(lwc_string_data(
-					token->idata)[0] == '(' ? ")" : "]")[0]);
+					&(token->data.data[0] == '(' ? ")" : "]")[0]);
 			state->substate = WS;
 		} else {
 			state->substate = WS2;
@@ -2120,8 +2355,8 @@ css_error parseAny(css_parser *parser)
 
 		/* Match correct close bracket (grammar ambiguity) */
 		if (token->type == CSS_TOKEN_CHAR &&
-				lwc_string_length(token->idata) == 1 &&
-				lwc_string_data(token->idata)[0] ==
+				token->data.len == 1 &&
+				token->data.data[0] ==
 				((uint8_t *) parserutils_stack_get_current(
 						parser->open_items))[0]) {
 			parserutils_stack_pop(parser->open_items, NULL);
@@ -2174,8 +2409,8 @@ css_error parseMalformedDeclaration(css_parser *parser)
 			if (token->type != CSS_TOKEN_CHAR)
 				continue;
 
-			len = lwc_string_length(token->idata);
-			data = lwc_string_data(token->idata);
+			len = token->data.len;
+			data = (const char *) token->data.data;
 
 			if (len != 1 || (data[0] != '{' && data[0] != '}' &&
 					data[0] != '[' && data[0] != ']' &&
@@ -2272,8 +2507,8 @@ css_error parseMalformedSelector(css_parser *parser)
 			if (token->type != CSS_TOKEN_CHAR)
 				continue;
 
-			len = lwc_string_length(token->idata);
-			data = lwc_string_data(token->idata);
+			len = token->data.len;
+			data = (const char *) token->data.data;
 
 			if (len != 1 || (data[0] != '{' && data[0] != '}' &&
 					data[0] != '[' && data[0] != ']' &&
@@ -2370,8 +2605,8 @@ css_error parseMalformedAtRule(css_parser *parser)
 			if (token->type != CSS_TOKEN_CHAR)
 				continue;
 
-			len = lwc_string_length(token->idata);
-			data = lwc_string_data(token->idata);
+			len = token->data.len;
+			data = (const char *) token->data.data;
 
 			if (len != 1 || (data[0] != '{' && data[0] != '}' &&
 					data[0] != '[' && data[0] != ']' &&
@@ -2577,9 +2812,9 @@ css_error parseISBody(css_parser *parser)
 		 * input at this point and read to the start of the next
 		 * declaration. FIRST(decl-list) = (';', '}') */
 		if (token->type != CSS_TOKEN_CHAR ||
-				lwc_string_length(token->idata) != 1 ||
-				(lwc_string_data(token->idata)[0] != '}' &&
-				lwc_string_data(token->idata)[0] != ';')) {
+				token->data.len != 1 ||
+				(token->data.data[0] != '}' &&
+				token->data.data[0] != ';')) {
 			parser_state to = { sDeclaration, Initial };
 			parser_state subsequent = { sISBody, DeclList };
 
@@ -2609,8 +2844,8 @@ css_error parseISBody(css_parser *parser)
 		}
 
 		if (token->type != CSS_TOKEN_CHAR ||
-				lwc_string_length(token->idata) != 1 ||
-				lwc_string_data(token->idata)[0] != '}') {
+				token->data.len != 1 ||
+				token->data.data[0] != '}') {
 			/* This should never happen, as FOLLOW(decl-list)
 			 * contains only '}' */
 			assert(0 && "Expected }");
@@ -2663,14 +2898,14 @@ void discard_tokens(css_parser *parser)
 	int32_t ctx = 0;
 	const css_token *tok;
 
-	while ((tok = parserutils_vector_iterate(
-			parser->tokens, &ctx)) != NULL) {
+	while ((tok = css__token_vector_iterate(
+			&parser->tokens, &ctx)) != NULL) {
 		if (tok->idata != NULL) {
 			lwc_string_unref(tok->idata);
 		}
 	}
 
-	parserutils_vector_clear(parser->tokens);
+	parser->tokens.length = 0;
 }
 
 #ifndef NDEBUG
@@ -2684,6 +2919,19 @@ static void printer(void *item)
 #endif
 
 #ifdef DEBUG_EVENTS
+static void dump_tokens(const css_token_vector *vector, const char *prefix,
+		void (*printer)(void *item))
+{
+	int32_t i;
+
+	printf("%s:", prefix);
+	for (i = 0; i < vector->length; i++) {
+		printf(" ");
+		printer(&vector->items[i]);
+	}
+	printf("\n");
+}
+
 static void tprinter(void *token)
 {
 	css_token *t = token;
@@ -10,14 +10,59 @@
 
 #include <libwapcaplet/libwapcaplet.h>
 
-#include <parserutils/utils/vector.h>
-
 #include <libcss/errors.h>
 #include <libcss/functypes.h>
 #include <libcss/types.h>
 
+#include "lex/lex.h"
+
 typedef struct css_parser css_parser;
 
+/**
+ * Vector of the tokens of the statement being parsed
+ *
+ * The tokens are stored contiguously, in storage that is reused for each
+ * statement, so the language parser may walk them without indirection.
+ */
+typedef struct css_token_vector {
+	css_token *items;		/**< Tokens */
+	int32_t length;			/**< Number of tokens */
+	int32_t alloc;			/**< Number of tokens allocated */
+} css_token_vector;
+
+/**
+ * Iterate over a token vector
+ *
+ * \param vector  The vector to iterate over
+ * \param ctx     Iteration context, which should be 0 to start with
+ * \return Pointer to the token at \a ctx, or NULL if there are no more.
+ *         \a ctx is advanced past the token returned.
+ */
+static inline const css_token *css__token_vector_iterate(
+		const css_token_vector *vector, int32_t *ctx)
+{
+	if (*ctx < 0 || *ctx >= vector->length)
+		return NULL;
+
+	return &vector->items[(*ctx)++];
+}
+
+/**
+ * Peek at a token in a token vector
+ *
+ * \param vector  The vector to look in
+ * \param ctx     Iteration context, which is not advanced
+ * \return Pointer to the token at \a ctx, or NULL if there is none.
+ */
+static inline const css_token *css__token_vector_peek(
+		const css_token_vector *vector, int32_t ctx)
+{
+	if (ctx < 0 || ctx >= vector->length)
+		return NULL;
+
+	return &vector->items[ctx];
+}
+
 /**
  * Parser event types
  */
@@ -36,7 +81,7 @@ typedef enum css_parser_event {
 } css_parser_event;
 
 typedef css_error (*css_parser_event_handler)(css_parser_event type,
-		const parserutils_vector *tokens, void *pw);
+		const css_token_vector *tokens, void *pw);
 
 /**
  * Parser option types
@@ -72,6 +117,8 @@ css_error css__parser_setopt(css_parser *parser, css_parser_opttype type,
 css_error css__parser_parse_chunk(css_parser *parser, const uint8_t *data,
 		size_t len);
 css_error css__parser_completed(css_parser *parser);
+css_error css__parser_parse_buffer(css_parser *parser, const uint8_t *data,
+		size_t len);
 
 const char *css__parser_read_charset(css_parser *parser,
 		css_charset_source *source);
@@ -28,7 +28,7 @@
  *		   If the input is invalid, then \a *ctx remains unchanged.
  */
 css_error css__parse_azimuth(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_style *result)
 {
 	int32_t orig_ctx = *ctx;
@@ -46,7 +46,7 @@ css_error css__parse_azimuth(css_language *c,
 	 *	 ]
 	 *	 | IDENT(leftwards, rightwards, inherit)
 	 */
-	token = parserutils_vector_peek(vector, *ctx);
+	token = css__token_vector_peek(vector, *ctx);
 	if (token == NULL) {
 		*ctx = orig_ctx;
 		return CSS_INVALID;
@@ -56,38 +56,38 @@ css_error css__parse_azimuth(css_language *c,
 			(lwc_string_caseless_isequal(
 			token->idata, c->strings[INHERIT],
 			&match) == lwc_error_ok && match)) {
-		parserutils_vector_iterate(vector, ctx);
+		css__token_vector_iterate(vector, ctx);
 		flags = FLAG_INHERIT;
 	} else if (token->type == CSS_TOKEN_IDENT &&
 			(lwc_string_caseless_isequal(
 			token->idata, c->strings[INITIAL],
 			&match) == lwc_error_ok && match)) {
-		parserutils_vector_iterate(vector, ctx);
+		css__token_vector_iterate(vector, ctx);
 		flags = FLAG_INITIAL;
 	} else if (token->type == CSS_TOKEN_IDENT &&
 			(lwc_string_caseless_isequal(
 			token->idata, c->strings[REVERT],
 			&match) == lwc_error_ok && match)) {
-		parserutils_vector_iterate(vector, ctx);
+		css__token_vector_iterate(vector, ctx);
 		flags = FLAG_REVERT;
 	} else if (token->type == CSS_TOKEN_IDENT &&
 			(lwc_string_caseless_isequal(
 			token->idata, c->strings[UNSET],
 			&match) == lwc_error_ok && match)) {
-		parserutils_vector_iterate(vector, ctx);
+		css__token_vector_iterate(vector, ctx);
 		flags = FLAG_UNSET;
 	} else if (token->type == CSS_TOKEN_IDENT &&
 		(lwc_string_caseless_isequal(token->idata, c->strings[LEFTWARDS],
 			&match) == lwc_error_ok && match)) {
-		parserutils_vector_iterate(vector, ctx);
+		css__token_vector_iterate(vector, ctx);
 		value = AZIMUTH_LEFTWARDS;
 	} else if (token->type == CSS_TOKEN_IDENT &&
 		(lwc_string_caseless_isequal(token->idata, c->strings[RIGHTWARDS],
 			&match) == lwc_error_ok && match)) {
-		parserutils_vector_iterate(vector, ctx);
+		css__token_vector_iterate(vector, ctx);
 		value = AZIMUTH_RIGHTWARDS;
 	} else if (token->type == CSS_TOKEN_IDENT) {
-		parserutils_vector_iterate(vector, ctx);
+		css__token_vector_iterate(vector, ctx);
 
 		/* Now, we may have one of the other keywords or behind,
 		 * potentially followed by behind or other keyword,
@@ -140,11 +140,11 @@ css_error css__parse_azimuth(css_language *c,
 		consumeWhitespace(vector, ctx);
 
 		/* Get potential following token */
-		token = parserutils_vector_peek(vector, *ctx);
+		token = css__token_vector_peek(vector, *ctx);
 
 		if (token != NULL && token->type == CSS_TOKEN_IDENT &&
 				value == AZIMUTH_BEHIND) {
-			parserutils_vector_iterate(vector, ctx);
+			css__token_vector_iterate(vector, ctx);
 
 			if ((lwc_string_caseless_isequal(
 					token->idata, c->strings[LEFT_SIDE],
@@ -188,7 +188,7 @@ css_error css__parse_azimuth(css_language *c,
 			}
 		} else if (token != NULL && token->type == CSS_TOKEN_IDENT &&
 				value != AZIMUTH_BEHIND) {
-			parserutils_vector_iterate(vector, ctx);
+			css__token_vector_iterate(vector, ctx);
 
 			if ((lwc_string_caseless_isequal(
 					token->idata, c->strings[BEHIND],
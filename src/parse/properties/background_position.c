@@ -28,7 +28,7 @@
  *		   If the input is invalid, then \a *ctx remains unchanged.
  */
 css_error css__parse_background_position(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_style *result)
 {
 	int32_t orig_ctx = *ctx;
@@ -42,7 +42,7 @@ css_error css__parse_background_position(css_language *c,
 
 	/* [length | percentage | IDENT(left, right, top, bottom, center)]{1,2}
 	 * | IDENT(inherit) */
-	token = parserutils_vector_peek(vector, *ctx);
+	token = css__token_vector_peek(vector, *ctx);
 	if (token == NULL) {
 		*ctx = orig_ctx;
 		return CSS_INVALID;
@@ -52,31 +52,31 @@ css_error css__parse_background_position(css_language *c,
 			(lwc_string_caseless_isequal(
 			token->idata, c->strings[INHERIT],
 			&match) == lwc_error_ok && match)) {
-		parserutils_vector_iterate(vector, ctx);
+		css__token_vector_iterate(vector, ctx);
 		flags = FLAG_INHERIT;
 	} else if (token->type == CSS_TOKEN_IDENT &&
 			(lwc_string_caseless_isequal(
 			token->idata, c->strings[INITIAL],
 			&match) == lwc_error_ok && match)) {
-		parserutils_vector_iterate(vector, ctx);
+		css__token_vector_iterate(vector, ctx);
 		flags = FLAG_INITIAL;
 	} else if (token->type == CSS_TOKEN_IDENT &&
 			(lwc_string_caseless_isequal(
 			token->idata, c->strings[REVERT],
 			&match) == lwc_error_ok && match)) {
-		parserutils_vector_iterate(vector, ctx);
+		css__token_vector_iterate(vector, ctx);
 		flags = FLAG_REVERT;
 	} else if (token->type == CSS_TOKEN_IDENT &&
 			(lwc_string_caseless_isequal(
 			token->idata, c->strings[UNSET],
 			&match) == lwc_error_ok && match)) {
-		parserutils_vector_iterate(vector, ctx);
+		css__token_vector_iterate(vector, ctx);
 		flags = FLAG_UNSET;
 	} else {
 		int i;
 
 		for (i = 0; i < 2; i++) {
-			token = parserutils_vector_peek(vector, *ctx);
+			token = css__token_vector_peek(vector, *ctx);
 			if (token == NULL)
 				break;
 
@@ -122,7 +122,7 @@ css_error css__parse_background_position(css_language *c,
 					return CSS_INVALID;
 				}
 
-				parserutils_vector_iterate(vector, ctx);
+				css__token_vector_iterate(vector, ctx);
 			} else if (token->type == CSS_TOKEN_DIMENSION ||
 					token->type == CSS_TOKEN_NUMBER ||
 					token->type == CSS_TOKEN_PERCENTAGE) {
@@ -28,7 +28,7 @@
  *		   If the input is invalid, then \a *ctx remains unchanged.
  */
 css_error css__parse_border(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_style *result)
 {
 	int32_t orig_ctx = *ctx;
@@ -28,7 +28,7 @@
  *		   If the input is invalid, then \a *ctx remains unchanged.
  */
 css_error css__parse_border_spacing(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_style *result)
 {
 	int32_t orig_ctx = *ctx;
@@ -39,7 +39,7 @@ css_error css__parse_border_spacing(css_language *c,
 	enum flag_value flag_value;
 
 	/* length length? | IDENT(inherit) */
-	token = parserutils_vector_peek(vector, *ctx);
+	token = css__token_vector_peek(vector, *ctx);
 	if (token == NULL) {
 		*ctx = orig_ctx;
 		return CSS_INVALID;
@@ -48,7 +48,7 @@ css_error css__parse_border_spacing(css_language *c,
 	flag_value = get_css_flag_value(c, token);
 
 	if (flag_value != FLAG_VALUE__NONE) {
-		parserutils_vector_iterate(vector, ctx);
+		css__token_vector_iterate(vector, ctx);
 		/* inherit */
 		error = css_stylesheet_style_flag_value(result, flag_value,
 				CSS_PROP_BORDER_SPACING);
@@ -72,7 +72,7 @@ css_error css__parse_border_spacing(css_language *c,
 
 		consumeWhitespace(vector, ctx);
 
-		token = parserutils_vector_peek(vector, *ctx);
+		token = css__token_vector_peek(vector, *ctx);
 		if (token != NULL) {
 			/* Attempt second length, ignoring errors.
 			 * The core !important parser will ensure
@@ -28,7 +28,7 @@
  *		   If the input is invalid, then \a *ctx remains unchanged.
  */
 css_error css__parse_border_style(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_style *result)
 {
 	int32_t orig_ctx = *ctx;
@@ -41,7 +41,7 @@ css_error css__parse_border_style(css_language *c,
 	enum flag_value flag_value;
 
 	/* Firstly, handle inherit */
-	token = parserutils_vector_peek(vector, *ctx);
+	token = css__token_vector_peek(vector, *ctx);
 	if (token == NULL)
 		return CSS_INVALID;
 
@@ -66,7 +66,7 @@ css_error css__parse_border_style(css_language *c,
 		error = css_stylesheet_style_flag_value(result, flag_value,
 				CSS_PROP_BORDER_LEFT_STYLE);
 		if (error == CSS_OK)
-			parserutils_vector_iterate(vector, ctx);
+			css__token_vector_iterate(vector, ctx);
 
 		return error;
 	}
@@ -109,11 +109,11 @@ css_error css__parse_border_style(css_language *c,
 
 		side_count++;
 
-		parserutils_vector_iterate(vector, ctx);
+		css__token_vector_iterate(vector, ctx);
 
 		consumeWhitespace(vector, ctx);
 
-		token = parserutils_vector_peek(vector, *ctx);
+		token = css__token_vector_peek(vector, *ctx);
 	} while ((*ctx != prev_ctx) && (token != NULL) && (side_count < 4));
 
 
@@ -28,7 +28,7 @@
  *		   If the input is invalid, then \a *ctx remains unchanged.
  */
 css_error css__parse_border_width(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_style *result)
 {
 	int32_t orig_ctx = *ctx;
@@ -43,7 +43,7 @@ css_error css__parse_border_width(css_language *c,
 	enum flag_value flag_value;
 
 	/* Firstly, handle inherit */
-	token = parserutils_vector_peek(vector, *ctx);
+	token = css__token_vector_peek(vector, *ctx);
 	if (token == NULL)
 		return CSS_INVALID;
 
@@ -68,7 +68,7 @@ css_error css__parse_border_width(css_language *c,
 		error = css_stylesheet_style_flag_value(result, flag_value,
 				CSS_PROP_BORDER_LEFT_WIDTH);
 		if (error == CSS_OK)
-			parserutils_vector_iterate(vector, ctx);
+			css__token_vector_iterate(vector, ctx);
 
 		return error;
 	}
@@ -84,14 +84,14 @@ css_error css__parse_border_width(css_language *c,
 
 		if ((token->type == CSS_TOKEN_IDENT) && (lwc_string_caseless_isequal(token->idata, c->strings[THIN], &match) == lwc_error_ok && match)) {
 			side_val[side_count] =  BORDER_WIDTH_THIN;
-			parserutils_vector_iterate(vector, ctx);
+			css__token_vector_iterate(vector, ctx);
 			error = CSS_OK;
 		} else if ((token->type == CSS_TOKEN_IDENT) && (lwc_string_caseless_isequal(token->idata, c->strings[MEDIUM], &match) == lwc_error_ok && match)) {
 			side_val[side_count] =  BORDER_WIDTH_MEDIUM;
-			parserutils_vector_iterate(vector, ctx);
+			css__token_vector_iterate(vector, ctx);
 			error = CSS_OK;
 		} else if ((token->type == CSS_TOKEN_IDENT) && (lwc_string_caseless_isequal(token->idata, c->strings[THICK], &match) == lwc_error_ok && match)) {
-			parserutils_vector_iterate(vector, ctx);
+			css__token_vector_iterate(vector, ctx);
 			error = CSS_OK;
 			side_val[side_count] =  BORDER_WIDTH_THICK;
 		} else {
@@ -119,7 +119,7 @@ css_error css__parse_border_width(css_language *c,
 
 			consumeWhitespace(vector, ctx);
 
-			token = parserutils_vector_peek(vector, *ctx);
+			token = css__token_vector_peek(vector, *ctx);
 		} else {
 			/* Forcibly cause loop to exit */
 			token = NULL;
@@ -28,7 +28,7 @@
  *                 If the input is invalid, then \a *ctx remains unchanged.
  */
 css_error css__parse_clip(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_style *result)
 {
 	int32_t orig_ctx = *ctx;
@@ -43,7 +43,7 @@ css_error css__parse_clip(css_language *c,
 	/* FUNCTION(rect) [ [ IDENT(auto) | length ] CHAR(,)? ]{3}
 	 *                [ IDENT(auto) | length ] CHAR{)} |
 	 * IDENT(auto, inherit) */
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 	if (token == NULL) {
 		*ctx = orig_ctx;
 		return CSS_INVALID;
@@ -73,7 +73,7 @@ css_error css__parse_clip(css_language *c,
 		for (i = 0; i < 4; i++) {
 			consumeWhitespace(vector, ctx);
 
-			token = parserutils_vector_peek(vector, *ctx);
+			token = css__token_vector_peek(vector, *ctx);
 			if (token == NULL) {
 				*ctx = orig_ctx;
 				return CSS_INVALID;
@@ -92,7 +92,7 @@ css_error css__parse_clip(css_language *c,
 					return CSS_INVALID;
 				}
 
-				parserutils_vector_iterate(vector, ctx);
+				css__token_vector_iterate(vector, ctx);
 			} else {
 				error = css__parse_unit_specifier(c, vector, ctx,
 						UNIT_PX,
@@ -118,21 +118,21 @@ css_error css__parse_clip(css_language *c,
 
 			/* Consume optional comma after first 3 parameters */
 			if (i < 3) {
-				token = parserutils_vector_peek(vector, *ctx);
+				token = css__token_vector_peek(vector, *ctx);
 				if (token == NULL) {
 					*ctx = orig_ctx;
 					return CSS_INVALID;
 				}
 
 				if (tokenIsChar(token, ','))
-					parserutils_vector_iterate(vector, ctx);
+					css__token_vector_iterate(vector, ctx);
 			}
 		}
 
 		consumeWhitespace(vector, ctx);
 
 		/* Finally, consume closing parenthesis */
-		token = parserutils_vector_iterate(vector, ctx);
+		token = css__token_vector_iterate(vector, ctx);
 		if (token == NULL || tokenIsChar(token, ')') == false) {
 			*ctx = orig_ctx;
 			return CSS_INVALID;
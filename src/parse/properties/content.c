@@ -29,7 +29,7 @@
  *		   If the input is invalid, then \a *ctx remains unchanged.
  */
 css_error css__parse_content(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_style *result)
 {
 	int32_t orig_ctx = *ctx;
@@ -39,7 +39,7 @@ css_error css__parse_content(css_language *c,
 	bool match;
 
 	/* IDENT(normal, none, inherit) | [ ... ]+ */
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 	if (token == NULL) {
 		*ctx = orig_ctx;
 		return error;
@@ -158,7 +158,7 @@ css_error css__parse_content(css_language *c,
 				consumeWhitespace(vector, ctx);
 
 				/* Expect IDENT */
-				token = parserutils_vector_iterate(vector, ctx);
+				token = css__token_vector_iterate(vector, ctx);
 				if (token == NULL || token->type != CSS_TOKEN_IDENT) {
 					*ctx = orig_ctx;
 					return CSS_INVALID;
@@ -181,7 +181,7 @@ css_error css__parse_content(css_language *c,
 				consumeWhitespace(vector, ctx);
 
 				/* Expect ')' */
-				token = parserutils_vector_iterate(vector, ctx);
+				token = css__token_vector_iterate(vector, ctx);
 				if (token == NULL || tokenIsChar(token, ')') == false) {
 					*ctx = orig_ctx;
 					return CSS_INVALID;
@@ -199,7 +199,7 @@ css_error css__parse_content(css_language *c,
 				consumeWhitespace(vector, ctx);
 
 				/* Expect IDENT */
-				token = parserutils_vector_iterate(vector, ctx);
+				token = css__token_vector_iterate(vector, ctx);
 				if (token == NULL || token->type != CSS_TOKEN_IDENT) {
 					*ctx = orig_ctx;
 					return CSS_INVALID;
@@ -210,7 +210,7 @@ css_error css__parse_content(css_language *c,
 				consumeWhitespace(vector, ctx);
 
 				/* Possible ',' */
-				token = parserutils_vector_peek(vector, *ctx);
+				token = css__token_vector_peek(vector, *ctx);
 				if (token == NULL ||
 				    (tokenIsChar(token, ',') == false &&
 				     tokenIsChar(token, ')') == false)) {
@@ -221,12 +221,12 @@ css_error css__parse_content(css_language *c,
 				if (tokenIsChar(token, ',')) {
 					uint16_t v;
 
-					parserutils_vector_iterate(vector, ctx);
+					css__token_vector_iterate(vector, ctx);
 
 					consumeWhitespace(vector, ctx);
 
 					/* Expect IDENT */
-					token = parserutils_vector_peek(vector, *ctx);
+					token = css__token_vector_peek(vector, *ctx);
 					if (token == NULL || token->type !=
 					    CSS_TOKEN_IDENT) {
 						*ctx = orig_ctx;
@@ -241,7 +241,7 @@ css_error css__parse_content(css_language *c,
 
 					opv |= v << CONTENT_COUNTER_STYLE_SHIFT;
 
-					parserutils_vector_iterate(vector, ctx);
+					css__token_vector_iterate(vector, ctx);
 
 					consumeWhitespace(vector, ctx);
 				} else {
@@ -250,7 +250,7 @@ css_error css__parse_content(css_language *c,
 				}
 
 				/* Expect ')' */
-				token = parserutils_vector_iterate(vector, ctx);
+				token = css__token_vector_iterate(vector, ctx);
 				if (token == NULL || tokenIsChar(token,	')') == false) {
 					*ctx = orig_ctx;
 					return CSS_INVALID;
@@ -285,7 +285,7 @@ css_error css__parse_content(css_language *c,
 				consumeWhitespace(vector, ctx);
 
 				/* Expect IDENT */
-				token = parserutils_vector_iterate(vector, ctx);
+				token = css__token_vector_iterate(vector, ctx);
 				if (token == NULL || token->type != CSS_TOKEN_IDENT) {
 					*ctx = orig_ctx;
 					return CSS_INVALID;
@@ -296,7 +296,7 @@ css_error css__parse_content(css_language *c,
 				consumeWhitespace(vector, ctx);
 
 				/* Expect ',' */
-				token = parserutils_vector_iterate(vector, ctx);
+				token = css__token_vector_iterate(vector, ctx);
 				if (token == NULL || tokenIsChar(token, ',') == false) {
 					*ctx = orig_ctx;
 					return CSS_INVALID;
@@ -305,7 +305,7 @@ css_error css__parse_content(css_language *c,
 				consumeWhitespace(vector, ctx);
 
 				/* Expect STRING */
-				token = parserutils_vector_iterate(vector, ctx);
+				token = css__token_vector_iterate(vector, ctx);
 				if (token == NULL || token->type != CSS_TOKEN_STRING) {
 					*ctx = orig_ctx;
 					return CSS_INVALID;
@@ -316,7 +316,7 @@ css_error css__parse_content(css_language *c,
 				consumeWhitespace(vector, ctx);
 
 				/* Possible ',' */
-				token = parserutils_vector_peek(vector, *ctx);
+				token = css__token_vector_peek(vector, *ctx);
 				if (token == NULL ||
 				    (tokenIsChar(token, ',') == false &&
 				     tokenIsChar(token, ')') == false)) {
@@ -327,12 +327,12 @@ css_error css__parse_content(css_language *c,
 				if (tokenIsChar(token, ',')) {
 					uint16_t v;
 
-					parserutils_vector_iterate(vector, ctx);
+					css__token_vector_iterate(vector, ctx);
 
 					consumeWhitespace(vector, ctx);
 
 					/* Expect IDENT */
-					token = parserutils_vector_peek(vector, *ctx);
+					token = css__token_vector_peek(vector, *ctx);
 					if (token == NULL || token->type !=
 					    CSS_TOKEN_IDENT) {
 						*ctx = orig_ctx;
@@ -348,7 +348,7 @@ css_error css__parse_content(css_language *c,
 
 					opv |= v << CONTENT_COUNTERS_STYLE_SHIFT;
 
-					parserutils_vector_iterate(vector, ctx);
+					css__token_vector_iterate(vector, ctx);
 
 					consumeWhitespace(vector, ctx);
 				} else {
@@ -357,7 +357,7 @@ css_error css__parse_content(css_language *c,
 				}
 
 				/* Expect ')' */
-				token = parserutils_vector_iterate(vector, ctx);
+				token = css__token_vector_iterate(vector, ctx);
 				if (token == NULL || tokenIsChar(token, ')') == false) {
 					*ctx = orig_ctx;
 					return CSS_INVALID;
@@ -410,7 +410,7 @@ css_error css__parse_content(css_language *c,
 			consumeWhitespace(vector, ctx);
 
 			prev_ctx = *ctx;
-			token = parserutils_vector_iterate(vector, ctx);
+			token = css__token_vector_iterate(vector, ctx);
 		} /* while */
 
 		/* Write list terminator */
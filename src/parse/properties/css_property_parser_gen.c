@@ -117,7 +117,7 @@ void output_header(FILE *outputf, const char *descriptor, struct keyval *parser_
 		" *		   If the input is invalid, then \\a *ctx remains unchanged.\n"
 		" */\n"
 		"css_error css__parse_%s(css_language *c,\n"
-		"		const parserutils_vector *vector, int32_t *ctx,\n"
+		"		const css_token_vector *vector, int32_t *ctx,\n"
 		"		css_style *result%s)\n"
 		"{\n",
 		descriptor,
@@ -135,7 +135,7 @@ void output_token_type_check(FILE *outputf, bool do_token_check, struct keyval_l
 		"	css_error error;\n"
 		"	const css_token *token;\n"
 		"	bool match;\n\n"
-		"	token = parserutils_vector_iterate(vector, ctx);\n"
+		"	token = css__token_vector_iterate(vector, ctx);\n"
 		"	if (%stoken == NULL%s",
 		do_token_check ? "(" : "",
 		do_token_check ? ")" : "");
@@ -264,9 +264,10 @@ void output_number(FILE *outputf, struct keyval *parseid, struct keyval_list *kv
 		"if (token->type == CSS_TOKEN_NUMBER) {\n"
 		"\t\tcss_fixed num = 0;\n"
 		"\t\tsize_t consumed = 0;\n\n"
-		"\t\tnum = css__number_from_lwc_string(token->idata, %s, &consumed);\n"
+		"\t\tnum = css__number_from_string(token->data.data,\n"
+		"\t\t\t\ttoken->data.len, %s, &consumed);\n"
 		"\t\t/* Invalid if there are trailing characters */\n"
-		"\t\tif (consumed != lwc_string_length(token->idata)) {\n"
+		"\t\tif (consumed != token->data.len) {\n"
 		"\t\t\t*ctx = orig_ctx;\n"
 		"\t\t\treturn CSS_INVALID;\n"
 		"\t\t}\n",
@@ -455,17 +456,18 @@ output_ident_list(FILE *outputf,
 		"\t\t\t}\n\n"
 		"\t\t\tconsumeWhitespace(vector, ctx);\n\n"
 		"\t\t\tpctx = *ctx;\n"
-		"\t\t\ttoken = parserutils_vector_iterate(vector, ctx);\n"
+		"\t\t\ttoken = css__token_vector_iterate(vector, ctx);\n"
 		"\t\t\tif ((token != NULL) && (token->type == CSS_TOKEN_NUMBER)) {\n"
 		"\t\t\t\tsize_t consumed = 0;\n\n"
-		"\t\t\t\tnum = css__number_from_lwc_string(token->idata, true, &consumed);\n"
-		"\t\t\t\tif (consumed != lwc_string_length(token->idata)) {\n"
+		"\t\t\t\tnum = css__number_from_string(token->data.data,\n"
+		"\t\t\t\t\t\ttoken->data.len, true, &consumed);\n"
+		"\t\t\t\tif (consumed != token->data.len) {\n"
 		"\t\t\t\t\t*ctx = orig_ctx;\n"
 		"\t\t\t\t\treturn CSS_INVALID;\n"
 		"\t\t\t\t}\n"
 		"\t\t\t\tconsumeWhitespace(vector, ctx);\n\n"
 		"\t\t\t\tpctx = *ctx;\n"
-		"\t\t\t\ttoken = parserutils_vector_iterate(vector, ctx);\n"
+		"\t\t\t\ttoken = css__token_vector_iterate(vector, ctx);\n"
 		"\t\t\t} else {\n"
 		"\t\t\t\tnum = INTTOFIX(%s);\n"
 		"\t\t\t}\n\n"
@@ -27,7 +27,7 @@
  *                 If the input is invalid, then \a *ctx remains unchanged.
  */
 css_error css__parse_cursor(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_style *result)
 {
 	int32_t orig_ctx = *ctx;
@@ -41,7 +41,7 @@ css_error css__parse_cursor(css_language *c,
 	 *              s-resize, w-resize, text, wait, help, progress) ]
 	 * | IDENT(inherit)
 	 */
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 	if ((token == NULL) ||
 	    (token->type != CSS_TOKEN_IDENT &&
 	     token->type != CSS_TOKEN_URI)) {
@@ -99,7 +99,7 @@ css_error css__parse_cursor(css_language *c,
 			consumeWhitespace(vector, ctx);
 
 			/* Expect ',' */
-			token = parserutils_vector_iterate(vector, ctx);
+			token = css__token_vector_iterate(vector, ctx);
 			if (token == NULL || tokenIsChar(token, ',') == false) {
 				*ctx = orig_ctx;
 				return CSS_INVALID;
@@ -108,7 +108,7 @@ css_error css__parse_cursor(css_language *c,
 			consumeWhitespace(vector, ctx);
 
 			/* Expect either URI or IDENT */
-			token = parserutils_vector_iterate(vector, ctx);
+			token = css__token_vector_iterate(vector, ctx);
 			if (token == NULL || (token->type != CSS_TOKEN_IDENT &&
 					token->type != CSS_TOKEN_URI)) {
 				*ctx = orig_ctx;
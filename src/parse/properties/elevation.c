@@ -28,7 +28,7 @@
  *		   If the input is invalid, then \a *ctx remains unchanged.
  */
 css_error css__parse_elevation(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_style *result)
 {
 	int32_t orig_ctx = *ctx;
@@ -41,7 +41,7 @@ css_error css__parse_elevation(css_language *c,
 	bool match;
 
 	/* angle | IDENT(below, level, above, higher, lower, inherit) */
-	token = parserutils_vector_peek(vector, *ctx);
+	token = css__token_vector_peek(vector, *ctx);
 	if (token == NULL) {
 		*ctx = orig_ctx;
 		return CSS_INVALID;
@@ -51,55 +51,55 @@ css_error css__parse_elevation(css_language *c,
 		(lwc_string_caseless_isequal(
 			token->idata, c->strings[INHERIT],
 			&match) == lwc_error_ok && match)) {
-		parserutils_vector_iterate(vector, ctx);
+		css__token_vector_iterate(vector, ctx);
 		flags = FLAG_INHERIT;
 	} else if (token->type == CSS_TOKEN_IDENT &&
 		(lwc_string_caseless_isequal(
 			token->idata, c->strings[INITIAL],
 			&match) == lwc_error_ok && match)) {
-		parserutils_vector_iterate(vector, ctx);
+		css__token_vector_iterate(vector, ctx);
 		flags = FLAG_INITIAL;
 	} else if (token->type == CSS_TOKEN_IDENT &&
 		(lwc_string_caseless_isequal(
 			token->idata, c->strings[REVERT],
 			&match) == lwc_error_ok && match)) {
-		parserutils_vector_iterate(vector, ctx);
+		css__token_vector_iterate(vector, ctx);
 		flags = FLAG_REVERT;
 	} else if (token->type == CSS_TOKEN_IDENT &&
 		(lwc_string_caseless_isequal(
 			token->idata, c->strings[UNSET],
 			&match) == lwc_error_ok && match)) {
-		parserutils_vector_iterate(vector, ctx);
+		css__token_vector_iterate(vector, ctx);
 		flags = FLAG_UNSET;
 	} else if (token->type == CSS_TOKEN_IDENT &&
 		(lwc_string_caseless_isequal(
 			token->idata, c->strings[BELOW],
 			&match) == lwc_error_ok && match)) {
-		parserutils_vector_iterate(vector, ctx);
+		css__token_vector_iterate(vector, ctx);
 		value = ELEVATION_BELOW;
 	} else if (token->type == CSS_TOKEN_IDENT &&
 		(lwc_string_caseless_isequal(
 			token->idata, c->strings[LEVEL],
 			&match) == lwc_error_ok && match)) {
-		parserutils_vector_iterate(vector, ctx);
+		css__token_vector_iterate(vector, ctx);
 		value = ELEVATION_LEVEL;
 	} else if (token->type == CSS_TOKEN_IDENT &&
 		(lwc_string_caseless_isequal(
 			token->idata, c->strings[ABOVE],
 			&match) == lwc_error_ok && match)) {
-		parserutils_vector_iterate(vector, ctx);
+		css__token_vector_iterate(vector, ctx);
 		value = ELEVATION_ABOVE;
 	} else if (token->type == CSS_TOKEN_IDENT &&
 		(lwc_string_caseless_isequal(
 			token->idata, c->strings[HIGHER],
 			&match) == lwc_error_ok && match)) {
-		parserutils_vector_iterate(vector, ctx);
+		css__token_vector_iterate(vector, ctx);
 		value = ELEVATION_HIGHER;
 	} else if (token->type == CSS_TOKEN_IDENT &&
 		(lwc_string_caseless_isequal(
 			token->idata, c->strings[LOWER],
 			&match) == lwc_error_ok && match)) {
-		parserutils_vector_iterate(vector, ctx);
+		css__token_vector_iterate(vector, ctx);
 		value = ELEVATION_LOWER;
 	} else {
 		error = css__parse_unit_specifier(c, vector, ctx, UNIT_DEG,
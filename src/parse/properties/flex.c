@@ -29,7 +29,7 @@
  */
 
 css_error css__parse_flex(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_style *result)
 {
 	int32_t orig_ctx = *ctx;
@@ -48,7 +48,7 @@ css_error css__parse_flex(css_language *c,
 	bool match;
 
 	/* Firstly, handle inherit */
-	token = parserutils_vector_peek(vector, *ctx);
+	token = css__token_vector_peek(vector, *ctx);
 	if (token == NULL) 
 		return CSS_INVALID;
 
@@ -68,7 +68,7 @@ css_error css__parse_flex(css_language *c,
 		error = css_stylesheet_style_flag_value(result, flag_value,
 				CSS_PROP_FLEX_BASIS);
 		if (error == CSS_OK)
-			parserutils_vector_iterate(vector, ctx);
+			css__token_vector_iterate(vector, ctx);
 
 		return error;
 	}
@@ -97,7 +97,7 @@ css_error css__parse_flex(css_language *c,
 			token->idata, c->strings[NONE],
 			&match) == lwc_error_ok && match)) {
 		short_none = true;
-		parserutils_vector_iterate(vector, ctx);
+		css__token_vector_iterate(vector, ctx);
 
 	} else if ((token->type == CSS_TOKEN_IDENT) &&
 		(lwc_string_caseless_isequal(
@@ -105,7 +105,7 @@ css_error css__parse_flex(css_language *c,
 			&match) == lwc_error_ok && match)) {
 		/* Handle shorthand auto, equivalent of flex: 1 1 auto; */
 		short_auto = true;
-		parserutils_vector_iterate(vector, ctx);
+		css__token_vector_iterate(vector, ctx);
 
 	} else do {
 		/* Attempt to parse the various longhand properties */
@@ -113,7 +113,7 @@ css_error css__parse_flex(css_language *c,
 		error = CSS_OK;
 
 		/* Ensure that we're not about to parse another inherit */
-		token = parserutils_vector_peek(vector, *ctx);
+		token = css__token_vector_peek(vector, *ctx);
 		if (token != NULL && is_css_inherit(c, token)) {
 			error = CSS_INVALID;
 			goto css__parse_flex_cleanup;
@@ -135,7 +135,7 @@ css_error css__parse_flex(css_language *c,
 
 		if (error == CSS_OK) {
 			consumeWhitespace(vector, ctx);
-			token = parserutils_vector_peek(vector, *ctx);
+			token = css__token_vector_peek(vector, *ctx);
 		} else {
 			/* Forcibly cause loop to exit */
 			token = NULL;
@@ -29,7 +29,7 @@
  */
 
 css_error css__parse_flex_flow(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_style *result)
 {
 	int32_t orig_ctx = *ctx;
@@ -43,7 +43,7 @@ css_error css__parse_flex_flow(css_language *c,
 	enum flag_value flag_value;
 
 	/* Firstly, handle inherit */
-	token = parserutils_vector_peek(vector, *ctx);
+	token = css__token_vector_peek(vector, *ctx);
 	if (token == NULL) 
 		return CSS_INVALID;
 
@@ -58,7 +58,7 @@ css_error css__parse_flex_flow(css_language *c,
 		error = css_stylesheet_style_flag_value(result, flag_value,
 				CSS_PROP_FLEX_WRAP);
 		if (error == CSS_OK)
-			parserutils_vector_iterate(vector, ctx);
+			css__token_vector_iterate(vector, ctx);
 
 		return error;
 	}
@@ -80,7 +80,7 @@ css_error css__parse_flex_flow(css_language *c,
 		error = CSS_OK;
 
 		/* Ensure that we're not about to parse another inherit */
-		token = parserutils_vector_peek(vector, *ctx);
+		token = css__token_vector_peek(vector, *ctx);
 		if (token != NULL && is_css_inherit(c, token)) {
 			error = CSS_INVALID;
 			goto css__parse_flex_flow_cleanup;
@@ -99,7 +99,7 @@ css_error css__parse_flex_flow(css_language *c,
 		if (error == CSS_OK) {
 			consumeWhitespace(vector, ctx);
 
-			token = parserutils_vector_peek(vector, *ctx);
+			token = css__token_vector_peek(vector, *ctx);
 		} else {
 			/* Forcibly cause loop to exit */
 			token = NULL;
@@ -225,7 +225,7 @@ static css_error parse_system_font(css_language *c,
  *		   If the input is invalid, then \a *ctx remains unchanged.
  */
 css_error css__parse_font(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_style *result)
 {
 	const css_token *token;
@@ -248,7 +248,7 @@ css_error css__parse_font(css_language *c,
 	int svw;
 
 	/* Firstly, handle inherit */
-	token = parserutils_vector_peek(vector, *ctx);
+	token = css__token_vector_peek(vector, *ctx);
 	if (token == NULL)
 		return CSS_INVALID;
 
@@ -283,7 +283,7 @@ css_error css__parse_font(css_language *c,
 		error = css_stylesheet_style_flag_value(result, flag_value,
 				CSS_PROP_FONT_FAMILY);
 		if (error == CSS_OK)
-			parserutils_vector_iterate(vector, ctx);
+			css__token_vector_iterate(vector, ctx);
 
 		return error;
 	}
@@ -301,7 +301,7 @@ css_error css__parse_font(css_language *c,
 		system_font.family = NULL;
 
 		if (error == CSS_OK)
-			parserutils_vector_iterate(vector, ctx);
+			css__token_vector_iterate(vector, ctx);
 
 		return error;
 	}
@@ -359,7 +359,7 @@ css_error css__parse_font(css_language *c,
 		error = CSS_OK;
 
 		/* Ensure that we're not about to parse another inherit */
-		token = parserutils_vector_peek(vector, *ctx);
+		token = css__token_vector_peek(vector, *ctx);
 		if ((token != NULL) && is_css_inherit(c, token)) {
 			error = CSS_INVALID;
 			goto css__parse_font_cleanup;
@@ -392,7 +392,7 @@ css_error css__parse_font(css_language *c,
 	consumeWhitespace(vector, ctx);
 
 	/* Ensure that we're not about to parse another inherit */
-	token = parserutils_vector_peek(vector, *ctx);
+	token = css__token_vector_peek(vector, *ctx);
 	if ((token != NULL) && is_css_inherit(c, token)) {
 		error = CSS_INVALID;
 		goto css__parse_font_cleanup;
@@ -406,14 +406,14 @@ css_error css__parse_font(css_language *c,
 	consumeWhitespace(vector, ctx);
 
 	/* Potential line-height */
-	token = parserutils_vector_peek(vector, *ctx);
+	token = css__token_vector_peek(vector, *ctx);
 	if ((token != NULL) && tokenIsChar(token, '/')) {
-		parserutils_vector_iterate(vector, ctx);
+		css__token_vector_iterate(vector, ctx);
 
 		consumeWhitespace(vector, ctx);
 
 		/* Ensure that we're not about to parse another inherit */
-		token = parserutils_vector_peek(vector, *ctx);
+		token = css__token_vector_peek(vector, *ctx);
 		if ((token != NULL) && is_css_inherit(c, token)) {
 			error = CSS_INVALID;
 			goto css__parse_font_cleanup;
@@ -429,7 +429,7 @@ css_error css__parse_font(css_language *c,
 	consumeWhitespace(vector, ctx);
 
 	/* Ensure that we're not about to parse another inherit */
-	token = parserutils_vector_peek(vector, *ctx);
+	token = css__token_vector_peek(vector, *ctx);
 	if ((token != NULL) && is_css_inherit(c, token)) {
 		error = CSS_INVALID;
 		goto css__parse_font_cleanup;
@@ -99,7 +99,7 @@ static css_code_t font_family_value(css_language *c, const css_token *token, boo
  *		   If the input is invalid, then \a *ctx remains unchanged.
  */
 css_error css__parse_font_family(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_style *result)
 {
 	int32_t orig_ctx = *ctx;
@@ -116,7 +116,7 @@ css_error css__parse_font_family(css_language *c,
 	 * Perhaps this is a quirk we should inherit?
 	 */
 
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 	if (token == NULL || (token->type != CSS_TOKEN_IDENT &&
 			token->type != CSS_TOKEN_STRING)) {
 		*ctx = orig_ctx;
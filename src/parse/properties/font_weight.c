@@ -28,7 +28,7 @@
  *		   If the input is invalid, then \a *ctx remains unchanged.
  */
 css_error css__parse_font_weight(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_style *result)
 {
 	int32_t orig_ctx = *ctx;
@@ -40,7 +40,7 @@ css_error css__parse_font_weight(css_language *c,
 
 	/* NUMBER (100, 200, 300, 400, 500, 600, 700, 800, 900) |
 	 * IDENT (normal, bold, bolder, lighter, inherit) */
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 	if (token == NULL || (token->type != CSS_TOKEN_IDENT &&
 			token->type != CSS_TOKEN_NUMBER)) {
 		*ctx = orig_ctx;
@@ -72,10 +72,10 @@ css_error css__parse_font_weight(css_language *c,
 
 	} else if (token->type == CSS_TOKEN_NUMBER) {
 		size_t consumed = 0;
-		css_fixed num = css__number_from_lwc_string(token->idata,
-				true, &consumed);
+		css_fixed num = css__number_from_string(token->data.data,
+				token->data.len, true, &consumed);
 		/* Invalid if there are trailing characters */
-		if (consumed != lwc_string_length(token->idata)) {
+		if (consumed != token->data.len) {
 			*ctx = orig_ctx;
 			return CSS_INVALID;
 		}
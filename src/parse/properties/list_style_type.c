@@ -28,7 +28,7 @@
  *		   If the input is invalid, then \a *ctx remains unchanged.
  */
 css_error css__parse_list_style_type(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_style *result)
 {
 	int32_t orig_ctx = *ctx;
@@ -43,7 +43,7 @@ css_error css__parse_list_style_type(css_language *c,
 	 *	  upper-latin, armenian, georgian, lower-alpha, upper-alpha,
 	 *	  none, inherit)
 	 */
-	ident = parserutils_vector_iterate(vector, ctx);
+	ident = css__token_vector_iterate(vector, ctx);
 	if (ident == NULL || ident->type != CSS_TOKEN_IDENT) {
 		*ctx = orig_ctx;
 		return CSS_INVALID;
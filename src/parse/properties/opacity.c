@@ -27,7 +27,7 @@
  *		   If the input is invalid, then \a *ctx remains unchanged.
  */
 css_error css__parse_opacity(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_style *result)
 {
 	int32_t orig_ctx = *ctx;
@@ -35,7 +35,7 @@ css_error css__parse_opacity(css_language *c,
 	const css_token *token;
 	enum flag_value flag_value;
 
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 	if ((token == NULL) || ((token->type != CSS_TOKEN_IDENT) && (token->type != CSS_TOKEN_NUMBER))) {
 		*ctx = orig_ctx;
 		return CSS_INVALID;
@@ -51,9 +51,10 @@ css_error css__parse_opacity(css_language *c,
 		css_fixed num = 0;
 		size_t consumed = 0;
 
-		num = css__number_from_lwc_string(token->idata, false, &consumed);
+		num = css__number_from_string(token->data.data,
+				token->data.len, false, &consumed);
 		/* Invalid if there are trailing characters */
-		if (consumed != lwc_string_length(token->idata)) {
+		if (consumed != token->data.len) {
 			*ctx = orig_ctx;
 			return CSS_INVALID;
 		}
@@ -28,7 +28,7 @@
  *		   If the input is invalid, then \a *ctx remains unchanged.
  */
 css_error css__parse_pause(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_style *result)
 {
 	int32_t orig_ctx = *ctx;
@@ -42,7 +42,7 @@ css_error css__parse_pause(css_language *c,
 	 *  tokens are either IDENT:none or URI
 	 */
 
-	first_token = parserutils_vector_peek(vector, *ctx);
+	first_token = css__token_vector_peek(vector, *ctx);
 
 	error = css__parse_pause_before(c, vector, ctx, result);
 	if (error == CSS_OK) {
@@ -50,7 +50,7 @@ css_error css__parse_pause(css_language *c,
 
 		consumeWhitespace(vector, ctx);
 
-		token = parserutils_vector_peek(vector, *ctx);
+		token = css__token_vector_peek(vector, *ctx);
 		if (token == NULL)  {
 			/* no second token, re-parse the first */
 			*ctx = orig_ctx;
@@ -28,7 +28,7 @@
  *		   If the input is invalid, then \a *ctx remains unchanged.
  */
 css_error css__parse_play_during(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_style *result)
 {
 	int32_t orig_ctx = *ctx;
@@ -41,7 +41,7 @@ css_error css__parse_play_during(css_language *c,
 	uint32_t uri_snumber;
 
 	/* URI [ IDENT(mix) || IDENT(repeat) ]? | IDENT(auto,none,inherit) */
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 	if ((token == NULL) ||
 	    ((token->type != CSS_TOKEN_IDENT) &&
 	     (token->type != CSS_TOKEN_URI))) {
@@ -109,7 +109,7 @@ css_error css__parse_play_during(css_language *c,
 		for (modifiers = 0; modifiers < 2; modifiers++) {
 			consumeWhitespace(vector, ctx);
 
-			token = parserutils_vector_peek(vector, *ctx);
+			token = css__token_vector_peek(vector, *ctx);
 			if (token != NULL && token->type == CSS_TOKEN_IDENT) {
 				if ((lwc_string_caseless_isequal(
 						token->idata, c->strings[MIX],
@@ -137,7 +137,7 @@ css_error css__parse_play_during(css_language *c,
 					return CSS_INVALID;
 				}
 
-				parserutils_vector_iterate(vector, ctx);
+				css__token_vector_iterate(vector, ctx);
 			}
 		}
 	}
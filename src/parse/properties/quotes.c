@@ -28,7 +28,7 @@
  *		   If the input is invalid, then \a *ctx remains unchanged.
  */
 css_error css__parse_quotes(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_style *result)
 {
 	int32_t orig_ctx = *ctx;
@@ -38,7 +38,7 @@ css_error css__parse_quotes(css_language *c,
 	bool match;
 
 	/* [ STRING STRING ]+ | IDENT(none,inherit) */
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 	if ((token == NULL) ||
 	    ((token->type != CSS_TOKEN_IDENT) &&
 	     (token->type != CSS_TOKEN_STRING))) {
@@ -79,7 +79,7 @@ css_error css__parse_quotes(css_language *c,
 
 			consumeWhitespace(vector, ctx);
 
-			token = parserutils_vector_iterate(vector, ctx);
+			token = css__token_vector_iterate(vector, ctx);
 			if ((token == NULL) ||
 			    (token->type != CSS_TOKEN_STRING)) {
 				error = CSS_INVALID;
@@ -108,10 +108,10 @@ css_error css__parse_quotes(css_language *c,
 
 			first = false;
 
-			token = parserutils_vector_peek(vector, *ctx);
+			token = css__token_vector_peek(vector, *ctx);
 			if (token == NULL || token->type != CSS_TOKEN_STRING)
 				break;
-			token = parserutils_vector_iterate(vector, ctx);
+			token = css__token_vector_iterate(vector, ctx);
 		}
 
 		if (error == CSS_OK) {
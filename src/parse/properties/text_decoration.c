@@ -28,7 +28,7 @@
  *                 If the input is invalid, then \a *ctx remains unchanged.
  */
 css_error css__parse_text_decoration(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_style *result)
 {
 	int32_t orig_ctx = *ctx;
@@ -39,7 +39,7 @@ css_error css__parse_text_decoration(css_language *c,
 
 	/* IDENT([ underline || overline || line-through || blink ])
 	 * | IDENT (none, inherit) */
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 	if ((token == NULL) || (token->type != CSS_TOKEN_IDENT) ) {
 		*ctx = orig_ctx;
 		return CSS_INVALID;
@@ -104,10 +104,10 @@ css_error css__parse_text_decoration(css_language *c,
 
 			consumeWhitespace(vector, ctx);
 
-			token = parserutils_vector_peek(vector, *ctx);
+			token = css__token_vector_peek(vector, *ctx);
 			if (token != NULL && token->type != CSS_TOKEN_IDENT)
 				break;
-			token = parserutils_vector_iterate(vector, ctx);
+			token = css__token_vector_iterate(vector, ctx);
 		}
 		error = css__stylesheet_style_appendOPV(result,
 				CSS_PROP_TEXT_DECORATION, 0, value);
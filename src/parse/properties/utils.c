@@ -126,7 +126,7 @@ css_error css__parse_list_style_type_value(css_language *c, const css_token *ide
  *		   If the input is invalid, then \a *ctx remains unchanged.
  */
 css_error css__parse_border_side(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_style *result, enum border_side_e side)
 {
 	int32_t orig_ctx = *ctx;
@@ -141,7 +141,7 @@ css_error css__parse_border_side(css_language *c,
 	css_style *width_style;
 
 	/* Firstly, handle inherit */
-	token = parserutils_vector_peek(vector, *ctx);
+	token = css__token_vector_peek(vector, *ctx);
 	if (token == NULL)
 		return CSS_INVALID;
 
@@ -156,7 +156,7 @@ css_error css__parse_border_side(css_language *c,
 
 		error = css_stylesheet_style_inherit(result, CSS_PROP_BORDER_TOP_WIDTH + side);
 		if (error == CSS_OK)
-			parserutils_vector_iterate(vector, ctx);
+			css__token_vector_iterate(vector, ctx);
 
 		return error;
 	}
@@ -185,7 +185,7 @@ css_error css__parse_border_side(css_language *c,
 		error = CSS_OK;
 
 		/* Ensure that we're not about to parse another inherit */
-		token = parserutils_vector_peek(vector, *ctx);
+		token = css__token_vector_peek(vector, *ctx);
 		if (token != NULL && is_css_inherit(c, token)) {
 			error = CSS_INVALID;
 			goto css__parse_border_side_cleanup;
@@ -211,7 +211,7 @@ css_error css__parse_border_side(css_language *c,
 		if (error == CSS_OK) {
 			consumeWhitespace(vector, ctx);
 
-			token = parserutils_vector_peek(vector, *ctx);
+			token = css__token_vector_peek(vector, *ctx);
 		} else {
 			/* Forcibly cause loop to exit */
 			token = NULL;
@@ -422,7 +422,7 @@ static void HWB_to_RGB(
  */
 static bool parse_rgb(
 		css_language *c,
-		const parserutils_vector *vector,
+		const css_token_vector *vector,
 		int32_t *ctx,
 		uint32_t *result)
 {
@@ -445,7 +445,7 @@ static bool parse_rgb(
 
 		consumeWhitespace(vector, ctx);
 
-		token = parserutils_vector_peek(vector, *ctx);
+		token = css__token_vector_peek(vector, *ctx);
 		if (token == NULL) {
 			return false;
 		} else if (!legacy && token->type == CSS_TOKEN_IDENT &&
@@ -474,9 +474,9 @@ static bool parse_rgb(
 				int_only = false;
 			}
 
-			num = css__number_from_lwc_string(token->idata,
-					int_only, &consumed);
-			if (consumed != lwc_string_length(token->idata)) {
+			num = css__number_from_string(token->data.data,
+					token->data.len, int_only, &consumed);
+			if (consumed != token->data.len) {
 				return false;
 			}
 
@@ -502,11 +502,11 @@ static bool parse_rgb(
 			}
 		}
 
-		parserutils_vector_iterate(vector, ctx);
+		css__token_vector_iterate(vector, ctx);
 
 		consumeWhitespace(vector, ctx);
 
-		token = parserutils_vector_peek(vector, *ctx);
+		token = css__token_vector_peek(vector, *ctx);
 		if (token == NULL) {
 			return false;
 		}
@@ -516,20 +516,20 @@ static bool parse_rgb(
 		}
 
 		if (i >= 2 && tokenIsChar(token, ')')) {
-			parserutils_vector_iterate(vector, ctx);
+			css__token_vector_iterate(vector, ctx);
 			break;
 
 		} else if (legacy) {
 			if (!tokenIsChar(token, ',')) {
 				return false;
 			}
-			parserutils_vector_iterate(vector, ctx);
+			css__token_vector_iterate(vector, ctx);
 
 		} else if (i == 2) {
 			if (!tokenIsChar(token, '/')) {
 				return false;
 			}
-			parserutils_vector_iterate(vector, ctx);
+			css__token_vector_iterate(vector, ctx);
 		}
 	}
 
@@ -549,7 +549,7 @@ static bool parse_rgb(
  * \return true on success, false on error.
  */
 static bool parse_hsl(
-		const parserutils_vector *vector,
+		const css_token_vector *vector,
 		int32_t *ctx,
 		uint32_t *result)
 {
@@ -566,24 +566,25 @@ static bool parse_hsl(
 	 */
 	consumeWhitespace(vector, ctx);
 
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 	if ((token == NULL) ||
 			(token->type != CSS_TOKEN_NUMBER &&
 			 token->type != CSS_TOKEN_DIMENSION)) {
 		return false;
 	}
 
-	hue = css__number_from_lwc_string(token->idata, false, &consumed);
+	hue = css__number_from_string(token->data.data,
+			token->data.len, false, &consumed);
 
 	switch (token->type) {
 	case CSS_TOKEN_NUMBER:
-		if (consumed != lwc_string_length(token->idata)) {
+		if (consumed != token->data.len) {
 			return false; /* failed to consume the whole string as a number */
 		}
 		break;
 	case CSS_TOKEN_DIMENSION: {
-		size_t len = lwc_string_length(token->idata);
-		const char *data = lwc_string_data(token->idata);
+		size_t len = token->data.len;
+		const char *data = (const char *) token->data.data;
 		uint32_t unit = UNIT_DEG;
 
 		error = css__parse_unit_keyword(
@@ -623,19 +624,19 @@ static bool parse_hsl(
 
 	consumeWhitespace(vector, ctx);
 
-	token = parserutils_vector_peek(vector, *ctx);
+	token = css__token_vector_peek(vector, *ctx);
 	if (token == NULL) {
 		return false;
 	}
 
 	if (tokenIsChar(token, ',')) {
-		parserutils_vector_iterate(vector, ctx);
+		css__token_vector_iterate(vector, ctx);
 		consumeWhitespace(vector, ctx);
 		legacy = true;
 	}
 
 	/* saturation */
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 	if (token == NULL)
 		return false;
 
@@ -644,8 +645,9 @@ static bool parse_hsl(
 		return false;
 	}
 
-	sat = css__number_from_lwc_string(token->idata, false, &consumed);
-	if (consumed != lwc_string_length(token->idata)) {
+	sat = css__number_from_string(token->data.data,
+			token->data.len, false, &consumed);
+	if (consumed != token->data.len) {
 		/* failed to consume the whole string as a number */
 		return false;
 	}
@@ -659,7 +661,7 @@ static bool parse_hsl(
 	consumeWhitespace(vector, ctx);
 
 	if (legacy) {
-		token = parserutils_vector_iterate(vector, ctx);
+		token = css__token_vector_iterate(vector, ctx);
 		if (token == NULL || !tokenIsChar(token, ',')) {
 			return false;
 		}
@@ -668,7 +670,7 @@ static bool parse_hsl(
 	}
 
 	/* lightness */
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 	if (token == NULL)
 		return false;
 
@@ -677,8 +679,9 @@ static bool parse_hsl(
 		return false;
 	}
 
-	lit = css__number_from_lwc_string(token->idata, false, &consumed);
-	if (consumed != lwc_string_length(token->idata)) {
+	lit = css__number_from_string(token->data.data,
+			token->data.len, false, &consumed);
+	if (consumed != token->data.len) {
 		/* failed to consume the whole string as a number */
 		return false;
 	}
@@ -691,21 +694,22 @@ static bool parse_hsl(
 
 	consumeWhitespace(vector, ctx);
 
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 
 	if (( legacy && tokenIsChar(token, ',')) ||
 	    (!legacy && tokenIsChar(token, '/'))) {
 		consumeWhitespace(vector, ctx);
 
-		token = parserutils_vector_iterate(vector, ctx);
+		token = css__token_vector_iterate(vector, ctx);
 		if ((token == NULL) ||
 				(token->type != CSS_TOKEN_NUMBER &&
 				 token->type != CSS_TOKEN_PERCENTAGE)) {
 			return false;
 		}
 
-		alpha = css__number_from_lwc_string(token->idata, false, &consumed);
-		if (consumed != lwc_string_length(token->idata)) {
+		alpha = css__number_from_string(token->data.data,
+				token->data.len, false, &consumed);
+		if (consumed != token->data.len) {
 			/* failed to consume the whole string as a number */
 			return false;
 		}
@@ -718,7 +722,7 @@ static bool parse_hsl(
 
 		consumeWhitespace(vector, ctx);
 
-		token = parserutils_vector_iterate(vector, ctx);
+		token = css__token_vector_iterate(vector, ctx);
 	}
 
 	if (!tokenIsChar(token, ')'))
@@ -751,7 +755,7 @@ static bool parse_hsl(
  * \return true on success, false on error.
  */
 static bool parse_hwb(
-		const parserutils_vector *vector,
+		const css_token_vector *vector,
 		int32_t *ctx,
 		uint32_t *result)
 {
@@ -767,24 +771,25 @@ static bool parse_hwb(
 	 */
 	consumeWhitespace(vector, ctx);
 
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 	if ((token == NULL) ||
 			(token->type != CSS_TOKEN_NUMBER &&
 			 token->type != CSS_TOKEN_DIMENSION)) {
 		return false;
 	}
 
-	hue = css__number_from_lwc_string(token->idata, false, &consumed);
+	hue = css__number_from_string(token->data.data,
+			token->data.len, false, &consumed);
 
 	switch (token->type) {
 	case CSS_TOKEN_NUMBER:
-		if (consumed != lwc_string_length(token->idata)) {
+		if (consumed != token->data.len) {
 			return false; /* failed to consume the whole string as a number */
 		}
 		break;
 	case CSS_TOKEN_DIMENSION: {
-		size_t len = lwc_string_length(token->idata);
-		const char *data = lwc_string_data(token->idata);
+		size_t len = token->data.len;
+		const char *data = (const char *) token->data.data;
 		uint32_t unit = UNIT_DEG;
 
 		error = css__parse_unit_keyword(
@@ -825,7 +830,7 @@ static bool parse_hwb(
 	consumeWhitespace(vector, ctx);
 
 	/* whiteness */
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 	if (token == NULL)
 		return false;
 
@@ -834,8 +839,9 @@ static bool parse_hwb(
 		return false;
 	}
 
-	white = css__number_from_lwc_string(token->idata, false, &consumed);
-	if (consumed != lwc_string_length(token->idata)) {
+	white = css__number_from_string(token->data.data,
+			token->data.len, false, &consumed);
+	if (consumed != token->data.len) {
 		/* failed to consume the whole string as a number */
 		return false;
 	}
@@ -849,7 +855,7 @@ static bool parse_hwb(
 	consumeWhitespace(vector, ctx);
 
 	/* blackness */
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 	if (token == NULL)
 		return false;
 
@@ -858,8 +864,9 @@ static bool parse_hwb(
 		return false;
 	}
 
-	black = css__number_from_lwc_string(token->idata, false, &consumed);
-	if (consumed != lwc_string_length(token->idata)) {
+	black = css__number_from_string(token->data.data,
+			token->data.len, false, &consumed);
+	if (consumed != token->data.len) {
 		/* failed to consume the whole string as a number */
 		return false;
 	}
@@ -872,20 +879,21 @@ static bool parse_hwb(
 
 	consumeWhitespace(vector, ctx);
 
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 
 	if (tokenIsChar(token, '/')) {
 		consumeWhitespace(vector, ctx);
 
-		token = parserutils_vector_iterate(vector, ctx);
+		token = css__token_vector_iterate(vector, ctx);
 		if ((token == NULL) ||
 				(token->type != CSS_TOKEN_NUMBER &&
 				 token->type != CSS_TOKEN_PERCENTAGE)) {
 			return false;
 		}
 
-		alpha = css__number_from_lwc_string(token->idata, false, &consumed);
-		if (consumed != lwc_string_length(token->idata)) {
+		alpha = css__number_from_string(token->data.data,
+				token->data.len, false, &consumed);
+		if (consumed != token->data.len) {
 			/* failed to consume the whole string as a number */
 			return false;
 		}
@@ -898,7 +906,7 @@ static bool parse_hwb(
 
 		consumeWhitespace(vector, ctx);
 
-		token = parserutils_vector_iterate(vector, ctx);
+		token = css__token_vector_iterate(vector, ctx);
 	}
 
 	if (!tokenIsChar(token, ')'))
@@ -929,13 +937,14 @@ static bool parse_hwb(
  * \param value   Pointer to location to receive value
  * \param result  Pointer to location to receive result (AARRGGBB)
  * \return CSS_OK      on success,
- *         CSS_INVALID if the input is invalid
+ *         CSS_INVALID if the input is invalid,
+ *         CSS_NOMEM   on memory exhaustion
  *
  * Post condition: \a *ctx is updated with the next token to process
  *                 If the input is invalid, then \a *ctx remains unchanged.
  */
 css_error css__parse_colour_specifier(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		uint16_t *value, uint32_t *result)
 {
 	int32_t orig_ctx = *ctx;
@@ -955,7 +964,7 @@ css_error css__parse_colour_specifier(css_language *c,
 	 * For quirks, NUMBER | DIMENSION | IDENT, too
 	 * I.E. "123456" -> NUMBER, "1234f0" -> DIMENSION, "f00000" -> IDENT
 	 */
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 	if (token == NULL || (token->type != CSS_TOKEN_IDENT &&
 			token->type != CSS_TOKEN_HASH &&
 			token->type != CSS_TOKEN_FUNCTION)) {
@@ -982,8 +991,14 @@ css_error css__parse_colour_specifier(css_language *c,
 		}
 
 		error = css__parse_named_colour(c, token->idata, result);
+		if (error == CSS_NOMEM) {
+			*ctx = orig_ctx;
+			return error;
+		}
+
 		if (error != CSS_OK && c->sheet->quirks_allowed) {
-			error = css__parse_hash_colour(token->idata, result);
+			error = css__parse_hash_colour(token->data.data,
+					token->data.len, result);
 			if (error == CSS_OK)
 				c->sheet->quirks_used = true;
 		}
@@ -991,19 +1006,22 @@ css_error css__parse_colour_specifier(css_language *c,
 		if (error != CSS_OK)
 			goto invalid;
 	} else if (token->type == CSS_TOKEN_HASH) {
-		error = css__parse_hash_colour(token->idata, result);
+		error = css__parse_hash_colour(token->data.data,
+				token->data.len, result);
 		if (error != CSS_OK)
 			goto invalid;
 	} else if (c->sheet->quirks_allowed &&
 			token->type == CSS_TOKEN_NUMBER) {
-		error = css__parse_hash_colour(token->idata, result);
+		error = css__parse_hash_colour(token->data.data,
+				token->data.len, result);
 		if (error == CSS_OK)
 			c->sheet->quirks_used = true;
 		else
 			goto invalid;
 	} else if (c->sheet->quirks_allowed &&
 			token->type == CSS_TOKEN_DIMENSION) {
-		error = css__parse_hash_colour(token->idata, result);
+		error = css__parse_hash_colour(token->data.data,
+				token->data.len, result);
 		if (error == CSS_OK)
 			c->sheet->quirks_used = true;
 		else
@@ -1060,7 +1078,8 @@ invalid:
  * \param data    Colour name string
  * \param result  Pointer to location to receive result
  * \return CSS_OK      on success,
- *         CSS_INVALID if the colour name is unknown
+ *         CSS_INVALID if the colour name is unknown,
+ *         CSS_NOMEM   on memory exhaustion
  */
 css_error css__parse_named_colour(css_language *c, lwc_string *data,
 		uint32_t *result)
@@ -1243,29 +1262,29 @@ css_error css__parse_named_colour(css_language *c, lwc_string *data,
 		BUTTONBORDER, /* WINDOWFRAME */
 		CANVASTEXT, /* WINDOWTEXT */
 	};
+	css_error error;
 	int i;
-	bool match;
 
 	/* try to match a named colour */
-	for (i = FIRST_COLOUR; i <= LAST_COLOUR; i++) {
-		if (lwc_string_caseless_isequal(data, c->strings[i], &match) ==
-		    lwc_error_ok &&
-		    match) {
-			/* Known named colour */
-			*result = colourmap[i - FIRST_COLOUR];
-			return CSS_OK;
-		}
+	error = css__propstrings_find(data, FIRST_COLOUR, LAST_COLOUR, &i);
+	if (error != CSS_OK)
+		return error;
+
+	if (i >= 0) {
+		/* Known named colour */
+		*result = colourmap[i - FIRST_COLOUR];
+		return CSS_OK;
 	}
 
 	/* map deprecated system colours to current system colours */
-	for (i = FIRST_DEPRECATEDCOLOUR; i <= LAST_DEPRECATEDCOLOUR; i++) {
-		if (lwc_string_caseless_isequal(data, c->strings[i], &match) ==
-		    lwc_error_ok &&
-		    match) {
-			/* Known legacy system named colour */
-			data = c->strings[deprecatedmap[i - FIRST_DEPRECATEDCOLOUR]];
-			break;
-		}
+	error = css__propstrings_find(data, FIRST_DEPRECATEDCOLOUR,
+			LAST_DEPRECATEDCOLOUR, &i);
+	if (error != CSS_OK)
+		return error;
+
+	if (i >= 0) {
+		/* Known legacy system named colour */
+		data = c->strings[deprecatedmap[i - FIRST_DEPRECATEDCOLOUR]];
 	}
 
 	/* attempt to get client to map colour */
@@ -1280,15 +1299,16 @@ css_error css__parse_named_colour(css_language *c, lwc_string *data,
  * Parse a hash colour (#rgb, #rgba, #rrggbb or #rrggbbaa)
  *
  * \param data    Pointer to colour string
+ * \param len     Length, in bytes, of colour string
  * \param result  Pointer to location to receive result (AARRGGBB)
  * \return CSS_OK      on success,
  *         CSS_INVALID if the input is invalid
  */
-css_error css__parse_hash_colour(lwc_string *data, uint32_t *result)
+css_error css__parse_hash_colour(const uint8_t *data, size_t len,
+		uint32_t *result)
 {
 	uint8_t r = 0, g = 0, b = 0, a = 0xff;
-	size_t len = lwc_string_length(data);
-	const char *input = lwc_string_data(data);
+	const char *input = (const char *) data;
 
 	switch (len) {
 	case 4:
@@ -1355,7 +1375,7 @@ css_error css__parse_hash_colour(lwc_string *data, uint32_t *result)
  *                 If the input is invalid, then \a *ctx remains unchanged.
  */
 css_error css__parse_unit_specifier(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		uint32_t default_unit,
 		css_fixed *length, uint32_t *unit)
 {
@@ -1367,7 +1387,7 @@ css_error css__parse_unit_specifier(css_language *c,
 
 	consumeWhitespace(vector, ctx);
 
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 	if (token == NULL || (token->type != CSS_TOKEN_DIMENSION &&
 			token->type != CSS_TOKEN_NUMBER &&
 			token->type != CSS_TOKEN_PERCENTAGE)) {
@@ -1375,11 +1395,12 @@ css_error css__parse_unit_specifier(css_language *c,
 		return CSS_INVALID;
 	}
 
-	num = css__number_from_lwc_string(token->idata, false, &consumed);
+	num = css__number_from_string(token->data.data,
+			token->data.len, false, &consumed);
 
 	if (token->type == CSS_TOKEN_DIMENSION) {
-		size_t len = lwc_string_length(token->idata);
-		const char *data = lwc_string_data(token->idata);
+		size_t len = token->data.len;
+		const char *data = (const char *) token->data.data;
 		uint32_t temp_unit = CSS_UNIT_PX;
 
 		error = css__parse_unit_keyword(data + consumed, len - consumed,
@@ -1414,7 +1435,7 @@ css_error css__parse_unit_specifier(css_language *c,
 			consumeWhitespace(vector, &temp_ctx);
 
 			/* Try to parse the unit keyword, ignoring errors */
-			token = parserutils_vector_iterate(vector, &temp_ctx);
+			token = css__token_vector_iterate(vector, &temp_ctx);
 			if (token != NULL && token->type == CSS_TOKEN_IDENT) {
 				error = css__parse_unit_keyword(
 						lwc_string_data(token->idata),
@@ -1429,7 +1450,7 @@ css_error css__parse_unit_specifier(css_language *c,
 		}
 	} else {
 		/* Percentage -- number must be entire token data */
-		if (consumed != lwc_string_length(token->idata)) {
+		if (consumed != token->data.len) {
 			*ctx = orig_ctx;
 			return CSS_INVALID;
 		}
@@ -1545,18 +1566,18 @@ css_error css__parse_unit_keyword(const char *ptr, size_t len, uint32_t *unit)
  *                 The resulting string's reference is passed to the caller
  */
 css_error css__ident_list_or_string_to_string(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		bool (*reserved)(css_language *c, const css_token *ident),
 		lwc_string **result)
 {
 	const css_token *token;
 
-	token = parserutils_vector_peek(vector, *ctx);
+	token = css__token_vector_peek(vector, *ctx);
 	if (token == NULL)
 		return CSS_INVALID;
 
 	if (token->type == CSS_TOKEN_STRING) {
-		token = parserutils_vector_iterate(vector, ctx);
+		token = css__token_vector_iterate(vector, ctx);
 		*result = lwc_string_ref(token->idata);
 		return CSS_OK;
 	} else	if(token->type == CSS_TOKEN_IDENT) {
@@ -1583,7 +1604,7 @@ css_error css__ident_list_or_string_to_string(css_language *c,
  *                 The resulting string's reference is passed to the caller
  */
 css_error css__ident_list_to_string(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		bool (*reserved)(css_language *c, const css_token *ident),
 		lwc_string **result)
 {
@@ -1600,7 +1621,7 @@ css_error css__ident_list_to_string(css_language *c,
 		return css_error_from_parserutils_error(perror);
 
 	/* We know this token exists, and is an IDENT */
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 
 	/* Consume all subsequent IDENT or S tokens */
 	while (token != NULL && (token->type == CSS_TOKEN_IDENT ||
@@ -1626,7 +1647,7 @@ css_error css__ident_list_to_string(css_language *c,
 			goto cleanup;
 		}
 
-		token = parserutils_vector_iterate(vector, ctx);
+		token = css__token_vector_iterate(vector, ctx);
 	}
 
 	/* Rewind context by one step if we consumed an unacceptable token */
@@ -1671,7 +1692,7 @@ cleanup:
  *                 If the input is invalid, then \a *ctx remains unchanged.
  */
 css_error css__comma_list_to_style(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		bool (*reserved)(css_language *c, const css_token *ident),
 		css_code_t (*get_value)(css_language *c, const css_token *token, bool first),
 		css_style *result)
@@ -1682,7 +1703,7 @@ css_error css__comma_list_to_style(css_language *c,
 	bool first = true;
 	css_error error = CSS_OK;
 
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 	if (token == NULL) {
 		*ctx = orig_ctx;
 		return CSS_INVALID;
@@ -1746,13 +1767,13 @@ css_error css__comma_list_to_style(css_language *c,
 
 		consumeWhitespace(vector, ctx);
 
-		token = parserutils_vector_peek(vector, *ctx);
+		token = css__token_vector_peek(vector, *ctx);
 		if (token != NULL && tokenIsChar(token, ',')) {
-			parserutils_vector_iterate(vector, ctx);
+			css__token_vector_iterate(vector, ctx);
 
 			consumeWhitespace(vector, ctx);
 
-			token = parserutils_vector_peek(vector, *ctx);
+			token = css__token_vector_peek(vector, *ctx);
 			if (token == NULL || (token->type != CSS_TOKEN_IDENT &&
 					token->type != CSS_TOKEN_STRING)) {
 				error = CSS_INVALID;
@@ -1766,7 +1787,7 @@ css_error css__comma_list_to_style(css_language *c,
 
 		prev_ctx = *ctx;
 
-		token = parserutils_vector_iterate(vector, ctx);
+		token = css__token_vector_iterate(vector, ctx);
 	}
 
 cleanup:
@@ -1816,17 +1837,156 @@ cleanup:
  *   /
  *   +
  *   =
+ *
+ * Operations whose operands are both constant are folded as they are
+ * parsed.  An operand is constant if it is a number, or a value in a unit
+ * which the calculator does not need to normalise (px, deg, ms, Hz, dpi).
+ * Thus calc(10px + 4px * 2) is stored as:
+ *
+ *   V 18 px
+ *   =
  */
 
 static css_error
 css__parse_calc_sum(css_language *c,
 		enum css_properties_e property,
-		const parserutils_vector *vector, int *ctx,
+		const css_token_vector *vector, int *ctx,
 		parserutils_buffer *result);
 
+/**
+ * Decode a buffer range which holds a single constant calc() operand
+ *
+ * \param buf    Buffer containing the calc bytecode
+ * \param start  Offset of the start of the range
+ * \param end    Offset of the end of the range
+ * \param value  Updated to the operand's value
+ * \param unit   Updated to the operand's unit, or UNIT_CALC_NUMBER
+ * \return true if the range holds exactly one constant operand, else false
+ */
+static bool
+css__parse_calc_constant(const parserutils_buffer *buf,
+		size_t start, size_t end,
+		css_fixed *value, uint32_t *unit)
+{
+	const size_t number_len = sizeof(css_code_t) + sizeof(css_fixed);
+	const size_t value_len = number_len + sizeof(uint32_t);
+	css_code_t op;
+
+	if (end - start != number_len && end - start != value_len)
+		return false;
+
+	memcpy(&op, buf->data + start, sizeof(op));
+	memcpy(value, buf->data + start + sizeof(op), sizeof(*value));
+
+	if (op == CALC_PUSH_NUMBER && end - start == number_len) {
+		*unit = UNIT_CALC_NUMBER;
+		return true;
+	}
+
+	if (op != CALC_PUSH_VALUE || end - start != value_len)
+		return false;
+
+	memcpy(unit, buf->data + start + number_len, sizeof(*unit));
+
+	/* Only units which normalise to themselves may be folded */
+	switch (*unit) {
+	case UNIT_PX:
+	case UNIT_DEG:
+	case UNIT_MS:
+	case UNIT_HZ:
+	case UNIT_DPI:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/**
+ * Fold a calc() operation with constant operands
+ *
+ * The left operand occupies [left, right) of the buffer and the right
+ * operand runs from right to the end of the buffer.  If both are constant
+ * they are replaced with the result of the operation, otherwise the buffer
+ * is left unchanged and the caller must emit the operator.
+ *
+ * \param result    Buffer containing the calc bytecode
+ * \param left      Offset of the start of the left operand
+ * \param right     Offset of the start of the right operand
+ * \param operator  The operation to fold
+ * \param folded    Updated to true if the operation was folded, else false
+ * \return CSS_OK on success, CSS_NOMEM on memory exhaustion
+ */
+static css_error
+css__parse_calc_fold(parserutils_buffer *result,
+		size_t left, size_t right, css_code_t operator,
+		bool *folded)
+{
+	css_fixed v_left, v_right;
+	uint32_t u_left, u_right;
+	css_code_t push;
+
+	*folded = false;
+
+	if (!css__parse_calc_constant(result, left, right,
+			&v_left, &u_left) ||
+			!css__parse_calc_constant(result, right, result->length,
+			&v_right, &u_right))
+		return CSS_OK;
+
+	switch (operator) {
+	case CALC_ADD:
+	case CALC_SUBTRACT:
+		if (u_left != u_right)
+			return CSS_OK;
+		if (operator == CALC_ADD)
+			v_left = css_add_fixed(v_left, v_right);
+		else
+			v_left = css_subtract_fixed(v_left, v_right);
+		break;
+	case CALC_MULTIPLY:
+		if (u_left == UNIT_CALC_NUMBER)
+			u_left = u_right;
+		else if (u_right != UNIT_CALC_NUMBER)
+			return CSS_OK;
+		v_left = css_multiply_fixed(v_left, v_right);
+		break;
+	case CALC_DIVIDE:
+		/* Leave division by zero for the calculator to reject */
+		if (u_right != UNIT_CALC_NUMBER || v_right == 0)
+			return CSS_OK;
+		v_left = css_divide_fixed(v_left, v_right);
+		break;
+	default:
+		return CSS_OK;
+	}
+
+	parserutils_buffer_discard(result, left, result->length - left);
+
+	if (u_left == UNIT_CALC_NUMBER) {
+		push = CALC_PUSH_NUMBER;
+		*folded = true;
+		return css_error_from_parserutils_error(
+			parserutils_buffer_appendv(result, 2,
+				&push, sizeof(push),
+				&v_left, sizeof(v_left)
+			)
+		);
+	}
+
+	push = CALC_PUSH_VALUE;
+	*folded = true;
+	return css_error_from_parserutils_error(
+		parserutils_buffer_appendv(result, 3,
+			&push, sizeof(push),
+			&v_left, sizeof(v_left),
+			&u_left, sizeof(u_left)
+		)
+	);
+}
+
 static css_error
 css__parse_calc_number(
-		const parserutils_vector *vector, int *ctx,
+		const css_token_vector *vector, int *ctx,
 		parserutils_buffer *result)
 {
 	const css_token *token;
@@ -1835,15 +1995,15 @@ css__parse_calc_number(
 	css_code_t push = CALC_PUSH_NUMBER;
 
 	/* Consume the number token */
-	token = parserutils_vector_iterate(vector, ctx);
+	token = css__token_vector_iterate(vector, ctx);
 	if (token == NULL || token->type != CSS_TOKEN_NUMBER) {
 		return CSS_INVALID;
 	}
 
-	num = css__number_from_string((const uint8_t *)lwc_string_data(token->idata),
-				lwc_string_length(token->idata), false, &consumed);
+	num = css__number_from_string(token->data.data, token->data.len,
+			false, &consumed);
 
-	if (consumed != lwc_string_length(token->idata)) {
+	if (consumed != token->data.len) {
 		return CSS_INVALID;
 	}
 
@@ -1858,7 +2018,7 @@ css__parse_calc_number(
 static css_error
 css__parse_calc_value(css_language *c,
 		enum css_properties_e property,
-		const parserutils_vector *vector, int *ctx,
+		const css_token_vector *vector, int *ctx,
 		parserutils_buffer *result)
 {
 	css_error error;
@@ -1866,21 +2026,21 @@ css__parse_calc_value(css_language *c,
 	const css_token *token;
 
 	/* On entry, we are already pointing at the value to parse, so peek it */
-	token = parserutils_vector_peek(vector, *ctx);
+	token = css__token_vector_peek(vector, *ctx);
 	if (tokenIsChar(token, '(')) {
-		parserutils_vector_iterate(vector, ctx);
+		css__token_vector_iterate(vector, ctx);
 		consumeWhitespace(vector, ctx);
 		error = css__parse_calc_sum(c, property, vector, ctx, result);
 		if (error != CSS_OK) {
 			return error;
 		}
 
-		token = parserutils_vector_peek(vector, *ctx);
+		token = css__token_vector_peek(vector, *ctx);
 		if (!tokenIsChar(token, ')')) {
 			return CSS_INVALID;
 		}
 		/* Consume the close-paren to complete this value */
-		parserutils_vector_iterate(vector, ctx);
+		css__token_vector_iterate(vector, ctx);
 	} else switch (token->type) {
 	case CSS_TOKEN_NUMBER:
 		error = css__parse_calc_number(vector, ctx, result);
@@ -1935,12 +2095,14 @@ css__parse_calc_value(css_language *c,
 static css_error
 css__parse_calc_product(css_language *c,
 		enum css_properties_e property,
-		const parserutils_vector *vector, int *ctx,
+		const css_token_vector *vector, int *ctx,
 		parserutils_buffer *result)
 {
 	css_error error = CSS_OK;
 	const css_token *token;
 	css_code_t operator;
+	size_t left = result->length, right;
+	bool folded;
 
 	/* First parse a value */
 	error = css__parse_calc_value(c, property, vector, ctx, result);
@@ -1950,7 +2112,7 @@ css__parse_calc_product(css_language *c,
 
 	do {
 		/* What is our next token? */
-		token = parserutils_vector_peek(vector, *ctx);
+		token = css__token_vector_peek(vector, *ctx);
 		if (token == NULL) {
 			error = CSS_INVALID;
 			break;
@@ -1968,10 +2130,11 @@ css__parse_calc_product(css_language *c,
 			break;
 		}
 		/* Consume that * or / now */
-		parserutils_vector_iterate(vector, ctx);
+		css__token_vector_iterate(vector, ctx);
 
 		consumeWhitespace(vector, ctx);
 
+		right = result->length;
 		if (operator == CALC_MULTIPLY) {
 			/* parse another value */
 			error = css__parse_calc_value(c, property, vector,
@@ -1982,6 +2145,13 @@ css__parse_calc_product(css_language *c,
 		if (error != CSS_OK)
 			break;
 
+		error = css__parse_calc_fold(result, left, right,
+				operator, &folded);
+		if (error != CSS_OK)
+			break;
+		if (folded)
+			continue;
+
 		/* emit the multiplication/division operator */
 		error = css_error_from_parserutils_error(
 			parserutils_buffer_append(result, (const uint8_t *)&operator, sizeof(operator))
@@ -1995,12 +2165,14 @@ css__parse_calc_product(css_language *c,
 css_error
 css__parse_calc_sum(css_language *c,
 		enum css_properties_e property,
-		const parserutils_vector *vector, int *ctx,
+		const css_token_vector *vector, int *ctx,
 		parserutils_buffer *result)
 {
 	css_error error = CSS_OK;
 	const css_token *token;
 	css_code_t operator;
+	size_t left = result->length, right;
+	bool folded;
 
 	/* First parse a product */
 	error = css__parse_calc_product(c, property, vector, ctx, result);
@@ -2010,7 +2182,7 @@ css__parse_calc_sum(css_language *c,
 
 	do {
 		/* What is our next token? */
-		token = parserutils_vector_peek(vector, *ctx);
+		token = css__token_vector_peek(vector, *ctx);
 		if (token == NULL) {
 			error = CSS_INVALID;
 			break;
@@ -2025,14 +2197,22 @@ css__parse_calc_sum(css_language *c,
 			break;
 		}
 		/* Consume that + or - now */
-		parserutils_vector_iterate(vector, ctx);
+		css__token_vector_iterate(vector, ctx);
 		consumeWhitespace(vector, ctx);
 
 		/* parse another product */
+		right = result->length;
 		error = css__parse_calc_product(c, property, vector, ctx, result);
 		if (error != CSS_OK)
 			break;
 
+		error = css__parse_calc_fold(result, left, right,
+				operator, &folded);
+		if (error != CSS_OK)
+			break;
+		if (folded)
+			continue;
+
 		/* emit the addition/subtraction operator */
 		error = css_error_from_parserutils_error(
 			parserutils_buffer_append(result, (const uint8_t *)&operator, sizeof(operator))
@@ -2044,7 +2224,7 @@ css__parse_calc_sum(css_language *c,
 
 /* Documented in utils.h */
 css_error css__parse_calc(css_language *c,
-		const parserutils_vector *vector, int *ctx,
+		const css_token_vector *vector, int *ctx,
 		css_style *result,
 		css_code_t OPV,
 		uint32_t unit)
@@ -2061,7 +2241,7 @@ css_error css__parse_calc(css_language *c,
 
 	consumeWhitespace(vector, ctx);
 
-	token = parserutils_vector_peek(vector, *ctx);
+	token = css__token_vector_peek(vector, *ctx);
 	if (token == NULL) {
 		*ctx = orig_ctx;
 		return CSS_INVALID;
@@ -2090,7 +2270,7 @@ css_error css__parse_calc(css_language *c,
 		goto cleanup;
 
 	consumeWhitespace(vector, ctx);
-	token = parserutils_vector_peek(vector, *ctx);
+	token = css__token_vector_peek(vector, *ctx);
 	if (!tokenIsChar(token, ')')) {
 		/* If we don't get a close-paren, give up now */
 		error = CSS_INVALID;
@@ -2105,7 +2285,7 @@ css_error css__parse_calc(css_language *c,
 		goto cleanup;
 
 	/* Swallow that close paren */
-	parserutils_vector_iterate(vector, ctx);
+	css__token_vector_iterate(vector, ctx);
 
 	/* Create the lwc string representing the calculation and store it in */
 	error = css_error_from_lwc_error(
@@ -66,7 +66,7 @@ enum border_side_e { BORDER_SIDE_TOP = 0, BORDER_SIDE_RIGHT = 1, BORDER_SIDE_BOT
  *		   If the input is invalid, then \a *ctx remains unchanged.
  */
 css_error css__parse_border_side(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_style *result, enum border_side_e side);
 
 /**
@@ -85,7 +85,7 @@ css_error css__parse_border_side(css_language *c,
  *		   If the input is invalid, then \a *ctx remains unchanged.
  */
 css_error css__parse_border_side_color(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_style *result, enum css_properties_e op);
 
 /**
@@ -104,7 +104,7 @@ css_error css__parse_border_side_color(css_language *c,
  *		   If the input is invalid, then \a *ctx remains unchanged.
  */
 css_error css__parse_border_side_style(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_style *result, enum css_properties_e op);
 
 
@@ -124,7 +124,7 @@ css_error css__parse_border_side_style(css_language *c,
  *		   If the input is invalid, then \a *ctx remains unchanged.
  */
 css_error css__parse_border_side_width(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_style *result, enum css_properties_e op);
 
 
@@ -144,7 +144,7 @@ css_error css__parse_border_side_width(css_language *c,
  *                 If the input is invalid, then \a *ctx remains unchanged.
  */
 css_error css__parse_side(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_style *result, enum css_properties_e op);
 
 
@@ -163,7 +163,7 @@ css_error css__parse_side(css_language *c,
  *		   If the input is invalid, then \a *ctx remains unchanged.
  */
 css_error css__parse_margin_side(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_style *result, enum css_properties_e op);
 
 /**
@@ -181,7 +181,7 @@ css_error css__parse_margin_side(css_language *c,
  *		   If the input is invalid, then \a *ctx remains unchanged.
  */
 css_error css__parse_padding_side(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		css_style *result, enum css_properties_e op);
 
 
@@ -194,16 +194,17 @@ css_error css__parse_list_style_type_value(css_language *c,
 		const css_token *token, uint16_t *value);
 
 css_error css__parse_colour_specifier(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		uint16_t *value, uint32_t *result);
 
 css_error css__parse_named_colour(css_language *c, lwc_string *data,
 		uint32_t *result);
 
-css_error css__parse_hash_colour(lwc_string *data, uint32_t *result);
+css_error css__parse_hash_colour(const uint8_t *data, size_t len,
+		uint32_t *result);
 
 css_error css__parse_unit_specifier(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		uint32_t default_unit,
 		css_fixed *length, uint32_t *unit);
 
@@ -211,17 +212,17 @@ css_error css__parse_unit_keyword(const char *ptr, size_t len,
 		uint32_t *unit);
 
 css_error css__ident_list_or_string_to_string(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		bool (*reserved)(css_language *c, const css_token *ident),
 		lwc_string **result);
 
 css_error css__ident_list_to_string(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		bool (*reserved)(css_language *c, const css_token *ident),
 		lwc_string **result);
 
 css_error css__comma_list_to_style(css_language *c,
-		const parserutils_vector *vector, int32_t *ctx,
+		const css_token_vector *vector, int32_t *ctx,
 		bool (*reserved)(css_language *c, const css_token *ident),
 		css_code_t (*get_value)(css_language *c,
 				const css_token *token,
@@ -248,7 +249,7 @@ css_error css__comma_list_to_style(css_language *c,
  *                 If the input is invalid, then \a *ctx remains unchanged.
  */
 css_error css__parse_calc(css_language *c,
-		const parserutils_vector *vector, int *ctx,
+		const css_token_vector *vector, int *ctx,
 		css_style *result,
 		css_code_t OPV,
 		uint32_t unit);
@@ -9,6 +9,7 @@
 #include "stylesheet.h"
 
 #include <assert.h>
+#include <string.h>
 
 /** build string map entry with a string constant */
 #define SMAP(s) { s, (sizeof((s)) - 1) /* -1 for '\0' */ }
@@ -19,9 +20,16 @@ typedef struct stringmap_entry {
 	size_t len;
 } stringmap_entry;
 
+/** Number of slots in the propstring index (a power of two) */
+#define INDEX_SLOTS 2048
+
 typedef struct css__propstrings_ctx {
 	uint32_t count;
 	lwc_string *strings[LAST_KNOWN];
+
+	/** Open addressed index of the strings by caseless hash value.
+	 * Each slot holds a string's number plus one, or zero if empty. */
+	uint16_t index[INDEX_SLOTS];
 } css__propstrings_ctx;
 
 static css__propstrings_ctx css__propstrings;
@@ -715,12 +723,28 @@ css_error css__propstrings_get(lwc_string ***strings)
 
 		/* Intern all known strings */
 		for (i = 0; i < LAST_KNOWN; i++) {
+			lwc_hash hash;
+
 			lerror = lwc_intern_string(stringmap[i].data,
 					stringmap[i].len,
 					&css__propstrings.strings[i]);
 
 			if (lerror != lwc_error_ok)
 				return CSS_NOMEM;
+
+			/* Index the string, which also interns its
+			 * caseless form */
+			lerror = lwc_string_caseless_hash_value(
+					css__propstrings.strings[i], &hash);
+			if (lerror != lwc_error_ok)
+				return CSS_NOMEM;
+
+			while (css__propstrings.index[
+					hash & (INDEX_SLOTS - 1)] != 0)
+				hash++;
+
+			css__propstrings.index[hash & (INDEX_SLOTS - 1)] =
+					i + 1;
 		}
 		css__propstrings.count++;
 	}
@@ -744,5 +768,55 @@ void css__propstrings_unref(void)
 
 		for (i = 0; i < LAST_KNOWN; i++)
 			lwc_string_unref(css__propstrings.strings[i]);
+
+		memset(css__propstrings.index, 0,
+				sizeof(css__propstrings.index));
+	}
+}
+
+/**
+ * Find a string in a range of the propstring list, ignoring case
+ *
+ * \param string  The string to look for
+ * \param first   Number of the first propstring to consider
+ * \param last    Number of the last propstring to consider
+ * \param index   Pointer to location to receive number of the matching
+ *                propstring, or -1 if none matches
+ * \return CSS_OK on success,
+ *         CSS_NOMEM on memory exhaustion
+ *
+ * This is equivalent to testing each propstring in the range with
+ * lwc_string_caseless_isequal(), but takes constant time.
+ */
+css_error css__propstrings_find(lwc_string *string, int first, int last,
+		int *index)
+{
+	lwc_hash hash;
+	uint16_t slot;
+
+	*index = -1;
+
+	if (lwc_string_caseless_hash_value(string, &hash) != lwc_error_ok)
+		return CSS_NOMEM;
+
+	while ((slot = css__propstrings.index[hash & (INDEX_SLOTS - 1)]) != 0) {
+		int i = slot - 1;
+		bool match;
+
+		if (i >= first && i <= last) {
+			if (lwc_string_caseless_isequal(
+					css__propstrings.strings[i], string,
+					&match) != lwc_error_ok)
+				return CSS_NOMEM;
+
+			if (match) {
+				*index = i;
+				break;
+			}
+		}
+
+		hash++;
 	}
+
+	return CSS_OK;
 }
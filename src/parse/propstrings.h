@@ -170,5 +170,7 @@ enum {
 
 css_error css__propstrings_get(lwc_string ***strings);
 void css__propstrings_unref(void);
+css_error css__propstrings_find(lwc_string *string, int first, int last,
+		int *index);
 
 #endif
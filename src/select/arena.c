@@ -6,16 +6,48 @@
  * Copyright 2015 Michael Drake <tlsa@netsurf-browser.org>
  */
 
+#include <stdlib.h>
 #include <string.h>
 
 #include "select/arena.h"
 #include "select/arena_hash.h"
 #include "select/computed.h"
 
-#define TU_SIZE 3037
-#define TS_SIZE 5101
+/** Initial number of bins in an arena's hash table */
+#define TS_INITIAL_SIZE 256
 
-struct css_computed_style *table_s[TS_SIZE];
+/** Number of bins to migrate to a grown table per arena operation */
+#define TS_MIGRATE_STEP 8
+
+/**
+ * Style sharing arena
+ *
+ * Interned styles are kept in a chained hash table, indexed by the low bits
+ * of each style's hash.  The table has a power of two number of bins, and is
+ * doubled in size when its load factor exceeds 3/4.
+ *
+ * Growing is incremental: the previous table is kept, and its bins are moved
+ * into the new table a few at a time by subsequent arena operations.  While
+ * this happens, bins of the old table below `migrate` have already been
+ * moved, and styles which hash to them live in the new table.
+ */
+struct css_arena {
+	uint32_t refcount;	/**< Number of references to the arena */
+
+	struct css_computed_style **table;	/**< Current hash table */
+	uint32_t size;				/**< Bins in current table */
+
+	struct css_computed_style **old_table;	/**< Table being migrated */
+	uint32_t old_size;			/**< Bins in old table */
+	uint32_t migrate;			/**< Next old bin to migrate */
+
+	uint32_t count;		/**< Number of interned styles */
+
+	uint64_t lookups;	/**< Number of styles looked up */
+	uint64_t hits;		/**< Lookups which found an existing style */
+	uint64_t probes;	/**< Chain entries visited by lookups */
+	uint64_t compares;	/**< Full style comparisons performed */
+};
 
 
 static inline uint32_t css__arena_hash_style(struct css_computed_style *s)
@@ -145,51 +177,286 @@ static inline bool css__arena_style_is_equal(
 }
 
 
+/**
+ * Find the bin that a style hash belongs in
+ *
+ * \param arena  The arena to look in
+ * \param hash   The style hash
+ * \return Pointer to the head of the bin's chain
+ */
+static inline struct css_computed_style **css__arena_bin(
+		css_arena *arena, uint32_t hash)
+{
+	if (arena->old_table != NULL) {
+		uint32_t index = hash & (arena->old_size - 1);
+
+		if (index >= arena->migrate) {
+			return &arena->old_table[index];
+		}
+	}
+
+	return &arena->table[hash & (arena->size - 1)];
+}
+
+
+/**
+ * Move some bins of a table being migrated into the current table
+ *
+ * \param arena  The arena to progress migration of
+ * \param bins   The maximum number of old bins to migrate
+ */
+static void css__arena_migrate(css_arena *arena, uint32_t bins)
+{
+	if (arena->old_table == NULL) {
+		return;
+	}
+
+	while (bins-- > 0 && arena->migrate < arena->old_size) {
+		struct css_computed_style *l = arena->old_table[arena->migrate];
+
+		while (l != NULL) {
+			struct css_computed_style *next = l->next;
+			struct css_computed_style **bin =
+					&arena->table[l->hash &
+						(arena->size - 1)];
+
+			l->next = *bin;
+			*bin = l;
+			l = next;
+		}
+
+		arena->old_table[arena->migrate] = NULL;
+		arena->migrate++;
+	}
+
+	if (arena->migrate == arena->old_size) {
+		free(arena->old_table);
+		arena->old_table = NULL;
+		arena->old_size = 0;
+		arena->migrate = 0;
+	}
+}
+
+
+/**
+ * Grow an arena's hash table, if its load factor requires it
+ *
+ * Failure to grow is not an error; the arena just gets slower.
+ *
+ * \param arena  The arena to consider growing
+ */
+static void css__arena_grow(css_arena *arena)
+{
+	struct css_computed_style **table;
+
+	if (arena->count <= arena->size - arena->size / 4 ||
+			arena->size > UINT32_MAX / 2) {
+		return;
+	}
+
+	/* Finish any previous migration before starting another */
+	css__arena_migrate(arena, arena->old_size);
+
+	table = calloc(arena->size * 2, sizeof(*table));
+	if (table == NULL) {
+		return;
+	}
+
+	arena->old_table = arena->table;
+	arena->old_size = arena->size;
+	arena->migrate = 0;
+
+	arena->table = table;
+	arena->size *= 2;
+}
+
+
+/* Internally exported function, documented in src/select/arena.h */
+css_error css__arena_create(css_arena **arena)
+{
+	css_arena *a;
+
+	a = calloc(1, sizeof(css_arena));
+	if (a == NULL) {
+		return CSS_NOMEM;
+	}
+
+	a->table = calloc(TS_INITIAL_SIZE, sizeof(*a->table));
+	if (a->table == NULL) {
+		free(a);
+		return CSS_NOMEM;
+	}
+
+	a->size = TS_INITIAL_SIZE;
+	a->refcount = 1;
+
+	*arena = a;
+	return CSS_OK;
+}
+
+
+/* Internally exported function, documented in src/select/arena.h */
+css_arena *css__arena_ref(css_arena *arena)
+{
+	arena->refcount++;
+	return arena;
+}
+
+
+/* Internally exported function, documented in src/select/arena.h */
+void css__arena_unref(css_arena *arena)
+{
+	arena->refcount--;
+	if (arena->refcount == 0) {
+		free(arena->old_table);
+		free(arena->table);
+		free(arena);
+	}
+}
+
+
+/* Internally exported function, documented in src/select/arena.h */
+void css__arena_get_stats(css_arena *arena, css_select_arena_stats *stats)
+{
+	uint32_t longest = 0;
+	uint32_t used = 0;
+
+	/* Settle the table, so the chain statistics describe one table */
+	css__arena_migrate(arena, arena->old_size);
+
+	for (uint32_t i = 0; i < arena->size; i++) {
+		struct css_computed_style *l;
+		uint32_t length = 0;
+
+		for (l = arena->table[i]; l != NULL; l = l->next) {
+			length++;
+		}
+
+		if (length > 0) {
+			used++;
+		}
+		if (length > longest) {
+			longest = length;
+		}
+	}
+
+	stats->styles = arena->count;
+	stats->bins = arena->size;
+	stats->used_bins = used;
+	stats->longest_chain = longest;
+	stats->lookups = arena->lookups;
+	stats->hits = arena->hits;
+	stats->probes = arena->probes;
+	stats->compares = arena->compares;
+}
+
+
+/**
+ * Look for an interned style equal to a given one
+ *
+ * \param arena  The arena to look in
+ * \param s      The style to look for; its hash is updated
+ * \return The equal interned style, or NULL if there is none
+ */
+static struct css_computed_style *css__arena_lookup(css_arena *arena,
+		struct css_computed_style *s)
+{
+	struct css_computed_style *l;
+
+	css__arena_migrate(arena, TS_MIGRATE_STEP);
+
+	s->hash = css__arena_hash_style(s);
+
+	/* Check for existing; the full hash is compared first, so that
+	 * the costly full comparison is only made for likely matches */
+	arena->lookups++;
+	for (l = *css__arena_bin(arena, s->hash); l != NULL; l = l->next) {
+		arena->probes++;
+		if (l->hash != s->hash) {
+			continue;
+		}
+
+		arena->compares++;
+		if (css__arena_style_is_equal(l, s)) {
+			arena->hits++;
+			return l;
+		}
+	}
+
+	return NULL;
+}
+
+
+/**
+ * Add a style which has no equal to an arena
+ *
+ * \param arena  The arena to add to
+ * \param s      The style to add, as hashed by css__arena_lookup()
+ */
+static void css__arena_insert(css_arena *arena, struct css_computed_style *s)
+{
+	struct css_computed_style **bin = css__arena_bin(arena, s->hash);
+
+	s->next = *bin;
+	*bin = s;
+	s->arena = css__arena_ref(arena);
+	s->count = 1;
+
+	arena->count++;
+	css__arena_grow(arena);
+}
+
+
 /* Internally exported function, documented in src/select/arena.h */
-css_error css__arena_intern_style(struct css_computed_style **style)
+css_error css__arena_intern_style(css_arena *arena,
+		struct css_computed_style **style)
 {
 	struct css_computed_style *s = *style;
-	uint32_t hash, index;
+	struct css_computed_style *l;
 
 	/* Don't try to intern an already-interned computed style */
-	if (s->count != 0) {
+	if (arena == NULL || s->count != 0) {
 		return CSS_BADPARM;
 	}
 
-	/* Need to intern the style block */
-	hash = css__arena_hash_style(s);
-	index = hash % TS_SIZE;
-	s->bin = index;
+	l = css__arena_lookup(arena, s);
+	if (l != NULL) {
+		/* Equal styles are equally absolute */
+		l->absolute |= s->absolute;
+		css_computed_style_destroy(s);
+		l->count++;
+		*style = l;
+		return CSS_OK;
+	}
 
-	if (table_s[index] == NULL) {
-		/* Can just insert */
-		table_s[index] = s;
-		s->count = 1;
-	} else {
-		/* Check for existing */
-		struct css_computed_style *l = table_s[index];
-		struct css_computed_style *existing = NULL;
-
-		do {
-			if (css__arena_style_is_equal(l, s)) {
-				existing = l;
-				break;
-			}
-			l = l->next;
-		} while (l != NULL);
-
-		if (existing != NULL) {
-			css_computed_style_destroy(s);
-			existing->count++;
-			*style = existing;
-		} else {
-			/* Add to list */
-			s->next = table_s[index];
-			table_s[index] = s;
-			s->count = 1;
-		}
+	css__arena_insert(arena, s);
+
+	return CSS_OK;
+}
+
+
+/* Internally exported function, documented in src/select/arena.h */
+css_error css__arena_find_style(css_arena *arena,
+		struct css_computed_style *style,
+		struct css_computed_style **result)
+{
+	struct css_computed_style *l;
+
+	if (arena == NULL || style->count != 0) {
+		return CSS_BADPARM;
+	}
+
+	l = css__arena_lookup(arena, style);
+	if (l != NULL) {
+		l->absolute |= style->absolute;
+		l->count++;
+		*result = l;
+		return CSS_OK;
 	}
 
+	css__arena_insert(arena, style);
+	*result = style;
+
 	return CSS_OK;
 }
 
@@ -197,36 +464,42 @@ css_error css__arena_intern_style(struct css_computed_style **style)
 /* Internally exported function, documented in src/select/arena.h */
 enum css_error css__arena_remove_style(struct css_computed_style *style)
 {
-	uint32_t index = style->bin;
+	css_arena *arena = style->arena;
+	struct css_computed_style **bin;
+	struct css_computed_style *l;
+	struct css_computed_style *prev = NULL;
 
-	if (table_s[index] == NULL) {
+	if (arena == NULL) {
 		return CSS_BADPARM;
+	}
 
-	} else {
-		/* Check for existing */
-		struct css_computed_style *l = table_s[index];
-		struct css_computed_style *existing = NULL;
-		struct css_computed_style *prev = NULL;
-
-		do {
-			if (css__arena_style_is_equal(l, style)) {
-				existing = l;
-				break;
-			}
-			prev = l;
-			l = l->next;
-		} while (l != NULL);
-
-		if (existing != NULL) {
-			if (prev != NULL) {
-				prev->next = existing->next;
-			} else {
-				table_s[index] = existing->next;
-			}
-		} else {
-			return CSS_BADPARM;
+	css__arena_migrate(arena, TS_MIGRATE_STEP);
+
+	/* An interned style is the only one of its value in the arena,
+	 * so we can find it by identity rather than by comparison */
+	bin = css__arena_bin(arena, style->hash);
+	for (l = *bin; l != NULL; l = l->next) {
+		if (l == style) {
+			break;
 		}
+		prev = l;
 	}
 
+	if (l == NULL) {
+		return CSS_BADPARM;
+	}
+
+	if (prev != NULL) {
+		prev->next = l->next;
+	} else {
+		*bin = l->next;
+	}
+
+	arena->count--;
+
+	style->next = NULL;
+	style->arena = NULL;
+	css__arena_unref(arena);
+
 	return CSS_OK;
 }
@@ -9,8 +9,57 @@
 #ifndef css_select_arena_h_
 #define css_select_arena_h_
 
+#include <libcss/errors.h>
+#include <libcss/select.h>
+
 struct css_computed_style;
 
+/**
+ * Style sharing arena
+ *
+ * Each selection context owns an arena into which the computed styles it
+ * produces are interned.  Interned styles hold a reference to the arena
+ * they live in, so an arena outlives its context for as long as any of
+ * its styles remain.
+ */
+typedef struct css_arena css_arena;
+
+/**
+ * Create a style sharing arena
+ *
+ * The created arena has a reference count of one.
+ *
+ * \param arena  Updated to the new arena on success
+ * \return CSS_OK on success, CSS_NOMEM on memory exhaustion.
+ */
+css_error css__arena_create(css_arena **arena);
+
+/**
+ * Add a reference to a style sharing arena
+ *
+ * \param arena  The arena to reference
+ * \return The same arena pointer for ease of use
+ */
+css_arena *css__arena_ref(css_arena *arena);
+
+/**
+ * Remove a reference to a style sharing arena
+ *
+ * The arena is freed when its last reference is removed.  Every interned
+ * style holds a reference, so an arena is never freed while in use.
+ *
+ * \param arena  The arena to unref
+ */
+void css__arena_unref(css_arena *arena);
+
+/**
+ * Get the usage statistics of a style sharing arena
+ *
+ * \param arena  The arena to get statistics for
+ * \param stats  Updated to the arena's statistics
+ */
+void css__arena_get_stats(css_arena *arena, css_select_arena_stats *stats);
+
 /*
  * Add computed style to the style sharing arena, or exchange for existing
  *
@@ -18,14 +67,36 @@ struct css_computed_style;
  * may be freed by this call and all future usage should be via the
  * updated computed style parameter.
  *
+ * \params arena  The arena to intern the style into
  * \params style  The style to intern; possibly freed and updated
  * \return CSS_OK on success or appropriate error otherwise.
  */
-enum css_error css__arena_intern_style(struct css_computed_style **style);
+enum css_error css__arena_intern_style(css_arena *arena,
+		struct css_computed_style **style);
+
+/*
+ * Find a computed style's equal in the style sharing arena, or add it
+ *
+ * Unlike css__arena_intern_style(), this never frees the given style, so
+ * a caller may compose into the same style again once it has been found
+ * to equal one already interned.
+ *
+ * \params arena   The arena to look in
+ * \params style   The style to find; interned itself if it has no equal
+ * \params result  Updated to a reference to the interned equal of
+ *                 \a style, which is \a style itself if it had none
+ * \return CSS_OK on success or appropriate error otherwise.
+ */
+enum css_error css__arena_find_style(css_arena *arena,
+		struct css_computed_style *style,
+		struct css_computed_style **result);
 
 /*
  * Remove a computed style from the style sharing arena
  *
+ * The style is removed from the arena it was interned into, and the
+ * style's reference to that arena is released.
+ *
  * \params style  The style to remove from the style sharing arena
  * \return CSS_OK on success or appropriate error otherwise.
  */
@@ -23,6 +23,11 @@ include_propget = '''\
 #include "select/propget.h"
 '''
 
+include_computed = '''\
+
+#include "select/computed.h"
+'''
+
 include_calc = '''\
 
 #include "select/calc.h"
@@ -50,6 +55,10 @@ assets['propget.h'] = {}
 assets['propget.h']['header'] = copyright + ifndef("propget")
 assets['propget.h']['footer'] = '\n#endif\n'
 
+assets['compose.h'] = {}
+assets['compose.h']['header'] = copyright + ifndef("compose") + include_computed
+assets['compose.h']['footer'] = '\n#endif\n'
+
 assets['destroy.inc'] = {}
 assets['destroy.inc']['header'] = copyright
 assets['destroy.inc']['footer'] = ''
@@ -0,0 +1,630 @@
+/*
+ * This file is part of LibCSS
+ * Licensed under the MIT License,
+ *                http://www.opensource.org/licenses/mit-license.php
+ * Copyright 2017 The NetSurf Project
+ */
+
+#ifndef CSS_COMPUTED_COMPOSE_H_
+#define CSS_COMPUTED_COMPOSE_H_
+
+#include "select/computed.h"
+
+
+/*
+ * Most properties are composed by taking the child's value, or the parent's
+ * where the child's is inherit. Those which own no references and have no
+ * special composition rules are blended: their bits are selected from the
+ * parent's and child's a whole word at a time, and their values copied without
+ * calls through the dispatch table.
+ * 
+ * Every property's inherit opcode is zero, so a property is inherit exactly
+ * when its opcode bits are clear.
+ */
+
+#define COMPOSE_N_WORDS 15
+
+/** Bits of each word of the bits array held by blended properties */
+static const uint32_t compose_blend_masks[COMPOSE_N_WORDS] = {
+	0xffffffff,
+	0xffffffff,
+	0x0000003f,
+	0xfe03ffff,
+	0x01fffff0,
+	0xffffffff,
+	0xfffff80f,
+	0xffffffff,
+	0xffffffff,
+	0x07ffffff,
+	0xffffffff,
+	0xff3fffff,
+	0xffffffff,
+	0xfffffc7f,
+	0xf7720000,
+};
+
+/** Properties which are composed by their own functions */
+static const uint16_t compose_call_props[] = {
+	CSS_PROP_BACKGROUND_IMAGE,
+	CSS_PROP_CLIP,
+	CSS_PROP_COLUMN_GAP,
+	CSS_PROP_CONTENT,
+	CSS_PROP_COUNTER_INCREMENT,
+	CSS_PROP_COUNTER_RESET,
+	CSS_PROP_CURSOR,
+	CSS_PROP_FONT_FAMILY,
+	CSS_PROP_LINE_HEIGHT,
+	CSS_PROP_LIST_STYLE_IMAGE,
+	CSS_PROP_QUOTES,
+	CSS_PROP_TEXT_ALIGN,
+	CSS_PROP_WIDTH,
+};
+
+/**
+ * Find the blended properties of a style which are inherit
+ *
+ * \param style    The style to consider
+ * \param inherit  Updated to the bits of each word of the bits array held
+ *                 by blended properties which are inherit
+ */
+static inline void compose_inherit_masks(
+		const css_computed_style *style,
+		uint32_t inherit[COMPOSE_N_WORDS])
+{
+	uint32_t bits;
+
+	/*
+	 * border_top_width; border_right_width; border_left_width;
+	 * border_bottom_width
+	 */
+	bits = style->i.bits[0];
+	inherit[0] = ((bits & 0x07000000) ? 0 : 0xff000000) |
+			((bits & 0x00070000) ? 0 : 0x00ff0000) |
+			((bits & 0x00000700) ? 0 : 0x0000ff00) |
+			((bits & 0x00000007) ? 0 : 0x000000ff);
+
+	/*
+	 * font_size; outline_width; column_rule_width; word_spacing
+	 */
+	bits = style->i.bits[1];
+	inherit[1] = ((bits & 0x07800000) ? 0 : 0xff800000) |
+			((bits & 0x00038000) ? 0 : 0x007f8000) |
+			((bits & 0x00000380) ? 0 : 0x00007f80) |
+			((bits & 0x00000003) ? 0 : 0x0000007f);
+
+	/*
+	 * text_indent
+	 */
+	bits = style->i.bits[2];
+	inherit[2] = ((bits & 0x00000001) ? 0 : 0x0000003f);
+
+	/*
+	 * column_width; bottom; padding_top; text_decoration
+	 */
+	bits = style->i.bits[3];
+	inherit[3] = ((bits & 0x06000000) ? 0 : 0xfe000000) |
+			((bits & 0x00001800) ? 0 : 0x0003f800) |
+			((bits & 0x00000020) ? 0 : 0x000007e0) |
+			((bits & 0x0000001f) ? 0 : 0x0000001f);
+
+	/*
+	 * top; right; min_width
+	 */
+	bits = style->i.bits[4];
+	inherit[4] = ((bits & 0x000c0000) ? 0 : 0x01fc0000) |
+			((bits & 0x00001800) ? 0 : 0x0003f800) |
+			((bits & 0x00000030) ? 0 : 0x000007f0);
+
+	/*
+	 * min_height; max_width; max_height; margin_top; outline_style
+	 */
+	bits = style->i.bits[5];
+	inherit[5] = ((bits & 0x06000000) ? 0 : 0xfe000000) |
+			((bits & 0x000c0000) ? 0 : 0x01fc0000) |
+			((bits & 0x00001800) ? 0 : 0x0003f800) |
+			((bits & 0x00000030) ? 0 : 0x000007f0) |
+			((bits & 0x0000000f) ? 0 : 0x0000000f);
+
+	/*
+	 * margin_right; margin_left; margin_bottom; font_weight
+	 */
+	bits = style->i.bits[6];
+	inherit[6] = ((bits & 0x06000000) ? 0 : 0xfe000000) |
+			((bits & 0x000c0000) ? 0 : 0x01fc0000) |
+			((bits & 0x00001800) ? 0 : 0x0003f800) |
+			((bits & 0x0000000f) ? 0 : 0x0000000f);
+
+	/*
+	 * letter_spacing; left; height; flex_basis; column_rule_style
+	 */
+	bits = style->i.bits[7];
+	inherit[7] = ((bits & 0x06000000) ? 0 : 0xfe000000) |
+			((bits & 0x000c0000) ? 0 : 0x01fc0000) |
+			((bits & 0x00001800) ? 0 : 0x0003f800) |
+			((bits & 0x00000030) ? 0 : 0x000007f0) |
+			((bits & 0x0000000f) ? 0 : 0x0000000f);
+
+	/*
+	 * padding_right; padding_left; padding_bottom; list_style_type;
+	 * display; white_space
+	 */
+	bits = style->i.bits[8];
+	inherit[8] = ((bits & 0x04000000) ? 0 : 0xfc000000) |
+			((bits & 0x00100000) ? 0 : 0x03f00000) |
+			((bits & 0x00004000) ? 0 : 0x000fc000) |
+			((bits & 0x00003f00) ? 0 : 0x00003f00) |
+			((bits & 0x000000f8) ? 0 : 0x000000f8) |
+			((bits & 0x00000007) ? 0 : 0x00000007);
+
+	/*
+	 * break_inside; break_before; break_after; border_top_style;
+	 * border_right_style; border_left_style; text_transform
+	 */
+	bits = style->i.bits[9];
+	inherit[9] = ((bits & 0x07800000) ? 0 : 0x07800000) |
+			((bits & 0x00780000) ? 0 : 0x00780000) |
+			((bits & 0x00078000) ? 0 : 0x00078000) |
+			((bits & 0x00007800) ? 0 : 0x00007800) |
+			((bits & 0x00000780) ? 0 : 0x00000780) |
+			((bits & 0x00000078) ? 0 : 0x00000078) |
+			((bits & 0x00000007) ? 0 : 0x00000007);
+
+	/*
+	 * background_repeat; align_self; align_items; align_content; z_index;
+	 * writing_mode; visibility; unicode_bidi; table_layout;
+	 * page_break_inside; outline_color; list_style_position; font_variant;
+	 * font_style
+	 */
+	bits = style->i.bits[10];
+	inherit[10] = ((bits & 0xe0000000) ? 0 : 0xe0000000) |
+			((bits & 0x1c000000) ? 0 : 0x1c000000) |
+			((bits & 0x03800000) ? 0 : 0x03800000) |
+			((bits & 0x00700000) ? 0 : 0x00700000) |
+			((bits & 0x000c0000) ? 0 : 0x000c0000) |
+			((bits & 0x00030000) ? 0 : 0x00030000) |
+			((bits & 0x0000c000) ? 0 : 0x0000c000) |
+			((bits & 0x00003000) ? 0 : 0x00003000) |
+			((bits & 0x00000c00) ? 0 : 0x00000c00) |
+			((bits & 0x00000300) ? 0 : 0x00000300) |
+			((bits & 0x000000c0) ? 0 : 0x000000c0) |
+			((bits & 0x00000030) ? 0 : 0x00000030) |
+			((bits & 0x0000000c) ? 0 : 0x0000000c) |
+			((bits & 0x00000003) ? 0 : 0x00000003);
+
+	/*
+	 * float; flex_wrap; empty_cells; direction; column_span;
+	 * column_rule_color; column_fill; column_count; caption_side;
+	 * box_sizing; border_top_color; border_right_color; border_left_color;
+	 * border_collapse; border_bottom_color
+	 */
+	bits = style->i.bits[11];
+	inherit[11] = ((bits & 0xc0000000) ? 0 : 0xc0000000) |
+			((bits & 0x30000000) ? 0 : 0x30000000) |
+			((bits & 0x0c000000) ? 0 : 0x0c000000) |
+			((bits & 0x03000000) ? 0 : 0x03000000) |
+			((bits & 0x00300000) ? 0 : 0x00300000) |
+			((bits & 0x000c0000) ? 0 : 0x000c0000) |
+			((bits & 0x00030000) ? 0 : 0x00030000) |
+			((bits & 0x0000c000) ? 0 : 0x0000c000) |
+			((bits & 0x00003000) ? 0 : 0x00003000) |
+			((bits & 0x00000c00) ? 0 : 0x00000c00) |
+			((bits & 0x00000300) ? 0 : 0x00000300) |
+			((bits & 0x000000c0) ? 0 : 0x000000c0) |
+			((bits & 0x00000030) ? 0 : 0x00000030) |
+			((bits & 0x0000000c) ? 0 : 0x0000000c) |
+			((bits & 0x00000003) ? 0 : 0x00000003);
+
+	/*
+	 * border_spacing; background_position; vertical_align; widows
+	 */
+	bits = style->i.bits[12];
+	inherit[12] = ((bits & 0x00200000) ? 0 : 0xffe00000) |
+			((bits & 0x00000400) ? 0 : 0x001ffc00) |
+			((bits & 0x0000001e) ? 0 : 0x000003fe) |
+			((bits & 0x00000001) ? 0 : 0x00000001);
+
+	/*
+	 * border_bottom_style; position; page_break_before; page_break_after;
+	 * overflow_y; overflow_x; justify_content; flex_direction; clear;
+	 * stroke_opacity
+	 */
+	bits = style->i.bits[13];
+	inherit[13] = ((bits & 0xf0000000) ? 0 : 0xf0000000) |
+			((bits & 0x0e000000) ? 0 : 0x0e000000) |
+			((bits & 0x01c00000) ? 0 : 0x01c00000) |
+			((bits & 0x00380000) ? 0 : 0x00380000) |
+			((bits & 0x00070000) ? 0 : 0x00070000) |
+			((bits & 0x0000e000) ? 0 : 0x0000e000) |
+			((bits & 0x00001c00) ? 0 : 0x00001c00) |
+			((bits & 0x00000070) ? 0 : 0x00000070) |
+			((bits & 0x0000000e) ? 0 : 0x0000000e) |
+			((bits & 0x00000001) ? 0 : 0x00000001);
+
+	/*
+	 * background_color; background_attachment; orphans; order; opacity;
+	 * flex_shrink; flex_grow; fill_opacity; color
+	 */
+	bits = style->i.bits[14];
+	inherit[14] = ((bits & 0xc0000000) ? 0 : 0xc0000000) |
+			((bits & 0x30000000) ? 0 : 0x30000000) |
+			((bits & 0x04000000) ? 0 : 0x04000000) |
+			((bits & 0x02000000) ? 0 : 0x02000000) |
+			((bits & 0x01000000) ? 0 : 0x01000000) |
+			((bits & 0x00400000) ? 0 : 0x00400000) |
+			((bits & 0x00200000) ? 0 : 0x00200000) |
+			((bits & 0x00100000) ? 0 : 0x00100000) |
+			((bits & 0x00020000) ? 0 : 0x00020000);
+}
+
+/**
+ * Compose the blended properties of two styles
+ *
+ * The bits of properties which are not blended are left clear.
+ *
+ * \param parent  Parent style
+ * \param child   Child style
+ * \param result  Blank style to compose into
+ */
+static inline void compose_blend(
+		const css_computed_style *parent,
+		const css_computed_style *child,
+		css_computed_style *result)
+{
+	uint32_t inherit[COMPOSE_N_WORDS];
+	const css_computed_style *from;
+	int i;
+
+	compose_inherit_masks(child, inherit);
+
+	for (i = 0; i < COMPOSE_N_WORDS; i++) {
+		result->i.bits[i] = (parent->i.bits[i] & inherit[i]) |
+			(child->i.bits[i] & compose_blend_masks[i] &
+			~inherit[i]);
+	}
+
+	/* background_color */
+	from = (inherit[14] & 0xc0000000) ? parent : child;
+	result->i.background_color = from->i.background_color;
+
+	/* background_position */
+	from = (inherit[12] & 0x1ffc00) ? parent : child;
+	if (((from->i.bits[12] >> 10) & 0x1) == CSS_BACKGROUND_POSITION_SET) {
+		result->i.background_position_a = from->i.background_position_a;
+		result->i.background_position_b = from->i.background_position_b;
+	} else {
+		result->i.bits[12] &= ~0x1ff800;
+	}
+
+	/* border_bottom_color */
+	from = (inherit[11] & 0x3) ? parent : child;
+	result->i.border_bottom_color = from->i.border_bottom_color;
+
+	/* border_bottom_width */
+	from = (inherit[0] & 0xff) ? parent : child;
+	if (((from->i.bits[0] >> 0) & 0x7) == CSS_BORDER_WIDTH_WIDTH) {
+		result->i.border_bottom_width = from->i.border_bottom_width;
+	} else {
+		result->i.bits[0] &= ~0xf8;
+	}
+
+	/* border_left_color */
+	from = (inherit[11] & 0x30) ? parent : child;
+	result->i.border_left_color = from->i.border_left_color;
+
+	/* border_left_width */
+	from = (inherit[0] & 0xff00) ? parent : child;
+	if (((from->i.bits[0] >> 8) & 0x7) == CSS_BORDER_WIDTH_WIDTH) {
+		result->i.border_left_width = from->i.border_left_width;
+	} else {
+		result->i.bits[0] &= ~0xf800;
+	}
+
+	/* border_right_color */
+	from = (inherit[11] & 0xc0) ? parent : child;
+	result->i.border_right_color = from->i.border_right_color;
+
+	/* border_right_width */
+	from = (inherit[0] & 0xff0000) ? parent : child;
+	if (((from->i.bits[0] >> 16) & 0x7) == CSS_BORDER_WIDTH_WIDTH) {
+		result->i.border_right_width = from->i.border_right_width;
+	} else {
+		result->i.bits[0] &= ~0xf80000;
+	}
+
+	/* border_spacing */
+	from = (inherit[12] & 0xffe00000) ? parent : child;
+	if (((from->i.bits[12] >> 21) & 0x1) == CSS_BORDER_SPACING_SET) {
+		result->i.border_spacing_a = from->i.border_spacing_a;
+		result->i.border_spacing_b = from->i.border_spacing_b;
+	} else {
+		result->i.bits[12] &= ~0xffc00000;
+	}
+
+	/* border_top_color */
+	from = (inherit[11] & 0x300) ? parent : child;
+	result->i.border_top_color = from->i.border_top_color;
+
+	/* border_top_width */
+	from = (inherit[0] & 0xff000000) ? parent : child;
+	if (((from->i.bits[0] >> 24) & 0x7) == CSS_BORDER_WIDTH_WIDTH) {
+		result->i.border_top_width = from->i.border_top_width;
+	} else {
+		result->i.bits[0] &= ~0xf8000000;
+	}
+
+	/* bottom */
+	from = (inherit[3] & 0x3f800) ? parent : child;
+	if (((from->i.bits[3] >> 11) & 0x3) == CSS_BOTTOM_SET) {
+		result->i.bottom = from->i.bottom;
+	} else {
+		result->i.bits[3] &= ~0x3e000;
+	}
+
+	/* color */
+	from = (inherit[14] & 0x20000) ? parent : child;
+	result->i.color = from->i.color;
+
+	/* column_count */
+	from = (inherit[11] & 0xc000) ? parent : child;
+	result->i.column_count = from->i.column_count;
+
+	/* column_rule_color */
+	from = (inherit[11] & 0xc0000) ? parent : child;
+	result->i.column_rule_color = from->i.column_rule_color;
+
+	/* column_rule_width */
+	from = (inherit[1] & 0x7f80) ? parent : child;
+	if (((from->i.bits[1] >> 7) & 0x7) == CSS_COLUMN_RULE_WIDTH_WIDTH) {
+		result->i.column_rule_width = from->i.column_rule_width;
+	} else {
+		result->i.bits[1] &= ~0x7c00;
+	}
+
+	/* column_width */
+	from = (inherit[3] & 0xfe000000) ? parent : child;
+	if (((from->i.bits[3] >> 25) & 0x3) == CSS_COLUMN_WIDTH_SET) {
+		result->i.column_width = from->i.column_width;
+	} else {
+		result->i.bits[3] &= ~0xf8000000;
+	}
+
+	/* fill_opacity */
+	from = (inherit[14] & 0x100000) ? parent : child;
+	if (((from->i.bits[14] >> 20) & 0x1) == CSS_FILL_OPACITY_SET) {
+		result->i.fill_opacity = from->i.fill_opacity;
+	}
+
+	/* flex_basis */
+	from = (inherit[7] & 0x7f0) ? parent : child;
+	if (((from->i.bits[7] >> 4) & 0x3) == CSS_FLEX_BASIS_SET) {
+		result->i.flex_basis = from->i.flex_basis;
+	} else {
+		result->i.bits[7] &= ~0x7c0;
+	}
+
+	/* flex_grow */
+	from = (inherit[14] & 0x200000) ? parent : child;
+	if (((from->i.bits[14] >> 21) & 0x1) == CSS_FLEX_GROW_SET) {
+		result->i.flex_grow = from->i.flex_grow;
+	}
+
+	/* flex_shrink */
+	from = (inherit[14] & 0x400000) ? parent : child;
+	if (((from->i.bits[14] >> 22) & 0x1) == CSS_FLEX_SHRINK_SET) {
+		result->i.flex_shrink = from->i.flex_shrink;
+	}
+
+	/* font_size */
+	from = (inherit[1] & 0xff800000) ? parent : child;
+	if (((from->i.bits[1] >> 23) & 0xf) == CSS_FONT_SIZE_DIMENSION) {
+		result->i.font_size = from->i.font_size;
+	} else {
+		result->i.bits[1] &= ~0xf8000000;
+	}
+
+	/* height */
+	from = (inherit[7] & 0x3f800) ? parent : child;
+	if (((from->i.bits[7] >> 11) & 0x3) == CSS_HEIGHT_SET) {
+		result->i.height = from->i.height;
+	} else {
+		result->i.bits[7] &= ~0x3e000;
+	}
+
+	/* left */
+	from = (inherit[7] & 0x1fc0000) ? parent : child;
+	if (((from->i.bits[7] >> 18) & 0x3) == CSS_LEFT_SET) {
+		result->i.left = from->i.left;
+	} else {
+		result->i.bits[7] &= ~0x1f00000;
+	}
+
+	/* letter_spacing */
+	from = (inherit[7] & 0xfe000000) ? parent : child;
+	if (((from->i.bits[7] >> 25) & 0x3) == CSS_LETTER_SPACING_SET) {
+		result->i.letter_spacing = from->i.letter_spacing;
+	} else {
+		result->i.bits[7] &= ~0xf8000000;
+	}
+
+	/* margin_bottom */
+	from = (inherit[6] & 0x3f800) ? parent : child;
+	if (((from->i.bits[6] >> 11) & 0x3) == CSS_MARGIN_SET) {
+		result->i.margin_bottom = from->i.margin_bottom;
+	} else {
+		result->i.bits[6] &= ~0x3e000;
+	}
+
+	/* margin_left */
+	from = (inherit[6] & 0x1fc0000) ? parent : child;
+	if (((from->i.bits[6] >> 18) & 0x3) == CSS_MARGIN_SET) {
+		result->i.margin_left = from->i.margin_left;
+	} else {
+		result->i.bits[6] &= ~0x1f00000;
+	}
+
+	/* margin_right */
+	from = (inherit[6] & 0xfe000000) ? parent : child;
+	if (((from->i.bits[6] >> 25) & 0x3) == CSS_MARGIN_SET) {
+		result->i.margin_right = from->i.margin_right;
+	} else {
+		result->i.bits[6] &= ~0xf8000000;
+	}
+
+	/* margin_top */
+	from = (inherit[5] & 0x7f0) ? parent : child;
+	if (((from->i.bits[5] >> 4) & 0x3) == CSS_MARGIN_SET) {
+		result->i.margin_top = from->i.margin_top;
+	} else {
+		result->i.bits[5] &= ~0x7c0;
+	}
+
+	/* max_height */
+	from = (inherit[5] & 0x3f800) ? parent : child;
+	if (((from->i.bits[5] >> 11) & 0x3) == CSS_MAX_HEIGHT_SET) {
+		result->i.max_height = from->i.max_height;
+	} else {
+		result->i.bits[5] &= ~0x3e000;
+	}
+
+	/* max_width */
+	from = (inherit[5] & 0x1fc0000) ? parent : child;
+	if (((from->i.bits[5] >> 18) & 0x3) == CSS_MAX_WIDTH_SET) {
+		result->i.max_width = from->i.max_width;
+	} else {
+		result->i.bits[5] &= ~0x1f00000;
+	}
+
+	/* min_height */
+	from = (inherit[5] & 0xfe000000) ? parent : child;
+	if (((from->i.bits[5] >> 25) & 0x3) == CSS_MIN_HEIGHT_SET) {
+		result->i.min_height = from->i.min_height;
+	} else {
+		result->i.bits[5] &= ~0xf8000000;
+	}
+
+	/* min_width */
+	from = (inherit[4] & 0x7f0) ? parent : child;
+	if (((from->i.bits[4] >> 4) & 0x3) == CSS_MIN_WIDTH_SET) {
+		result->i.min_width = from->i.min_width;
+	} else {
+		result->i.bits[4] &= ~0x7c0;
+	}
+
+	/* opacity */
+	from = (inherit[14] & 0x1000000) ? parent : child;
+	if (((from->i.bits[14] >> 24) & 0x1) == CSS_OPACITY_SET) {
+		result->i.opacity = from->i.opacity;
+	}
+
+	/* order */
+	from = (inherit[14] & 0x2000000) ? parent : child;
+	if (((from->i.bits[14] >> 25) & 0x1) == CSS_ORDER_SET) {
+		result->i.order = from->i.order;
+	}
+
+	/* orphans */
+	from = (inherit[14] & 0x4000000) ? parent : child;
+	result->i.orphans = from->i.orphans;
+
+	/* outline_color */
+	from = (inherit[10] & 0xc0) ? parent : child;
+	if (((from->i.bits[10] >> 6) & 0x3) == CSS_OUTLINE_COLOR_COLOR) {
+		result->i.outline_color = from->i.outline_color;
+	}
+
+	/* outline_width */
+	from = (inherit[1] & 0x7f8000) ? parent : child;
+	if (((from->i.bits[1] >> 15) & 0x7) == CSS_OUTLINE_WIDTH_WIDTH) {
+		result->i.outline_width = from->i.outline_width;
+	} else {
+		result->i.bits[1] &= ~0x7c0000;
+	}
+
+	/* padding_bottom */
+	from = (inherit[8] & 0xfc000) ? parent : child;
+	if (((from->i.bits[8] >> 14) & 0x1) == CSS_PADDING_SET) {
+		result->i.padding_bottom = from->i.padding_bottom;
+	} else {
+		result->i.bits[8] &= ~0xf8000;
+	}
+
+	/* padding_left */
+	from = (inherit[8] & 0x3f00000) ? parent : child;
+	if (((from->i.bits[8] >> 20) & 0x1) == CSS_PADDING_SET) {
+		result->i.padding_left = from->i.padding_left;
+	} else {
+		result->i.bits[8] &= ~0x3e00000;
+	}
+
+	/* padding_right */
+	from = (inherit[8] & 0xfc000000) ? parent : child;
+	if (((from->i.bits[8] >> 26) & 0x1) == CSS_PADDING_SET) {
+		result->i.padding_right = from->i.padding_right;
+	} else {
+		result->i.bits[8] &= ~0xf8000000;
+	}
+
+	/* padding_top */
+	from = (inherit[3] & 0x7e0) ? parent : child;
+	if (((from->i.bits[3] >> 5) & 0x1) == CSS_PADDING_SET) {
+		result->i.padding_top = from->i.padding_top;
+	} else {
+		result->i.bits[3] &= ~0x7c0;
+	}
+
+	/* right */
+	from = (inherit[4] & 0x3f800) ? parent : child;
+	if (((from->i.bits[4] >> 11) & 0x3) == CSS_RIGHT_SET) {
+		result->i.right = from->i.right;
+	} else {
+		result->i.bits[4] &= ~0x3e000;
+	}
+
+	/* stroke_opacity */
+	from = (inherit[13] & 0x1) ? parent : child;
+	if (((from->i.bits[13] >> 0) & 0x1) == CSS_STROKE_OPACITY_SET) {
+		result->i.stroke_opacity = from->i.stroke_opacity;
+	}
+
+	/* text_indent */
+	from = (inherit[2] & 0x3f) ? parent : child;
+	if (((from->i.bits[2] >> 0) & 0x1) == CSS_TEXT_INDENT_SET) {
+		result->i.text_indent = from->i.text_indent;
+	} else {
+		result->i.bits[2] &= ~0x3e;
+	}
+
+	/* top */
+	from = (inherit[4] & 0x1fc0000) ? parent : child;
+	if (((from->i.bits[4] >> 18) & 0x3) == CSS_TOP_SET) {
+		result->i.top = from->i.top;
+	} else {
+		result->i.bits[4] &= ~0x1f00000;
+	}
+
+	/* vertical_align */
+	from = (inherit[12] & 0x3fe) ? parent : child;
+	if (((from->i.bits[12] >> 1) & 0xf) == CSS_VERTICAL_ALIGN_SET) {
+		result->i.vertical_align = from->i.vertical_align;
+	} else {
+		result->i.bits[12] &= ~0x3e0;
+	}
+
+	/* widows */
+	from = (inherit[12] & 0x1) ? parent : child;
+	result->i.widows = from->i.widows;
+
+	/* word_spacing */
+	from = (inherit[1] & 0x7f) ? parent : child;
+	if (((from->i.bits[1] >> 0) & 0x3) == CSS_WORD_SPACING_SET) {
+		result->i.word_spacing = from->i.word_spacing;
+	} else {
+		result->i.bits[1] &= ~0x7c;
+	}
+
+	/* z_index */
+	from = (inherit[10] & 0xc0000) ? parent : child;
+	result->i.z_index = from->i.z_index;
+}
+
+#endif
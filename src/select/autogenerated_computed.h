@@ -291,8 +291,10 @@ struct css_computed_style {
 
 	struct css_computed_style *next;
 	uint32_t count;
-	uint32_t bin;
+	uint32_t hash;
+	bool absolute;
 	css_calculator *calc;
+	struct css_arena *arena;
 };
 
 #endif
@@ -37,8 +37,11 @@
 /* Size of bloom filter as multiple of 32 bits.
  * Has to be 4, 8, or 16.
  * Larger increases optimisation of style selection engine but uses more memory.
+ * May be overridden at build time, e.g. -DCSS_BLOOM_SIZE=8.
  */
+#ifndef CSS_BLOOM_SIZE
 #define CSS_BLOOM_SIZE 4
+#endif
 
 
 
@@ -56,6 +59,20 @@
 typedef uint32_t css_bloom;
 
 
+/* Vector paths for subset tests and merges.  Every supported size is a
+ * whole number of 128-bit vectors, and of 256-bit vectors for sizes >= 8. */
+#if defined(__AVX2__) && (CSS_BLOOM_SIZE >= 8)
+#include <immintrin.h>
+#define CSS_BLOOM_AVX2
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define CSS_BLOOM_SSE2
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define CSS_BLOOM_NEON
+#endif
+
+
 /**
  * Add a hash value to the bloom filter.
  *
@@ -100,41 +117,45 @@ static inline bool css_bloom_in_bloom(
 		const css_bloom a[CSS_BLOOM_SIZE],
 		const css_bloom b[CSS_BLOOM_SIZE])
 {
-	if ((a[0] & b[0]) != a[0])
-		return false;
-	if ((a[1] & b[1]) != a[1])
-		return false;
-	if ((a[2] & b[2]) != a[2])
-		return false;
-	if ((a[3] & b[3]) != a[3])
-		return false;
-#if (CSS_BLOOM_SIZE > 4)
-	if ((a[4] & b[4]) != a[4])
-		return false;
-	if ((a[5] & b[5]) != a[5])
-		return false;
-	if ((a[6] & b[6]) != a[6])
-		return false;
-	if ((a[7] & b[7]) != a[7])
-		return false;
-#endif
-#if (CSS_BLOOM_SIZE > 8)
-	if ((a[8] & b[8]) != a[8])
-		return false;
-	if ((a[9] & b[9]) != a[9])
-		return false;
-	if ((a[10] & b[10]) != a[10])
-		return false;
-	if ((a[11] & b[11]) != a[11])
-		return false;
-	if ((a[12] & b[12]) != a[12])
-		return false;
-	if ((a[13] & b[13]) != a[13])
-		return false;
-	if ((a[14] & b[14]) != a[14])
-		return false;
-	if ((a[15] & b[15]) != a[15])
-		return false;
+	unsigned int i;
+
+#if defined(CSS_BLOOM_AVX2)
+	for (i = 0; i < CSS_BLOOM_SIZE; i += 8) {
+		__m256i va = _mm256_loadu_si256(
+				(const __m256i *)(const void *)(a + i));
+		__m256i vb = _mm256_loadu_si256(
+				(const __m256i *)(const void *)(b + i));
+
+		/* Carry flag set iff (~vb & va) == 0 */
+		if (_mm256_testc_si256(vb, va) == 0)
+			return false;
+	}
+#elif defined(CSS_BLOOM_SSE2)
+	for (i = 0; i < CSS_BLOOM_SIZE; i += 4) {
+		__m128i va = _mm_loadu_si128(
+				(const __m128i *)(const void *)(a + i));
+		__m128i vb = _mm_loadu_si128(
+				(const __m128i *)(const void *)(b + i));
+		__m128i missing = _mm_andnot_si128(vb, va);
+
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(missing,
+				_mm_setzero_si128())) != 0xffff)
+			return false;
+	}
+#elif defined(CSS_BLOOM_NEON)
+	for (i = 0; i < CSS_BLOOM_SIZE; i += 4) {
+		uint64x2_t missing = vreinterpretq_u64_u32(
+				vbicq_u32(vld1q_u32(a + i), vld1q_u32(b + i)));
+
+		if ((vgetq_lane_u64(missing, 0) |
+				vgetq_lane_u64(missing, 1)) != 0)
+			return false;
+	}
+#else
+	for (i = 0; i < CSS_BLOOM_SIZE; i++) {
+		if ((a[i] & b[i]) != a[i])
+			return false;
+	}
 #endif
 	return true;
 }
@@ -150,25 +171,34 @@ static inline void css_bloom_merge(
 		const css_bloom a[restrict CSS_BLOOM_SIZE],
 		      css_bloom b[restrict CSS_BLOOM_SIZE])
 {
-	b[0] |= a[0];
-	b[1] |= a[1];
-	b[2] |= a[2];
-	b[3] |= a[3];
-#if (CSS_BLOOM_SIZE > 4)
-	b[4] |= a[4];
-	b[5] |= a[5];
-	b[6] |= a[6];
-	b[7] |= a[7];
-#endif
-#if (CSS_BLOOM_SIZE > 8)
-	b[8] |= a[8];
-	b[9] |= a[9];
-	b[10] |= a[10];
-	b[11] |= a[11];
-	b[12] |= a[12];
-	b[13] |= a[13];
-	b[14] |= a[14];
-	b[15] |= a[15];
+	unsigned int i;
+
+#if defined(CSS_BLOOM_AVX2)
+	for (i = 0; i < CSS_BLOOM_SIZE; i += 8) {
+		__m256i *vb = (__m256i *)(void *)(b + i);
+
+		_mm256_storeu_si256(vb, _mm256_or_si256(
+				_mm256_loadu_si256(vb),
+				_mm256_loadu_si256(
+				(const __m256i *)(const void *)(a + i))));
+	}
+#elif defined(CSS_BLOOM_SSE2)
+	for (i = 0; i < CSS_BLOOM_SIZE; i += 4) {
+		__m128i *vb = (__m128i *)(void *)(b + i);
+
+		_mm_storeu_si128(vb, _mm_or_si128(_mm_loadu_si128(vb),
+				_mm_loadu_si128(
+				(const __m128i *)(const void *)(a + i))));
+	}
+#elif defined(CSS_BLOOM_NEON)
+	for (i = 0; i < CSS_BLOOM_SIZE; i += 4) {
+		vst1q_u32(b + i, vorrq_u32(vld1q_u32(b + i),
+				vld1q_u32(a + i)));
+	}
+#else
+	for (i = 0; i < CSS_BLOOM_SIZE; i++) {
+		b[i] |= a[i];
+	}
 #endif
 }
 
@@ -70,6 +70,11 @@ void css_calculator_unref(css_calculator *calc)
 {
 	calc->refcount -= 1;
 	if (calc->refcount == 0) {
+		for (size_t i = 0; i < CSS_CALCULATOR_CACHE_SIZE; i++) {
+			if (calc->cache[i].expr != NULL) {
+				lwc_string_unref(calc->cache[i].expr);
+			}
+		}
 #ifndef NDEBUG
 		lwc_string_unref(calc->canary);
 #endif
@@ -189,6 +194,44 @@ static css_error css__normalise_unit(const css_unit_ctx *unit_ctx,
 	return CSS_INVALID;
 }
 
+/**
+ * Determine whether a unit's normalised value depends on the style
+ *
+ * \param u The unit to test
+ * \return true if normalising the unit consults the style or root style
+ */
+static inline bool css__unit_uses_style(unit u)
+{
+	switch (u) {
+	case UNIT_EX:
+	case UNIT_EM:
+	case UNIT_CH:
+	case UNIT_REM:
+	case UNIT_LH:
+	case UNIT_VI:
+	case UNIT_VB:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/**
+ * Find the result cache slot for an expression and available space
+ *
+ * \param calc The calculator whose cache to search
+ * \param available The available space (for percentages)
+ * \param expr The expression
+ * \return The cache slot for the expression
+ */
+static inline css_calculator_cache_entry *css__calculator_cache_slot(
+		css_calculator *calc, int32_t available, lwc_string *expr)
+{
+	uintptr_t key = ((uintptr_t)expr >> 4) ^ ((uint32_t)available * 31u);
+
+	return &calc->cache[key & (CSS_CALCULATOR_CACHE_SIZE - 1)];
+}
+
 /****************************** Compute ************************************/
 
 /* Exported function, documented in calc.h */
@@ -201,6 +244,19 @@ css_error css_calculator_calculate(css_calculator *calc,
 	css_error ret = CSS_OK;
 	/* Alignment note: lwc string data is always very well aligned */
 	css_code_t *codeptr = (css_code_t *)(void *)lwc_string_data(expr);
+	css_calculator_cache_entry *entry =
+			css__calculator_cache_slot(calc, available, expr);
+	bool uses_style = false;
+
+	if (entry->expr == expr &&
+			entry->available == available &&
+			entry->viewport_width == unit_ctx->viewport_width &&
+			entry->viewport_height == unit_ctx->viewport_height &&
+			entry->device_dpi == unit_ctx->device_dpi) {
+		*unit_out = entry->unit;
+		*value_out = entry->value;
+		return CSS_OK;
+	}
 
 	/* Reset the stack before we begin, just in case */
 	calc->stack_ptr = 0;
@@ -212,6 +268,7 @@ css_error css_calculator_calculate(css_calculator *calc,
 		case CALC_PUSH_VALUE: {
 			css_fixed v = (css_fixed)(*codeptr++);
 			unit u = (unit)(*codeptr++);
+			uses_style |= css__unit_uses_style(u);
 			ret = css__normalise_unit(unit_ctx, style, available,
 						  &u, &v);
 			if (ret != CSS_OK) {
@@ -281,5 +338,20 @@ css_error css_calculator_calculate(css_calculator *calc,
 	*unit_out = css__to_css_unit(calc->stack[0].unit);
 	*value_out = calc->stack[0].value;
 
+	if (!uses_style) {
+		if (entry->expr != expr) {
+			if (entry->expr != NULL) {
+				lwc_string_unref(entry->expr);
+			}
+			entry->expr = lwc_string_ref(expr);
+		}
+		entry->available = available;
+		entry->viewport_width = unit_ctx->viewport_width;
+		entry->viewport_height = unit_ctx->viewport_height;
+		entry->device_dpi = unit_ctx->device_dpi;
+		entry->unit = *unit_out;
+		entry->value = *value_out;
+	}
+
 	return CSS_OK;
 }
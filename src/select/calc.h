@@ -19,11 +19,32 @@ typedef struct {
 	css_fixed value;
 } css_calculator_stack_entry;
 
+/** The number of entries in a calculator's result cache (power of two) */
+#define CSS_CALCULATOR_CACHE_SIZE 64
+
+/**
+ * A cached calc() result
+ *
+ * Only expressions whose value does not depend on the style they were
+ * derived from are cached, so the result is keyed on the expression, the
+ * available space and the parts of the unit context which can affect it.
+ */
+typedef struct {
+	lwc_string *expr; /**< Cached expression (ref held), or NULL */
+	int32_t available;
+	css_fixed viewport_width;
+	css_fixed viewport_height;
+	css_fixed device_dpi;
+	css_unit unit;
+	css_fixed value;
+} css_calculator_cache_entry;
+
 typedef struct {
 	uint32_t refcount;
 	css_calculator_stack_entry *stack;
 	size_t stack_alloc;
 	size_t stack_ptr;
+	css_calculator_cache_entry cache[CSS_CALCULATOR_CACHE_SIZE];
 #ifndef NDEBUG
 	lwc_string *canary;
 #endif
@@ -73,6 +94,9 @@ void css_calculator_unref(css_calculator *calc);
  * interpret the bytecode in the given expression, with the given display
  * context and available space, and will fill out the computed unit and value.
  *
+ * Results of expressions which do not depend on the style are cached, so
+ * repeatedly resolving the same expression in the same context is cheap.
+ *
  * \param calc The calculator to use
  * \param unit_ctx The display context for resolving units
  * \param available The available space (for percentages)
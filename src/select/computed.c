@@ -8,6 +8,7 @@
 #include <string.h>
 
 #include "select/arena.h"
+#include "select/autogenerated_compose.h"
 #include "select/calc.h"
 #include "select/computed.h"
 #include "select/dispatch.h"
@@ -16,6 +17,12 @@
 #include "select/unit.h"
 #include "utils/utils.h"
 
+static css_error compute_font_size(const css_hint_length *ref_length,
+		const css_unit_ctx *unit_ctx,
+		css_hint *size, css_hint_length *ex_size);
+static css_error compute_absolute_values(css_computed_style *style,
+		const css_hint *size, const css_hint_length *ex_size);
+
 static css_error compute_absolute_color(css_computed_style *style,
 		uint8_t (*get)(const css_computed_style *style,
 				css_color *color),
@@ -84,7 +91,6 @@ css_error css__computed_style_create(css_computed_style **result, css_calculator
 	if (s == NULL)
 		return CSS_NOMEM;
 
-	s->bin = UINT32_MAX;
 	s->calc = css_calculator_ref(calc);
 
 	*result = s;
@@ -93,24 +99,14 @@ css_error css__computed_style_create(css_computed_style **result, css_calculator
 }
 
 /**
- * Destroy a computed style
+ * Release the values a computed style holds
  *
- * \param style  Style to destroy
- * \return CSS_OK on success, appropriate error otherwise
+ * The style is left holding stale pointers, so must be freed or cleared.
+ *
+ * \param style  Style to release the values of
  */
-css_error css_computed_style_destroy(css_computed_style *style)
+static void computed_style_release(css_computed_style *style)
 {
-	if (style == NULL)
-		return CSS_BADPARM;
-
-	if (style->count > 1) {
-		style->count--;
-		return CSS_OK;
-
-	} else if (style->count == 1) {
-		css__arena_remove_style(style);
-	}
-
 	if (style->counter_increment != NULL) {
 		css_computed_counter *c;
 
@@ -195,11 +191,33 @@ css_error css_computed_style_destroy(css_computed_style *style)
 	lwc_string_unref(style->i.list_style_image);
 	lwc_string_unref(style->i.background_image);
 
+#include "select/autogenerated_destroy.inc"
+}
+
+/**
+ * Destroy a computed style
+ *
+ * \param style  Style to destroy
+ * \return CSS_OK on success, appropriate error otherwise
+ */
+css_error css_computed_style_destroy(css_computed_style *style)
+{
+	if (style == NULL)
+		return CSS_BADPARM;
+
+	if (style->count > 1) {
+		style->count--;
+		return CSS_OK;
+
+	} else if (style->count == 1) {
+		css__arena_remove_style(style);
+	}
+
+	computed_style_release(style);
+
 	if (style->calc != NULL)
 		css_calculator_unref(style->calc);
 
-#include "select/autogenerated_destroy.inc"
-
 	free(style);
 
 	return CSS_OK;
@@ -274,15 +292,204 @@ css_error css__computed_style_clone(
 	return CSS_OK;
 }
 
+/**
+ * Number of entries in a composition context's cache of results; a power of two
+ */
+#define COMPOSE_CACHE_SIZE 256
+
+/**
+ * Number of entries in a composition context's cache of fixed styles; a
+ * power of two
+ */
+#define COMPOSE_FIXED_SIZE 64
+
+/**
+ * Number of entries in a composition context's cache of font sizes; a
+ * power of two
+ */
+#define COMPOSE_FONT_SIZE_CACHE_SIZE 64
+
+/**
+ * An entry in a composition context's cache of results
+ *
+ * An entry holds a reference to each of the styles it names, so that none
+ * may be freed and another take its place while the entry remains.
+ */
+typedef struct compose_entry {
+	css_computed_style *parent;	/**< Parent style */
+	css_computed_style *child;	/**< Child style */
+	css_unit_ctx unit_ctx;		/**< Unit conversion context */
+	css_computed_style *result;	/**< Composed style, or NULL if unused */
+} compose_entry;
+
+/**
+ * An entry in a composition context's cache of font sizes
+ *
+ * A computed font size, and the size of an ex unit, depend only on the
+ * specified font size, the parent's, the root element's and the default.
+ */
+typedef struct compose_font_size {
+	css_hint_length parent;		/**< Parent's font size */
+	css_hint_length root;		/**< Root element's font size */
+	css_fixed font_size_default;	/**< Client default font size */
+	css_hint specified;		/**< Specified font size */
+	css_hint size;			/**< Computed font size */
+	css_hint_length ex_size;	/**< Size of an ex unit, in ems */
+	bool used;			/**< Whether the entry is in use */
+} compose_font_size;
+
+/**
+ * Composition context
+ *
+ * Styles are composed into a scratch style, which is only given up when it
+ * is interned as a new style; when it equals one already interned, it is
+ * cleared and used again.
+ *
+ * Children which compose to themselves have no inherited or relative
+ * values, and so compose to themselves with any parent; they are kept in
+ * a set of fixed styles.  Other results are cached by parent, child and
+ * unit conversion context.  Both caches are direct mapped, and only hold
+ * interned styles, since they must be referenced.
+ *
+ * Deep trees repeat the same few font sizes, so computed font sizes are
+ * cached too, by value.
+ */
+struct css_compose_ctx {
+	css_computed_style *scratch;	/**< Style to compose into, or NULL */
+
+	compose_entry cache[COMPOSE_CACHE_SIZE];	/**< Cached results */
+	css_computed_style *fixed[COMPOSE_FIXED_SIZE];	/**< Fixed styles */
+
+	/** Cached font sizes */
+	compose_font_size font_sizes[COMPOSE_FONT_SIZE_CACHE_SIZE];
+};
+
+/**
+ * Compute the absolute values of a style, using a composition context
+ *
+ * \param ctx       The composition context
+ * \param parent    Parent style
+ * \param style     Computed style to process
+ * \param unit_ctx  Client length conversion context
+ * \return CSS_OK on success, appropriate error otherwise.
+ */
+static css_error compose_ctx_compute_absolute_values(css_compose_ctx *ctx,
+		const css_computed_style *parent,
+		css_computed_style *style,
+		const css_unit_ctx *unit_ctx)
+{
+	css_hint_length psize = { 0, CSS_UNIT_PX };
+	css_hint_length root = { unit_ctx->font_size_default, CSS_UNIT_PX };
+	css_hint specified = {
+		.data.length = { 0, CSS_UNIT_PX }
+	};
+	compose_font_size *entry;
+	uint32_t hash;
+	css_error error;
+
+	if (get_font_size(parent, &psize.value, &psize.unit) !=
+			CSS_FONT_SIZE_DIMENSION) {
+		return CSS_BADPARM;
+	}
+
+	if (unit_ctx->root_style != NULL) {
+		get_font_size(unit_ctx->root_style, &root.value, &root.unit);
+	}
+
+	specified.status = get_font_size(style,
+			&specified.data.length.value,
+			&specified.data.length.unit);
+
+	hash = (uint32_t) psize.value * 0x9e3779b1u ^
+			(uint32_t) specified.data.length.value ^
+			(uint32_t) specified.status << 24;
+	entry = &ctx->font_sizes[(hash ^ (hash >> 16)) &
+			(COMPOSE_FONT_SIZE_CACHE_SIZE - 1)];
+
+	if (entry->used == false ||
+			entry->parent.value != psize.value ||
+			entry->parent.unit != psize.unit ||
+			entry->root.value != root.value ||
+			entry->root.unit != root.unit ||
+			entry->font_size_default !=
+					unit_ctx->font_size_default ||
+			entry->specified.status != specified.status ||
+			entry->specified.data.length.value !=
+					specified.data.length.value ||
+			entry->specified.data.length.unit !=
+					specified.data.length.unit) {
+		entry->size = specified;
+		error = compute_font_size(&psize, unit_ctx,
+				&entry->size, &entry->ex_size);
+		if (error != CSS_OK) {
+			entry->used = false;
+			return error;
+		}
+
+		entry->parent = psize;
+		entry->root = root;
+		entry->font_size_default = unit_ctx->font_size_default;
+		entry->specified = specified;
+		entry->used = true;
+	}
+
+	return compute_absolute_values(style, &entry->size, &entry->ex_size);
+}
+
+/**
+ * Compose two computed styles into a blank style
+ *
+ * \param ctx       Composition context, or NULL
+ * \param parent    Parent style
+ * \param child     Child style
+ * \param unit_ctx  Context for length unit conversions
+ * \param composed  Blank style to compose into
+ * \return CSS_OK on success, appropriate error otherwise.
+ */
+static css_error compose_into(css_compose_ctx *ctx,
+		const css_computed_style *restrict parent,
+		const css_computed_style *restrict child,
+		const css_unit_ctx *unit_ctx,
+		css_computed_style *restrict composed)
+{
+	css_error error;
+	size_t i;
+
+	/* Blend most properties a word at a time */
+	compose_blend(parent, child, composed);
+
+	/* Then compose those which need more care individually */
+	for (i = 0; i < N_ELEMENTS(compose_call_props); i++) {
+		error = prop_dispatch[compose_call_props[i]].compose(
+				parent, child, composed);
+		if (error != CSS_OK)
+			return error;
+	}
+
+	/* Every value comes from one or the other, so if neither has any
+	 * relative values, there are none to compute */
+	if (parent->absolute && child->absolute) {
+		composed->absolute = true;
+		return CSS_OK;
+	}
+
+	/* Finally, compute absolute values for everything */
+	if (ctx != NULL) {
+		return compose_ctx_compute_absolute_values(ctx,
+				parent, composed, unit_ctx);
+	}
+
+	return css__compute_absolute_values(parent, composed, unit_ctx);
+}
+
 /**
  * Compose two computed styles
  *
- * \param parent             Parent style
- * \param child              Child style
- * \param compute_font_size  Function to compute an absolute font size
- * \param pw                 Client data for compute_font_size
- * \param result             Updated to point to new composed style
- *                           Ownership passed to client.
+ * \param parent    Parent style
+ * \param child     Child style
+ * \param unit_ctx  Context for length unit conversions
+ * \param result    Updated to point to new composed style
+ *                  Ownership passed to client.
  * \return CSS_OK on success, appropriate error otherwise.
  *
  * \pre \a parent is a fully composed style (thus has no inherited properties)
@@ -294,35 +501,283 @@ css_error css_computed_style_compose(
 		css_computed_style **restrict result)
 {
 	css_computed_style *composed;
+	css_arena *arena;
 	css_error error;
-	size_t i;
 
-	/* TODO:
-	 *   Make this function take a composition context, to allow us
-	 *   to avoid the churn of unnecesaraly allocating and freeing
-	 *   the memory to compose styles into.
-	 */
+	/* Intern the result alongside the styles it was composed from */
+	arena = (child->arena != NULL) ? child->arena : parent->arena;
+	if (arena == NULL) {
+		return CSS_BADPARM;
+	}
+
 	error = css__computed_style_create(&composed, child->calc);
 	if (error != CSS_OK) {
 		return error;
 	}
 
-	/* Iterate through the properties */
-	for (i = 0; i < CSS_N_PROPERTIES; i++) {
-		/* Compose the property */
-		error = prop_dispatch[i].compose(parent, child, composed);
-		if (error != CSS_OK)
-			break;
+	error = compose_into(NULL, parent, child, unit_ctx, composed);
+	if (error != CSS_OK) {
+		css_computed_style_destroy(composed);
+		return error;
 	}
 
-	/* Finally, compute absolute values for everything */
-	error = css__compute_absolute_values(parent, composed, unit_ctx);
+	*result = composed;
+	return css__arena_intern_style(arena, result);
+}
+
+/**
+ * Create a composition context
+ *
+ * \param result  Updated to the new context on success
+ * \return CSS_OK on success,
+ *         CSS_NOMEM on memory exhaustion,
+ *         CSS_BADPARM on bad parameters.
+ */
+css_error css_compose_ctx_create(css_compose_ctx **result)
+{
+	css_compose_ctx *ctx;
+
+	if (result == NULL)
+		return CSS_BADPARM;
+
+	ctx = calloc(1, sizeof(css_compose_ctx));
+	if (ctx == NULL)
+		return CSS_NOMEM;
+
+	*result = ctx;
+
+	return CSS_OK;
+}
+
+/**
+ * Release the references held by a cached composition result
+ *
+ * \param entry  The entry to empty
+ */
+static void compose_entry_release(compose_entry *entry)
+{
+	if (entry->result == NULL)
+		return;
+
+	css_computed_style_destroy(entry->result);
+	css_computed_style_destroy(entry->parent);
+	css_computed_style_destroy(entry->child);
+	if (entry->unit_ctx.root_style != NULL) {
+		css_computed_style_destroy(
+				(css_computed_style *) entry->unit_ctx.root_style);
+	}
+
+	entry->result = NULL;
+}
+
+/**
+ * Destroy a composition context
+ *
+ * Styles composed with the context remain valid.
+ *
+ * \param ctx  The context to destroy
+ * \return CSS_OK on success, appropriate error otherwise.
+ */
+css_error css_compose_ctx_destroy(css_compose_ctx *ctx)
+{
+	size_t i;
+
+	if (ctx == NULL)
+		return CSS_BADPARM;
+
+	for (i = 0; i < COMPOSE_CACHE_SIZE; i++) {
+		compose_entry_release(&ctx->cache[i]);
+	}
+
+	for (i = 0; i < COMPOSE_FIXED_SIZE; i++) {
+		if (ctx->fixed[i] != NULL)
+			css_computed_style_destroy(ctx->fixed[i]);
+	}
+
+	if (ctx->scratch != NULL)
+		css_computed_style_destroy(ctx->scratch);
+
+	free(ctx);
+
+	return CSS_OK;
+}
+
+/**
+ * Hash a pair of styles, for indexing a composition context's caches
+ *
+ * \param parent  Parent style, or NULL
+ * \param child   Child style
+ * \return The hash
+ */
+static inline uint32_t compose_hash(const css_computed_style *parent,
+		const css_computed_style *child)
+{
+	/* Styles are allocated on at least 16 byte boundaries, so the
+	 * low bits of their addresses carry no information */
+	uintptr_t p = (uintptr_t) parent >> 4;
+	uintptr_t c = (uintptr_t) child >> 4;
+
+	return (uint32_t) ((p * 0x9e3779b1u) ^ c ^ (c >> 11));
+}
+
+/**
+ * Determine whether two unit conversion contexts are the same
+ *
+ * \param a  A context
+ * \param b  Another context
+ * \return true if the contexts convert every length alike.
+ */
+static inline bool compose_unit_ctx_equal(
+		const css_unit_ctx *a, const css_unit_ctx *b)
+{
+	return a->viewport_width == b->viewport_width &&
+			a->viewport_height == b->viewport_height &&
+			a->font_size_default == b->font_size_default &&
+			a->font_size_minimum == b->font_size_minimum &&
+			a->device_dpi == b->device_dpi &&
+			a->root_style == b->root_style &&
+			a->pw == b->pw &&
+			a->measure == b->measure;
+}
+
+/**
+ * Get a composition context's scratch style, ready to compose into
+ *
+ * \param ctx   The composition context
+ * \param calc  The calculator the composed style is to use
+ * \return CSS_OK on success, appropriate error otherwise.
+ */
+static css_error compose_ctx_prepare_scratch(css_compose_ctx *ctx,
+		css_calculator *calc)
+{
+	css_computed_style *scratch = ctx->scratch;
+
+	if (scratch == NULL)
+		return css__computed_style_create(&ctx->scratch, calc);
+
+	/* Values are only set where their type calls for one, so those
+	 * of the previous composition must be cleared, lest they make
+	 * the style differ from an equal one */
+	computed_style_release(scratch);
+	memset(&scratch->i, 0, sizeof(scratch->i));
+	scratch->absolute = false;
+	scratch->content = NULL;
+	scratch->counter_increment = NULL;
+	scratch->counter_reset = NULL;
+	scratch->cursor = NULL;
+	scratch->font_family = NULL;
+	scratch->quotes = NULL;
+
+	if (scratch->calc != calc) {
+		css_calculator_unref(scratch->calc);
+		scratch->calc = css_calculator_ref(calc);
+	}
+
+	return CSS_OK;
+}
+
+/**
+ * Compose two computed styles, using a composition context
+ *
+ * The result is the same style as css_computed_style_compose() would give.
+ *
+ * \param ctx       The composition context
+ * \param parent    Parent style
+ * \param child     Child style
+ * \param unit_ctx  Context for length unit conversions
+ * \param result    Updated to point to new composed style
+ *                  Ownership passed to client.
+ * \return CSS_OK on success, appropriate error otherwise.
+ *
+ * \pre \a parent is a fully composed style (thus has no inherited properties)
+ */
+css_error css_computed_style_compose_ctx(css_compose_ctx *ctx,
+		const css_computed_style *restrict parent,
+		const css_computed_style *restrict child,
+		const css_unit_ctx *unit_ctx,
+		css_computed_style **restrict result)
+{
+	css_computed_style **fixed;
+	css_computed_style *composed;
+	compose_entry *entry = NULL;
+	css_arena *arena;
+	css_error error;
+
+	if (ctx == NULL || parent == NULL || child == NULL ||
+			unit_ctx == NULL || result == NULL)
+		return CSS_BADPARM;
+
+	/* Intern the result alongside the styles it was composed from */
+	arena = (child->arena != NULL) ? child->arena : parent->arena;
+	if (arena == NULL) {
+		return CSS_BADPARM;
+	}
+
+	fixed = &ctx->fixed[compose_hash(NULL, child) &
+			(COMPOSE_FIXED_SIZE - 1)];
+	if (*fixed == child) {
+		*result = css__computed_style_ref(*fixed);
+		return CSS_OK;
+	}
+
+	if (parent->count != 0 && child->count != 0 &&
+			(unit_ctx->root_style == NULL ||
+			unit_ctx->root_style->count != 0)) {
+		entry = &ctx->cache[compose_hash(parent, child) &
+				(COMPOSE_CACHE_SIZE - 1)];
+
+		if (entry->result != NULL && entry->parent == parent &&
+				entry->child == child &&
+				compose_unit_ctx_equal(&entry->unit_ctx,
+						unit_ctx)) {
+			*result = css__computed_style_ref(entry->result);
+			return CSS_OK;
+		}
+	}
+
+	error = compose_ctx_prepare_scratch(ctx, child->calc);
+	if (error != CSS_OK) {
+		return error;
+	}
+
+	error = compose_into(ctx, parent, child, unit_ctx, ctx->scratch);
 	if (error != CSS_OK) {
 		return error;
 	}
 
+	error = css__arena_find_style(arena, ctx->scratch, &composed);
+	if (error != CSS_OK) {
+		return error;
+	}
+
+	if (composed == ctx->scratch) {
+		/* Given to the arena; compose into a new style next time */
+		ctx->scratch = NULL;
+	}
+
+	if (composed == child) {
+		if (*fixed != NULL)
+			css_computed_style_destroy(*fixed);
+		*fixed = css__computed_style_ref(composed);
+
+	} else if (entry != NULL) {
+		compose_entry_release(entry);
+
+		entry->parent = css__computed_style_ref(
+				(css_computed_style *) parent);
+		entry->child = css__computed_style_ref(
+				(css_computed_style *) child);
+		memcpy(&entry->unit_ctx, unit_ctx, sizeof(css_unit_ctx));
+		if (unit_ctx->root_style != NULL) {
+			css__computed_style_ref(
+					(css_computed_style *)
+					unit_ctx->root_style);
+		}
+		entry->result = css__computed_style_ref(composed);
+	}
+
 	*result = composed;
-	return css__arena_intern_style(result);
+	return CSS_OK;
 }
 
 /******************************************************************************
@@ -1256,7 +1711,8 @@ css_error css__compute_absolute_values(const css_computed_style *parent,
 		const css_unit_ctx *unit_ctx)
 {
 	css_hint_length *ref_length = NULL;
-	css_hint psize, size, ex_size;
+	css_hint_length ex_size;
+	css_hint psize, size;
 	css_error error;
 
 	/* Get reference font-size for relative sizes. */
@@ -1274,42 +1730,81 @@ css_error css__compute_absolute_values(const css_computed_style *parent,
 			&size.data.length.value,
 			&size.data.length.unit);
 
-	error = css_unit_compute_absolute_font_size(ref_length,
-			unit_ctx->root_style,
-			unit_ctx->font_size_default,
-			&size);
+	error = compute_font_size(ref_length, unit_ctx, &size, &ex_size);
 	if (error != CSS_OK)
 		return error;
 
-	error = set_font_size(style, size.status,
-			size.data.length.value,
-			size.data.length.unit);
+	return compute_absolute_values(style, &size, &ex_size);
+}
+
+/**
+ * Compute an absolute font size, and the size of an ex unit
+ *
+ * \param ref_length  Parent's font size, or NULL for tree root
+ * \param unit_ctx    Client length conversion context
+ * \param size        Specified font size, updated to the computed one
+ * \param ex_size     Updated to the size of an ex unit, in ems
+ * \return CSS_OK on success, appropriate error otherwise.
+ */
+css_error compute_font_size(const css_hint_length *ref_length,
+		const css_unit_ctx *unit_ctx,
+		css_hint *size, css_hint_length *ex_size)
+{
+	css_hint ex;
+	css_error error;
+
+	error = css_unit_compute_absolute_font_size(ref_length,
+			unit_ctx->root_style,
+			unit_ctx->font_size_default,
+			size);
 	if (error != CSS_OK)
 		return error;
 
 	/* Compute the size of an ex unit */
-	ex_size.status = CSS_FONT_SIZE_DIMENSION;
-	ex_size.data.length.value = INTTOFIX(1);
-	ex_size.data.length.unit = CSS_UNIT_EX;
+	ex.status = CSS_FONT_SIZE_DIMENSION;
+	ex.data.length.value = INTTOFIX(1);
+	ex.data.length.unit = CSS_UNIT_EX;
 
 	error = css_unit_compute_absolute_font_size(
-			&size.data.length,
+			&size->data.length,
 			unit_ctx->root_style,
 			unit_ctx->font_size_default,
-			&ex_size);
+			&ex);
 	if (error != CSS_OK)
 		return error;
 
 	/* Convert ex size into ems */
-	if (size.data.length.value != 0)
-		ex_size.data.length.value = FDIV(ex_size.data.length.value,
-					size.data.length.value);
+	if (size->data.length.value != 0)
+		ex_size->value = FDIV(ex.data.length.value,
+					size->data.length.value);
 	else
-		ex_size.data.length.value = 0;
-	ex_size.data.length.unit = CSS_UNIT_EM;
+		ex_size->value = 0;
+	ex_size->unit = CSS_UNIT_EM;
+
+	return CSS_OK;
+}
+
+/**
+ * Compute the absolute values of a style, given its font size
+ *
+ * \param style    Computed style to process
+ * \param size     Computed font size
+ * \param ex_size  Size of an ex unit, in ems
+ * \return CSS_OK on success.
+ */
+css_error compute_absolute_values(css_computed_style *style,
+		const css_hint *size, const css_hint_length *ex_size)
+{
+	css_error error;
+
+	error = set_font_size(style, size->status,
+			size->data.length.value,
+			size->data.length.unit);
+	if (error != CSS_OK)
+		return error;
 
 	/* Fix up background-position */
-	error = compute_absolute_length_pair(style, &ex_size.data.length,
+	error = compute_absolute_length_pair(style, ex_size,
 			get_background_position,
 			set_background_position);
 	if (error != CSS_OK)
@@ -1328,99 +1823,99 @@ css_error css__compute_absolute_values(const css_computed_style *parent,
 		return error;
 
 	/* Fix up border-{top,right,bottom,left}-width */
-	error = compute_absolute_border_width(style, &ex_size.data.length);
+	error = compute_absolute_border_width(style, ex_size);
 	if (error != CSS_OK)
 		return error;
 
 	/* Fix up sides */
-	error = compute_absolute_sides(style, &ex_size.data.length);
+	error = compute_absolute_sides(style, ex_size);
 	if (error != CSS_OK)
 		return error;
 
 	/* Fix up height */
-	error = compute_absolute_length(style, &ex_size.data.length,
+	error = compute_absolute_length(style, ex_size,
 			get_height, set_height);
 	if (error != CSS_OK)
 		return error;
 
 	/* Fix up line-height (must be before vertical-align) */
-	error = compute_absolute_line_height(style, &ex_size.data.length);
+	error = compute_absolute_line_height(style, ex_size);
 	if (error != CSS_OK)
 		return error;
 
 	/* Fix up margins */
-	error = compute_absolute_margins(style, &ex_size.data.length);
+	error = compute_absolute_margins(style, ex_size);
 	if (error != CSS_OK)
 		return error;
 
 	/* Fix up max-height */
-	error = compute_absolute_length(style, &ex_size.data.length,
+	error = compute_absolute_length(style, ex_size,
 			get_max_height, set_max_height);
 	if (error != CSS_OK)
 		return error;
 
 	/* Fix up max-width */
-	error = compute_absolute_length(style, &ex_size.data.length,
+	error = compute_absolute_length(style, ex_size,
 			get_max_width, set_max_width);
 	if (error != CSS_OK)
 		return error;
 
 	/* Fix up min-height */
-	error = compute_absolute_length(style, &ex_size.data.length,
+	error = compute_absolute_length(style, ex_size,
 			get_min_height, set_min_height);
 	if (error != CSS_OK)
 		return error;
 
 	/* Fix up min-width */
-	error = compute_absolute_length(style, &ex_size.data.length,
+	error = compute_absolute_length(style, ex_size,
 			get_min_width, set_min_width);
 	if (error != CSS_OK)
 		return error;
 
 	/* Fix up padding */
-	error = compute_absolute_padding(style, &ex_size.data.length);
+	error = compute_absolute_padding(style, ex_size);
 	if (error != CSS_OK)
 		return error;
 
 	/* Fix up text-indent */
-	error = compute_absolute_length(style, &ex_size.data.length,
+	error = compute_absolute_length(style, ex_size,
 			get_text_indent, set_text_indent);
 	if (error != CSS_OK)
 		return error;
 
 	/* Fix up vertical-align */
-	error = compute_absolute_vertical_align(style, &ex_size.data.length);
+	error = compute_absolute_vertical_align(style, ex_size);
 	if (error != CSS_OK)
 		return error;
 
 	/* Fix up width */
-	error = compute_absolute_length_calc(style, &ex_size.data.length,
+	error = compute_absolute_length_calc(style, ex_size,
 			get_width, set_width);
 	if (error != CSS_OK)
 		return error;
 
 	/* Fix up flex-basis */
-	error = compute_absolute_length(style, &ex_size.data.length,
+	error = compute_absolute_length(style, ex_size,
 			get_flex_basis, set_flex_basis);
 	if (error != CSS_OK)
 		return error;
 
 	/* Fix up border-spacing */
 	error = compute_absolute_length_pair(style,
-			&ex_size.data.length,
+			ex_size,
 			get_border_spacing,
 			set_border_spacing);
 	if (error != CSS_OK)
 		return error;
 
 	/* Fix up clip */
-	error = compute_absolute_clip(style, &ex_size.data.length);
+	error = compute_absolute_clip(style, ex_size);
 	if (error != CSS_OK)
 		return error;
 
 	/* Fix up letter-spacing */
 	error = compute_absolute_length(style,
-			&ex_size.data.length,
+			ex_size,
 			get_letter_spacing,
 			set_letter_spacing);
 	if (error != CSS_OK)
@@ -1435,7 +1930,7 @@ css_error css__compute_absolute_values(const css_computed_style *parent,
 
 	/* Fix up outline-width */
 	error = compute_absolute_border_side_width(style,
-			&ex_size.data.length,
+			ex_size,
 			get_outline_width,
 		set_outline_width);
 	if (error != CSS_OK)
@@ -1443,7 +1938,7 @@ css_error css__compute_absolute_values(const css_computed_style *parent,
 
 	/* Fix up word-spacing */
 	error = compute_absolute_length(style,
-			&ex_size.data.length,
+			ex_size,
 			get_word_spacing,
 			set_word_spacing);
 	if (error != CSS_OK)
@@ -1451,7 +1946,7 @@ css_error css__compute_absolute_values(const css_computed_style *parent,
 
 	/* Fix up column-rule-width */
 	error = compute_absolute_border_side_width(style,
-			&ex_size.data.length,
+			ex_size,
 			get_column_rule_width,
 			set_column_rule_width);
 	if (error != CSS_OK)
@@ -1459,7 +1954,7 @@ css_error css__compute_absolute_values(const css_computed_style *parent,
 
 	/* Fix up column-width */
 	error = compute_absolute_length(style,
-			&ex_size.data.length,
+			ex_size,
 			get_column_width,
 			set_column_width);
 	if (error != CSS_OK)
@@ -1467,12 +1962,15 @@ css_error css__compute_absolute_values(const css_computed_style *parent,
 
 	/* Fix up column-gap */
 	error = compute_absolute_length(style,
-			&ex_size.data.length,
+			ex_size,
 			get_column_gap,
 			set_column_gap);
 	if (error != CSS_OK)
 		return error;
 
+	/* Nothing is left relative, so the values need not be computed again */
+	style->absolute = true;
+
 	return CSS_OK;
 }
 
@@ -5,8 +5,10 @@
  * Copyright 2009 John-Mark Bell <jmb@netsurf-browser.org>
  */
 
+#include <assert.h>
 #include <stdio.h>
 #include <string.h>
+#include <strings.h>
 
 #include <libcss/hint.h>
 
@@ -19,6 +21,7 @@
 
 typedef struct hash_entry {
 	const css_selector *sel;
+	uint32_t source;
 	css_bloom sel_chain_bloom[CSS_BLOOM_SIZE];
 	struct hash_entry *next;
 } hash_entry;
@@ -26,10 +29,27 @@ typedef struct hash_entry {
 typedef struct hash_t {
 #define DEFAULT_SLOTS (1<<6)
 	size_t n_slots;
+	size_t n_entries;
 
 	hash_entry *slots;
 } hash_t;
 
+typedef struct dep_entry {
+	lwc_string *name;		/* Class, id, attribute or pseudo name */
+	lwc_hash hash;			/* Caseless hash of name */
+	uint8_t change;			/* Kind of change to name */
+	uint8_t restyle;		/* Nodes to restyle on change */
+	struct dep_entry *next;
+} dep_entry;
+
+typedef struct dep_t {
+#define DEFAULT_DEP_SLOTS (1<<6)
+	size_t n_slots;
+	size_t n_entries;
+
+	dep_entry **slots;
+} dep_t;
+
 struct css_selector_hash {
 	hash_t elements;
 
@@ -39,14 +59,41 @@ struct css_selector_hash {
 
 	hash_entry universal;
 
+	dep_t deps;
+
+	/** A universal compound selector may tell ancestors apart by more
+	 * than their name, id and classes */
+	bool universal_ancestor_deps;
+
+	/** Restyle flags for a change to any class, or to the id, required
+	 * by attribute selectors on "class" or "id" which cannot be keyed
+	 * on a single name */
+	uint8_t any_class_restyle;
+	uint8_t any_id_restyle;
+
 	size_t hash_size;
 };
 
+/** Kind of dependency recorded for the element name of a compound
+ * selector which may tell ancestors apart by more than their name, id
+ * and classes: by attributes, pseudo classes or siblings */
+#define DEP_ANCESTOR 0xff
+
 static hash_entry empty_slot;
 
 static inline lwc_string *_class_name(const css_selector *selector);
 static inline lwc_string *_id_name(const css_selector *selector);
+static inline lwc_string *_element_name(const css_selector *selector);
+static css_error _insert_into_table(css_selector_hash *ctx, hash_t *table,
+		lwc_string *(*name)(const css_selector *selector),
+		const css_selector *selector, uint32_t source);
 static css_error _insert_into_chain(css_selector_hash *ctx, hash_entry *head,
+		const css_selector *selector, uint32_t source);
+static css_error _add_dependency(css_selector_hash *hash,
+		uint8_t change, lwc_string *name, uint8_t restyle);
+static css_error _add_attribute_dependencies(css_selector_hash *hash,
+		const css_selector_detail *detail, uint8_t restyle);
+static css_error _add_dependencies(css_selector_hash *hash,
 		const css_selector *selector);
 static css_error _remove_from_chain(css_selector_hash *ctx, hash_entry *head,
 		const css_selector *selector);
@@ -82,6 +129,10 @@ static css_error _iterate_universal(
 #define RULE_HAS_BYTECODE(r) \
 	(((css_rule_selector *)(r->sel->rule))->style != NULL)
 
+/* Entries from inactive sources are skipped, if sources are filtered */
+#define SOURCE_IS_ACTIVE(req, r) \
+	((req)->sources == NULL || (req)->sources[(r)->source])
+
 
 /**
  * Test first selector on selector chain for having matching element name.
@@ -110,6 +161,29 @@ static inline bool _chain_good_for_element_name(const css_selector *selector,
 }
 
 
+/**
+ * Test a selector chain's bloom filter against the node's bloom filter.
+ *
+ * \param req   Selection requirements, with node bloom and counters
+ * \param head  Hash entry whose chain bloom to test
+ * \return true iff the chain bloom is a subset of the node bloom
+ */
+static inline bool _chain_good_for_bloom(
+		const struct css_hash_selection_requirments *req,
+		const hash_entry *head)
+{
+	bool good = css_bloom_in_bloom(head->sel_chain_bloom, req->node_bloom);
+
+	if (req->bloom_stats != NULL) {
+		req->bloom_stats->tests++;
+		if (good == false)
+			req->bloom_stats->rejects++;
+	}
+
+	return good;
+}
+
+
 /**
  * Create a hash
  *
@@ -154,12 +228,24 @@ css_error css__selector_hash_create(css_selector_hash **hash)
 	}
 	h->ids.n_slots = DEFAULT_SLOTS;
 
+	/* Dependency table */
+	h->deps.slots = calloc(DEFAULT_DEP_SLOTS, sizeof(dep_entry *));
+	if (h->deps.slots == NULL) {
+		free(h->ids.slots);
+		free(h->classes.slots);
+		free(h->elements.slots);
+		free(h);
+		return CSS_NOMEM;
+	}
+	h->deps.n_slots = DEFAULT_DEP_SLOTS;
+
 	/* Universal chain head already initiliased by calloc of `h`. */
 
 	h->hash_size = sizeof(css_selector_hash) +
 			DEFAULT_SLOTS * sizeof(hash_entry) +
 			DEFAULT_SLOTS * sizeof(hash_entry) +
-			DEFAULT_SLOTS * sizeof(hash_entry);
+			DEFAULT_SLOTS * sizeof(hash_entry) +
+			DEFAULT_DEP_SLOTS * sizeof(dep_entry *);
 
 	*hash = h;
 
@@ -217,6 +303,19 @@ css_error css__selector_hash_destroy(css_selector_hash *hash)
 		free(d);
 	}
 
+	/* Dependency table */
+	for (i = 0; i < hash->deps.n_slots; i++) {
+		dep_entry *dep, *next;
+
+		for (dep = hash->deps.slots[i]; dep != NULL; dep = next) {
+			next = dep->next;
+
+			lwc_string_unref(dep->name);
+			free(dep);
+		}
+	}
+	free(hash->deps.slots);
+
 	free(hash);
 
 	return CSS_OK;
@@ -232,44 +331,172 @@ css_error css__selector_hash_destroy(css_selector_hash *hash)
 css_error css__selector_hash_insert(css_selector_hash *hash,
 		const css_selector *selector)
 {
-	uint32_t index, mask;
-	lwc_string *name;
+	return css__selector_hash_insert_from_source(hash, selector, 0);
+}
+
+/**
+ * Insert an item from a numbered source into a hash
+ *
+ * \param hash      The hash to insert into
+ * \param selector  Pointer to selector
+ * \param source    Number of the source the selector belongs to
+ * \return CSS_OK on success, appropriate error otherwise
+ *
+ * Hash chains are ordered by ascending specificity, then by ascending
+ * source, then by ascending rule index.  This allows selectors from
+ * several stylesheets to be merged into a single hash.
+ */
+css_error css__selector_hash_insert_from_source(css_selector_hash *hash,
+		const css_selector *selector, uint32_t source)
+{
 	css_error error;
 
 	if (hash == NULL || selector == NULL)
 		return CSS_BADPARM;
 
+	error = _add_dependencies(hash, selector);
+	if (error != CSS_OK)
+		return error;
+
 	/* Work out which hash to insert into */
-	if ((name = _id_name(selector)) != NULL) {
+	if (_id_name(selector) != NULL) {
 		/* Named ID */
-		mask = hash->ids.n_slots - 1;
-		index = _hash_name(name) & mask;
-
-		error = _insert_into_chain(hash, &hash->ids.slots[index],
-				selector);
-	} else if ((name = _class_name(selector)) != NULL) {
+		error = _insert_into_table(hash, &hash->ids, _id_name,
+				selector, source);
+	} else if (_class_name(selector) != NULL) {
 		/* Named class */
-		mask = hash->classes.n_slots - 1;
-		index = _hash_name(name) & mask;
-
-		error = _insert_into_chain(hash, &hash->classes.slots[index],
-				selector);
+		error = _insert_into_table(hash, &hash->classes, _class_name,
+				selector, source);
 	} else if (lwc_string_length(selector->data.qname.name) != 1 ||
 			lwc_string_data(selector->data.qname.name)[0] != '*') {
 		/* Named element */
-		mask = hash->elements.n_slots - 1;
-		index = _hash_name(selector->data.qname.name) & mask;
-
-		error = _insert_into_chain(hash, &hash->elements.slots[index],
-				selector);
+		error = _insert_into_table(hash, &hash->elements,
+				_element_name, selector, source);
 	} else {
 		/* Universal chain */
-		error = _insert_into_chain(hash, &hash->universal, selector);
+		error = _insert_into_chain(hash, &hash->universal, selector,
+				source);
 	}
 
 	return error;
 }
 
+/**
+ * Record the names a selector chain depends on, without inserting it
+ *
+ * \param hash      The hash to record dependencies in
+ * \param selector  Pointer to selector
+ * \return CSS_OK on success, appropriate error otherwise
+ *
+ * This allows a hash to serve as a set of the names used by selectors.
+ */
+css_error css__selector_hash_insert_dependencies(css_selector_hash *hash,
+		const css_selector *selector)
+{
+	if (hash == NULL || selector == NULL)
+		return CSS_BADPARM;
+
+	return _add_dependencies(hash, selector);
+}
+
+/**
+ * Find the nodes to restyle when a name on a node changes
+ *
+ * \param hash     Hash to consider
+ * \param change   Kind of change made to the node
+ * \param name     Class, id, attribute or pseudo class name that changed
+ * \param restyle  Updated with the union of its value and the
+ *                 css_select_restyle flags for the change
+ * \return CSS_OK on success, appropriate error otherwise
+ *
+ * The flags are found from every selector ever inserted into the hash,
+ * so may be conservative once selectors have been removed.
+ */
+css_error css__selector_hash_get_restyle(css_selector_hash *hash,
+		css_select_change change, lwc_string *name, uint32_t *restyle)
+{
+	const dep_entry *dep;
+	lwc_hash value;
+
+	if (hash == NULL || name == NULL || restyle == NULL)
+		return CSS_BADPARM;
+
+	if (change == CSS_SELECT_CHANGE_CLASS)
+		*restyle |= hash->any_class_restyle;
+	else if (change == CSS_SELECT_CHANGE_ID)
+		*restyle |= hash->any_id_restyle;
+
+	if (lwc_string_caseless_hash_value(name, &value) != lwc_error_ok)
+		return CSS_NOMEM;
+
+	dep = hash->deps.slots[(value ^ change) & (hash->deps.n_slots - 1)];
+
+	for (; dep != NULL; dep = dep->next) {
+		bool match;
+
+		if (dep->change != change || dep->hash != value)
+			continue;
+
+		if (lwc_string_caseless_isequal(dep->name, name,
+				&match) == lwc_error_ok && match) {
+			*restyle |= dep->restyle;
+			break;
+		}
+	}
+
+	return CSS_OK;
+}
+
+/**
+ * Find whether ancestors with an element name may be told apart
+ *
+ * \param hash      Hash to consider
+ * \param name      Element name of the ancestors
+ * \param distinct  Updated to true if any selector in the hash may tell
+ *                  apart two ancestors with this name which have the same
+ *                  classes and no id, otherwise left unchanged
+ * \return CSS_OK on success, appropriate error otherwise
+ *
+ * Such ancestors are told apart only by selectors which test their
+ * attributes, pseudo classes or siblings.  As with the restyle flags, the
+ * answer is found from every selector ever inserted into the hash.
+ */
+css_error css__selector_hash_ancestors_distinct(css_selector_hash *hash,
+		lwc_string *name, bool *distinct)
+{
+	const dep_entry *dep;
+	lwc_hash value;
+
+	if (hash == NULL || name == NULL || distinct == NULL)
+		return CSS_BADPARM;
+
+	if (hash->universal_ancestor_deps) {
+		*distinct = true;
+		return CSS_OK;
+	}
+
+	if (lwc_string_caseless_hash_value(name, &value) != lwc_error_ok)
+		return CSS_NOMEM;
+
+	dep = hash->deps.slots[(value ^ DEP_ANCESTOR) &
+			(hash->deps.n_slots - 1)];
+
+	for (; dep != NULL; dep = dep->next) {
+		bool match;
+
+		if (dep->change != DEP_ANCESTOR || dep->hash != value)
+			continue;
+
+		if (lwc_string_caseless_isequal(dep->name, name,
+				&match) == lwc_error_ok && match) {
+			*distinct = true;
+			break;
+		}
+	}
+
+	return CSS_OK;
+}
+
 /**
  * Remove an item from a hash
  *
@@ -295,6 +522,8 @@ css_error css__selector_hash_remove(css_selector_hash *hash,
 
 		error = _remove_from_chain(hash, &hash->ids.slots[index],
 				selector);
+		if (error == CSS_OK)
+			hash->ids.n_entries--;
 	} else if ((name = _class_name(selector)) != NULL) {
 		/* Named class */
 		mask = hash->classes.n_slots - 1;
@@ -302,6 +531,8 @@ css_error css__selector_hash_remove(css_selector_hash *hash,
 
 		error = _remove_from_chain(hash, &hash->classes.slots[index],
 				selector);
+		if (error == CSS_OK)
+			hash->classes.n_entries--;
 	} else if (lwc_string_length(selector->data.qname.name) != 1 ||
 			lwc_string_data(selector->data.qname.name)[0] != '*') {
 		/* Named element */
@@ -310,6 +541,8 @@ css_error css__selector_hash_remove(css_selector_hash *hash,
 
 		error = _remove_from_chain(hash, &hash->elements.slots[index],
 				selector);
+		if (error == CSS_OK)
+			hash->elements.n_entries--;
 	} else {
 		/* Universal chain */
 		error = _remove_from_chain(hash, &hash->universal, selector);
@@ -365,10 +598,9 @@ css_error css__selector_hash_find(css_selector_hash *hash,
 			if (lerror != lwc_error_ok)
 				return css_error_from_lwc_error(lerror);
 
-			if (match && RULE_HAS_BYTECODE(head)) {
-				if (css_bloom_in_bloom(
-						head->sel_chain_bloom,
-						req->node_bloom) &&
+			if (match && RULE_HAS_BYTECODE(head) &&
+					SOURCE_IS_ACTIVE(req, head)) {
+				if (_chain_good_for_bloom(req, head) &&
 				    mq_rule_good_for_media(head->sel->rule,
 						req->unit_ctx, req->media,
 						req->str)) {
@@ -440,10 +672,9 @@ css_error css__selector_hash_find_by_class(css_selector_hash *hash,
 				if (lerror != lwc_error_ok)
 					return css_error_from_lwc_error(lerror);
 
-				if (match && RULE_HAS_BYTECODE(head)) {
-					if (css_bloom_in_bloom(
-							head->sel_chain_bloom,
-							req->node_bloom) &&
+				if (match && RULE_HAS_BYTECODE(head) &&
+						SOURCE_IS_ACTIVE(req, head)) {
+					if (_chain_good_for_bloom(req, head) &&
 					    _chain_good_for_element_name(
 							head->sel,
 							&(req->qname),
@@ -522,10 +753,9 @@ css_error css__selector_hash_find_by_id(css_selector_hash *hash,
 				if (lerror != lwc_error_ok)
 					return css_error_from_lwc_error(lerror);
 
-				if (match && RULE_HAS_BYTECODE(head)) {
-					if (css_bloom_in_bloom(
-							head->sel_chain_bloom,
-							req->node_bloom) &&
+				if (match && RULE_HAS_BYTECODE(head) &&
+						SOURCE_IS_ACTIVE(req, head)) {
+					if (_chain_good_for_bloom(req, head) &&
 					    _chain_good_for_element_name(
 							head->sel,
 							&req->qname,
@@ -580,9 +810,8 @@ css_error css__selector_hash_find_universal(css_selector_hash *hash,
 		/* Search through chain for first match */
 		while (head != NULL) {
 			if (RULE_HAS_BYTECODE(head) &&
-			    css_bloom_in_bloom(
-					head->sel_chain_bloom,
-					req->node_bloom) &&
+			    SOURCE_IS_ACTIVE(req, head) &&
+			    _chain_good_for_bloom(req, head) &&
 			    mq_rule_good_for_media(head->sel->rule,
 					req->unit_ctx, req->media,
 					req->str)) {
@@ -623,6 +852,19 @@ css_error css__selector_hash_size(css_selector_hash *hash, size_t *size)
 	return CSS_OK;
 }
 
+/**
+ * Retrieve the source of a selector found in a hash
+ *
+ * \param matched  Selector found by a find function or iterator
+ * \return The source number the selector was inserted with
+ */
+uint32_t css__selector_hash_source(const css_selector **matched)
+{
+	const hash_entry *entry = (const hash_entry *) matched;
+
+	return entry->source;
+}
+
 /******************************************************************************
  * Private functions                                                          *
  ******************************************************************************/
@@ -681,6 +923,17 @@ lwc_string *_id_name(const css_selector *selector)
 	return name;
 }
 
+/**
+ * Retrieve the element name of a selector in the element hash
+ *
+ * \param selector  Selector to consider
+ * \return Pointer to element name
+ */
+lwc_string *_element_name(const css_selector *selector)
+{
+	return selector->data.qname.name;
+}
+
 
 /**
  * Add a selector detail to the bloom filter, if the detail is relevant.
@@ -780,6 +1033,376 @@ static void print_chain_bloom_details(css_bloom bloom[CSS_BLOOM_SIZE])
 }
 #endif
 
+/**
+ * Double the number of slots in a hash's dependency table
+ *
+ * \param hash  Hash whose dependency table to grow
+ * \return CSS_OK on success, CSS_NOMEM on memory exhaustion
+ */
+static css_error _grow_dependencies(css_selector_hash *hash)
+{
+	size_t n_slots = hash->deps.n_slots * 2;
+	dep_entry **slots;
+	uint32_t i;
+
+	slots = calloc(n_slots, sizeof(dep_entry *));
+	if (slots == NULL)
+		return CSS_NOMEM;
+
+	for (i = 0; i < hash->deps.n_slots; i++) {
+		dep_entry *dep, *next;
+
+		for (dep = hash->deps.slots[i]; dep != NULL; dep = next) {
+			size_t index = (dep->hash ^ dep->change) &
+					(n_slots - 1);
+
+			next = dep->next;
+
+			dep->next = slots[index];
+			slots[index] = dep;
+		}
+	}
+
+	free(hash->deps.slots);
+	hash->deps.slots = slots;
+	hash->hash_size += (n_slots - hash->deps.n_slots) *
+			sizeof(dep_entry *);
+	hash->deps.n_slots = n_slots;
+
+	return CSS_OK;
+}
+
+/**
+ * Record that a change to a name requires restyling
+ *
+ * \param hash     Hash to record the dependency in
+ * \param change   Kind of change, or DEP_ANCESTOR
+ * \param name     Name that may change
+ * \param restyle  css_select_restyle flags for nodes to restyle
+ * \return CSS_OK on success, appropriate error otherwise
+ */
+css_error _add_dependency(css_selector_hash *hash,
+		uint8_t change, lwc_string *name, uint8_t restyle)
+{
+	dep_entry *dep;
+	lwc_hash value;
+	size_t index;
+
+	if (lwc_string_caseless_hash_value(name, &value) != lwc_error_ok)
+		return CSS_NOMEM;
+
+	index = (value ^ change) & (hash->deps.n_slots - 1);
+
+	for (dep = hash->deps.slots[index]; dep != NULL; dep = dep->next) {
+		bool match;
+
+		if (dep->change == change && dep->hash == value &&
+				lwc_string_caseless_isequal(dep->name, name,
+						&match) == lwc_error_ok &&
+				match) {
+			dep->restyle |= restyle;
+			return CSS_OK;
+		}
+	}
+
+	if (hash->deps.n_entries >= hash->deps.n_slots * 2) {
+		css_error error = _grow_dependencies(hash);
+		if (error != CSS_OK)
+			return error;
+
+		index = (value ^ change) & (hash->deps.n_slots - 1);
+	}
+
+	dep = malloc(sizeof(dep_entry));
+	if (dep == NULL)
+		return CSS_NOMEM;
+
+	dep->name = lwc_string_ref(name);
+	dep->hash = value;
+	dep->change = change;
+	dep->restyle = restyle;
+	dep->next = hash->deps.slots[index];
+	hash->deps.slots[index] = dep;
+
+	hash->deps.n_entries++;
+	hash->hash_size += sizeof(dep_entry);
+
+	return CSS_OK;
+}
+
+/**
+ * Find whether an attribute name is caselessly equal to a string
+ *
+ * \param name  Attribute name
+ * \param data  String to compare with, in lower case
+ * \param len   Length of string
+ * \return true if the names are equal, false otherwise
+ */
+static inline bool _attribute_is(lwc_string *name, const char *data,
+		size_t len)
+{
+	return lwc_string_length(name) == len &&
+			strncasecmp(lwc_string_data(name), data, len) == 0;
+}
+
+/**
+ * Record the class or id dependencies of an attribute selector
+ *
+ * \param hash     Hash to record dependencies in
+ * \param detail   Attribute selector detail to consider
+ * \param restyle  css_select_restyle flags for nodes to restyle
+ * \return CSS_OK on success, appropriate error otherwise
+ *
+ * Selectors on the "class" and "id" attributes match or stop matching as
+ * classes and ids change.  Only [class~=x] depends on a single class, and
+ * only [id=x] on a single id.  Any other test of these attributes may be
+ * affected by a change to any class or to the id.
+ */
+css_error _add_attribute_dependencies(css_selector_hash *hash,
+		const css_selector_detail *detail, uint8_t restyle)
+{
+	lwc_string *value = detail->value.string;
+
+	if (_attribute_is(detail->qname.name, "class", SLEN("class"))) {
+		if (detail->type == CSS_SELECTOR_ATTRIBUTE_INCLUDES &&
+				value != NULL)
+			return _add_dependency(hash, CSS_SELECT_CHANGE_CLASS,
+					value, restyle);
+
+		hash->any_class_restyle |= restyle;
+	} else if (_attribute_is(detail->qname.name, "id", SLEN("id"))) {
+		if (detail->type == CSS_SELECTOR_ATTRIBUTE_EQUAL &&
+				value != NULL)
+			return _add_dependency(hash, CSS_SELECT_CHANGE_ID,
+					value, restyle);
+
+		hash->any_id_restyle |= restyle;
+	}
+
+	return CSS_OK;
+}
+
+/**
+ * Record the names a selector chain depends on
+ *
+ * A name in the chain's subject requires the node itself to be restyled
+ * when it changes.  A name elsewhere in the chain requires restyling of
+ * the node's descendants, or of its later siblings and their descendants,
+ * according to the combinator to its right.
+ *
+ * The element names of compound selectors other than the subject are also
+ * recorded where they test attributes or pseudo classes, or are joined to
+ * a sibling, as ancestors with such names may not share descendants'
+ * styles.
+ *
+ * \param hash      Hash to record dependencies in
+ * \param selector  Selector chain to consider
+ * \return CSS_OK on success, appropriate error otherwise
+ */
+css_error _add_dependencies(css_selector_hash *hash,
+		const css_selector *selector)
+{
+	uint8_t restyle = CSS_SELECT_RESTYLE_SELF;
+
+	while (selector != NULL) {
+		const css_selector_detail *detail = &selector->data;
+		bool ancestor_dep = false;
+		css_error error;
+
+		do {
+			css_select_change change;
+
+			switch (detail->type) {
+			case CSS_SELECTOR_CLASS:
+				change = CSS_SELECT_CHANGE_CLASS;
+				break;
+			case CSS_SELECTOR_ID:
+				change = CSS_SELECT_CHANGE_ID;
+				break;
+			case CSS_SELECTOR_PSEUDO_CLASS:
+				change = CSS_SELECT_CHANGE_PSEUDO_CLASS;
+				ancestor_dep = true;
+				break;
+			case CSS_SELECTOR_ATTRIBUTE:
+			case CSS_SELECTOR_ATTRIBUTE_EQUAL:
+			case CSS_SELECTOR_ATTRIBUTE_DASHMATCH:
+			case CSS_SELECTOR_ATTRIBUTE_INCLUDES:
+			case CSS_SELECTOR_ATTRIBUTE_PREFIX:
+			case CSS_SELECTOR_ATTRIBUTE_SUFFIX:
+			case CSS_SELECTOR_ATTRIBUTE_SUBSTRING:
+				change = CSS_SELECT_CHANGE_ATTRIBUTE;
+				ancestor_dep = true;
+
+				error = _add_attribute_dependencies(hash,
+						detail, restyle);
+				if (error != CSS_OK)
+					return error;
+				break;
+			default:
+				/* Element names and pseudo elements */
+				continue;
+			}
+
+			error = _add_dependency(hash, change,
+					detail->qname.name, restyle);
+			if (error != CSS_OK)
+				return error;
+		} while ((detail++)->next != 0);
+
+		if (selector->data.comb == CSS_COMBINATOR_SIBLING ||
+				selector->data.comb ==
+					CSS_COMBINATOR_GENERIC_SIBLING)
+			ancestor_dep = true;
+
+		/* The subject's own dependencies taint its node data */
+		if (ancestor_dep && restyle != CSS_SELECT_RESTYLE_SELF) {
+			lwc_string *name = selector->data.qname.name;
+
+			if (lwc_string_length(name) == 1 &&
+					lwc_string_data(name)[0] == '*') {
+				hash->universal_ancestor_deps = true;
+			} else {
+				error = _add_dependency(hash, DEP_ANCESTOR,
+						name, 0);
+				if (error != CSS_OK)
+					return error;
+			}
+		}
+
+		/* The combinator joins this compound selector to the one
+		 * on its left, which matches an ancestor or an earlier
+		 * sibling of the node matching this one. */
+		switch (selector->data.comb) {
+		case CSS_COMBINATOR_ANCESTOR:
+		case CSS_COMBINATOR_PARENT:
+			restyle = CSS_SELECT_RESTYLE_DESCENDANTS;
+			break;
+		case CSS_COMBINATOR_SIBLING:
+		case CSS_COMBINATOR_GENERIC_SIBLING:
+			restyle = CSS_SELECT_RESTYLE_SIBLINGS;
+			break;
+		default:
+			break;
+		}
+
+		selector = selector->combinator;
+	}
+
+	return CSS_OK;
+}
+
+/**
+ * Double the number of slots in one of a hash's tables
+ *
+ * \param ctx    Selector hash
+ * \param table  Table to grow
+ * \param name   Function to retrieve the name a selector is hashed by
+ * \return CSS_OK on success, CSS_NOMEM on memory exhaustion
+ *
+ * Each chain is split between two slots of the new table. Entries keep
+ * their relative order, so the new chains remain sorted.
+ */
+static css_error _grow_table(css_selector_hash *ctx, hash_t *table,
+		lwc_string *(*name)(const css_selector *selector))
+{
+	size_t n_slots = table->n_slots * 2;
+	hash_entry *slots, **tails;
+	uint32_t i;
+
+	slots = calloc(n_slots, sizeof(hash_entry));
+	if (slots == NULL)
+		return CSS_NOMEM;
+
+	tails = calloc(n_slots, sizeof(hash_entry *));
+	if (tails == NULL) {
+		free(slots);
+		return CSS_NOMEM;
+	}
+
+	/* Old chain i only feeds new slots i and i + table->n_slots, so
+	 * its head is always the first entry to reach either of them and
+	 * can never need allocating as a chained entry */
+	for (i = 0; i < table->n_slots; i++) {
+		hash_entry *head = &table->slots[i];
+		hash_entry *entry, *next;
+
+		if (head->sel == NULL)
+			continue;
+
+		for (entry = head; entry != NULL; entry = next) {
+			size_t index = _hash_name(name(entry->sel)) &
+					(n_slots - 1);
+			hash_entry *moved;
+
+			next = entry->next;
+
+			if (slots[index].sel == NULL) {
+				/* Entry becomes the head of its new chain */
+				slots[index] = *entry;
+				moved = &slots[index];
+
+				if (entry != head) {
+					free(entry);
+					ctx->hash_size -= sizeof(hash_entry);
+				}
+			} else {
+				/* Entry is chained in both tables */
+				assert(entry != head);
+
+				moved = entry;
+				tails[index]->next = moved;
+			}
+
+			moved->next = NULL;
+			tails[index] = moved;
+		}
+	}
+
+	free(tails);
+	free(table->slots);
+	table->slots = slots;
+	ctx->hash_size += (n_slots - table->n_slots) * sizeof(hash_entry);
+	table->n_slots = n_slots;
+
+	return CSS_OK;
+}
+
+/**
+ * Insert a selector into one of a hash's tables
+ *
+ * \param ctx       Selector hash
+ * \param table     Table to insert into
+ * \param name      Function to retrieve the name a selector is hashed by
+ * \param selector  Selector to insert
+ * \param source    Number of the source the selector belongs to
+ * \return CSS_OK on success, CSS_NOMEM on memory exhaustion
+ */
+static css_error _insert_into_table(css_selector_hash *ctx, hash_t *table,
+		lwc_string *(*name)(const css_selector *selector),
+		const css_selector *selector, uint32_t source)
+{
+	css_error error;
+	size_t index;
+
+	/* Keep chains short as large sheets are added */
+	if (table->n_entries >= table->n_slots * 2) {
+		error = _grow_table(ctx, table, name);
+		if (error != CSS_OK)
+			return error;
+	}
+
+	index = _hash_name(name(selector)) & (table->n_slots - 1);
+
+	error = _insert_into_chain(ctx, &table->slots[index], selector,
+			source);
+	if (error != CSS_OK)
+		return error;
+
+	table->n_entries++;
+
+	return CSS_OK;
+}
+
 /**
  * Insert a selector into a hash chain
  *
@@ -790,10 +1413,11 @@ static void print_chain_bloom_details(css_bloom bloom[CSS_BLOOM_SIZE])
  *         CSS_NOMEM on memory exhaustion.
  */
 css_error _insert_into_chain(css_selector_hash *ctx, hash_entry *head,
-		const css_selector *selector)
+		const css_selector *selector, uint32_t source)
 {
 	if (head->sel == NULL) {
 		head->sel = selector;
+		head->source = source;
 		head->next = NULL;
 		_chain_bloom_generate(selector, head->sel_chain_bloom);
 
@@ -813,8 +1437,14 @@ css_error _insert_into_chain(css_selector_hash *ctx, hash_entry *head,
 			if (search->sel->specificity > selector->specificity)
 				break;
 
+			/* Sort by ascending source */
+			if (search->sel->specificity == selector->specificity &&
+					search->source > source)
+				break;
+
 			/* Sort by ascending rule index */
 			if (search->sel->specificity == selector->specificity &&
+					search->source == source &&
 					search->sel->rule->index >
 					selector->rule->index)
 				break;
@@ -834,6 +1464,7 @@ css_error _insert_into_chain(css_selector_hash *ctx, hash_entry *head,
 		}
 
 		entry->sel = selector;
+		entry->source = source;
 		_chain_bloom_generate(selector, entry->sel_chain_bloom);
 
 #ifdef PRINT_CHAIN_BLOOM_DETAILS
@@ -876,8 +1507,13 @@ css_error _remove_from_chain(css_selector_hash *ctx, hash_entry *head,
 
 	if (prev == NULL) {
 		if (search->next != NULL) {
-			head->sel = search->next->sel;
-			head->next = search->next->next;
+			hash_entry *next = search->next;
+
+			*head = *next;
+
+			free(next);
+
+			ctx->hash_size -= sizeof(hash_entry);
 		} else {
 			head->sel = NULL;
 			head->next = NULL;
@@ -923,10 +1559,9 @@ css_error _iterate_elements(
 			if (lerror != lwc_error_ok)
 				return css_error_from_lwc_error(lerror);
 
-			if (match && RULE_HAS_BYTECODE(head)) {
-				if (css_bloom_in_bloom(
-						head->sel_chain_bloom,
-						req->node_bloom) &&
+			if (match && RULE_HAS_BYTECODE(head) &&
+					SOURCE_IS_ACTIVE(req, head)) {
+				if (_chain_good_for_bloom(req, head) &&
 				    mq_rule_good_for_media(head->sel->rule,
 						req->unit_ctx, req->media,
 						req->str)) {
@@ -979,10 +1614,9 @@ css_error _iterate_classes(
 				if (lerror != lwc_error_ok)
 					return css_error_from_lwc_error(lerror);
 
-				if (match && RULE_HAS_BYTECODE(head)) {
-					if (css_bloom_in_bloom(
-							head->sel_chain_bloom,
-							req->node_bloom) &&
+				if (match && RULE_HAS_BYTECODE(head) &&
+						SOURCE_IS_ACTIVE(req, head)) {
+					if (_chain_good_for_bloom(req, head) &&
 					    _chain_good_for_element_name(
 							head->sel,
 							&(req->qname),
@@ -1042,10 +1676,9 @@ css_error _iterate_ids(
 				if (lerror != lwc_error_ok)
 					return css_error_from_lwc_error(lerror);
 
-				if (match && RULE_HAS_BYTECODE(head)) {
-					if (css_bloom_in_bloom(
-							head->sel_chain_bloom,
-							req->node_bloom) &&
+				if (match && RULE_HAS_BYTECODE(head) &&
+						SOURCE_IS_ACTIVE(req, head)) {
+					if (_chain_good_for_bloom(req, head) &&
 					    _chain_good_for_element_name(
 							head->sel,
 							&req->qname,
@@ -1093,9 +1726,8 @@ css_error _iterate_universal(
 		/* Search through chain for first match */
 		while (head != NULL) {
 			if (RULE_HAS_BYTECODE(head) &&
-			    css_bloom_in_bloom(
-					head->sel_chain_bloom,
-					req->node_bloom) &&
+			    SOURCE_IS_ACTIVE(req, head) &&
+			    _chain_good_for_bloom(req, head) &&
 			    mq_rule_good_for_media(head->sel->rule,
 					req->unit_ctx, req->media,
 					req->str)) {
@@ -13,6 +13,7 @@
 #include <libcss/unit.h>
 #include <libcss/errors.h>
 #include <libcss/functypes.h>
+#include <libcss/select.h>
 
 #include "select/bloom.h"
 #include "select/strings.h"
@@ -30,6 +31,8 @@ struct css_hash_selection_requirments {
 	const css_media *media;		/* Media spec we're selecting for */
 	const css_unit_ctx *unit_ctx;	/* Document unit conversion context. */
 	const css_bloom *node_bloom;	/* Node's bloom filter */
+	const bool *sources;		/* Active sources, or NULL for all */
+	css_select_bloom_stats *bloom_stats; /* Bloom counters, or NULL */
 };
 
 typedef css_error (*css_selector_hash_iterator)(
@@ -42,6 +45,10 @@ css_error css__selector_hash_destroy(css_selector_hash *hash);
 
 css_error css__selector_hash_insert(css_selector_hash *hash,
 		const struct css_selector *selector);
+css_error css__selector_hash_insert_from_source(css_selector_hash *hash,
+		const struct css_selector *selector, uint32_t source);
+css_error css__selector_hash_insert_dependencies(css_selector_hash *hash,
+		const struct css_selector *selector);
 css_error css__selector_hash_remove(css_selector_hash *hash,
 		const struct css_selector *selector);
 
@@ -64,5 +71,12 @@ css_error css__selector_hash_find_universal(css_selector_hash *hash,
 
 css_error css__selector_hash_size(css_selector_hash *hash, size_t *size);
 
+css_error css__selector_hash_get_restyle(css_selector_hash *hash,
+		css_select_change change, lwc_string *name, uint32_t *restyle);
+css_error css__selector_hash_ancestors_distinct(css_selector_hash *hash,
+		lwc_string *name, bool *distinct);
+
+uint32_t css__selector_hash_source(const struct css_selector **matched);
+
 #endif
 
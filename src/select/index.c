@@ -0,0 +1,436 @@
+/*
+ * This file is part of LibCSS
+ * Licensed under the MIT License,
+ *                http://www.opensource.org/licenses/mit-license.php
+ * Copyright 2026 The NetSurf Project
+ */
+
+#include <stdlib.h>
+
+#include "stylesheet.h"
+#include "select/index.h"
+#include "select/mq.h"
+#include "utils/utils.h"
+
+/** Maximum depth of nested imports */
+#define IMPORT_STACK_SIZE 256
+
+/**
+ * Grow an array by one element if it is full
+ *
+ * \param array  Pointer to the array, updated if it is reallocated
+ * \param used   Number of elements in use
+ * \param alloc  Number of elements allocated, updated on growth
+ * \param size   Size of an element
+ * \return CSS_OK on success, CSS_NOMEM on memory exhaustion.
+ */
+static css_error _grow(void **array, uint32_t used, uint32_t *alloc,
+		size_t size)
+{
+	uint32_t new_alloc;
+	void *temp;
+
+	if (used < *alloc)
+		return CSS_OK;
+
+	new_alloc = (*alloc == 0) ? 8 : *alloc * 2;
+
+	temp = realloc(*array, new_alloc * size);
+	if (temp == NULL)
+		return CSS_NOMEM;
+
+	*array = temp;
+	*alloc = new_alloc;
+
+	return CSS_OK;
+}
+
+/* Internally exported function, documented in index.h */
+css_error css__select_walk_sheet(const css_stylesheet *sheet,
+		const css_select_walk_handler *handler, void *pw)
+{
+	const css_stylesheet *s = sheet;
+	const css_rule *rule = s->rule_list;
+	uint32_t sp = 0;
+	const css_rule *import_stack[IMPORT_STACK_SIZE];
+	css_error error;
+
+	do {
+		/* Find first non-charset rule, if we're at the list head */
+		if (rule == s->rule_list) {
+			while (rule != NULL && rule->type == CSS_RULE_CHARSET)
+				rule = rule->next;
+		}
+
+		if (rule != NULL && rule->type == CSS_RULE_IMPORT) {
+			/* Current rule is an import */
+			const css_rule_import *import =
+					(const css_rule_import *) rule;
+			bool follow = false;
+
+			error = handler->import(pw, import, &follow);
+			if (error != CSS_OK)
+				return error;
+
+			if (follow && import->sheet != NULL) {
+				if (sp >= IMPORT_STACK_SIZE)
+					return CSS_INVALID;
+
+				import_stack[sp++] = rule;
+
+				s = import->sheet;
+				rule = s->rule_list;
+			} else {
+				/* Not applicable; skip over it */
+				rule = rule->next;
+			}
+		} else {
+			/* Gone past import rules in this sheet */
+			error = handler->sheet(pw, s);
+			if (error != CSS_OK)
+				return error;
+
+			/* Find next sheet to process */
+			if (sp > 0) {
+				sp--;
+
+				if (handler->leave != NULL) {
+					error = handler->leave(pw,
+							(const css_rule_import *)
+							import_stack[sp]);
+					if (error != CSS_OK)
+						return error;
+				}
+
+				rule = import_stack[sp]->next;
+				s = import_stack[sp]->parent;
+			} else {
+				s = NULL;
+			}
+		}
+	} while (s != NULL);
+
+	return CSS_OK;
+}
+
+/**
+ * Add the selectors of a rule to a style index
+ *
+ * \param index   The index to add to
+ * \param rule    The rule to consider
+ * \param source  Number of the source the rule belongs to
+ * \return CSS_OK on success, appropriate error otherwise.
+ */
+static css_error _add_rule(css_select_index *index, const css_rule *rule,
+		uint32_t source)
+{
+	css_error error;
+
+	switch (rule->type) {
+	case CSS_RULE_SELECTOR:
+	{
+		const css_rule_selector *s = (const css_rule_selector *) rule;
+		uint32_t i;
+
+		for (i = 0; i < rule->items; i++) {
+			if (index->names_only) {
+				error = css__selector_hash_insert_dependencies(
+						index->selectors,
+						s->selectors[i]);
+			} else {
+				error = css__selector_hash_insert_from_source(
+						index->selectors,
+						s->selectors[i], source);
+			}
+			if (error != CSS_OK)
+				return error;
+		}
+	}
+		break;
+	case CSS_RULE_MEDIA:
+	{
+		const css_rule_media *m = (const css_rule_media *) rule;
+		const css_rule *r;
+
+		for (r = m->first_child; r != NULL; r = r->next) {
+			error = _add_rule(index, r, source);
+			if (error != CSS_OK)
+				return error;
+		}
+	}
+		break;
+	default:
+		break;
+	}
+
+	return CSS_OK;
+}
+
+/**
+ * Add a stylesheet's own selectors to a style index as a new source
+ *
+ * \param index   The index to add to
+ * \param sheet   The sheet to add
+ * \param top     Index of the top-level sheet the sheet belongs to
+ * \param import  Index of the import that brought in the sheet, or -1
+ * \param alloc   Number of sources allocated, updated on growth
+ * \return CSS_OK on success, appropriate error otherwise.
+ */
+static css_error _add_source(css_select_index *index,
+		const css_stylesheet *sheet, uint32_t top, int32_t import,
+		uint32_t *alloc)
+{
+	css_select_index_source *source;
+	const css_rule *rule;
+	css_error error;
+
+	error = _grow((void **) &index->sources, index->n_sources, alloc,
+			sizeof(*index->sources));
+	if (error != CSS_OK)
+		return error;
+
+	source = &index->sources[index->n_sources];
+	source->sheet = sheet;
+	source->modifications = sheet->modifications;
+	source->origin = index->sheets[top].origin;
+	source->top = top;
+	source->import = import;
+
+	for (rule = sheet->rule_list; rule != NULL; rule = rule->next) {
+		error = _add_rule(index, rule, index->n_sources);
+		if (error != CSS_OK)
+			return error;
+	}
+
+	index->n_sources++;
+
+	return CSS_OK;
+}
+
+/**
+ * State for adding a top-level sheet and its imports to a style index
+ */
+typedef struct add_sheet_ctx {
+	css_select_index *index;	/**< The index to add to */
+	uint32_t top;			/**< Index of the top-level sheet */
+	int32_t import;			/**< Import being walked, or -1 */
+	uint32_t *sources_alloc;	/**< Number of sources allocated */
+	uint32_t *imports_alloc;	/**< Number of imports allocated */
+} add_sheet_ctx;
+
+/**
+ * Record an import rule in a style index, and follow it if it has a sheet
+ *
+ * \param pw      The add_sheet_ctx
+ * \param import  The import rule
+ * \param follow  Updated to true if the import's sheet is to be added
+ * \return CSS_OK on success, appropriate error otherwise.
+ */
+static css_error _add_sheet_import(void *pw, const css_rule_import *import,
+		bool *follow)
+{
+	add_sheet_ctx *c = pw;
+	css_select_index *index = c->index;
+	css_select_index_import *entry;
+	css_error error;
+
+	error = _grow((void **) &index->imports, index->n_imports,
+			c->imports_alloc, sizeof(*index->imports));
+	if (error != CSS_OK)
+		return error;
+
+	entry = &index->imports[index->n_imports];
+	entry->rule = import;
+	entry->sheet = import->sheet;
+	entry->parent = c->import;
+	entry->top = c->top;
+	entry->active = false;
+
+	/* Media are considered when the index is activated, so every
+	 * import with a sheet is followed */
+	if (import->sheet != NULL) {
+		c->import = index->n_imports;
+		*follow = true;
+	}
+
+	index->n_imports++;
+
+	return CSS_OK;
+}
+
+/**
+ * Return to the sheet containing an import, once its sheet is added
+ *
+ * \param pw      The add_sheet_ctx
+ * \param import  The import rule
+ * \return CSS_OK.
+ */
+static css_error _add_sheet_leave(void *pw, const css_rule_import *import)
+{
+	add_sheet_ctx *c = pw;
+
+	UNUSED(import);
+
+	c->import = c->index->imports[c->import].parent;
+
+	return CSS_OK;
+}
+
+/**
+ * Add a stylesheet reached while walking a top-level sheet as a source
+ *
+ * \param pw     The add_sheet_ctx
+ * \param sheet  The sheet to add
+ * \return CSS_OK on success, appropriate error otherwise.
+ */
+static css_error _add_sheet_source(void *pw, const css_stylesheet *sheet)
+{
+	add_sheet_ctx *c = pw;
+
+	return _add_source(c->index, sheet, c->top, c->import,
+			c->sources_alloc);
+}
+
+static const css_select_walk_handler add_sheet_handler = {
+	_add_sheet_import,
+	_add_sheet_leave,
+	_add_sheet_source
+};
+
+/**
+ * Add a top-level stylesheet and everything it imports to a style index
+ *
+ * \param index          The index to add to
+ * \param top            Index of the top-level sheet
+ * \param sources_alloc  Number of sources allocated, updated on growth
+ * \param imports_alloc  Number of imports allocated, updated on growth
+ * \return CSS_OK on success, appropriate error otherwise.
+ */
+static css_error _add_sheet(css_select_index *index, uint32_t top,
+		uint32_t *sources_alloc, uint32_t *imports_alloc)
+{
+	add_sheet_ctx c = {
+		index, top, -1, sources_alloc, imports_alloc
+	};
+
+	return css__select_walk_sheet(index->sheets[top].sheet,
+			&add_sheet_handler, &c);
+}
+
+/* Internally exported function, documented in index.h */
+css_error css__select_index_create(const css_select_sheet *sheets,
+		uint32_t n_sheets, bool names_only, css_select_index **index)
+{
+	uint32_t sources_alloc = 0, imports_alloc = 0;
+	css_select_index *idx;
+	css_error error;
+	uint32_t i;
+
+	idx = calloc(1, sizeof(*idx));
+	if (idx == NULL)
+		return CSS_NOMEM;
+
+	idx->sheets = sheets;
+	idx->n_sheets = n_sheets;
+	idx->names_only = names_only;
+
+	error = css__selector_hash_create(&idx->selectors);
+	if (error != CSS_OK)
+		goto failed;
+
+	for (i = 0; i < n_sheets; i++) {
+		error = _add_sheet(idx, i, &sources_alloc, &imports_alloc);
+		if (error != CSS_OK)
+			goto failed;
+	}
+
+	idx->sheet_active = calloc(n_sheets + 1, sizeof(bool));
+	idx->source_active = calloc(idx->n_sources + 1, sizeof(bool));
+	if (idx->sheet_active == NULL || idx->source_active == NULL) {
+		error = CSS_NOMEM;
+		goto failed;
+	}
+
+	*index = idx;
+
+	return CSS_OK;
+
+failed:
+	css__select_index_destroy(idx);
+	return error;
+}
+
+/* Internally exported function, documented in index.h */
+void css__select_index_destroy(css_select_index *index)
+{
+	if (index->selectors != NULL)
+		css__selector_hash_destroy(index->selectors);
+
+	free(index->sheet_active);
+	free(index->source_active);
+	free(index->imports);
+	free(index->sources);
+	free(index);
+}
+
+/* Internally exported function, documented in index.h */
+bool css__select_index_is_current(const css_select_index *index)
+{
+	uint32_t i;
+
+	/* Check the sources first: every rule added to or removed from a
+	 * sheet is counted, so if no source has been modified, each import
+	 * rule recorded below is still in its sheet. */
+	for (i = 0; i < index->n_sources; i++) {
+		const css_select_index_source *source = &index->sources[i];
+
+		if (source->sheet->modifications != source->modifications)
+			return false;
+	}
+
+	for (i = 0; i < index->n_imports; i++) {
+		const css_select_index_import *import = &index->imports[i];
+
+		if (import->rule->sheet != import->sheet)
+			return false;
+	}
+
+	return true;
+}
+
+/* Internally exported function, documented in index.h */
+void css__select_index_activate(css_select_index *index,
+		const css_unit_ctx *unit_ctx,
+		const css_media *media,
+		const css_select_strings *str)
+{
+	uint32_t i;
+
+	for (i = 0; i < index->n_sheets; i++) {
+		const css_select_sheet *s = &index->sheets[i];
+
+		index->sheet_active[i] = s->sheet->disabled == false &&
+				mq__list_match(s->media, unit_ctx, media, str);
+	}
+
+	/* Imports are ordered such that an import's parent precedes it */
+	for (i = 0; i < index->n_imports; i++) {
+		css_select_index_import *import = &index->imports[i];
+		bool parent_active = (import->parent < 0) ?
+				index->sheet_active[import->top] :
+				index->imports[import->parent].active;
+
+		import->active = parent_active &&
+				import->sheet != NULL &&
+				mq__list_match(import->rule->media,
+						unit_ctx, media, str);
+	}
+
+	for (i = 0; i < index->n_sources; i++) {
+		const css_select_index_source *source = &index->sources[i];
+
+		index->source_active[i] = (source->import < 0) ?
+				index->sheet_active[source->top] :
+				index->imports[source->import].active;
+	}
+}
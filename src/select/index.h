@@ -0,0 +1,172 @@
+/*
+ * This file is part of LibCSS
+ * Licensed under the MIT License,
+ *                http://www.opensource.org/licenses/mit-license.php
+ * Copyright 2026 The NetSurf Project
+ */
+
+#ifndef css_select_index_h_
+#define css_select_index_h_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <libcss/errors.h>
+
+#include "select/hash.h"
+#include "select/select.h"
+
+/**
+ * Callbacks for css__select_walk_sheet()
+ */
+typedef struct css_select_walk_handler {
+	/**
+	 * Decide whether to follow an import rule
+	 *
+	 * \param pw      Client private data
+	 * \param import  The import rule, whose sheet may be NULL
+	 * \param follow  Updated to true to walk the imported sheet
+	 * \return CSS_OK on success, appropriate error otherwise.
+	 */
+	css_error (*import)(void *pw, const css_rule_import *import,
+			bool *follow);
+
+	/**
+	 * Finish with a followed import, once its sheet has been walked
+	 *
+	 * May be NULL.
+	 *
+	 * \param pw      Client private data
+	 * \param import  The import rule
+	 * \return CSS_OK on success, appropriate error otherwise.
+	 */
+	css_error (*leave)(void *pw, const css_rule_import *import);
+
+	/**
+	 * Process a sheet, after every sheet it imports
+	 *
+	 * \param pw     Client private data
+	 * \param sheet  The sheet to process
+	 * \return CSS_OK on success, appropriate error otherwise.
+	 */
+	css_error (*sheet)(void *pw, const css_stylesheet *sheet);
+} css_select_walk_handler;
+
+/**
+ * Walk a stylesheet and the sheets it imports in cascade order
+ *
+ * \param sheet    The top-level sheet
+ * \param handler  Callbacks to make during the walk
+ * \param pw       Client private data for the callbacks
+ * \return CSS_OK on success,
+ *         CSS_INVALID if imports are nested too deeply,
+ *         or any error returned by a callback.
+ *
+ * Each sheet is processed once the sheets its import rules lead to have
+ * been processed, in the order the import rules appear.
+ */
+css_error css__select_walk_sheet(const css_stylesheet *sheet,
+		const css_select_walk_handler *handler, void *pw);
+
+/**
+ * An import rule encountered while building a style index
+ */
+typedef struct css_select_index_import {
+	const css_rule_import *rule;	/**< The import rule */
+	const css_stylesheet *sheet;	/**< Imported sheet when indexed */
+	int32_t parent;			/**< Import of containing sheet, or -1 */
+	uint32_t top;			/**< Index of top-level sheet */
+	bool active;			/**< Whether import currently applies */
+} css_select_index_import;
+
+/**
+ * A stylesheet whose selectors are in a style index
+ *
+ * Sources are numbered in the order css_select_style() processes
+ * stylesheets: a sheet's imports precede the sheet itself, and top-level
+ * sheets are in selection context order.
+ */
+typedef struct css_select_index_source {
+	const css_stylesheet *sheet;	/**< Stylesheet */
+	uint32_t modifications;		/**< Sheet's modifications when
+					 * indexed */
+	css_origin origin;		/**< Origin of top-level sheet */
+	uint32_t top;			/**< Index of top-level sheet */
+	int32_t import;			/**< Import of sheet, or -1 if top */
+} css_select_index_source;
+
+/**
+ * Style index
+ *
+ * A single selector hash holding the selectors of every stylesheet in a
+ * selection context, including imported sheets.  Each selector is tagged
+ * with the source it came from, so the hash chains are ordered as if the
+ * sheets were processed one after another.
+ *
+ * An index may instead record only the names its selectors use, such as
+ * the classes and ids, without the selectors themselves.  Its hash then
+ * serves as a set of names, which is much cheaper to build.
+ */
+typedef struct css_select_index {
+	css_selector_hash *selectors;	/**< Selectors of all sources */
+	bool names_only;		/**< Whether only names are recorded */
+
+	const css_select_sheet *sheets;	/**< Top-level sheets */
+	uint32_t n_sheets;		/**< Number of top-level sheets */
+	bool *sheet_active;		/**< Whether each top-level applies */
+
+	css_select_index_import *imports; /**< Imports, parents first */
+	uint32_t n_imports;		/**< Number of imports */
+
+	css_select_index_source *sources; /**< Sources, in cascade order */
+	uint32_t n_sources;		/**< Number of sources */
+	bool *source_active;		/**< Whether each source applies */
+} css_select_index;
+
+/**
+ * Build a style index for a selection context's stylesheets
+ *
+ * \param sheets      Array of the context's top-level sheets
+ * \param n_sheets    Number of sheets
+ * \param names_only  Whether to record only the names selectors use
+ * \param index       Updated to the new index on success
+ * \return CSS_OK on success, appropriate error otherwise.
+ *
+ * The index refers to the sheets array, so must be destroyed before the
+ * array is changed.
+ */
+css_error css__select_index_create(const css_select_sheet *sheets,
+		uint32_t n_sheets, bool names_only, css_select_index **index);
+
+/**
+ * Destroy a style index
+ *
+ * \param index  The index to destroy
+ */
+void css__select_index_destroy(css_select_index *index);
+
+/**
+ * Determine whether a style index still reflects its stylesheets
+ *
+ * Rules may be added to or removed from a sheet, or imported sheets
+ * registered, after the sheet was added to a selection context.
+ *
+ * \param index  The index to check
+ * \return true if the index is current, false if it must be rebuilt.
+ */
+bool css__select_index_is_current(const css_select_index *index);
+
+/**
+ * Determine which of a style index's sources apply to a media
+ *
+ * \param index     The index to update
+ * \param unit_ctx  Current unit conversion context
+ * \param media     Current media spec
+ * \param str       Selection strings
+ */
+void css__select_index_activate(css_select_index *index,
+		const css_unit_ctx *unit_ctx,
+		const css_media *media,
+		const css_select_strings *str);
+
+#endif
@@ -6,9 +6,17 @@
 overrides = {
     'get': {},
     'set': {},
+    'compose': set(),
     'properties': {}
 }
 
+# Properties whose compose function does more than take the parent's value
+# where the child's is inherit, or whose copy function stores values other
+# than zero alongside opcodes which have none, so which must not be composed
+# by blending.
+overrides['compose'].add('text_align')
+overrides['compose'].add('column_gap')
+
 overrides['get']['clip'] = '''\
 static inline uint8_t get_clip(
 		const css_computed_style *style,
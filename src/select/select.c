@@ -20,6 +20,7 @@
 #include "select/computed.h"
 #include "select/dispatch.h"
 #include "select/hash.h"
+#include "select/index.h"
 #include "select/mq.h"
 #include "select/propset.h"
 #include "select/font_face.h"
@@ -35,15 +36,6 @@
 /* Define this to enable verbose messages when attempting to share styles */
 #undef DEBUG_STYLE_SHARING
 
-/**
- * Container for stylesheet selection info
- */
-typedef struct css_select_sheet {
-	const css_stylesheet *sheet;	/**< Stylesheet */
-	css_origin origin;		/**< Stylesheet origin */
-	css_mq_query *media;		/**< Applicable media */
-} css_select_sheet;
-
 /**
  * CSS selection context
  */
@@ -60,6 +52,15 @@ struct css_select_ctx {
 
 	css_calculator *calc; /**< A calculator to hand off to computed styles */
 
+	css_arena *arena;	/**< Style sharing arena for selected styles */
+
+	bool use_index;		/**< Whether to select using a style index */
+	css_select_index *index; /**< Style index, or NULL if not built */
+	css_select_index *names; /**< Names used by selectors, or NULL */
+
+	css_select_bloom_stats bloom_stats; /**< Bloom filter counters */
+	css_select_sharing_stats sharing_stats; /**< Style sharing counters */
+
 	/* Interned default style */
 	css_computed_style *default_style;
 };
@@ -107,6 +108,17 @@ static css_error set_initial(css_select_state *state,
 static css_error select_from_sheet(css_select_ctx *ctx,
 		const css_stylesheet *sheet, css_origin origin,
 		css_select_state *state);
+static css_error restyle_from_sheet(const css_stylesheet *sheet,
+		css_select_change change, lwc_string *name,
+		uint32_t *restyle);
+static css_error css_select__style(css_select_ctx *ctx, void *node,
+		const css_unit_ctx *unit_ctx,
+		const css_media *media, const css_stylesheet *inline_style,
+		css_select_handler *handler,
+		css_select_subtree_handler *subtree, void *pw,
+		css_select_results **result);
+static css_error match_selectors_in_index(css_select_ctx *ctx,
+		const css_select_index *index, css_select_state *state);
 static css_error match_selectors_in_sheet(css_select_ctx *ctx,
 		const css_stylesheet *sheet, css_select_state *state);
 static css_error match_selector_chain(css_select_ctx *ctx,
@@ -255,8 +267,16 @@ css_error css_select_ctx_create(css_select_ctx **result)
 		return error;
 	}
 
+	error = css__arena_create(&c->arena);
+	if (error != CSS_OK) {
+		css_calculator_unref(c->calc);
+		free(c);
+		return error;
+	}
+
 	error = css_select_strings_intern(&c->str);
 	if (error != CSS_OK) {
+		css__arena_unref(c->arena);
 		css_calculator_unref(c->calc);
 		free(c);
 		return error;
@@ -267,6 +287,132 @@ css_error css_select_ctx_create(css_select_ctx **result)
 	return CSS_OK;
 }
 
+/**
+ * Discard a selection context's style index and set of selector names
+ *
+ * \param ctx  The context whose style index to discard
+ *
+ * They are rebuilt when next needed.
+ */
+static void css_select__discard_index(css_select_ctx *ctx)
+{
+	if (ctx->index != NULL) {
+		css__select_index_destroy(ctx->index);
+		ctx->index = NULL;
+	}
+
+	if (ctx->names != NULL) {
+		css__select_index_destroy(ctx->names);
+		ctx->names = NULL;
+	}
+}
+
+/**
+ * Prepare a selection context's style index for selection
+ *
+ * \param ctx       The context to prepare
+ * \param unit_ctx  Context for length unit conversions
+ * \param media     Currently active media specification
+ * \return CSS_OK on success, appropriate error otherwise.
+ *
+ * If the context uses a style index, it is (re)built as required, and
+ * the sources which apply to the media are determined.  Otherwise, any
+ * out of date set of names used by the context's selectors is discarded,
+ * to be rebuilt by css_select__names() if style sharing consults it.
+ *
+ * This is called once for each call to the public selection functions,
+ * rather than for each node they select for.
+ */
+static css_error css_select__prepare_index(css_select_ctx *ctx,
+		const css_unit_ctx *unit_ctx, const css_media *media)
+{
+	css_error error;
+
+	if (ctx->use_index == false) {
+		if (ctx->names != NULL &&
+				!css__select_index_is_current(ctx->names))
+			css_select__discard_index(ctx);
+
+		return CSS_OK;
+	}
+
+	if (ctx->index != NULL && !css__select_index_is_current(ctx->index))
+		css_select__discard_index(ctx);
+
+	if (ctx->index == NULL) {
+		error = css__select_index_create(ctx->sheets, ctx->n_sheets,
+				false, &ctx->index);
+		if (error != CSS_OK)
+			return error;
+	}
+
+	css__select_index_activate(ctx->index, unit_ctx, media, &ctx->str);
+
+	return CSS_OK;
+}
+
+/**
+ * Get the hash recording the names used by a context's selectors
+ *
+ * \param ctx    The context to consider, prepared for selection
+ * \param names  Updated to the hash
+ * \return CSS_OK on success, appropriate error otherwise.
+ *
+ * The style index records the names used by its selectors, so is used
+ * in place of the set of names when the context has one.  Otherwise the
+ * set of names is built the first time it is needed.
+ */
+static css_error css_select__names(css_select_ctx *ctx,
+		css_selector_hash **names)
+{
+	css_error error;
+
+	if (ctx->index != NULL) {
+		*names = ctx->index->selectors;
+		return CSS_OK;
+	}
+
+	if (ctx->names == NULL) {
+		error = css__select_index_create(ctx->sheets, ctx->n_sheets,
+				true, &ctx->names);
+		if (error != CSS_OK)
+			return error;
+	}
+
+	*names = ctx->names->selectors;
+
+	return CSS_OK;
+}
+
+/**
+ * Find whether a name is used by any of a context's selectors
+ *
+ * \param ctx     The context to consider, prepared for selection
+ * \param change  Kind of name: class, id, attribute or pseudo class
+ * \param name    The name to look for
+ * \param used    Updated to whether any selector uses the name
+ * \return CSS_OK on success, appropriate error otherwise.
+ */
+static css_error css_select__name_used(css_select_ctx *ctx,
+		css_select_change change, lwc_string *name, bool *used)
+{
+	uint32_t restyle = CSS_SELECT_RESTYLE_NONE;
+	css_selector_hash *names;
+	css_error error;
+
+	*used = false;
+
+	error = css_select__names(ctx, &names);
+	if (error != CSS_OK)
+		return error;
+
+	error = css__selector_hash_get_restyle(names, change, name, &restyle);
+
+	*used = (restyle != CSS_SELECT_RESTYLE_NONE);
+
+	return error;
+}
+
 /**
  * Destroy a selection context
  *
@@ -283,6 +429,8 @@ css_error css_select_ctx_destroy(css_select_ctx *ctx)
 	if (ctx->default_style != NULL)
 		css_computed_style_destroy(ctx->default_style);
 
+	css_select__discard_index(ctx);
+
 	if (ctx->sheets != NULL) {
 		for (uint32_t index = 0; index < ctx->n_sheets; index++) {
 			css__mq_query_destroy(ctx->sheets[index].media);
@@ -292,6 +440,8 @@ css_error css_select_ctx_destroy(css_select_ctx *ctx)
 
 	css_calculator_unref(ctx->calc);
 
+	css__arena_unref(ctx->arena);
+
 	free(ctx);
 
 	return CSS_OK;
@@ -347,6 +497,8 @@ css_error css_select_ctx_insert_sheet(css_select_ctx *ctx,
 	if (index > ctx->n_sheets)
 		return CSS_INVALID;
 
+	css_select__discard_index(ctx);
+
 	temp = realloc(ctx->sheets,
 			(ctx->n_sheets + 1) * sizeof(css_select_sheet));
 	if (temp == NULL)
@@ -407,6 +559,8 @@ css_error css_select_ctx_remove_sheet(css_select_ctx *ctx,
 	if (index == ctx->n_sheets)
 		return CSS_INVALID;
 
+	css_select__discard_index(ctx);
+
 	css__mq_query_destroy(ctx->sheets[index].media);
 
 	ctx->n_sheets--;
@@ -435,6 +589,126 @@ css_error css_select_ctx_count_sheets(css_select_ctx *ctx, uint32_t *count)
 	return CSS_OK;
 }
 
+/**
+ * Enable or disable a selection context's style index
+ *
+ * \param ctx     Context to consider
+ * \param enable  Whether to select using a style index
+ * \return CSS_OK on success, appropriate error otherwise
+ *
+ * By default, each of a context's stylesheets is searched separately for
+ * the selectors that may match a node.  When the style index is enabled,
+ * the selectors of all the context's sheets, including imported sheets,
+ * are merged into a single index that is searched once for each node.
+ * This is faster for contexts with many sheets.
+ *
+ * The index is built when styles are next selected, and is rebuilt
+ * whenever sheets are added to or removed from the context, or rules
+ * are added to or removed from its sheets.
+ */
+css_error css_select_ctx_enable_index(css_select_ctx *ctx, bool enable)
+{
+	if (ctx == NULL)
+		return CSS_BADPARM;
+
+	if (ctx->use_index != enable)
+		css_select__discard_index(ctx);
+
+	ctx->use_index = enable;
+
+	return CSS_OK;
+}
+
+/**
+ * Get the style sharing statistics of a selection context
+ *
+ * \param ctx    Context to consider
+ * \param stats  Pointer to location to receive statistics
+ * \return CSS_OK on success, appropriate error otherwise
+ */
+css_error css_select_ctx_get_arena_stats(css_select_ctx *ctx,
+		css_select_arena_stats *stats)
+{
+	if (ctx == NULL || stats == NULL)
+		return CSS_BADPARM;
+
+	css__arena_get_stats(ctx->arena, stats);
+
+	return CSS_OK;
+}
+
+/**
+ * Get the bloom filter statistics of a selection context
+ *
+ * \param ctx    Context to consider
+ * \param stats  Pointer to location to receive statistics
+ * \return CSS_OK on success, appropriate error otherwise
+ */
+css_error css_select_ctx_get_bloom_stats(css_select_ctx *ctx,
+		css_select_bloom_stats *stats)
+{
+	if (ctx == NULL || stats == NULL)
+		return CSS_BADPARM;
+
+	*stats = ctx->bloom_stats;
+	stats->bits = CSS_BLOOM_SIZE * 32;
+
+	return CSS_OK;
+}
+
+/**
+ * Get the style sharing statistics of a selection context
+ *
+ * \param ctx    Context to consider
+ * \param stats  Pointer to location to receive statistics
+ * \return CSS_OK on success, appropriate error otherwise
+ */
+css_error css_select_ctx_get_sharing_stats(css_select_ctx *ctx,
+		css_select_sharing_stats *stats)
+{
+	if (ctx == NULL || stats == NULL)
+		return CSS_BADPARM;
+
+	*stats = ctx->sharing_stats;
+
+	return CSS_OK;
+}
+
+/**
+ * Find the nodes to restyle after a change to a node
+ *
+ * \param ctx      Context to consider
+ * \param change   Kind of change made to the node
+ * \param name     Class, id, attribute or pseudo class name that changed
+ * \param restyle  Pointer to location to receive css_select_restyle flags
+ * \return CSS_OK on success, appropriate error otherwise
+ *
+ * The result considers the selectors of every sheet in the context and
+ * everything they import, regardless of media, so it may be conservative.
+ * When an id changes, both the old and new ids should be considered.
+ */
+css_error css_select_ctx_get_restyle(css_select_ctx *ctx,
+		css_select_change change, lwc_string *name,
+		uint32_t *restyle)
+{
+	css_error error;
+	uint32_t i;
+
+	if (ctx == NULL || name == NULL || restyle == NULL)
+		return CSS_BADPARM;
+
+	*restyle = CSS_SELECT_RESTYLE_NONE;
+
+	for (i = 0; i < ctx->n_sheets; i++) {
+		error = restyle_from_sheet(ctx->sheets[i].sheet, change, name,
+				restyle);
+		if (error != CSS_OK)
+			return error;
+	}
+
+	return CSS_OK;
+}
+
 /**
  * Retrieve a sheet from a selection context
  *
@@ -484,7 +758,7 @@ static css_error css__select_ctx_create_default_style(css_select_ctx *ctx,
 	}
 
 	/* Neither create nor initialise intern the style, so intern it now */
-	error = css__arena_intern_style(&style);
+	error = css__arena_intern_style(ctx->arena, &style);
 	if (error != CSS_OK)
 		return error;
 
@@ -529,6 +803,119 @@ css_error css_select_default_style(css_select_ctx *ctx,
 }
 
 
+/**
+ * Add a node's element name, id and class names to a bloom filter
+ *
+ * \param node     Node to add
+ * \param handler  Dispatch table of handler functions
+ * \param pw       Client-specific private data for handler functions
+ * \param bloom    Bloom filter to add to
+ * \return CSS_OK on success, appropriate error otherwise.
+ */
+static css_error css__bloom_add_node(void *node,
+		css_select_handler *handler, void *pw,
+		css_bloom bloom[CSS_BLOOM_SIZE])
+{
+	css_qname qname = { NULL, NULL };
+	lwc_string *id = NULL;
+	lwc_string **classes = NULL;
+	uint32_t n_classes = 0;
+	lwc_hash hash;
+	css_error error;
+
+	error = handler->node_name(pw, node, &qname);
+	if (error != CSS_OK)
+		goto cleanup;
+
+	error = handler->node_id(pw, node, &id);
+	if (error != CSS_OK)
+		goto cleanup;
+
+	error = handler->node_classes(pw, node, &classes, &n_classes);
+	if (error != CSS_OK)
+		goto cleanup;
+
+	error = CSS_NOMEM;
+
+	if (lwc_string_caseless_hash_value(qname.name, &hash) !=
+			lwc_error_ok)
+		goto cleanup;
+	css_bloom_add_hash(bloom, hash);
+
+	if (id != NULL) {
+		if (lwc_string_caseless_hash_value(id, &hash) !=
+				lwc_error_ok)
+			goto cleanup;
+		css_bloom_add_hash(bloom, hash);
+	}
+
+	for (uint32_t i = 0; i < n_classes; i++) {
+		if (lwc_string_caseless_hash_value(classes[i], &hash) !=
+				lwc_error_ok)
+			goto cleanup;
+		css_bloom_add_hash(bloom, hash);
+	}
+
+	error = CSS_OK;
+
+cleanup:
+	if (classes != NULL) {
+		for (uint32_t i = 0; i < n_classes; i++) {
+			lwc_string_unref(classes[i]);
+		}
+	}
+
+	lwc_string_unref(id);
+	lwc_string_unref(qname.ns);
+	lwc_string_unref(qname.name);
+
+	return error;
+}
+
+/**
+ * Build the bloom filter for a node that has none
+ *
+ * A node's bloom filter holds the names of the node and all its ancestors.
+ * Walk up the tree adding each node's names, until reaching an ancestor
+ * whose bloom filter is still held in its node data, or the root.
+ *
+ * \param node     Node to build bloom filter for
+ * \param handler  Dispatch table of handler functions
+ * \param pw       Client-specific private data for handler functions
+ * \param bloom    Bloom filter to build, initially empty
+ * \return CSS_OK on success, appropriate error otherwise.
+ */
+static css_error css__build_node_bloom(void *node,
+		css_select_handler *handler, void *pw,
+		css_bloom bloom[CSS_BLOOM_SIZE])
+{
+	css_error error;
+
+	while (node != NULL) {
+		struct css_node_data *node_data;
+
+		error = handler->get_libcss_node_data(pw, node,
+				(void **) (void *) &node_data);
+		if (error != CSS_OK)
+			return error;
+
+		if (node_data != NULL && node_data->bloom != NULL) {
+			css_bloom_merge(node_data->bloom, bloom);
+			break;
+		}
+
+		error = css__bloom_add_node(node, handler, pw, bloom);
+		if (error != CSS_OK)
+			return error;
+
+		error = handler->parent_node(pw, node, &node);
+		if (error != CSS_OK)
+			return error;
+	}
+
+	return CSS_OK;
+}
+
 /**
  * Get a bloom filter for the parent node
  *
@@ -551,9 +938,6 @@ static css_error css__get_parent_bloom(void *parent,
 
 	/* Get parent node's bloom filter */
 	if (parent != NULL) {
-		/* Get parent bloom filter */
-		struct css_node_data *node_data;
-
 		/* Hideous casting to avoid warnings on all platforms
 		 * we build for. */
 		error = handler->get_libcss_node_data(pw, parent,
@@ -567,24 +951,22 @@ static css_error css__get_parent_bloom(void *parent,
 	}
 
 	if (bloom == NULL) {
-		uint32_t i;
 		/* Need to create parent bloom */
 
 		if (parent != NULL) {
-			/* TODO:
-			 * Build & set the parent node's bloom properly.
-			 * This will speed up the case where DOM change
-			 * has caused bloom to get deleted.  For now we
-			 * fall back to a fully saturated bloom filter,
-			 * which is slower but perfectly valid.
-			 */
-			bloom = malloc(sizeof(css_bloom) * CSS_BLOOM_SIZE);
+			/* The parent's node data has been dropped, e.g.
+			 * after a DOM change.  Rebuild its bloom from the
+			 * parent and its ancestors. */
+			bloom = calloc(CSS_BLOOM_SIZE, sizeof(css_bloom));
 			if (bloom == NULL) {
 				return CSS_NOMEM;
 			}
 
-			for (i = 0; i < CSS_BLOOM_SIZE; i++) {
-				bloom[i] = ~0;
+			error = css__build_node_bloom(parent, handler, pw,
+					bloom);
+			if (error != CSS_OK) {
+				free(bloom);
+				return error;
 			}
 
 			if (node_data == NULL) {
@@ -602,6 +984,8 @@ static css_error css__get_parent_bloom(void *parent,
 					css__destroy_node_data(node_data);
 					return error;
 				}
+			} else {
+				node_data->bloom = bloom;
 			}
 		} else {
 			/* No ancestors; empty bloom filter */
@@ -730,38 +1114,139 @@ static css_error css__set_node_data(void *node, css_select_state *state,
 enum share_candidate_type {
 	CANDIDATE_SIBLING,
 	CANDIDATE_COUSIN,
+	CANDIDATE_SECOND_COUSIN,
 };
 
 
 /**
- * Get node_data for candidate node if we can reuse its style.
+ * Check that every class selectors use from one list is in another list.
  *
- * \param[in]  state                 The selection state for current node.
- * \param[in]  share_candidate_node  The node to test id and classes of.
- * \param[in]  type                  The candidate's relation to selection node.
- * \param[out] sharable_node_data    Returns node_data or NULL.
- * \return CSS_OK on success, appropriate error otherwise.
+ * \param[in]  ctx        The selection context.
+ * \param[in]  classes    The classes to look for.
+ * \param[in]  n_classes  The number of classes to look for.
+ * \param[in]  other      The classes to look in.
+ * \param[in]  n_other    The number of classes to look in.
+ * \param[out] within     Returns whether every used class was found.
+ * \return CSS_OK on success or appropriate error otherwise.
  */
-static css_error css_select_style__get_sharable_node_data_for_candidate(
-		css_select_state *state,
-		void *share_candidate_node,
-		enum share_candidate_type type,
-		struct css_node_data **sharable_node_data)
+static css_error css_select_style__used_classes_within(css_select_ctx *ctx,
+		lwc_string **classes, uint32_t n_classes,
+		lwc_string **other, uint32_t n_other, bool *within)
 {
 	css_error error;
-	lwc_string *share_candidate_id;
-	uint32_t share_candidate_n_classes;
-	lwc_string **share_candidate_classes;
-	struct css_node_data *node_data;
+	uint32_t i, j;
 
-	UNUSED(type);
+	*within = false;
 
-	*sharable_node_data = NULL;
+	for (i = 0; i < n_classes; i++) {
+		bool used = false;
+		bool match = false;
 
-	/* We get the candidate node data first, as if it has none, we can't
-	 * share its data anyway.
-	 * Hideous casting to avoid warnings on all platforms we build for. */
-	error = state->handler->get_libcss_node_data(state->pw,
+		error = css_select__name_used(ctx, CSS_SELECT_CHANGE_CLASS,
+				classes[i], &used);
+		if (error != CSS_OK)
+			return error;
+		if (used == false)
+			continue;
+
+		for (j = 0; j < n_other; j++) {
+			if (lwc_string_caseless_isequal(classes[i], other[j],
+					&match) != lwc_error_ok)
+				return CSS_OK;
+			if (match)
+				break;
+		}
+
+		if (match == false)
+			return CSS_OK;
+	}
+
+	*within = true;
+
+	return CSS_OK;
+}
+
+
+/**
+ * Compare the classes of two nodes, as far as selectors use them.
+ *
+ * \param[in]  ctx        The selection context.
+ * \param[in]  classes    The classes of one node.
+ * \param[in]  n_classes  The number of classes of the node.
+ * \param[in]  other      The classes of the other node.
+ * \param[in]  n_other    The number of classes of the other node.
+ * \param[out] alike      Returns whether the classes are alike.
+ * \return CSS_OK on success or appropriate error otherwise.
+ *
+ * Classes no selector uses cannot affect matching, so are ignored, as is
+ * the order the classes are given in.
+ */
+static css_error css_select_style__classes_alike(css_select_ctx *ctx,
+		lwc_string **classes, uint32_t n_classes,
+		lwc_string **other, uint32_t n_other, bool *alike)
+{
+	css_error error;
+	uint32_t i;
+	bool match;
+
+	/* Authors tend to list classes in the same order, so try the
+	 * cheap ordered comparison first */
+	if (n_classes == n_other) {
+		for (i = 0; i < n_classes; i++) {
+			if (lwc_string_caseless_isequal(classes[i], other[i],
+					&match) != lwc_error_ok ||
+					match == false)
+				break;
+		}
+
+		if (i == n_classes) {
+			*alike = true;
+			return CSS_OK;
+		}
+	}
+
+	error = css_select_style__used_classes_within(ctx,
+			classes, n_classes, other, n_other, alike);
+	if (error != CSS_OK || *alike == false)
+		return error;
+
+	return css_select_style__used_classes_within(ctx,
+			other, n_other, classes, n_classes, alike);
+}
+
+
+/**
+ * Get node_data for candidate node if we can reuse its style.
+ *
+ * \param[in]  ctx                   The selection context.
+ * \param[in]  state                 The selection state for current node.
+ * \param[in]  share_candidate_node  The node to test id and classes of.
+ * \param[out] sharable_node_data    Returns node_data or NULL.
+ * \return CSS_OK on success, appropriate error otherwise.
+ *
+ * Cousins are only returned as candidates once their ancestors have been
+ * found to be indistinguishable from the node's, so the same tests apply
+ * whatever the candidate's relation to the node.
+ */
+static css_error css_select_style__get_sharable_node_data_for_candidate(
+		css_select_ctx *ctx,
+		css_select_state *state,
+		void *share_candidate_node,
+		struct css_node_data **sharable_node_data)
+{
+	css_error error;
+	lwc_string *share_candidate_id;
+	uint32_t share_candidate_n_classes;
+	lwc_string **share_candidate_classes;
+	struct css_node_data *node_data;
+	bool used, alike;
+
+	*sharable_node_data = NULL;
+
+	/* We get the candidate node data first, as if it has none, we can't
+	 * share its data anyway.
+	 * Hideous casting to avoid warnings on all platforms we build for. */
+	error = state->handler->get_libcss_node_data(state->pw,
 			share_candidate_node, (void **) (void *) &node_data);
 	if (error != CSS_OK || node_data == NULL) {
 #ifdef DEBUG_STYLE_SHARING
@@ -828,12 +1313,17 @@ static css_error css_select_style__get_sharable_node_data_for_candidate(
 		return error;
 
 	} else if (share_candidate_id != NULL) {
+		/* An id which no selector uses can't affect matching */
+		error = css_select__name_used(ctx, CSS_SELECT_CHANGE_ID,
+				share_candidate_id, &used);
 		lwc_string_unref(share_candidate_id);
+		if (error != CSS_OK || used) {
 #ifdef DEBUG_STYLE_SHARING
-		printf("      \t%s\tno share: candidate id\n",
-				lwc_string_data(state->element.name));
+			printf("      \t%s\tno share: candidate id\n",
+					lwc_string_data(state->element.name));
 #endif
-		return CSS_OK;
+			return error;
+		}
 	}
 
 	/* Check candidate classes don't prevent sharing */
@@ -845,32 +1335,18 @@ static css_error css_select_style__get_sharable_node_data_for_candidate(
 		return error;
 	}
 
-	if (state->n_classes != share_candidate_n_classes) {
+	error = css_select_style__classes_alike(ctx,
+			state->classes, state->n_classes,
+			share_candidate_classes, share_candidate_n_classes,
+			&alike);
+	if (error != CSS_OK || alike == false) {
 #ifdef DEBUG_STYLE_SHARING
-		printf("      \t%s\tno share: class count mismatch\n",
+		printf("      \t%s\tno share: class mismatch\n",
 				lwc_string_data(state->element.name));
 #endif
 		goto cleanup;
 	}
 
-	/* TODO: no need to care about the order, but it's simpler to
-	 *       have an ordered match, and authors are more likely to be
-	 *       consistent than  not. */
-	for (uint32_t i = 0; i < share_candidate_n_classes; i++) {
-		bool match;
-		if (lwc_string_caseless_isequal(
-				state->classes[i],
-				share_candidate_classes[i],
-				&match) == lwc_error_ok &&
-				match == false) {
-#ifdef DEBUG_STYLE_SHARING
-			printf("      \t%s\tno share: class mismatch\n",
-					lwc_string_data(state->element.name));
-#endif
-			goto cleanup;
-		}
-	}
-
 	if (node_data->flags & CSS_NODE_FLAGS_HAS_HINTS) {
 		/* TODO: check hints match.  For now, just prevent sharing */
 #ifdef DEBUG_STYLE_SHARING
@@ -889,33 +1365,210 @@ cleanup:
 		}
 	}
 
-	return CSS_OK;
+	return error;
+}
+
+
+/**
+ * Find whether two ancestors are indistinguishable by selectors.
+ *
+ * \param[in]  ctx       The selection context.
+ * \param[in]  state     The selection state for current node.
+ * \param[in]  ancestor  An ancestor of the node.
+ * \param[in]  other     A node with the same element name as ancestor.
+ * \param[in]  name      The element name of both nodes.
+ * \param[out] alike     Returns whether the nodes are alike.
+ * \return CSS_OK on success or appropriate error otherwise.
+ *
+ * Nodes are alike if they have no id and the same classes, as far as
+ * selectors use them, and no selector may test their attributes, pseudo
+ * classes or siblings.  The node's
+ * own taint flags only record such tests of the node itself, not of its
+ * ancestors, so this must be checked for each ancestor which differs
+ * between the node and a cousin.
+ */
+static css_error css_select_style__ancestors_alike(
+		css_select_ctx *ctx, css_select_state *state,
+		void *ancestor, void *other, lwc_string *name, bool *alike)
+{
+	lwc_string **classes[2] = { NULL, NULL };
+	uint32_t n_classes[2] = { 0, 0 };
+	void *nodes[2] = { ancestor, other };
+	css_selector_hash *names;
+	bool distinct = false;
+	css_error error;
+	uint32_t i, j;
+
+	*alike = false;
+
+	error = css_select__names(ctx, &names);
+	if (error != CSS_OK)
+		return error;
+
+	error = css__selector_hash_ancestors_distinct(names, name, &distinct);
+	if (error != CSS_OK || distinct)
+		return error;
+
+	for (i = 0; i < 2; i++) {
+		lwc_string *id;
+		bool used;
+
+		error = state->handler->node_id(state->pw, nodes[i], &id);
+		if (error != CSS_OK)
+			goto cleanup;
+
+		if (id != NULL) {
+			error = css_select__name_used(ctx,
+					CSS_SELECT_CHANGE_ID, id, &used);
+			lwc_string_unref(id);
+			if (error != CSS_OK || used)
+				goto cleanup;
+		}
+
+		error = state->handler->node_classes(state->pw, nodes[i],
+				&classes[i], &n_classes[i]);
+		if (error != CSS_OK)
+			goto cleanup;
+	}
+
+	error = css_select_style__classes_alike(ctx,
+			classes[0], n_classes[0], classes[1], n_classes[1],
+			alike);
+
+cleanup:
+	for (i = 0; i < 2; i++) {
+		if (classes[i] != NULL) {
+			for (j = 0; j < n_classes[i]; j++)
+				lwc_string_unref(classes[i][j]);
+		}
+	}
+
+	return error;
+}
+
+
+/**
+ * Get the last child of a node with a given element name.
+ *
+ * \param[in]  state      The selection state for current node.
+ * \param[in]  node       The node to get the child of.
+ * \param[in]  qname      The element name to look for.
+ * \param[out] child_out  Returns the child or NULL.
+ * \return CSS_OK on success or appropriate error otherwise.
+ */
+static css_error css_select_style__get_named_last_child(
+		css_select_state *state, void *node,
+		const css_qname *qname, void **child_out)
+{
+	css_select_subtree_handler *subtree = state->subtree;
+	void *child;
+	css_error error;
+
+	*child_out = NULL;
+
+	error = subtree->first_child_node(state->pw, node, &child);
+
+	while (error == CSS_OK && child != NULL) {
+		bool match;
+
+		error = state->handler->node_has_name(state->pw, child,
+				qname, &match);
+		if (error != CSS_OK)
+			break;
+
+		if (match)
+			*child_out = child;
+
+		error = subtree->next_sibling_node(state->pw, child, &child);
+	}
+
+	return error;
 }
 
 
 /**
- * Get previous named cousin node.
+ * Get the nearest previous named cousin or second cousin node.
  *
+ * \param[in]  ctx         The selection context.
  * \param[in]  state       The selection state for current node.
- * \param[in]  node        The node to get the cousin of.
+ * \param[in]  type        The relation of the node to get.
  * \param[out] cousin_out  Returns a cousin node or NULL.
  * \return CSS_OK on success or appropriate error otherwise.
+ *
+ * A cousin is the last child with the node's name of the parent's previous
+ * sibling with the parent's name.  A second cousin is found likewise,
+ * starting from the grandparent.  Each of the ancestors these pass through
+ * must be alike the node's ancestor at the same depth.
+ *
+ * Finding children needs the subtree traversal functions, so cousins are
+ * only found when selecting for a subtree.
  */
 static css_error css_select_style__get_named_cousin(
-		css_select_state *state, void *node,
-		void **cousin_out)
+		css_select_ctx *ctx, css_select_state *state,
+		enum share_candidate_type type, void **cousin_out)
 {
-	/* TODO:
-	 *
-	 * Consider cousin nodes; Go to parent's previous sibling's last child.
-	 * The parent and the parent's sibling must be "similar".
-	 */
-	UNUSED(state);
-	UNUSED(node);
+	void *ancestors[2];
+	css_qname names[2] = { { NULL, NULL }, { NULL, NULL } };
+	uint32_t depth = (type == CANDIDATE_SECOND_COUSIN) ? 2 : 1;
+	void *node = state->node;
+	void *other = NULL;
+	css_error error = CSS_OK;
+	uint32_t i;
 
 	*cousin_out = NULL;
 
-	return CSS_OK;
+	if (state->subtree == NULL)
+		return CSS_OK;
+
+	for (i = 0; i < depth; i++) {
+		error = state->handler->parent_node(state->pw, node,
+				&ancestors[i]);
+		if (error != CSS_OK || ancestors[i] == NULL)
+			goto cleanup;
+
+		error = state->handler->node_name(state->pw, ancestors[i],
+				&names[i]);
+		if (error != CSS_OK)
+			goto cleanup;
+
+		node = ancestors[i];
+	}
+
+	/* Get the furthest ancestor's previous sibling with its name */
+	error = state->handler->named_generic_sibling_node(state->pw,
+			ancestors[depth - 1], &names[depth - 1], &other);
+	if (error != CSS_OK)
+		goto cleanup;
+
+	/* Descend from it, through nodes alike the node's ancestors */
+	for (i = depth; i > 0 && other != NULL; i--) {
+		const css_qname *name = (i > 1) ?
+				&names[i - 2] : &state->element;
+		bool alike;
+
+		error = css_select_style__ancestors_alike(ctx, state,
+				ancestors[i - 1], other, names[i - 1].name,
+				&alike);
+		if (error != CSS_OK || alike == false)
+			goto cleanup;
+
+		error = css_select_style__get_named_last_child(state,
+				other, name, &other);
+		if (error != CSS_OK)
+			goto cleanup;
+	}
+
+	*cousin_out = other;
+
+cleanup:
+	for (i = 0; i < depth; i++) {
+		if (names[i].ns != NULL)
+			lwc_string_unref(names[i].ns);
+		if (names[i].name != NULL)
+			lwc_string_unref(names[i].name);
+	}
+
+	return error;
 }
 
 
@@ -925,13 +1578,17 @@ static css_error css_select_style__get_named_cousin(
  * This is an optimisation to needing to perform selection for a node,
  * by sharing the style for a previous node.
  *
+ * Previous siblings with the node's name are considered first, and then
+ * its cousins and second cousins.
+ *
+ * \param[in]  ctx                 The selection context.
  * \param[in]  node                Node we're selecting for.
  * \param[in]  state               The current selection state.
  * \param[out] sharable_node_data  Returns node_data or NULL.
  * \return CSS_OK on success or appropriate error otherwise.
  */
 static css_error css_select_style__get_sharable_node_data(
-		void *node, css_select_state *state,
+		css_select_ctx *ctx, void *node, css_select_state *state,
 		struct css_node_data **sharable_node_data)
 {
 	css_error error;
@@ -941,18 +1598,18 @@ static css_error css_select_style__get_sharable_node_data(
 
 	/* TODO: move this test to caller? */
 	if (state->id != NULL) {
-		/* If the node has an ID can't share another node's style. */
-		/* TODO: Consider whether this ID exists in the ID hash tables.
-		 *       (If not, the ID cannot affect the node's style.)
-		 *
-		 *       Call css__selector_hash_find_by_id, for each sheet,
-		 *       and if we get a non-NULL "matched" then return.
-		 *
-		 *       Check overhead is worth cost. */
+		/* If the node has an ID that a selector uses, it can't
+		 * share another node's style. */
+		bool used;
+
+		error = css_select__name_used(ctx, CSS_SELECT_CHANGE_ID,
+				state->id, &used);
+		if (error != CSS_OK || used) {
 #ifdef DEBUG_STYLE_SHARING
 printf("      \t%s\tno share: node id (%s)\n", lwc_string_data(state->element.name), lwc_string_data(state->id));
 #endif
-		return CSS_OK;
+			return error;
+		}
 	}
 	if (state->node_data->flags & CSS_NODE_FLAGS_HAS_INLINE_STYLE) {
 #ifdef DEBUG_STYLE_SHARING
@@ -969,35 +1626,53 @@ printf("      \t%s\tno share: inline style\n");
 				node, &state->element, &share_candidate_node);
 		if (error != CSS_OK) {
 			return error;
-		} else {
-			if (share_candidate_node == NULL) {
-				error = css_select_style__get_named_cousin(
-						state, node,
-						&share_candidate_node);
-				if (error != CSS_OK) {
-					return error;
-				} else {
-					if (share_candidate_node == NULL) {
-						break;
-					}
-				}
-				type = CANDIDATE_COUSIN;
+		}
+
+		/* Out of siblings; move on to more distant relations */
+		while (share_candidate_node == NULL &&
+				type != CANDIDATE_SECOND_COUSIN) {
+			type = (type == CANDIDATE_SIBLING) ?
+					CANDIDATE_COUSIN :
+					CANDIDATE_SECOND_COUSIN;
+
+			error = css_select_style__get_named_cousin(
+					ctx, state, type,
+					&share_candidate_node);
+			if (error != CSS_OK) {
+				return error;
 			}
 		}
 
+		if (share_candidate_node == NULL) {
+			break;
+		}
+
+		ctx->sharing_stats.candidates++;
+
 		/* Check whether we can share the candidate node's
 		 * style.  We already know the element names match,
 		 * check that candidate node's ID and class won't
 		 * prevent sharing. */
 		error = css_select_style__get_sharable_node_data_for_candidate(
-				state, share_candidate_node,
-				type, sharable_node_data);
+				ctx, state, share_candidate_node,
+				sharable_node_data);
 		if (error != CSS_OK) {
 			return error;
 		}
 
 		if (*sharable_node_data != NULL) {
 			/* Found style date we can share */
+			switch (type) {
+			case CANDIDATE_SIBLING:
+				ctx->sharing_stats.siblings++;
+				break;
+			case CANDIDATE_COUSIN:
+				ctx->sharing_stats.cousins++;
+				break;
+			case CANDIDATE_SECOND_COUSIN:
+				ctx->sharing_stats.second_cousins++;
+				break;
+			}
 			break;
 		}
 
@@ -1055,7 +1730,8 @@ static void css_select__finalise_selection_state(
  *
  * \param[in]  state         The selection state to initialise
  * \param[in]  node          The node we are selecting for.
- * \param[in]  parent        The node's parent node, or NULL.
+ * \param[in]  parent_bloom  The bloom filter of the node's parent.
+ * \param[in]  reject        Reject cache for the node's ancestors.
  * \param[in]  media         The media specification we're selecting for.
  * \param[in]  unit_ctx      Unit conversion context.
  * \param[in]  handler       The client selection callback table.
@@ -1065,7 +1741,8 @@ static void css_select__finalise_selection_state(
 static css_error css_select__initialise_selection_state(
 		css_select_state *state,
 		void *node,
-		void *parent,
+		css_bloom *parent_bloom,
+		reject_cache *reject,
 		const css_media *media,
 		const css_unit_ctx *unit_ctx,
 		css_select_handler *handler,
@@ -1081,8 +1758,7 @@ static css_error css_select__initialise_selection_state(
 	state->unit_ctx = unit_ctx;
 	state->handler = handler;
 	state->pw = pw;
-	state->next_reject = state->reject_cache +
-			(N_ELEMENTS(state->reject_cache) - 1);
+	state->reject = reject;
 
 	/* Allocate the result set */
 	state->results = calloc(1, sizeof(css_select_results));
@@ -1095,11 +1771,7 @@ static css_error css_select__initialise_selection_state(
 		goto failed;
 	}
 
-	error = css__get_parent_bloom(parent, handler, pw,
-			&state->node_data->bloom);
-	if (error != CSS_OK) {
-		goto failed;
-	}
+	state->node_data->bloom = parent_bloom;
 
 	/* Get node's name */
 	error = handler->node_name(pw, node, &state->element);
@@ -1231,31 +1903,29 @@ static css_error css__select_revert_property(
 }
 
 /**
- * Select a style for the given node
+ * Select a style for a node whose parent has been found
  *
  * \param ctx             Selection context to use
  * \param node            Node to select style for
+ * \param parent          The node's parent node, or NULL
+ * \param parent_bloom    The bloom filter of the node's parent
+ * \param reject          Reject cache for the node's ancestors
  * \param unit_ctx        Context for length unit conversions.
  * \param media           Currently active media specification
  * \param inline_style    Corresponding inline style for node, or NULL
  * \param handler         Dispatch table of handler functions
+ * \param subtree         Subtree traversal functions, or NULL
  * \param pw              Client-specific private data for handler functions
  * \param result          Pointer to location to receive result set
  * \return CSS_OK on success, appropriate error otherwise.
- *
- * In computing the style, no reference is made to the parent node's
- * style. Therefore, the resultant computed style is not ready for
- * immediate use, as some properties may be marked as inherited.
- * Use css_computed_style_compose() to obtain a fully computed style.
- *
- * This two-step approach to style computation is designed to allow
- * the client to store the partially computed style and efficiently
- * update the fully computed style for a node when layout changes.
  */
-css_error css_select_style(css_select_ctx *ctx, void *node,
+static css_error css_select__style_node(css_select_ctx *ctx,
+		void *node, void *parent, css_bloom *parent_bloom,
+		reject_cache *reject,
 		const css_unit_ctx *unit_ctx,
 		const css_media *media, const css_stylesheet *inline_style,
-		css_select_handler *handler, void *pw,
+		css_select_handler *handler,
+		css_select_subtree_handler *subtree, void *pw,
 		css_select_results **result)
 {
 	css_origin origin = CSS_ORIGIN_UA;
@@ -1263,21 +1933,14 @@ css_error css_select_style(css_select_ctx *ctx, void *node,
 	css_error error;
 	css_select_state state;
 	css_hint *hints = NULL;
-	void *parent = NULL;
 	struct css_node_data *share;
 
-	if (ctx == NULL || node == NULL || result == NULL || handler == NULL ||
-	    handler->handler_version != CSS_SELECT_HANDLER_VERSION_1)
-		return CSS_BADPARM;
-
-	error = handler->parent_node(pw, node, &parent);
+	error = css_select__initialise_selection_state(&state, node,
+			parent_bloom, reject, media, unit_ctx, handler, pw);
 	if (error != CSS_OK)
 		return error;
 
-	error = css_select__initialise_selection_state(
-			&state, node, parent, media, unit_ctx, handler, pw);
-	if (error != CSS_OK)
-		return error;
+	state.subtree = subtree;
 
 	/* Fetch presentational hints */
 	error = handler->node_presentational_hint(pw, node, &nhints, &hints);
@@ -1292,7 +1955,10 @@ css_error css_select_style(css_select_ctx *ctx, void *node,
 	}
 
 	/* Check if we can share another node's style */
-	error = css_select_style__get_sharable_node_data(node, &state, &share);
+	ctx->sharing_stats.nodes++;
+
+	error = css_select_style__get_sharable_node_data(ctx, node, &state,
+			&share);
 	if (error != CSS_OK) {
 		goto cleanup;
 	} else if (share != NULL) {
@@ -1344,6 +2010,16 @@ css_error css_select_style(css_select_ctx *ctx, void *node,
 		}
 	}
 
+	/* Select styles from the context's style index, if it has one and
+	 * origins need not be considered one at a time for revert. */
+	if (ctx->index != NULL && state.revert == NULL) {
+		error = match_selectors_in_index(ctx, ctx->index, &state);
+		if (error != CSS_OK)
+			goto cleanup;
+
+		goto consider_inline;
+	}
+
 	/* Iterate through the top-level stylesheets, selecting styles
 	 * from those which apply to our current media requirements and
 	 * are not disabled */
@@ -1379,6 +2055,7 @@ css_error css_select_style(css_select_ctx *ctx, void *node,
 		}
 	}
 
+consider_inline:
 	/* Consider any inline style for the node */
 	if (inline_style != NULL) {
 		css_rule_selector *sel =
@@ -1394,6 +2071,11 @@ css_error css_select_style(css_select_ctx *ctx, void *node,
 
 		/* No bytecode if input was empty or wholly invalid */
 		if (sel->style != NULL) {
+			/* Inline style is author style, whatever the origin of
+			 * the last rule matched before it */
+			state.sheet = inline_style;
+			state.current_origin = CSS_ORIGIN_AUTHOR;
+
 			/* Inline style applies to base element only */
 			state.current_pseudo = CSS_PSEUDO_ELEMENT_NONE;
 			state.computed = state.results->styles[
@@ -1501,7 +2183,8 @@ css_error css_select_style(css_select_ctx *ctx, void *node,
 		if (state.results->styles[j] == NULL)
 			continue;
 
-		error = css__arena_intern_style(&state.results->styles[j]);
+		error = css__arena_intern_style(ctx->arena,
+				&state.results->styles[j]);
 		if (error != CSS_OK) {
 			goto cleanup;
 		}
@@ -1527,16 +2210,278 @@ cleanup:
 }
 
 /**
- * Destroy a selection result set
+ * Select a style for the given node
  *
- * \param results  Result set to destroy
- * \return CSS_OK on success, appropriate error otherwise
+ * \param ctx             Selection context to use
+ * \param node            Node to select style for
+ * \param unit_ctx        Context for length unit conversions.
+ * \param media           Currently active media specification
+ * \param inline_style    Corresponding inline style for node, or NULL
+ * \param handler         Dispatch table of handler functions
+ * \param pw              Client-specific private data for handler functions
+ * \param result          Pointer to location to receive result set
+ * \return CSS_OK on success, appropriate error otherwise.
+ *
+ * In computing the style, no reference is made to the parent node's
+ * style. Therefore, the resultant computed style is not ready for
+ * immediate use, as some properties may be marked as inherited.
+ * Use css_computed_style_compose() to obtain a fully computed style.
+ *
+ * This two-step approach to style computation is designed to allow
+ * the client to store the partially computed style and efficiently
+ * update the fully computed style for a node when layout changes.
  */
-css_error css_select_results_destroy(css_select_results *results)
+css_error css_select_style(css_select_ctx *ctx, void *node,
+		const css_unit_ctx *unit_ctx,
+		const css_media *media, const css_stylesheet *inline_style,
+		css_select_handler *handler, void *pw,
+		css_select_results **result)
 {
-	uint32_t i;
+	css_error error;
 
-	if (results == NULL)
+	if (ctx == NULL || node == NULL || result == NULL || handler == NULL ||
+	    handler->handler_version != CSS_SELECT_HANDLER_VERSION_1)
+		return CSS_BADPARM;
+
+	error = css_select__prepare_index(ctx, unit_ctx, media);
+	if (error != CSS_OK)
+		return error;
+
+	return css_select__style(ctx, node, unit_ctx, media, inline_style,
+			handler, NULL, pw, result);
+}
+
+/**
+ * Select a style for a node, finding its parent
+ *
+ * \param ctx             Selection context to use
+ * \param node            Node to select style for
+ * \param unit_ctx        Context for length unit conversions.
+ * \param media           Currently active media specification
+ * \param inline_style    Corresponding inline style for node, or NULL
+ * \param handler         Dispatch table of handler functions
+ * \param subtree         Subtree traversal functions, or NULL
+ * \param pw              Client-specific private data for handler functions
+ * \param result          Pointer to location to receive result set
+ * \return CSS_OK on success, appropriate error otherwise.
+ *
+ * The context must have been prepared with css_select__prepare_index().
+ */
+static css_error css_select__style(css_select_ctx *ctx, void *node,
+		const css_unit_ctx *unit_ctx,
+		const css_media *media, const css_stylesheet *inline_style,
+		css_select_handler *handler,
+		css_select_subtree_handler *subtree, void *pw,
+		css_select_results **result)
+{
+	css_error error;
+	void *parent = NULL;
+	css_bloom *parent_bloom;
+	reject_cache reject;
+
+	error = handler->parent_node(pw, node, &parent);
+	if (error != CSS_OK)
+		return error;
+
+	error = css__get_parent_bloom(parent, handler, pw, &parent_bloom);
+	if (error != CSS_OK)
+		return error;
+
+	reject.next = reject.items + (N_ELEMENTS(reject.items) - 1);
+
+	return css_select__style_node(ctx, node, parent, parent_bloom,
+			&reject, unit_ctx, media, inline_style,
+			handler, subtree, pw, result);
+}
+
+/**
+ * Select styles for a run of sibling nodes
+ *
+ * \param ctx             Selection context to use
+ * \param parent          Parent node of the siblings, or NULL
+ * \param nodes           Array of n_nodes sibling nodes, in document order
+ * \param inline_styles   Array of n_nodes inline styles, or NULL for none
+ * \param n_nodes         Number of nodes to select styles for
+ * \param unit_ctx        Context for length unit conversions.
+ * \param media           Currently active media specification
+ * \param handler         Dispatch table of handler functions
+ * \param pw              Client-specific private data for handler functions
+ * \param results         Array of n_nodes locations to receive result sets
+ * \return CSS_OK on success, appropriate error otherwise.
+ *
+ * This is equivalent to calling css_select_style() for each node in turn,
+ * except that the parent node, its bloom filter and the selection reject
+ * cache are found once and shared by all the nodes.  Every node must be a
+ * child of parent, and an entry in inline_styles may be NULL if its node
+ * has no inline style.
+ *
+ * On failure, any result sets already produced are destroyed and all
+ * entries in results are set to NULL.
+ */
+css_error css_select_style_siblings(css_select_ctx *ctx, void *parent,
+		void **nodes, const css_stylesheet **inline_styles,
+		uint32_t n_nodes,
+		const css_unit_ctx *unit_ctx,
+		const css_media *media,
+		css_select_handler *handler, void *pw,
+		css_select_results **results)
+{
+	css_error error;
+	css_bloom *parent_bloom;
+	reject_cache reject;
+	uint32_t i;
+
+	if (ctx == NULL || nodes == NULL || results == NULL ||
+	    handler == NULL ||
+	    handler->handler_version != CSS_SELECT_HANDLER_VERSION_1)
+		return CSS_BADPARM;
+
+	for (i = 0; i < n_nodes; i++) {
+		results[i] = NULL;
+	}
+
+	error = css__get_parent_bloom(parent, handler, pw, &parent_bloom);
+	if (error != CSS_OK)
+		return error;
+
+	error = css_select__prepare_index(ctx, unit_ctx, media);
+	if (error != CSS_OK)
+		return error;
+
+	reject.next = reject.items + (N_ELEMENTS(reject.items) - 1);
+
+	for (i = 0; i < n_nodes; i++) {
+		error = css_select__style_node(ctx, nodes[i], parent,
+				parent_bloom, &reject, unit_ctx, media,
+				inline_styles != NULL ? inline_styles[i] : NULL,
+				handler, NULL, pw, &results[i]);
+		if (error != CSS_OK) {
+			while (i > 0) {
+				i--;
+				css_select_results_destroy(results[i]);
+				results[i] = NULL;
+			}
+			return error;
+		}
+	}
+
+	return CSS_OK;
+}
+
+/**
+ * Select styles for every element in a subtree
+ *
+ * \param ctx             Selection context to use
+ * \param root            Root node of subtree to select styles for
+ * \param unit_ctx        Context for length unit conversions.
+ * \param media           Currently active media specification
+ * \param handler         Dispatch table of handler functions
+ * \param subtree         Dispatch table of subtree traversal functions
+ * \param pw              Client-specific private data for handler functions
+ * \return CSS_OK on success, appropriate error otherwise.
+ *
+ * The subtree is walked in document order, so each node's parent and
+ * preceding siblings have been selected for before the node itself.  This
+ * ensures the parent bloom filters and the node data used for style sharing
+ * are available as each node is selected.  The subtree traversal functions
+ * are also used to find each node's cousins, so that nodes may share their
+ * styles as well as those of their siblings.
+ *
+ * The selection results for each node are passed to the client through the
+ * subtree handler's node_selected callback.  As with css_select_style(),
+ * the results are partial computed styles.  Since parents are always
+ * reported before their children, the client may compose each node's style
+ * from within the callback.
+ *
+ * Selection is performed on the calling thread; the selection handler
+ * callbacks are not required to be reentrant.
+ */
+css_error css_select_style_subtree(css_select_ctx *ctx, void *root,
+		const css_unit_ctx *unit_ctx,
+		const css_media *media,
+		css_select_handler *handler,
+		css_select_subtree_handler *subtree, void *pw)
+{
+	uint32_t depth = 0;
+	void *node = root;
+	css_error error;
+
+	if (ctx == NULL || root == NULL || handler == NULL ||
+	    handler->handler_version != CSS_SELECT_HANDLER_VERSION_1 ||
+	    subtree == NULL || subtree->handler_version !=
+			CSS_SELECT_SUBTREE_HANDLER_VERSION_1)
+		return CSS_BADPARM;
+
+	error = css_select__prepare_index(ctx, unit_ctx, media);
+	if (error != CSS_OK)
+		return error;
+
+	while (true) {
+		const css_stylesheet *inline_style;
+		css_select_results *results;
+		void *next;
+
+		/* Select for the current node */
+		error = subtree->node_inline_style(pw, node, &inline_style);
+		if (error != CSS_OK)
+			return error;
+
+		error = css_select__style(ctx, node, unit_ctx, media,
+				inline_style, handler, subtree, pw, &results);
+		if (error != CSS_OK)
+			return error;
+
+		error = subtree->node_selected(pw, node, results);
+		if (error != CSS_OK)
+			return error;
+
+		/* Descend into the node's children, if any */
+		error = subtree->first_child_node(pw, node, &next);
+		if (error != CSS_OK)
+			return error;
+
+		if (next != NULL) {
+			node = next;
+			depth++;
+			continue;
+		}
+
+		/* Otherwise move on to the next sibling of the node or of
+		 * its nearest ancestor that has one, without leaving the
+		 * subtree. */
+		while (true) {
+			if (depth == 0)
+				return CSS_OK;
+
+			error = subtree->next_sibling_node(pw, node, &next);
+			if (error != CSS_OK)
+				return error;
+
+			if (next != NULL) {
+				node = next;
+				break;
+			}
+
+			error = handler->parent_node(pw, node, &node);
+			if (error != CSS_OK)
+				return error;
+
+			depth--;
+		}
+	}
+}
+
+/**
+ * Destroy a selection result set
+ *
+ * \param results  Result set to destroy
+ * \return CSS_OK on success, appropriate error otherwise
+ */
+css_error css_select_results_destroy(css_select_results *results)
+{
+	uint32_t i;
+
+	if (results == NULL)
 		return CSS_BADPARM;
 
 	for (i = 0; i < CSS_PSEUDO_ELEMENT_COUNT; i++) {
@@ -1735,71 +2680,144 @@ css_error set_initial(css_select_state *state,
 	return CSS_OK;
 }
 
-#define IMPORT_STACK_SIZE 256
+/**
+ * State for selecting from a stylesheet and its imports
+ */
+typedef struct select_sheet_ctx {
+	css_select_ctx *ctx;		/**< Selection context */
+	css_origin origin;		/**< Origin of top-level sheet */
+	css_select_state *state;	/**< Selection state */
+} select_sheet_ctx;
+
+/**
+ * Follow an import if it applies to the media being selected for
+ *
+ * \param pw      The select_sheet_ctx
+ * \param import  The import rule
+ * \param follow  Updated to true if the import applies
+ * \return CSS_OK.
+ */
+static css_error select_sheet_import(void *pw, const css_rule_import *import,
+		bool *follow)
+{
+	select_sheet_ctx *c = pw;
+
+	*follow = mq__list_match(import->media, c->state->unit_ctx,
+			c->state->media, &c->ctx->str);
+
+	return CSS_OK;
+}
+
+/**
+ * Select from the selectors of a sheet reached from a top-level sheet
+ *
+ * \param pw     The select_sheet_ctx
+ * \param sheet  The sheet to select from
+ * \return CSS_OK on success, appropriate error otherwise.
+ */
+static css_error select_sheet_selectors(void *pw, const css_stylesheet *sheet)
+{
+	select_sheet_ctx *c = pw;
+
+	c->state->sheet = sheet;
+	c->state->current_origin = c->origin;
+
+	return match_selectors_in_sheet(c->ctx, sheet, c->state);
+}
+
+static const css_select_walk_handler select_sheet_handler = {
+	select_sheet_import,
+	NULL,
+	select_sheet_selectors
+};
 
+/**
+ * Select from a stylesheet and the applicable sheets it imports
+ *
+ * \param ctx     Selection context
+ * \param sheet   The top-level sheet
+ * \param origin  Origin of the sheet
+ * \param state   Selection state
+ * \return CSS_OK on success, appropriate error otherwise.
+ */
 css_error select_from_sheet(css_select_ctx *ctx, const css_stylesheet *sheet,
 		css_origin origin, css_select_state *state)
 {
-	const css_stylesheet *s = sheet;
-	const css_rule *rule = s->rule_list;
-	uint32_t sp = 0;
-	const css_rule *import_stack[IMPORT_STACK_SIZE];
+	select_sheet_ctx c = { ctx, origin, state };
 
-	do {
-		/* Find first non-charset rule, if we're at the list head */
-		if (rule == s->rule_list) {
-			while (rule != NULL && rule->type == CSS_RULE_CHARSET)
-				rule = rule->next;
-		}
-
-		if (rule != NULL && rule->type == CSS_RULE_IMPORT) {
-			/* Current rule is an import */
-			const css_rule_import *import =
-					(const css_rule_import *) rule;
-
-			if (import->sheet != NULL &&
-					mq__list_match(import->media,
-							state->unit_ctx,
-							state->media,
-							&ctx->str)) {
-				/* It's applicable, so process it */
-				if (sp >= IMPORT_STACK_SIZE)
-					return CSS_NOMEM;
-
-				import_stack[sp++] = rule;
-
-				s = import->sheet;
-				rule = s->rule_list;
-			} else {
-				/* Not applicable; skip over it */
-				rule = rule->next;
-			}
-		} else {
-			/* Gone past import rules in this sheet */
-			css_error error;
+	return css__select_walk_sheet(sheet, &select_sheet_handler, &c);
+}
 
-			/* Process this sheet */
-			state->sheet = s;
-			state->current_origin = origin;
+/**
+ * State for finding the nodes to restyle from a stylesheet's selectors
+ */
+typedef struct restyle_sheet_ctx {
+	css_select_change change;	/**< Kind of change made to the node */
+	lwc_string *name;		/**< Name that changed */
+	uint32_t *restyle;		/**< css_select_restyle flags found */
+} restyle_sheet_ctx;
 
-			error = match_selectors_in_sheet(ctx, s, state);
-			if (error != CSS_OK)
-				return error;
+/**
+ * Follow every import with a sheet, whatever its media
+ *
+ * \param pw      The restyle_sheet_ctx
+ * \param import  The import rule
+ * \param follow  Updated to true
+ * \return CSS_OK.
+ */
+static css_error restyle_sheet_import(void *pw, const css_rule_import *import,
+		bool *follow)
+{
+	UNUSED(pw);
+	UNUSED(import);
 
-			/* Find next sheet to process */
-			if (sp > 0) {
-				sp--;
-				rule = import_stack[sp]->next;
-				s = import_stack[sp]->parent;
-			} else {
-				s = NULL;
-			}
-		}
-	} while (s != NULL);
+	*follow = true;
 
 	return CSS_OK;
 }
 
+/**
+ * Add the restyle flags required by a sheet reached from a top-level sheet
+ *
+ * \param pw     The restyle_sheet_ctx
+ * \param sheet  The sheet to consider
+ * \return CSS_OK on success, appropriate error otherwise.
+ */
+static css_error restyle_sheet_selectors(void *pw,
+		const css_stylesheet *sheet)
+{
+	restyle_sheet_ctx *c = pw;
+
+	return css__selector_hash_get_restyle(sheet->selectors, c->change,
+			c->name, c->restyle);
+}
+
+static const css_select_walk_handler restyle_sheet_handler = {
+	restyle_sheet_import,
+	NULL,
+	restyle_sheet_selectors
+};
+
+/**
+ * Find the nodes to restyle after a change, from a stylesheet and its
+ * imports
+ *
+ * \param sheet    The top-level sheet
+ * \param change   Kind of change made to the node
+ * \param name     Class, id, attribute or pseudo class name that changed
+ * \param restyle  Updated with the union of its value and the
+ *                 css_select_restyle flags for the change
+ * \return CSS_OK on success, appropriate error otherwise.
+ */
+static css_error restyle_from_sheet(const css_stylesheet *sheet,
+		css_select_change change, lwc_string *name,
+		uint32_t *restyle)
+{
+	restyle_sheet_ctx c = { change, name, restyle };
+
+	return css__select_walk_sheet(sheet, &restyle_sheet_handler, &c);
+}
+
 static css_error _select_font_face_from_rule(
 		const css_rule_font_face *rule, css_origin origin,
 		css_select_font_faces_state *state,
@@ -1847,75 +2865,88 @@ static css_error _select_font_face_from_rule(
 	return CSS_OK;
 }
 
-static css_error select_font_faces_from_sheet(
-		const css_stylesheet *sheet,
-		css_origin origin,
-		css_select_font_faces_state *state,
-		const css_select_strings *str)
+/**
+ * State for selecting font faces from a stylesheet and its imports
+ */
+typedef struct font_faces_sheet_ctx {
+	css_origin origin;		/**< Origin of top-level sheet */
+	css_select_font_faces_state *state; /**< Font face selection state */
+	const css_select_strings *str;	/**< Selection strings */
+} font_faces_sheet_ctx;
+
+/**
+ * Follow an import if it applies to the media being selected for
+ *
+ * \param pw      The font_faces_sheet_ctx
+ * \param import  The import rule
+ * \param follow  Updated to true if the import applies
+ * \return CSS_OK.
+ */
+static css_error font_faces_sheet_import(void *pw,
+		const css_rule_import *import, bool *follow)
 {
-	const css_stylesheet *s = sheet;
-	const css_rule *rule = s->rule_list;
-	uint32_t sp = 0;
-	const css_rule *import_stack[IMPORT_STACK_SIZE];
+	font_faces_sheet_ctx *c = pw;
 
-	do {
-		/* Find first non-charset rule, if we're at the list head */
-		if (rule == s->rule_list) {
-			while (rule != NULL && rule->type == CSS_RULE_CHARSET)
-				rule = rule->next;
-		}
-
-		if (rule != NULL && rule->type == CSS_RULE_IMPORT) {
-			/* Current rule is an import */
-			const css_rule_import *import =
-					(const css_rule_import *) rule;
-
-			if (import->sheet != NULL &&
-					mq__list_match(import->media,
-							state->unit_ctx,
-							state->media,
-							str)) {
-				/* It's applicable, so process it */
-				if (sp >= IMPORT_STACK_SIZE)
-					return CSS_NOMEM;
-
-				import_stack[sp++] = rule;
-
-				s = import->sheet;
-				rule = s->rule_list;
-			} else {
-				/* Not applicable; skip over it */
-				rule = rule->next;
-			}
-		} else if (rule != NULL && rule->type == CSS_RULE_FONT_FACE) {
-			css_error error;
+	*follow = mq__list_match(import->media, c->state->unit_ctx,
+			c->state->media, c->str);
 
-			error = _select_font_face_from_rule(
-					(const css_rule_font_face *) rule,
-					origin, state, str);
+	return CSS_OK;
+}
 
-			if (error != CSS_OK)
-				return error;
+/**
+ * Select the font faces of a sheet reached from a top-level sheet
+ *
+ * \param pw     The font_faces_sheet_ctx
+ * \param sheet  The sheet to select from
+ * \return CSS_OK on success, appropriate error otherwise.
+ */
+static css_error font_faces_sheet_rules(void *pw,
+		const css_stylesheet *sheet)
+{
+	font_faces_sheet_ctx *c = pw;
+	const css_rule *rule;
 
-			rule = rule->next;
-		} else if (rule == NULL) {
-			/* Find next sheet to process */
-			if (sp > 0) {
-				sp--;
-				rule = import_stack[sp]->next;
-				s = import_stack[sp]->parent;
-			} else {
-				s = NULL;
-			}
-		} else {
-			rule = rule->next;
-		}
-	} while (s != NULL);
+	for (rule = sheet->rule_list; rule != NULL; rule = rule->next) {
+		css_error error;
+
+		if (rule->type != CSS_RULE_FONT_FACE)
+			continue;
+
+		error = _select_font_face_from_rule(
+				(const css_rule_font_face *) rule,
+				c->origin, c->state, c->str);
+		if (error != CSS_OK)
+			return error;
+	}
 
 	return CSS_OK;
 }
 
-#undef IMPORT_STACK_SIZE
+static const css_select_walk_handler font_faces_sheet_handler = {
+	font_faces_sheet_import,
+	NULL,
+	font_faces_sheet_rules
+};
+
+/**
+ * Select font faces from a stylesheet and the applicable sheets it imports
+ *
+ * \param sheet   The top-level sheet
+ * \param origin  Origin of the sheet
+ * \param state   Font face selection state
+ * \param str     Selection strings
+ * \return CSS_OK on success, appropriate error otherwise.
+ */
+static css_error select_font_faces_from_sheet(
+		const css_stylesheet *sheet,
+		css_origin origin,
+		css_select_font_faces_state *state,
+		const css_select_strings *str)
+{
+	font_faces_sheet_ctx c = { origin, state, str };
+
+	return css__select_walk_sheet(sheet, &font_faces_sheet_handler, &c);
+}
 
 static inline bool _selectors_pending(const css_selector **node,
 		const css_selector **id, const css_selector ***classes,
@@ -1936,52 +2967,60 @@ static inline bool _selectors_pending(const css_selector **node,
 	return pending;
 }
 
-static inline bool _selector_less_specific(const css_selector *ref,
-		const css_selector *cand)
+static inline bool _selector_less_specific(const css_selector **ref,
+		const css_selector **cand)
 {
 	bool result = true;
+	uint32_t ref_source, cand_source;
 
-	if (cand == NULL)
+	if (*cand == NULL)
 		return false;
 
 	if (ref == NULL)
 		return true;
 
 	/* Sort by specificity */
-	if (cand->specificity < ref->specificity) {
+	if ((*cand)->specificity < (*ref)->specificity) {
+		return true;
+	} else if ((*ref)->specificity < (*cand)->specificity) {
+		return false;
+	}
+
+	/* Then by source, for selectors from a style index */
+	ref_source = css__selector_hash_source(ref);
+	cand_source = css__selector_hash_source(cand);
+	if (cand_source != ref_source) {
+		return cand_source < ref_source;
+	}
+
+	/* Then by rule index -- earliest wins */
+	if ((*cand)->rule->index < (*ref)->rule->index)
 		result = true;
-	} else if (ref->specificity < cand->specificity) {
+	else
 		result = false;
-	} else {
-		/* Then by rule index -- earliest wins */
-		if (cand->rule->index < ref->rule->index)
-			result = true;
-		else
-			result = false;
-	}
 
 	return result;
 }
 
-static const css_selector *_selector_next(const css_selector **node,
+static const css_selector **_selector_next(const css_selector **node,
 		const css_selector **id, const css_selector ***classes,
 		uint32_t n_classes, const css_selector **univ,
 		css_select_rule_source *src)
 {
-	const css_selector *ret = NULL;
+	const css_selector **ret = NULL;
 
-	if (_selector_less_specific(ret, *node)) {
-		ret = *node;
+	if (_selector_less_specific(ret, node)) {
+		ret = node;
 		src->source = CSS_SELECT_RULE_SRC_ELEMENT;
 	}
 
-	if (_selector_less_specific(ret, *id)) {
-		ret = *id;
+	if (_selector_less_specific(ret, id)) {
+		ret = id;
 		src->source = CSS_SELECT_RULE_SRC_ID;
 	}
 
-	if (_selector_less_specific(ret, *univ)) {
-		ret = *univ;
+	if (_selector_less_specific(ret, univ)) {
+		ret = univ;
 		src->source = CSS_SELECT_RULE_SRC_UNIVERSAL;
 	}
 
@@ -1989,8 +3028,8 @@ static const css_selector *_selector_next(const css_selector **node,
 		uint32_t i;
 
 		for (i = 0; i < n_classes; i++) {
-			if (_selector_less_specific(ret, *(classes[i]))) {
-				ret = *(classes[i]);
+			if (_selector_less_specific(ret, classes[i])) {
+				ret = classes[i];
 				src->source = CSS_SELECT_RULE_SRC_CLASS;
 				src->class = i;
 			}
@@ -2000,8 +3039,18 @@ static const css_selector *_selector_next(const css_selector **node,
 	return ret;
 }
 
-css_error match_selectors_in_sheet(css_select_ctx *ctx,
-		const css_stylesheet *sheet, css_select_state *state)
+/**
+ * Match the selectors in a selector hash against the node being selected for
+ *
+ * \param ctx        Selection context
+ * \param selectors  The selector hash to search
+ * \param index      Style index the hash belongs to, or NULL for a sheet's
+ * \param state      Selection state
+ * \return CSS_OK on success, appropriate error otherwise.
+ */
+static css_error match_selectors_in_hash(css_select_ctx *ctx,
+		css_selector_hash *selectors, const css_select_index *index,
+		css_select_state *state)
 {
 	static const css_selector *empty_selector = NULL;
 	const uint32_t n_classes = state->n_classes;
@@ -2023,10 +3072,12 @@ css_error match_selectors_in_sheet(css_select_ctx *ctx,
 	req.unit_ctx = state->unit_ctx;
 	req.node_bloom = state->node_data->bloom;
 	req.str = &ctx->str;
+	req.sources = (index != NULL) ? index->source_active : NULL;
+	req.bloom_stats = &ctx->bloom_stats;
 
 	/* Find hash chain that applies to current node */
 	req.qname = state->element;
-	error = css__selector_hash_find(sheet->selectors,
+	error = css__selector_hash_find(selectors,
 			&req, &node_iterator,
 			&node_selectors);
 	if (error != CSS_OK)
@@ -2043,7 +3094,7 @@ css_error match_selectors_in_sheet(css_select_ctx *ctx,
 		for (i = 0; i < n_classes; i++) {
 			req.class = state->classes[i];
 			error = css__selector_hash_find_by_class(
-					sheet->selectors, &req,
+					selectors, &req,
 					&class_iterator, &class_selectors[i]);
 			if (error != CSS_OK)
 				goto cleanup;
@@ -2053,14 +3104,14 @@ css_error match_selectors_in_sheet(css_select_ctx *ctx,
 	if (state->id != NULL) {
 		/* Find hash chain for node ID */
 		req.id = state->id;
-		error = css__selector_hash_find_by_id(sheet->selectors,
+		error = css__selector_hash_find_by_id(selectors,
 				&req, &id_iterator, &id_selectors);
 		if (error != CSS_OK)
 			goto cleanup;
 	}
 
 	/* Find hash chain for universal selector */
-	error = css__selector_hash_find_universal(sheet->selectors, &req,
+	error = css__selector_hash_find_universal(selectors, &req,
 			&univ_iterator, &univ_selectors);
 	if (error != CSS_OK)
 		goto cleanup;
@@ -2068,6 +3119,7 @@ css_error match_selectors_in_sheet(css_select_ctx *ctx,
 	/* Process matching selectors, if any */
 	while (_selectors_pending(node_selectors, id_selectors,
 			class_selectors, n_classes, univ_selectors)) {
+		const css_selector **entry;
 		const css_selector *selector;
 
 		/* Selectors must be matched in ascending order of specificity
@@ -2075,13 +3127,24 @@ css_error match_selectors_in_sheet(css_select_ctx *ctx,
 		 *
 		 * Pick the least specific/earliest occurring selector.
 		 */
-		selector = _selector_next(node_selectors, id_selectors,
+		entry = _selector_next(node_selectors, id_selectors,
 				class_selectors, n_classes, univ_selectors,
 				&src);
 
 		/* We know there are selectors pending, so should have a
 		 * selector here */
-		assert(selector != NULL);
+		assert(entry != NULL && *entry != NULL);
+		selector = *entry;
+
+		/* Selectors from a style index carry their sheet's origin */
+		if (index != NULL) {
+			const css_select_index_source *source =
+					&index->sources[
+					css__selector_hash_source(entry)];
+
+			state->sheet = source->sheet;
+			state->current_origin = source->origin;
+		}
 
 		/* Match and handle the selector chain */
 		error = match_selector_chain(ctx, selector, state);
@@ -2125,6 +3188,18 @@ cleanup:
 	return error;
 }
 
+css_error match_selectors_in_sheet(css_select_ctx *ctx,
+		const css_stylesheet *sheet, css_select_state *state)
+{
+	return match_selectors_in_hash(ctx, sheet->selectors, NULL, state);
+}
+
+css_error match_selectors_in_index(css_select_ctx *ctx,
+		const css_select_index *index, css_select_state *state)
+{
+	return match_selectors_in_hash(ctx, index->selectors, index, state);
+}
+
 static void update_reject_cache(css_select_state *state,
 		css_combinator comb, const css_selector *s)
 {
@@ -2134,7 +3209,7 @@ static void update_reject_cache(css_select_state *state,
 	if (detail->next)
 		next_detail = detail + 1;
 
-	if (state->next_reject < state->reject_cache ||
+	if (state->reject->next < state->reject->items ||
 			comb != CSS_COMBINATOR_ANCESTOR ||
 			next_detail == NULL ||
 			next_detail->next != 0 ||
@@ -2143,9 +3218,9 @@ static void update_reject_cache(css_select_state *state,
 		return;
 
 	/* Insert */
-	state->next_reject->type = next_detail->type;
-	state->next_reject->value = next_detail->qname.name;
-	state->next_reject--;
+	state->reject->next->type = next_detail->type;
+	state->reject->next->value = next_detail->qname.name;
+	state->reject->next--;
 }
 
 css_error match_selector_chain(css_select_ctx *ctx,
@@ -2356,9 +3431,9 @@ css_error match_universal_combinator(css_select_ctx *ctx, css_combinator type,
 			next_detail != NULL &&
 			(next_detail->type == CSS_SELECTOR_CLASS ||
 			 next_detail->type == CSS_SELECTOR_ID)) {
-		reject_item *reject = state->next_reject + 1;
-		reject_item *last = state->reject_cache +
-				N_ELEMENTS(state->reject_cache) - 1;
+		reject_item *reject = state->reject->next + 1;
+		reject_item *last = state->reject->items +
+				N_ELEMENTS(state->reject->items) - 1;
 		bool match = false;
 
 		while (reject <= last) {
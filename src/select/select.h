@@ -15,6 +15,15 @@
 
 #include "stylesheet.h"
 
+/**
+ * Container for stylesheet selection info
+ */
+typedef struct css_select_sheet {
+	const css_stylesheet *sheet;	/**< Stylesheet */
+	css_origin origin;		/**< Stylesheet origin */
+	css_mq_query *media;		/**< Applicable media */
+} css_select_sheet;
+
 /**
  * Item in the reject cache (only class and id types are valid)
  */
@@ -23,6 +32,17 @@ typedef struct reject_item {
 	css_selector_type type;
 } reject_item;
 
+/**
+ * Cache of ancestor classes and ids which are known not to be present
+ *
+ * The cache depends only on a node's ancestors, so it may be shared by the
+ * selection states of sibling nodes.
+ */
+typedef struct reject_cache {
+	reject_item items[128];	/* Cached rejections (filled from end) */
+	reject_item *next;	/* Next free slot in cache */
+} reject_cache;
+
 typedef struct prop_state {
 	uint32_t specificity;                 /* Specificity of property in result */
 	unsigned int    set              : 1, /* Whether property is set in result */
@@ -79,6 +99,7 @@ typedef struct css_select_state {
 	css_computed_style *computed;	/* Computed style to populate */
 
 	css_select_handler *handler;	/* Handler functions */
+	css_select_subtree_handler *subtree; /* Subtree functions, or NULL */
 	void *pw;			/* Client data for handlers */
 
 	const css_stylesheet *sheet;	/* Current sheet being processed */
@@ -91,8 +112,7 @@ typedef struct css_select_state {
 	lwc_string **classes;		/* Node classes, if any */
 	uint32_t n_classes;		/* Number of classes */
 
-	reject_item reject_cache[128];	/* Reject cache (filled from end) */
-	reject_item *next_reject;	/* Next free slot in reject cache */
+	reject_cache *reject;		/* Reject cache for node's ancestors */
 
 	struct css_node_data *node_data;	/* Data we'll store on node */
 
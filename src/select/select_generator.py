@@ -506,8 +506,10 @@ class CSSGroup:
 
         t.append('struct css_computed_style *next;')
         t.append('uint32_t count;')
-        t.append('uint32_t bin;')
+        t.append('uint32_t hash;')
+        t.append('bool absolute;')
         t.append('css_calculator *calc;')
+        t.append('struct css_arena *arena;')
         t.indent(-1)
         t.append('};')
 
@@ -732,6 +734,167 @@ class CSSGroup:
 
         return t.to_string()
 
+    def is_blended(self, p):
+        """Return True if a property may be composed by blending its bits
+        and values, rather than by calling its compose function.
+
+        Properties which own references, or whose accessors or compose
+        function are overridden, are composed by their own functions.
+        """
+        return (not p.has_calc and
+                not any(v.is_ptr for v in p.values) and
+                p.name not in overrides['get'] and
+                p.name not in overrides['set'] and
+                p.name not in overrides['compose'])
+
+    def make_compose_h(self):
+        """Output this group's blending of properties for compose.h."""
+        t = Text()
+        n_words = len(self.bits_array)
+        blended = [ p for p in sorted(self.props, key=(lambda x: x.name))
+                    if self.is_blended(p) ]
+
+        def type_mask(p):
+            return (2 ** p.type_size - 1) << p.shift
+
+        t.append()
+        t.comment()
+        t.append('Most properties are composed by taking the child\'s '
+                 'value, or the parent\'s where the child\'s is inherit. '
+                 'Those which own no references and have no special '
+                 'composition rules are blended: their bits are selected '
+                 'from the parent\'s and child\'s a whole word at a time, '
+                 'and their values copied without calls through the '
+                 'dispatch table.')
+        t.append()
+        t.append('Every property\'s inherit opcode is zero, so a property '
+                 'is inherit exactly when its opcode bits are clear.')
+        t.comment()
+        t.append()
+        t.append('#define COMPOSE_N_WORDS {}'.format(n_words))
+
+        t.append()
+        t.append('/** Bits of each word of the bits array held by blended '
+                 'properties */')
+        t.append('static const uint32_t compose_blend_masks'
+                 '[COMPOSE_N_WORDS] = {')
+        t.indent(1)
+        for i, b in enumerate(self.bits_array):
+            mask = sum([ int(p.mask, 16) for p in b.contents
+                         if self.is_blended(p) ])
+            t.append('0x{:08x},'.format(mask))
+        t.indent(-1)
+        t.append('};')
+
+        t.append()
+        t.append('/** Properties which are composed by their own functions */')
+        t.append('static const uint16_t compose_call_props[] = {')
+        t.indent(1)
+        for p in sorted(self.props, key=(lambda x: x.name)):
+            if not self.is_blended(p):
+                t.append('CSS_PROP_{},'.format(p.name.upper()))
+        t.indent(-1)
+        t.append('};')
+
+        t.append()
+        t.append('/**')
+        t.append(' * Find the blended properties of a style which are inherit')
+        t.append(' *')
+        t.append(' * \\param style    The style to consider')
+        t.append(' * \\param inherit  Updated to the bits of each word of '
+                 'the bits array held')
+        t.append(' *                 by blended properties which are inherit')
+        t.append(' */')
+        t.append('static inline void compose_inherit_masks(')
+        t.append('\t\tconst css_computed_style *style,', pre_formatted=True)
+        t.append('\t\tuint32_t inherit[COMPOSE_N_WORDS])',
+                 pre_formatted=True)
+        t.append('{')
+        t.indent(1)
+        t.append('uint32_t bits;')
+        for i, b in enumerate(self.bits_array):
+            props = [ p for p in b.contents if self.is_blended(p) ]
+            t.append()
+            if not props:
+                t.append('inherit[{}] = 0;'.format(i))
+                continue
+            t.comment()
+            t.append('; '.join([ p.name for p in props ]))
+            t.comment()
+            t.append('bits = style->i.bits[{}];'.format(i))
+            for j, p in enumerate(props):
+                t.append('{}((bits & 0x{:08x}) ? 0 : 0x{:08x}){}'.format(
+                    'inherit[{}] = '.format(i) if j == 0 else '\t\t\t',
+                    type_mask(p), int(p.mask, 16),
+                    ';' if j == len(props) - 1 else ' |'),
+                    pre_formatted=(j != 0))
+        t.indent(-1)
+        t.append('}')
+
+        t.append()
+        t.append('/**')
+        t.append(' * Compose the blended properties of two styles')
+        t.append(' *')
+        t.append(' * The bits of properties which are not blended are left '
+                 'clear.')
+        t.append(' *')
+        t.append(' * \\param parent  Parent style')
+        t.append(' * \\param child   Child style')
+        t.append(' * \\param result  Blank style to compose into')
+        t.append(' */')
+        t.append('static inline void compose_blend(')
+        t.append('\t\tconst css_computed_style *parent,', pre_formatted=True)
+        t.append('\t\tconst css_computed_style *child,', pre_formatted=True)
+        t.append('\t\tcss_computed_style *result)', pre_formatted=True)
+        t.append('{')
+        t.indent(1)
+        t.append('uint32_t inherit[COMPOSE_N_WORDS];')
+        t.append('const css_computed_style *from;')
+        t.append('int i;')
+        t.append()
+        t.append('compose_inherit_masks(child, inherit);')
+        t.append()
+        t.append('for (i = 0; i < COMPOSE_N_WORDS; i++) {')
+        t.indent(1)
+        t.append('result->i.bits[i] = (parent->i.bits[i] & inherit[i]) |')
+        t.append('\t\t\t(child->i.bits[i] & compose_blend_masks[i] &',
+                 pre_formatted=True)
+        t.append('\t\t\t~inherit[i]);', pre_formatted=True)
+        t.indent(-1)
+        t.append('}')
+
+        for p in blended:
+            if not p.values:
+                continue
+            field = int(p.mask, 16)
+            value_bits = field & ~type_mask(p)
+            t.append()
+            t.append('/* {} */'.format(p.name))
+            t.append('from = (inherit[{}] & {}) ? parent : child;'.format(
+                p.index, p.mask))
+            if p.condition:
+                # Values are only copied for the opcode which has them
+                t.append('if (((from->i.bits[{}] >> {}) & 0x{:x}) == '
+                         '{}) {{'.format(p.index, p.shift,
+                                         2 ** p.type_size - 1, p.condition))
+                t.indent(1)
+            for v in p.values:
+                t.append('result->i.{0} = from->i.{0};'.format(
+                    p.name + v.suffix))
+            if p.condition:
+                if value_bits:
+                    t.indent(-1)
+                    t.append('} else {')
+                    t.indent(1)
+                    t.append('result->i.bits[{}] &= ~0x{:x};'.format(
+                        p.index, value_bits))
+                t.indent(-1)
+                t.append('}')
+        t.indent(-1)
+        t.append('}')
+
+        return t.to_string()
+
     def make_value_declaration(self, for_commented):
         """Output declarations of values for this group's properties.
 
@@ -759,6 +922,8 @@ class CSSGroup:
             return self.make_propset_h()
         elif filename == 'propget.h':
             return self.make_propget_h()
+        elif filename == 'compose.h':
+            return self.make_compose_h()
         elif filename == 'destroy.inc':
             return self.make_destroy_inc()
         else:
@@ -0,0 +1,1358 @@
+/*
+ * This file is part of LibCSS.
+ * Licensed under the MIT License,
+ *		  http://www.opensource.org/licenses/mit-license.php
+ * Copyright 2026 The NetSurf Project
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "stylesheet.h"
+#include "parse/mq.h"
+#include "select/font_face.h"
+#include "utils/utils.h"
+
+/*
+ * A serialised stylesheet is a sequence of 32-bit words, in the byte order
+ * of the host that wrote it.  It contains no pointers, so it may be loaded
+ * from anywhere in memory, such as from a mapped file:
+ *
+ *   magic, version, properties, flags, strings, vector strings, rules
+ *   each string:  length, data (padded to a whole number of words)
+ *   each rule:    type, type-specific data
+ *
+ * Strings are referred to by their position in the string table plus one,
+ * with zero meaning NULL.  The first vector strings form the sheet's
+ * bytecode string vector, so bytecode is written unchanged.
+ */
+
+/** Magic number, reading "LCSS" on little-endian hosts */
+#define IMAGE_MAGIC 0x5353434c
+/** Version of the image format */
+#define IMAGE_VERSION 1
+/** Words in the image header */
+#define IMAGE_HEADER_WORDS 7
+/** Maximum nesting of media query conditions in a loaded image */
+#define IMAGE_MAX_DEPTH 256
+
+/** Image header flags */
+enum {
+	IMAGE_QUIRKS_USED = (1 << 0),
+	IMAGE_USES_REVERT = (1 << 1)
+};
+
+/**
+ * State for serialising a stylesheet
+ *
+ * Writing to the serialiser never fails immediately: the first error is
+ * recorded, and subsequent writes ignored, so that callers need only check
+ * for errors once they have finished.
+ */
+typedef struct serialiser {
+	uint32_t *words;		/**< Words of rule data */
+	size_t used;			/**< Number of words in use */
+	size_t alloc;			/**< Number of words allocated */
+
+	lwc_string **strings;		/**< String table, in order */
+	uint32_t n_strings;		/**< Number of strings in table */
+	uint32_t strings_alloc;		/**< Number of strings allocated */
+
+	/** Map from string to its number in the table */
+	struct {
+		lwc_string *string;
+		uint32_t number;
+	} *map;
+	uint32_t map_size;		/**< Number of map slots (power of 2) */
+
+	css_error error;		/**< First error encountered */
+} serialiser;
+
+/**
+ * State for loading a stylesheet image
+ *
+ * Reads past the end of the image return zero and record CSS_INVALID.
+ */
+typedef struct loader {
+	const uint8_t *data;		/**< Image data */
+	size_t len;			/**< Length of image, in bytes */
+	size_t pos;			/**< Offset of next word to read */
+
+	lwc_string **strings;		/**< Interned string table */
+	uint32_t n_strings;		/**< Number of strings in table */
+
+	css_error error;		/**< First error encountered */
+} loader;
+
+/******************************************************************************
+ * Serialising                                                                *
+ ******************************************************************************/
+
+/**
+ * Append a word to a serialised image
+ *
+ * \param s     Serialiser state
+ * \param word  Word to append
+ */
+static void put(serialiser *s, uint32_t word)
+{
+	if (s->error != CSS_OK)
+		return;
+
+	if (s->used == s->alloc) {
+		size_t alloc = (s->alloc == 0) ? 1024 : s->alloc * 2;
+		uint32_t *words = realloc(s->words, alloc * sizeof(uint32_t));
+
+		if (words == NULL) {
+			s->error = CSS_NOMEM;
+			return;
+		}
+
+		s->words = words;
+		s->alloc = alloc;
+	}
+
+	s->words[s->used++] = word;
+}
+
+/**
+ * Find the slot in the string map for a string
+ *
+ * \param s       Serialiser state
+ * \param string  String to find
+ * \return Index of the string's slot, or of the empty slot it belongs in
+ */
+static uint32_t map_slot(const serialiser *s, const lwc_string *string)
+{
+	uint32_t mask = s->map_size - 1;
+	uint32_t index = ((uint32_t) ((uintptr_t) string >> 4) *
+			2654435761u) & mask;
+
+	while (s->map[index].string != NULL &&
+			s->map[index].string != string)
+		index = (index + 1) & mask;
+
+	return index;
+}
+
+/**
+ * Add a string to a serialised image's string table
+ *
+ * \param s       Serialiser state
+ * \param string  String to add
+ * \return Number of the string in the table
+ *
+ * As strings are interned, they are identified by their address.
+ */
+static uint32_t add_string(serialiser *s, lwc_string *string)
+{
+	uint32_t index;
+
+	if (s->error != CSS_OK)
+		return 0;
+
+	/* Keep the map no more than half full */
+	if (s->n_strings * 2 >= s->map_size) {
+		uint32_t size = (s->map_size == 0) ? 256 : s->map_size * 2;
+		serialiser old = *s;
+		uint32_t i;
+
+		s->map = calloc(size, sizeof(*s->map));
+		if (s->map == NULL) {
+			s->map = old.map;
+			s->error = CSS_NOMEM;
+			return 0;
+		}
+		s->map_size = size;
+
+		for (i = 0; i < old.map_size; i++) {
+			if (old.map[i].string != NULL)
+				s->map[map_slot(s, old.map[i].string)] =
+						old.map[i];
+		}
+
+		free(old.map);
+	}
+
+	index = map_slot(s, string);
+	if (s->map[index].string != NULL)
+		return s->map[index].number;
+
+	if (s->n_strings == s->strings_alloc) {
+		uint32_t alloc = s->strings_alloc + 256;
+		lwc_string **strings = realloc(s->strings,
+				alloc * sizeof(lwc_string *));
+
+		if (strings == NULL) {
+			s->error = CSS_NOMEM;
+			return 0;
+		}
+
+		s->strings = strings;
+		s->strings_alloc = alloc;
+	}
+
+	s->strings[s->n_strings++] = string;
+	s->map[index].string = string;
+	s->map[index].number = s->n_strings;
+
+	return s->n_strings;
+}
+
+/**
+ * Append a reference to a string to a serialised image
+ *
+ * \param s       Serialiser state
+ * \param string  String to refer to, or NULL
+ */
+static void put_string(serialiser *s, lwc_string *string)
+{
+	put(s, (string != NULL) ? add_string(s, string) : 0);
+}
+
+/**
+ * Append a style's bytecode to a serialised image
+ *
+ * \param s      Serialiser state
+ * \param style  Style to append, or NULL
+ */
+static void put_style(serialiser *s, const css_style *style)
+{
+	uint32_t i;
+
+	if (style == NULL) {
+		put(s, 0);
+		return;
+	}
+
+	put(s, 1);
+	put(s, style->used);
+
+	for (i = 0; i < style->used; i++)
+		put(s, style->bytecode[i]);
+}
+
+/**
+ * Append a selector chain to a serialised image
+ *
+ * \param s         Serialiser state
+ * \param selector  Last selector in the chain
+ */
+static void put_selector(serialiser *s, const css_selector *selector)
+{
+	const css_selector *sel;
+	uint32_t count = 0;
+
+	for (sel = selector; sel != NULL; sel = sel->combinator)
+		count++;
+
+	put(s, count);
+
+	for (sel = selector; sel != NULL; sel = sel->combinator) {
+		const css_selector_detail *detail;
+
+		count = 1;
+		for (detail = &sel->data; detail->next; detail++)
+			count++;
+
+		put(s, sel->specificity);
+		put(s, count);
+
+		for (detail = &sel->data; count > 0; detail++, count--) {
+			put(s, detail->type | (detail->comb << 4) |
+					(detail->value_type << 7) |
+					(detail->negate << 8));
+			put_string(s, detail->qname.ns);
+			put_string(s, detail->qname.name);
+
+			if (detail->value_type ==
+					CSS_SELECTOR_DETAIL_VALUE_NTH) {
+				put(s, (uint32_t) detail->value.nth.a);
+				put(s, (uint32_t) detail->value.nth.b);
+			} else {
+				put_string(s, detail->value.string);
+			}
+		}
+	}
+}
+
+/**
+ * Append a media query value to a serialised image
+ *
+ * \param s      Serialiser state
+ * \param value  Value to append
+ */
+static void put_mq_value(serialiser *s, const css_mq_value *value)
+{
+	put(s, value->type);
+
+	switch (value->type) {
+	case CSS_MQ_VALUE_TYPE_NUM:
+	case CSS_MQ_VALUE_TYPE_RATIO:
+		put(s, (uint32_t) value->data.num_or_ratio);
+		break;
+	case CSS_MQ_VALUE_TYPE_DIM:
+		put(s, (uint32_t) value->data.dim.len);
+		put(s, value->data.dim.unit);
+		break;
+	case CSS_MQ_VALUE_TYPE_IDENT:
+		put_string(s, value->data.ident);
+		break;
+	}
+}
+
+/**
+ * Append a media condition to a serialised image
+ *
+ * \param s     Serialiser state
+ * \param cond  Condition to append, or NULL
+ */
+static void put_mq_cond(serialiser *s, const css_mq_cond *cond)
+{
+	uint32_t i;
+
+	if (cond == NULL) {
+		put(s, 0);
+		return;
+	}
+
+	put(s, 1 | (cond->negate << 1) | (cond->op << 2));
+	put(s, cond->nparts);
+
+	for (i = 0; i < cond->nparts; i++) {
+		const css_mq_cond_or_feature *part = cond->parts[i];
+
+		put(s, part->type);
+
+		if (part->type == CSS_MQ_FEATURE) {
+			const css_mq_feature *feat = part->data.feat;
+
+			put_string(s, feat->name);
+			put(s, feat->op);
+			put(s, feat->op2);
+			put_mq_value(s, &feat->value);
+			put_mq_value(s, &feat->value2);
+		} else {
+			put_mq_cond(s, part->data.cond);
+		}
+	}
+}
+
+/**
+ * Append a media query list to a serialised image
+ *
+ * \param s      Serialiser state
+ * \param media  Media query list, or NULL
+ */
+static void put_media(serialiser *s, const css_mq_query *media)
+{
+	const css_mq_query *query;
+	uint32_t count = 0;
+
+	for (query = media; query != NULL; query = query->next)
+		count++;
+
+	put(s, count);
+
+	for (query = media; query != NULL; query = query->next) {
+		put(s, query->negate_type);
+		put(s, (uint32_t) query->type);
+		put(s, (uint32_t) (query->type >> 32));
+		put_mq_cond(s, query->cond);
+	}
+}
+
+/**
+ * Append a rule to a serialised image
+ *
+ * \param s     Serialiser state
+ * \param rule  Rule to append
+ */
+static void put_rule(serialiser *s, const css_rule *rule)
+{
+	put(s, rule->type);
+
+	switch (rule->type) {
+	case CSS_RULE_UNKNOWN:
+		break;
+	case CSS_RULE_SELECTOR:
+	{
+		const css_rule_selector *r = (const css_rule_selector *) rule;
+		uint32_t i;
+
+		put(s, rule->items);
+		for (i = 0; i < rule->items; i++)
+			put_selector(s, r->selectors[i]);
+
+		put_style(s, r->style);
+	}
+		break;
+	case CSS_RULE_CHARSET:
+		put_string(s, ((const css_rule_charset *) rule)->encoding);
+		break;
+	case CSS_RULE_IMPORT:
+	{
+		const css_rule_import *r = (const css_rule_import *) rule;
+
+		put_string(s, r->url);
+		put_media(s, r->media);
+	}
+		break;
+	case CSS_RULE_MEDIA:
+	{
+		const css_rule_media *r = (const css_rule_media *) rule;
+		const css_rule *c;
+		uint32_t count = 0;
+
+		put_media(s, r->media);
+
+		for (c = r->first_child; c != NULL; c = c->next)
+			count++;
+
+		put(s, count);
+
+		for (c = r->first_child; c != NULL; c = c->next)
+			put_rule(s, c);
+	}
+		break;
+	case CSS_RULE_FONT_FACE:
+	{
+		const css_font_face *f =
+				((const css_rule_font_face *) rule)->font_face;
+		uint32_t i;
+
+		if (f == NULL) {
+			put(s, 0);
+			break;
+		}
+
+		put(s, 1);
+		put_string(s, f->font_family);
+		put(s, f->bits[0]);
+		put(s, f->n_srcs);
+
+		for (i = 0; i < f->n_srcs; i++) {
+			put_string(s, f->srcs[i].location);
+			put(s, f->srcs[i].bits[0]);
+		}
+	}
+		break;
+	case CSS_RULE_PAGE:
+	{
+		const css_rule_page *r = (const css_rule_page *) rule;
+
+		if (r->selector != NULL) {
+			put(s, 1);
+			put_selector(s, r->selector);
+		} else {
+			put(s, 0);
+		}
+
+		put_style(s, r->style);
+	}
+		break;
+	}
+}
+
+/**
+ * Serialise a stylesheet into a binary image
+ *
+ * \param sheet   The stylesheet to serialise
+ * \param buffer  Buffer to receive the image, or NULL to find its size
+ * \param len     Pointer to length of buffer, in bytes, updated with the
+ *                length of the image
+ * \return CSS_OK on success,
+ *         CSS_BADPARM on bad parameters,
+ *         CSS_INVALID if the stylesheet has not been completely parsed,
+ *         CSS_NOMEM if the buffer is too small or on memory exhaustion
+ *
+ * The image may be passed to css_stylesheet_load_serialised() to recreate
+ * the stylesheet without parsing it again.  Imported stylesheets are not
+ * included: the loaded stylesheet's imports will be pending.
+ *
+ * Images contain bytecode, so are only valid for the version of LibCSS
+ * which wrote them, on hosts with the same byte order.
+ */
+css_error css_stylesheet_serialise(const css_stylesheet *sheet,
+		uint8_t *buffer, size_t *len)
+{
+	serialiser s;
+	const css_rule *rule;
+	uint32_t header[IMAGE_HEADER_WORDS];
+	uint32_t n_rules = 0, i;
+	size_t required;
+	uint8_t *ptr;
+
+	if (sheet == NULL || len == NULL)
+		return CSS_BADPARM;
+
+	if (sheet->parser != NULL)
+		return CSS_INVALID;
+
+	memset(&s, 0, sizeof(s));
+
+	/* The bytecode string vector leads the string table */
+	for (i = 0; i < sheet->string_vector_c; i++)
+		add_string(&s, sheet->string_vector[i]);
+
+	for (rule = sheet->rule_list; rule != NULL; rule = rule->next) {
+		put_rule(&s, rule);
+		n_rules++;
+	}
+
+	if (s.error != CSS_OK) {
+		free(s.words);
+		free(s.strings);
+		free(s.map);
+		return s.error;
+	}
+
+	header[0] = IMAGE_MAGIC;
+	header[1] = IMAGE_VERSION;
+	header[2] = CSS_N_PROPERTIES;
+	header[3] = (sheet->quirks_used ? IMAGE_QUIRKS_USED : 0) |
+			(sheet->uses_revert ? IMAGE_USES_REVERT : 0);
+	header[4] = s.n_strings;
+	header[5] = sheet->string_vector_c;
+	header[6] = n_rules;
+
+	required = sizeof(header) + s.used * sizeof(uint32_t);
+	for (i = 0; i < s.n_strings; i++)
+		required += sizeof(uint32_t) +
+				((lwc_string_length(s.strings[i]) + 3) & ~3);
+
+	if (buffer == NULL || *len < required) {
+		free(s.words);
+		free(s.strings);
+		free(s.map);
+		*len = required;
+		return (buffer == NULL) ? CSS_OK : CSS_NOMEM;
+	}
+
+	ptr = buffer;
+
+	memcpy(ptr, header, sizeof(header));
+	ptr += sizeof(header);
+
+	for (i = 0; i < s.n_strings; i++) {
+		uint32_t length = lwc_string_length(s.strings[i]);
+		uint32_t padded = (length + 3) & ~3;
+
+		memcpy(ptr, &length, sizeof(length));
+		ptr += sizeof(length);
+
+		memcpy(ptr, lwc_string_data(s.strings[i]), length);
+		memset(ptr + length, 0, padded - length);
+		ptr += padded;
+	}
+
+	/* An empty sheet has no words */
+	if (s.used > 0)
+		memcpy(ptr, s.words, s.used * sizeof(uint32_t));
+
+	free(s.words);
+	free(s.strings);
+	free(s.map);
+
+	*len = required;
+
+	return CSS_OK;
+}
+
+/******************************************************************************
+ * Loading                                                                    *
+ ******************************************************************************/
+
+/**
+ * Read a word from a stylesheet image
+ *
+ * \param l  Loader state
+ * \return The word read, or 0 if the image is exhausted
+ */
+static uint32_t get(loader *l)
+{
+	uint32_t word;
+
+	if (l->len - l->pos < sizeof(word)) {
+		l->error = CSS_INVALID;
+		return 0;
+	}
+
+	memcpy(&word, l->data + l->pos, sizeof(word));
+	l->pos += sizeof(word);
+
+	return word;
+}
+
+/**
+ * Determine whether a stylesheet image has room for a number of items
+ *
+ * \param l      Loader state
+ * \param count  Number of items
+ * \param size   Minimum size of each item, in words
+ * \return True if the items may fit in the rest of the image, else false
+ *
+ * This is used to reject counts that could not possibly be satisfied
+ * before allocating storage for them.
+ */
+static bool has_words(const loader *l, uint32_t count, uint32_t size)
+{
+	return l->error == CSS_OK &&
+			count <= (l->len - l->pos) / sizeof(uint32_t) / size;
+}
+
+/**
+ * Read a string reference from a stylesheet image
+ *
+ * \param l  Loader state
+ * \return The string referred to (not referenced), or NULL for none
+ */
+static lwc_string *get_string(loader *l)
+{
+	uint32_t number = get(l);
+
+	if (number > l->n_strings) {
+		l->error = CSS_INVALID;
+		return NULL;
+	}
+
+	return (number == 0) ? NULL : l->strings[number - 1];
+}
+
+/**
+ * Read a style from a stylesheet image
+ *
+ * \param l      Loader state
+ * \param sheet  Stylesheet being loaded
+ * \param style  Pointer to location to receive style, or NULL if none
+ * \return CSS_OK on success, appropriate error otherwise
+ */
+static css_error get_style(loader *l, css_stylesheet *sheet,
+		css_style **style)
+{
+	css_style *s;
+	css_error error;
+	uint32_t used;
+
+	*style = NULL;
+
+	if (get(l) == 0)
+		return l->error;
+
+	used = get(l);
+	if (!has_words(l, used, 1))
+		return CSS_INVALID;
+
+	error = css__stylesheet_style_create(sheet, &s);
+	if (error != CSS_OK)
+		return error;
+
+	if (s->allocated < used) {
+		css_code_t *bytecode = css__pool_realloc(sheet->pool,
+				s->bytecode, s->allocated * sizeof(css_code_t),
+				used * sizeof(css_code_t));
+
+		if (bytecode == NULL) {
+			css__stylesheet_style_destroy(s);
+			return CSS_NOMEM;
+		}
+
+		s->bytecode = bytecode;
+		s->allocated = used;
+	}
+
+	memcpy(s->bytecode, l->data + l->pos, used * sizeof(css_code_t));
+	l->pos += used * sizeof(css_code_t);
+	s->used = used;
+
+	*style = s;
+
+	return CSS_OK;
+}
+
+/**
+ * Read a selector detail from a stylesheet image
+ *
+ * \param l       Loader state
+ * \param detail  Detail to fill in
+ * \param last    Whether the detail is in the first selector of the chain
+ * \return CSS_OK on success, appropriate error otherwise
+ *
+ * On failure, any strings already referenced by the detail remain so.
+ */
+static css_error get_selector_detail(loader *l, css_selector_detail *detail,
+		bool last)
+{
+	uint32_t bits = get(l);
+	lwc_string *ns = get_string(l);
+	lwc_string *name = get_string(l);
+
+	if (l->error != CSS_OK || name == NULL ||
+			(bits & 0xf) > CSS_SELECTOR_ATTRIBUTE_SUBSTRING ||
+			((bits >> 4) & 0x7) > CSS_COMBINATOR_GENERIC_SIBLING ||
+			(bits >> 9) != 0)
+		return CSS_INVALID;
+
+	detail->type = bits & 0xf;
+	detail->value_type = (bits >> 7) & 0x1;
+	detail->negate = (bits >> 8) & 0x1;
+
+	/* Only the first detail of a selector may have a combinator, and
+	 * then only if another selector precedes it in the chain */
+	detail->comb = CSS_COMBINATOR_NONE;
+	if (((bits >> 4) & 0x7) != CSS_COMBINATOR_NONE) {
+		if (last)
+			return CSS_INVALID;
+		detail->comb = (bits >> 4) & 0x7;
+	}
+
+	/* Selector hashing needs the caseless form of names */
+	if (name->insensitive == NULL &&
+			lwc__intern_caseless_string(name) != lwc_error_ok)
+		return CSS_NOMEM;
+
+	detail->qname.ns = (ns != NULL) ? lwc_string_ref(ns) : NULL;
+	detail->qname.name = lwc_string_ref(name);
+
+	if (detail->value_type == CSS_SELECTOR_DETAIL_VALUE_NTH) {
+		detail->value.nth.a = (int32_t) get(l);
+		detail->value.nth.b = (int32_t) get(l);
+	} else {
+		lwc_string *value = get_string(l);
+
+		detail->value.string = (value != NULL) ?
+				lwc_string_ref(value) : NULL;
+	}
+
+	return l->error;
+}
+
+/**
+ * Read a selector chain from a stylesheet image
+ *
+ * \param l         Loader state
+ * \param sheet     Stylesheet being loaded
+ * \param selector  Pointer to location to receive last selector in chain
+ * \return CSS_OK on success, appropriate error otherwise
+ */
+static css_error get_selector(loader *l, css_stylesheet *sheet,
+		css_selector **selector)
+{
+	css_selector *first = NULL, **link = &first;
+	uint32_t count = get(l);
+	css_error error = CSS_OK;
+
+	if (count == 0 || !has_words(l, count, 5))
+		return CSS_INVALID;
+
+	while (count-- > 0) {
+		uint32_t specificity = get(l);
+		uint32_t n_details = get(l);
+		css_selector *sel;
+		uint32_t i;
+
+		if (n_details == 0 || !has_words(l, n_details, 4)) {
+			error = CSS_INVALID;
+			break;
+		}
+
+		sel = css__pool_alloc(sheet->pool, sizeof(css_selector) +
+				(n_details - 1) * sizeof(css_selector_detail));
+		if (sel == NULL) {
+			error = CSS_NOMEM;
+			break;
+		}
+
+		memset(sel, 0, sizeof(css_selector) +
+				(n_details - 1) * sizeof(css_selector_detail));
+		sel->specificity = specificity;
+
+		/* Mark every detail but the last up front, so that the whole
+		 * selector is freed should it not be completed */
+		for (i = 0; i + 1 < n_details; i++)
+			(&sel->data)[i].next = 1;
+
+		/* Link the selector in first, so that it is destroyed with
+		 * the chain if it cannot be completed */
+		*link = sel;
+		link = &sel->combinator;
+
+		for (i = 0; i < n_details; i++) {
+			css_selector_detail *detail = &(&sel->data)[i];
+
+			error = get_selector_detail(l, detail,
+					i > 0 || count == 0);
+			if (error != CSS_OK)
+				break;
+		}
+
+		if (error != CSS_OK)
+			break;
+
+		/* A combinator must join this selector to the next */
+		if (count > 0 && sel->data.comb == CSS_COMBINATOR_NONE) {
+			error = CSS_INVALID;
+			break;
+		}
+	}
+
+	if (error != CSS_OK) {
+		if (first != NULL)
+			css__stylesheet_selector_destroy(sheet, first);
+		return error;
+	}
+
+	*selector = first;
+
+	return CSS_OK;
+}
+
+/**
+ * Read a media query value from a stylesheet image
+ *
+ * \param l      Loader state
+ * \param value  Value to fill in
+ * \return CSS_OK on success, appropriate error otherwise
+ */
+static css_error get_mq_value(loader *l, css_mq_value *value)
+{
+	uint32_t type = get(l);
+
+	switch (type) {
+	case CSS_MQ_VALUE_TYPE_NUM:
+	case CSS_MQ_VALUE_TYPE_RATIO:
+		value->data.num_or_ratio = (css_fixed) get(l);
+		break;
+	case CSS_MQ_VALUE_TYPE_DIM:
+		value->data.dim.len = (css_fixed) get(l);
+		value->data.dim.unit = get(l);
+		break;
+	case CSS_MQ_VALUE_TYPE_IDENT:
+	{
+		lwc_string *ident = get_string(l);
+
+		if (ident == NULL)
+			return CSS_INVALID;
+
+		value->data.ident = lwc_string_ref(ident);
+	}
+		break;
+	default:
+		return CSS_INVALID;
+	}
+
+	value->type = type;
+
+	return l->error;
+}
+
+/**
+ * Read a media condition from a stylesheet image
+ *
+ * \param l      Loader state
+ * \param cond   Pointer to location to receive condition, or NULL if none
+ * \param depth  Nesting depth of the condition
+ * \return CSS_OK on success, appropriate error otherwise
+ *
+ * The condition is stored to \a cond as soon as it is created, so that the
+ * caller may destroy whatever has been loaded should this fail.
+ */
+static css_error get_mq_cond(loader *l, css_mq_cond **cond, uint32_t depth)
+{
+	uint32_t bits = get(l);
+	uint32_t nparts, i;
+	css_mq_cond *c;
+
+	*cond = NULL;
+
+	if (bits == 0)
+		return l->error;
+
+	nparts = get(l);
+	if ((bits >> 3) != 0 || (bits & 1) == 0 ||
+			depth > IMAGE_MAX_DEPTH || !has_words(l, nparts, 2))
+		return CSS_INVALID;
+
+	c = calloc(1, sizeof(css_mq_cond));
+	if (c == NULL)
+		return CSS_NOMEM;
+
+	c->negate = (bits >> 1) & 1;
+	c->op = (bits >> 2) & 1;
+	*cond = c;
+
+	c->parts = calloc(nparts, sizeof(css_mq_cond_or_feature *));
+	if (c->parts == NULL && nparts > 0)
+		return CSS_NOMEM;
+
+	for (i = 0; i < nparts; i++) {
+		uint32_t type = get(l);
+		css_mq_cond_or_feature *part;
+		css_error error;
+
+		if (type != CSS_MQ_FEATURE && type != CSS_MQ_COND)
+			return CSS_INVALID;
+
+		part = calloc(1, sizeof(css_mq_cond_or_feature));
+		if (part == NULL)
+			return CSS_NOMEM;
+
+		part->type = type;
+		c->parts[c->nparts++] = part;
+
+		if (type == CSS_MQ_FEATURE) {
+			css_mq_feature *feat;
+			lwc_string *name;
+
+			feat = calloc(1, sizeof(css_mq_feature));
+			if (feat == NULL)
+				return CSS_NOMEM;
+
+			part->data.feat = feat;
+
+			name = get_string(l);
+			if (name == NULL)
+				return CSS_INVALID;
+
+			feat->name = lwc_string_ref(name);
+			feat->op = get(l);
+			feat->op2 = get(l);
+
+			if (feat->op > CSS_MQ_FEATURE_OP_GT ||
+					feat->op2 > CSS_MQ_FEATURE_OP_GT)
+				return CSS_INVALID;
+
+			error = get_mq_value(l, &feat->value);
+			if (error != CSS_OK)
+				return error;
+
+			error = get_mq_value(l, &feat->value2);
+		} else {
+			error = get_mq_cond(l, &part->data.cond, depth + 1);
+			if (error == CSS_OK && part->data.cond == NULL)
+				error = CSS_INVALID;
+		}
+
+		if (error != CSS_OK)
+			return error;
+	}
+
+	return l->error;
+}
+
+/**
+ * Read a media query list from a stylesheet image
+ *
+ * \param l      Loader state
+ * \param media  Pointer to location to receive media query list
+ * \return CSS_OK on success, appropriate error otherwise
+ */
+static css_error get_media(loader *l, css_mq_query **media)
+{
+	css_mq_query *first = NULL, **link = &first;
+	uint32_t count = get(l);
+	css_error error = CSS_OK;
+
+	if (!has_words(l, count, 4))
+		return CSS_INVALID;
+
+	while (count-- > 0) {
+		css_mq_query *query = calloc(1, sizeof(css_mq_query));
+		uint32_t negate_type, type_low, type_high;
+
+		if (query == NULL) {
+			error = CSS_NOMEM;
+			break;
+		}
+
+		*link = query;
+		link = &query->next;
+
+		negate_type = get(l);
+		type_low = get(l);
+		type_high = get(l);
+
+		if (negate_type > 1) {
+			error = CSS_INVALID;
+			break;
+		}
+
+		query->negate_type = negate_type;
+		query->type = ((uint64_t) type_high << 32) | type_low;
+
+		error = get_mq_cond(l, &query->cond, 0);
+		if (error != CSS_OK)
+			break;
+	}
+
+	if (error != CSS_OK) {
+		css__mq_query_destroy(first);
+		return error;
+	}
+
+	*media = first;
+
+	return CSS_OK;
+}
+
+/**
+ * Read a font-face from a stylesheet image
+ *
+ * \param l          Loader state
+ * \param font_face  Pointer to location to receive font-face, or NULL
+ * \return CSS_OK on success, appropriate error otherwise
+ */
+static css_error get_font_face(loader *l, css_font_face **font_face)
+{
+	css_font_face_src *srcs;
+	lwc_string *family;
+	css_font_face *f;
+	uint32_t bits, n_srcs, i;
+	css_error error;
+
+	*font_face = NULL;
+
+	if (get(l) == 0)
+		return l->error;
+
+	family = get_string(l);
+	bits = get(l);
+	n_srcs = get(l);
+
+	if (bits > UINT8_MAX || !has_words(l, n_srcs, 2))
+		return CSS_INVALID;
+
+	error = css__font_face_create(&f);
+	if (error != CSS_OK)
+		return error;
+
+	if (family != NULL)
+		f->font_family = lwc_string_ref(family);
+	f->bits[0] = bits;
+
+	if (n_srcs == 0) {
+		*font_face = f;
+		return CSS_OK;
+	}
+
+	srcs = calloc(n_srcs, sizeof(css_font_face_src));
+	if (srcs == NULL) {
+		css__font_face_destroy(f);
+		return CSS_NOMEM;
+	}
+
+	for (i = 0; i < n_srcs; i++) {
+		lwc_string *location = get_string(l);
+
+		bits = get(l);
+
+		if (location == NULL || bits > UINT8_MAX)
+			break;
+
+		srcs[i].location = lwc_string_ref(location);
+		srcs[i].bits[0] = bits;
+	}
+
+	/* The font-face takes ownership of the sources loaded so far */
+	css__font_face_set_srcs(f, srcs, i);
+
+	if (i < n_srcs) {
+		css__font_face_destroy(f);
+		return CSS_INVALID;
+	}
+
+	*font_face = f;
+
+	return CSS_OK;
+}
+
+/**
+ * Read a rule from a stylesheet image and add it to the stylesheet
+ *
+ * \param l       Loader state
+ * \param sheet   Stylesheet being loaded
+ * \param parent  Parent @media rule, or NULL for a top-level rule
+ * \return CSS_OK on success, appropriate error otherwise
+ */
+static css_error get_rule(loader *l, css_stylesheet *sheet, css_rule *parent)
+{
+	uint32_t type = get(l);
+	css_rule *rule;
+	css_error error;
+
+	if (l->error != CSS_OK || type > CSS_RULE_PAGE ||
+			(parent != NULL && type == CSS_RULE_MEDIA))
+		return CSS_INVALID;
+
+	error = css__stylesheet_rule_create(sheet, type, &rule);
+	if (error != CSS_OK)
+		return error;
+
+	/* Fill in anything that the rule must have before it is added to
+	 * the sheet, as the parser does */
+	switch (type) {
+	case CSS_RULE_SELECTOR:
+	{
+		uint32_t count = get(l), i;
+
+		if (count > UINT16_MAX || !has_words(l, count, 1)) {
+			error = CSS_INVALID;
+			break;
+		}
+
+		for (i = 0; i < count; i++) {
+			css_selector *sel;
+
+			error = get_selector(l, sheet, &sel);
+			if (error != CSS_OK)
+				break;
+
+			error = css__stylesheet_rule_add_selector(sheet,
+					rule, sel);
+			if (error != CSS_OK) {
+				css__stylesheet_selector_destroy(sheet, sel);
+				break;
+			}
+		}
+	}
+		break;
+	case CSS_RULE_CHARSET:
+	{
+		lwc_string *encoding = get_string(l);
+
+		if (encoding == NULL) {
+			error = CSS_INVALID;
+			break;
+		}
+
+		error = css__stylesheet_rule_set_charset(sheet, rule,
+				encoding);
+	}
+		break;
+	case CSS_RULE_IMPORT:
+	{
+		lwc_string *url = get_string(l);
+		css_mq_query *media;
+
+		if (url == NULL || parent != NULL) {
+			error = CSS_INVALID;
+			break;
+		}
+
+		error = get_media(l, &media);
+		if (error != CSS_OK)
+			break;
+
+		error = css__stylesheet_rule_set_nascent_import(sheet, rule,
+				url, media);
+		if (error != CSS_OK) {
+			css__mq_query_destroy(media);
+			break;
+		}
+
+		if (sheet->import != NULL)
+			error = sheet->import(sheet->import_pw, sheet, url);
+	}
+		break;
+	case CSS_RULE_MEDIA:
+	{
+		css_mq_query *media;
+
+		error = get_media(l, &media);
+		if (error != CSS_OK)
+			break;
+
+		error = css__stylesheet_rule_set_media(sheet, rule, media);
+		if (error != CSS_OK)
+			css__mq_query_destroy(media);
+	}
+		break;
+	case CSS_RULE_PAGE:
+		if (get(l) != 0) {
+			css_selector *sel;
+
+			error = get_selector(l, sheet, &sel);
+			if (error != CSS_OK)
+				break;
+
+			error = css__stylesheet_rule_set_page_selector(sheet,
+					rule, sel);
+			if (error != CSS_OK)
+				css__stylesheet_selector_destroy(sheet, sel);
+		} else {
+			error = l->error;
+		}
+		break;
+	}
+
+	if (error == CSS_OK)
+		error = css__stylesheet_add_rule(sheet, rule, parent);
+
+	if (error != CSS_OK) {
+		css__stylesheet_rule_destroy(sheet, rule);
+		return error;
+	}
+
+	/* Rule is now owned by the sheet: add the rest of its contents */
+	switch (type) {
+	case CSS_RULE_SELECTOR:
+	case CSS_RULE_PAGE:
+	{
+		css_style *style;
+
+		error = get_style(l, sheet, &style);
+		if (error != CSS_OK || style == NULL)
+			break;
+
+		error = css__stylesheet_rule_append_style(sheet, rule, style);
+		if (error != CSS_OK)
+			css__stylesheet_style_destroy(style);
+	}
+		break;
+	case CSS_RULE_MEDIA:
+	{
+		uint32_t count = get(l), i;
+
+		if (!has_words(l, count, 1)) {
+			error = CSS_INVALID;
+			break;
+		}
+
+		for (i = 0; i < count; i++) {
+			error = get_rule(l, sheet, rule);
+			if (error != CSS_OK)
+				break;
+		}
+	}
+		break;
+	case CSS_RULE_FONT_FACE:
+		error = get_font_face(l,
+				&((css_rule_font_face *) rule)->font_face);
+		break;
+	}
+
+	return error;
+}
+
+/**
+ * Load a stylesheet from a binary image
+ *
+ * \param sheet  The stylesheet to load into
+ * \param data   Pointer to the image
+ * \param len    Length, in bytes, of the image
+ * \return CSS_OK on success,
+ *         CSS_IMPORTS_PENDING if there are imports pending,
+ *         CSS_BADPARM on bad parameters,
+ *         CSS_INVALID if the image is not valid, or the stylesheet has
+ *                     already had data appended to it,
+ *         CSS_NOMEM on memory exhaustion
+ *
+ * The image must have been produced by css_stylesheet_serialise().  This
+ * is used in place of css_stylesheet_append_data() and
+ * css_stylesheet_data_done(), and the image need only remain valid until
+ * this returns.  If loading fails, the stylesheet may be partially loaded,
+ * and should be destroyed.
+ *
+ * The structure of the image is checked, but its bytecode is not, so
+ * images should only be loaded from trusted sources.
+ */
+css_error css_stylesheet_load_serialised(css_stylesheet *sheet,
+		const uint8_t *data, size_t len)
+{
+	uint32_t flags, n_vector, n_rules, i;
+	css_error error = CSS_OK;
+	loader l;
+
+	if (sheet == NULL || data == NULL)
+		return CSS_BADPARM;
+
+	if (sheet->parser == NULL || sheet->rule_count != 0 ||
+			sheet->string_vector_c != 0)
+		return CSS_INVALID;
+
+	memset(&l, 0, sizeof(l));
+	l.data = data;
+	l.len = len;
+
+	if (get(&l) != IMAGE_MAGIC || get(&l) != IMAGE_VERSION ||
+			get(&l) != CSS_N_PROPERTIES)
+		return CSS_INVALID;
+
+	flags = get(&l);
+	l.n_strings = get(&l);
+	n_vector = get(&l);
+	n_rules = get(&l);
+
+	if (n_vector > l.n_strings || !has_words(&l, l.n_strings, 1))
+		return CSS_INVALID;
+
+	/* Intern the string table */
+	l.strings = malloc(l.n_strings * sizeof(lwc_string *));
+	if (l.strings == NULL && l.n_strings > 0)
+		return CSS_NOMEM;
+
+	for (i = 0; i < l.n_strings; i++) {
+		size_t length = get(&l);
+		size_t padded = (length + 3) & ~((size_t) 3);
+		lwc_error lerror;
+
+		if (l.error != CSS_OK || padded > l.len - l.pos) {
+			error = CSS_INVALID;
+			break;
+		}
+
+		lerror = lwc_intern_string((const char *) l.data + l.pos,
+				length, &l.strings[i]);
+		if (lerror != lwc_error_ok) {
+			error = css_error_from_lwc_error(lerror);
+			break;
+		}
+
+		l.pos += padded;
+	}
+
+	if (error != CSS_OK) {
+		while (i > 0)
+			lwc_string_unref(l.strings[--i]);
+		free(l.strings);
+		return error;
+	}
+
+	/* The leading strings become the bytecode string vector */
+	if (n_vector > 0) {
+		sheet->string_vector = malloc(n_vector * sizeof(lwc_string *));
+		if (sheet->string_vector == NULL) {
+			error = CSS_NOMEM;
+		} else {
+			for (i = 0; i < n_vector; i++) {
+				sheet->string_vector[i] =
+						lwc_string_ref(l.strings[i]);
+			}
+
+			sheet->string_vector_l = n_vector;
+			sheet->string_vector_c = n_vector;
+		}
+	}
+
+	sheet->quirks_used = (flags & IMAGE_QUIRKS_USED) != 0;
+	sheet->uses_revert = (flags & IMAGE_USES_REVERT) != 0;
+
+	for (i = 0; i < n_rules && error == CSS_OK; i++) {
+		error = get_rule(&l, sheet, NULL);
+		if (error == CSS_OK)
+			sheet->generation++;
+	}
+
+	if (error == CSS_OK && l.pos != l.len)
+		error = CSS_INVALID;
+
+	for (i = 0; i < l.n_strings; i++)
+		lwc_string_unref(l.strings[i]);
+	free(l.strings);
+
+	if (error != CSS_OK)
+		return error;
+
+	/* Complete the (empty) parse, as css_stylesheet_data_done() would */
+	return css_stylesheet_data_done(sheet);
+}
@@ -21,6 +21,9 @@
 static css_error _add_selectors(css_stylesheet *sheet, css_rule *rule);
 static css_error _remove_selectors(css_stylesheet *sheet, css_rule *rule);
 static size_t _rule_size(const css_rule *rule);
+static size_t _rule_struct_size(css_rule_type type);
+static void _rule_shrink(css_rule *rule);
+static css_error css__stylesheet_parse_done(css_stylesheet *sheet);
 
 /**
  * Add a string to a stylesheet's string vector.
@@ -225,6 +228,22 @@ css_error css_stylesheet_create(const css_stylesheet_params *params,
 		}
 	}
 
+	/* Inline styles are small and numerous, so are not worth a pool */
+	if (params->inline_style == false) {
+		error = css__pool_create(&sheet->pool);
+		if (error != CSS_OK) {
+			if (sheet->title != NULL)
+				free(sheet->title);
+			free(sheet->url);
+			css__selector_hash_destroy(sheet->selectors);
+			css__language_destroy(sheet->parser_frontend);
+			css__parser_destroy(sheet->parser);
+			css__propstrings_unref();
+			free(sheet);
+			return error;
+		}
+	}
+
 	sheet->resolve = params->resolve;
 	sheet->resolve_pw = params->resolve_pw;
 
@@ -241,6 +260,8 @@ css_error css_stylesheet_create(const css_stylesheet_params *params,
 	if (sheet->title != NULL)
 		sheet->size += strlen(sheet->title);
 
+	sheet->refcnt = 1;
+
 	*stylesheet = sheet;
 
 	return CSS_OK;
@@ -251,6 +272,9 @@ css_error css_stylesheet_create(const css_stylesheet_params *params,
  *
  * \param sheet	 The stylesheet to destroy
  * \return CSS_OK on success, appropriate error otherwise
+ *
+ * If the stylesheet is frozen, this releases a reference to it, and the
+ * stylesheet is only destroyed once the last reference is released.
  */
 css_error css_stylesheet_destroy(css_stylesheet *sheet)
 {
@@ -260,6 +284,24 @@ css_error css_stylesheet_destroy(css_stylesheet *sheet)
 	if (sheet == NULL)
 		return CSS_BADPARM;
 
+	if (--sheet->refcnt > 0)
+		return CSS_OK;
+
+	/* A frozen sheet holds references to the sheets it imports */
+	if (sheet->frozen) {
+		for (r = sheet->rule_list; r != NULL; r = r->next) {
+			css_rule_import *i = (css_rule_import *) r;
+
+			if (r->type != CSS_RULE_UNKNOWN &&
+					r->type != CSS_RULE_CHARSET &&
+					r->type != CSS_RULE_IMPORT)
+				break;
+
+			if (r->type == CSS_RULE_IMPORT)
+				css_stylesheet_destroy(i->sheet);
+		}
+	}
+
 	if (sheet->title != NULL)
 		free(sheet->title);
 
@@ -296,6 +338,9 @@ css_error css_stylesheet_destroy(css_stylesheet *sheet)
 	if (sheet->string_vector != NULL)
 		free(sheet->string_vector);
 
+	/* Release what remains of the rules, selectors and styles */
+	css__pool_destroy(sheet->pool);
+
 	css__propstrings_unref();
 
 	free(sheet);
@@ -323,6 +368,40 @@ css_error css_stylesheet_append_data(css_stylesheet *sheet,
 	return css__parser_parse_chunk(sheet->parser, data, len);
 }
 
+/**
+ * Parse the whole of a stylesheet's source data from a single buffer
+ *
+ * \param sheet  The stylesheet to parse data into
+ * \param data   Pointer to the complete source data
+ * \param len    Length, in bytes, of data
+ * \return CSS_OK on success,
+ *         CSS_IMPORTS_PENDING if there are imports pending,
+ *         appropriate error otherwise
+ *
+ * This is equivalent to css_stylesheet_append_data() followed by
+ * css_stylesheet_data_done(). Where the data is UTF-8, it is tokenised in
+ * place rather than being copied. The data need only remain valid until
+ * this returns.
+ */
+css_error css_stylesheet_parse_buffer(css_stylesheet *sheet,
+		const uint8_t *data, size_t len)
+{
+	css_error error;
+
+	if (sheet == NULL || data == NULL)
+		return CSS_BADPARM;
+
+	if (sheet->parser == NULL)
+		return CSS_INVALID;
+
+	/* This sees the end of the data, so the parser is complete */
+	error = css__parser_parse_buffer(sheet->parser, data, len);
+	if (error != CSS_OK)
+		return error;
+
+	return css__stylesheet_parse_done(sheet);
+}
+
 /**
  * Flag that the last of a stylesheet's data has been seen
  *
@@ -333,7 +412,6 @@ css_error css_stylesheet_append_data(css_stylesheet *sheet,
  */
 css_error css_stylesheet_data_done(css_stylesheet *sheet)
 {
-	const css_rule *r;
 	css_error error;
 
 	if (sheet == NULL)
@@ -346,6 +424,20 @@ css_error css_stylesheet_data_done(css_stylesheet *sheet)
 	if (error != CSS_OK)
 		return error;
 
+	return css__stylesheet_parse_done(sheet);
+}
+
+/**
+ * Finish parsing a stylesheet, once its parser has seen the end of the data
+ *
+ * \param sheet  The stylesheet in question
+ * \return CSS_OK on success,
+ *         CSS_IMPORTS_PENDING if there are imports pending
+ */
+static css_error css__stylesheet_parse_done(css_stylesheet *sheet)
+{
+	const css_rule *r;
+
 	/* Destroy the parser, as it's no longer needed */
 	css__language_destroy(sheet->parser_frontend);
 	css__parser_destroy(sheet->parser);
@@ -359,6 +451,11 @@ css_error css_stylesheet_data_done(css_stylesheet *sheet)
 		sheet->cached_style = NULL;
 	}
 
+	/* Any rules left open by the end of the data are now complete */
+	sheet->generation = 0;
+	for (r = sheet->rule_list; r != NULL; r = r->next)
+		sheet->generation++;
+
 	/* Determine if there are any pending imports */
 	for (r = sheet->rule_list; r != NULL; r = r->next) {
 		const css_rule_import *i = (const css_rule_import *) r;
@@ -460,6 +557,173 @@ css_error css_stylesheet_register_import(css_stylesheet *parent,
 	return CSS_INVALID;
 }
 
+/**
+ * Freeze a stylesheet, making it immutable and reference counted
+ *
+ * \param sheet  The stylesheet to freeze
+ * \return CSS_OK on success,
+ *         CSS_BADPARM on bad parameters,
+ *         CSS_INVALID if the stylesheet has not been completely parsed, or
+ *                     has an import which is pending or not frozen
+ *
+ * This may be called once parsing has completed and every import has been
+ * registered.  It releases what remains of the stylesheet's parse state,
+ * including the client callbacks given when it was created, and trims its
+ * storage to fit.  A frozen stylesheet holds a reference to each of the
+ * stylesheets it imports, which must have been frozen first.
+ *
+ * Frozen stylesheets may not be modified, and may be shared between any
+ * number of selection contexts.  Further references are taken with
+ * css_stylesheet_ref() and released with css_stylesheet_destroy().
+ * Selection contexts take no references, so the client must hold one
+ * for as long as the stylesheet is in any context.
+ *
+ * Selection only reads stylesheets, so a frozen stylesheet may be used by
+ * selection contexts in several threads at once, provided that the
+ * client serialises calls to css_stylesheet_ref() and
+ * css_stylesheet_destroy(), and that libwapcaplet's reference counting is
+ * safe for concurrent use, as computed styles reference the stylesheet's
+ * strings.
+ */
+css_error css_stylesheet_freeze(css_stylesheet *sheet)
+{
+	css_rule *r, *c;
+
+	if (sheet == NULL)
+		return CSS_BADPARM;
+
+	if (sheet->frozen)
+		return CSS_OK;
+
+	if (sheet->parser != NULL)
+		return CSS_INVALID;
+
+	for (r = sheet->rule_list; r != NULL; r = r->next) {
+		css_rule_import *i = (css_rule_import *) r;
+
+		if (r->type != CSS_RULE_UNKNOWN &&
+				r->type != CSS_RULE_CHARSET &&
+				r->type != CSS_RULE_IMPORT)
+			break;
+
+		if (r->type == CSS_RULE_IMPORT &&
+				(i->sheet == NULL || i->sheet->frozen == false))
+			return CSS_INVALID;
+	}
+
+	/* Nothing can fail from here on */
+	for (r = sheet->rule_list; r != NULL; r = r->next) {
+		if (r->type == CSS_RULE_IMPORT) {
+			((css_rule_import *) r)->sheet->refcnt++;
+		} else if (r->type == CSS_RULE_MEDIA) {
+			for (c = ((css_rule_media *) r)->first_child;
+					c != NULL; c = c->next)
+				_rule_shrink(c);
+		} else {
+			_rule_shrink(r);
+		}
+	}
+
+	if (sheet->string_vector_c < sheet->string_vector_l) {
+		lwc_string **string_vector = NULL;
+
+		if (sheet->string_vector_c > 0) {
+			string_vector = realloc(sheet->string_vector,
+					sheet->string_vector_c *
+					sizeof(lwc_string *));
+		} else {
+			free(sheet->string_vector);
+			sheet->string_vector = NULL;
+			sheet->string_vector_l = 0;
+		}
+
+		if (string_vector != NULL) {
+			sheet->string_vector = string_vector;
+			sheet->string_vector_l = sheet->string_vector_c;
+		}
+	}
+
+	/* The callbacks' private data belongs to whoever loaded the sheet */
+	sheet->import = NULL;
+	sheet->import_pw = NULL;
+	sheet->resolve = NULL;
+	sheet->resolve_pw = NULL;
+	sheet->color = NULL;
+	sheet->color_pw = NULL;
+	sheet->font = NULL;
+	sheet->font_pw = NULL;
+
+	sheet->frozen = true;
+
+	return CSS_OK;
+}
+
+/**
+ * Take a reference to a frozen stylesheet
+ *
+ * \param sheet  The stylesheet to reference
+ * \return CSS_OK on success,
+ *         CSS_BADPARM on bad parameters,
+ *         CSS_INVALID if the stylesheet is not frozen
+ *
+ * The reference is released with css_stylesheet_destroy().
+ */
+css_error css_stylesheet_ref(css_stylesheet *sheet)
+{
+	if (sheet == NULL)
+		return CSS_BADPARM;
+
+	if (sheet->frozen == false)
+		return CSS_INVALID;
+
+	sheet->refcnt++;
+
+	return CSS_OK;
+}
+
+/**
+ * Retrieve a stylesheet's generation
+ *
+ * \param sheet       The stylesheet to consider
+ * \param generation  Pointer to location to receive generation
+ * \return CSS_OK on success, appropriate error otherwise
+ *
+ * The generation is the number of top-level rules which have been
+ * completely parsed.  Rules are added to a stylesheet as soon as the
+ * parser reaches them, so a stylesheet may be used for selection while its
+ * data is still arriving.  A client may poll the generation after each
+ * call to css_stylesheet_append_data() to learn when further rules have
+ * completed, and select styles again.  The rule being parsed when the
+ * generation was retrieved may already be partly visible to selection.
+ */
+css_error css_stylesheet_get_generation(css_stylesheet *sheet,
+		uint32_t *generation)
+{
+	if (sheet == NULL || generation == NULL)
+		return CSS_BADPARM;
+
+	*generation = sheet->generation;
+
+	return CSS_OK;
+}
+
+/**
+ * Determine whether a stylesheet is frozen
+ *
+ * \param sheet   The stylesheet to consider
+ * \param frozen  Pointer to location to receive frozen state
+ * \return CSS_OK on success, appropriate error otherwise
+ */
+css_error css_stylesheet_is_frozen(css_stylesheet *sheet, bool *frozen)
+{
+	if (sheet == NULL || frozen == NULL)
+		return CSS_BADPARM;
+
+	*frozen = sheet->frozen;
+
+	return CSS_OK;
+}
+
 /**
  * Retrieve the language level of a stylesheet
  *
@@ -569,13 +833,18 @@ css_error css_stylesheet_get_disabled(css_stylesheet *sheet, bool *disabled)
  *
  * \param sheet	    The stylesheet to modify
  * \param disabled  The new disabled state
- * \return CSS_OK on success, appropriate error otherwise
+ * \return CSS_OK on success,
+ *	   CSS_INVALID if the stylesheet is frozen,
+ *	   appropriate error otherwise
  */
 css_error css_stylesheet_set_disabled(css_stylesheet *sheet, bool disabled)
 {
 	if (sheet == NULL)
 		return CSS_BADPARM;
 
+	if (sheet->frozen)
+		return CSS_INVALID;
+
 	sheet->disabled = disabled;
 
 	/** \todo needs to trigger some event announcing styles have changed */
@@ -591,7 +860,9 @@ css_error css_stylesheet_set_disabled(css_stylesheet *sheet, bool disabled)
  * \return CSS_OK on success.
  *
  * \note The returned size will not include the size of interned strings
- *	 or imported stylesheets.
+ *	 or imported stylesheets.  Other than for inline styles, it includes
+ *	 exactly the memory held for the stylesheet's rules, selectors and
+ *	 styles, rather than an estimate.
  */
 css_error css_stylesheet_size(css_stylesheet *sheet, size_t *size)
 {
@@ -601,7 +872,15 @@ css_error css_stylesheet_size(css_stylesheet *sheet, size_t *size)
 	if (sheet == NULL || size == NULL)
 		return CSS_BADPARM;
 
-	bytes = sheet->size;
+	/* A pool knows exactly what it holds, so needs no estimate */
+	if (sheet->pool != NULL) {
+		bytes = sizeof(css_stylesheet) + strlen(sheet->url) +
+				css__pool_size(sheet->pool);
+		if (sheet->title != NULL)
+			bytes += strlen(sheet->title);
+	} else {
+		bytes = sheet->size;
+	}
 
 	/* Selector hash */
 	if (sheet->selectors != NULL) {
@@ -651,14 +930,16 @@ css_error css__stylesheet_style_create(css_stylesheet *sheet, css_style **style)
 		return CSS_OK;
 	}
 
-	s = malloc(sizeof(css_style));
+	s = css__pool_alloc(sheet->pool, sizeof(css_style));
 	if (s == NULL)
 		return CSS_NOMEM;
 
-	s->bytecode = malloc(sizeof(css_code_t) * CSS_STYLE_DEFAULT_SIZE);
+	s->bytecode = css__pool_alloc(sheet->pool,
+			sizeof(css_code_t) * CSS_STYLE_DEFAULT_SIZE);
 
 	if (s->bytecode == NULL) {
-		free(s); /* do not leak */
+		/* do not leak */
+		css__pool_free(sheet->pool, s, sizeof(css_style));
 
 		return CSS_NOMEM;
 	}
@@ -684,7 +965,9 @@ css_error css__stylesheet_merge_style(css_style *target, css_style *style)
 	if (newcode_len > target->allocated) {
 		newcode_len += CSS_STYLE_DEFAULT_SIZE - 1;
 		newcode_len &= ~(CSS_STYLE_DEFAULT_SIZE - 1);
-		newcode = realloc(target->bytecode,
+		newcode = css__pool_realloc(target->sheet->pool,
+				target->bytecode,
+				target->allocated * sizeof(css_code_t),
 				newcode_len * sizeof(css_code_t));
 
 		if (newcode == NULL)
@@ -732,7 +1015,9 @@ css_error css__stylesheet_style_append(css_style *style, css_code_t css_code)
 		/* space not available to append, extend allocation */
 		css_code_t *newcode;
 		uint32_t newcode_len = style->allocated * 2;
-		newcode = realloc(style->bytecode,
+		newcode = css__pool_realloc(style->sheet->pool,
+				style->bytecode,
+				sizeof(css_code_t) * style->allocated,
 				sizeof(css_code_t) * newcode_len);
 		if (newcode == NULL)
 			return CSS_NOMEM;
@@ -766,13 +1051,17 @@ css_error css__stylesheet_style_destroy(css_style *style)
 		sheet->cached_style = style;
 		style->used = 0;
 	} else if (sheet->cached_style->allocated < style->allocated) {
-		free(sheet->cached_style->bytecode);
-		free(sheet->cached_style);
+		css__pool_free(sheet->pool, sheet->cached_style->bytecode,
+				sheet->cached_style->allocated *
+				sizeof(css_code_t));
+		css__pool_free(sheet->pool, sheet->cached_style,
+				sizeof(css_style));
 		sheet->cached_style = style;
 		style->used = 0;
 	} else {
-		free(style->bytecode);
-		free(style);
+		css__pool_free(sheet->pool, style->bytecode,
+				style->allocated * sizeof(css_code_t));
+		css__pool_free(sheet->pool, style, sizeof(css_style));
 	}
 
 	return CSS_OK;
@@ -797,7 +1086,7 @@ css_error css__stylesheet_selector_create(css_stylesheet *sheet,
 			selector == NULL)
 		return CSS_BADPARM;
 
-	sel = malloc(sizeof(css_selector));
+	sel = css__pool_alloc(sheet->pool, sizeof(css_selector));
 	if (sel == NULL)
 		return CSS_NOMEM;
 
@@ -842,6 +1131,7 @@ css_error css__stylesheet_selector_destroy(css_stylesheet *sheet,
 {
 	css_selector *c, *d;
 	css_selector_detail *detail;
+	size_t n_details;
 
 	if (sheet == NULL || selector == NULL)
 		return CSS_BADPARM;
@@ -853,6 +1143,7 @@ css_error css__stylesheet_selector_destroy(css_stylesheet *sheet,
 	for (c = selector->combinator; c != NULL; c = d) {
 		d = c->combinator;
 
+		n_details = 0;
 		for (detail = &c->data; detail;) {
 			lwc_string_unref(detail->qname.ns);
 			lwc_string_unref(detail->qname.name);
@@ -863,15 +1154,19 @@ css_error css__stylesheet_selector_destroy(css_stylesheet *sheet,
 				lwc_string_unref(detail->value.string);
 			}
 
+			n_details++;
+
 			if (detail->next)
 				detail++;
 			else
 				detail = NULL;
 		}
 
-		free(c);
+		css__pool_free(sheet->pool, c, sizeof(css_selector) +
+				(n_details - 1) * sizeof(css_selector_detail));
 	}
 
+	n_details = 0;
 	for (detail = &selector->data; detail;) {
 		lwc_string_unref(detail->qname.ns);
 		lwc_string_unref(detail->qname.name);
@@ -881,15 +1176,17 @@ css_error css__stylesheet_selector_destroy(css_stylesheet *sheet,
 			lwc_string_unref(detail->value.string);
 		}
 
+		n_details++;
+
 		if (detail->next)
 			detail++;
 		else
 			detail = NULL;
 	}
 
-
 	/* Destroy this selector */
-	free(selector);
+	css__pool_free(sheet->pool, selector, sizeof(css_selector) +
+			(n_details - 1) * sizeof(css_selector_detail));
 
 	return CSS_OK;
 }
@@ -959,7 +1256,10 @@ css_error css__stylesheet_selector_append_specific(css_stylesheet *sheet,
 		num_details++;
 
 	/* Grow selector by one detail block */
-	temp = realloc((*parent), sizeof(css_selector) +
+	temp = css__pool_realloc(sheet->pool, (*parent),
+			sizeof(css_selector) +
+			num_details * sizeof(css_selector_detail),
+			sizeof(css_selector) +
 			(num_details + 1) * sizeof(css_selector_detail));
 	if (temp == NULL)
 		return CSS_NOMEM;
@@ -1059,36 +1359,14 @@ css_error css__stylesheet_rule_create(css_stylesheet *sheet, css_rule_type type,
 		css_rule **rule)
 {
 	css_rule *r;
-	size_t required = 0;
+	size_t required;
 
 	if (sheet == NULL || rule == NULL)
 		return CSS_BADPARM;
 
-	switch (type) {
-	case CSS_RULE_UNKNOWN:
-		required = sizeof(css_rule);
-		break;
-	case CSS_RULE_SELECTOR:
-		required = sizeof(css_rule_selector);
-		break;
-	case CSS_RULE_CHARSET:
-		required = sizeof(css_rule_charset);
-		break;
-	case CSS_RULE_IMPORT:
-		required = sizeof(css_rule_import);
-		break;
-	case CSS_RULE_MEDIA:
-		required = sizeof(css_rule_media);
-		break;
-	case CSS_RULE_FONT_FACE:
-		required = sizeof(css_rule_font_face);
-		break;
-	case CSS_RULE_PAGE:
-		required = sizeof(css_rule_page);
-		break;
-	}
+	required = _rule_struct_size(type);
 
-	r = malloc(required);
+	r = css__pool_alloc(sheet->pool, required);
 	if (r == NULL)
 		return CSS_NOMEM;
 
@@ -1136,7 +1414,8 @@ css_error css__stylesheet_rule_destroy(css_stylesheet *sheet, css_rule *rule)
 		}
 
 		if (s->selectors != NULL)
-			free(s->selectors);
+			css__pool_free(sheet->pool, s->selectors,
+					rule->items * sizeof(css_selector *));
 
 		if (s->style != NULL)
 			css__stylesheet_style_destroy(s->style);
@@ -1206,7 +1485,7 @@ css_error css__stylesheet_rule_destroy(css_stylesheet *sheet, css_rule *rule)
 	}
 
 	/* Destroy rule */
-	free(rule);
+	css__pool_free(sheet->pool, rule, _rule_struct_size(rule->type));
 
 	return CSS_OK;
 }
@@ -1231,7 +1510,8 @@ css_error css__stylesheet_rule_add_selector(css_stylesheet *sheet,
 	/* Ensure rule is a CSS_RULE_SELECTOR */
 	assert(rule->type == CSS_RULE_SELECTOR);
 
-	sels = realloc(r->selectors,
+	sels = css__pool_realloc(sheet->pool, r->selectors,
+			r->base.items * sizeof(css_selector *),
 			(r->base.items + 1) * sizeof(css_selector *));
 	if (sels == NULL)
 		return CSS_NOMEM;
@@ -1433,6 +1713,7 @@ css_error css__stylesheet_add_rule(css_stylesheet *sheet, css_rule *rule,
 
 	/* Add to the sheet's size */
 	sheet->size += _rule_size(rule);
+	sheet->modifications++;
 
 	if (parent != NULL) {
 		css_rule_media *media = (css_rule_media *) parent;
@@ -1496,6 +1777,7 @@ css_error css__stylesheet_remove_rule(css_stylesheet *sheet, css_rule *rule)
 
 	/* Reduce sheet's size */
 	sheet->size -= _rule_size(rule);
+	sheet->modifications++;
 
 	if (rule->next == NULL)
 		sheet->last_rule = rule->prev;
@@ -1638,6 +1920,34 @@ css_error _remove_selectors(css_stylesheet *sheet, css_rule *rule)
 	return CSS_OK;
 }
 
+/**
+ * Determine the size of the structure for a type of rule
+ *
+ * \param type  Type of rule
+ * \return Size in bytes
+ */
+size_t _rule_struct_size(css_rule_type type)
+{
+	switch (type) {
+	case CSS_RULE_UNKNOWN:
+		break;
+	case CSS_RULE_SELECTOR:
+		return sizeof(css_rule_selector);
+	case CSS_RULE_CHARSET:
+		return sizeof(css_rule_charset);
+	case CSS_RULE_IMPORT:
+		return sizeof(css_rule_import);
+	case CSS_RULE_MEDIA:
+		return sizeof(css_rule_media);
+	case CSS_RULE_FONT_FACE:
+		return sizeof(css_rule_font_face);
+	case CSS_RULE_PAGE:
+		return sizeof(css_rule_page);
+	}
+
+	return sizeof(css_rule);
+}
+
 /**
  * Calculate the size of a rule
  *
@@ -1721,3 +2031,35 @@ size_t _rule_size(const css_rule *r)
 
 	return bytes;
 }
+
+/**
+ * Shrink the bytecode of a rule's style to the space it uses
+ *
+ * \param rule  The rule to shrink
+ */
+void _rule_shrink(css_rule *rule)
+{
+	css_style *style;
+	css_code_t *bytecode;
+
+	if (rule->type == CSS_RULE_SELECTOR)
+		style = ((css_rule_selector *) rule)->style;
+	else if (rule->type == CSS_RULE_PAGE)
+		style = ((css_rule_page *) rule)->style;
+	else
+		return;
+
+	/* Pooled bytecode is freed with the pool, and shrinking it would
+	 * only move it to another block */
+	if (style == NULL || style->sheet->pool != NULL ||
+			style->used == 0 || style->used == style->allocated)
+		return;
+
+	/* Failure to shrink is harmless: the style is just left as it is */
+	bytecode = realloc(style->bytecode,
+			style->used * sizeof(css_code_t));
+	if (bytecode != NULL) {
+		style->bytecode = bytecode;
+		style->allocated = style->used;
+	}
+}
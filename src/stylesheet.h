@@ -22,6 +22,7 @@
 #include "parse/parse.h"
 #include "parse/mq.h"
 #include "select/hash.h"
+#include "utils/pool.h"
 
 typedef struct css_rule css_rule;
 typedef struct css_selector css_selector;
@@ -171,6 +172,8 @@ struct css_stylesheet {
 	css_selector_hash *selectors;		/**< Hashtable of selectors */
 
 	uint32_t rule_count;			/**< Number of rules in sheet */
+	uint32_t modifications;			/**< Number of rules added to
+						 * or removed from sheet */
 	css_rule *rule_list;			/**< List of rules in sheet */
 	css_rule *last_rule;			/**< Last rule in list */
 
@@ -214,6 +217,15 @@ struct css_stylesheet {
 						 * length in entries */
 	uint32_t string_vector_c;               /**< The number of string
 						 * vector entries used */
+
+	uint32_t generation;			/**< Number of top-level rules
+						 * completed */
+
+	css_pool *pool;				/**< Pool holding rules, selectors
+						 * and styles, or NULL */
+
+	bool frozen;				/**< Whether sheet is immutable */
+	uint32_t refcnt;			/**< Reference count */
 };
 
 css_error css__stylesheet_style_create(css_stylesheet *sheet,
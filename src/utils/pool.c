@@ -0,0 +1,262 @@
+/*
+ * This file is part of LibCSS
+ * Licensed under the MIT License,
+ *                http://www.opensource.org/licenses/mit-license.php
+ * Copyright 2026 The NetSurf Project
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/pool.h"
+
+/** Granularity, and alignment, of blocks: that of malloc() on common hosts,
+ * which structures declared with _ALIGNED rely upon */
+#define POOL_ALIGN 16
+/** Largest block allocated from a chunk */
+#define POOL_MAX_SMALL 2048
+/** Number of small block free lists */
+#define POOL_N_CLASSES (POOL_MAX_SMALL / POOL_ALIGN)
+/** Size of the first chunk */
+#define POOL_MIN_CHUNK 4096
+/** Size beyond which chunks stop growing */
+#define POOL_MAX_CHUNK 65536
+
+/** Round a size up to a whole number of small block units */
+#define POOL_ROUND(size) \
+	(((size) + POOL_ALIGN - 1) & ~((size_t) POOL_ALIGN - 1))
+/** Offset of the data following a header */
+#define POOL_HEADER_SIZE POOL_ROUND(sizeof(pool_header))
+
+/** Header of a chunk, or of a large block */
+typedef union pool_header {
+	struct {
+		union pool_header *prev;	/**< Previous in list */
+		union pool_header *next;	/**< Next in list */
+		size_t size;			/**< Size, including header */
+	} link;
+	long double align_d;			/**< Force alignment */
+	uint64_t align_u;			/**< Force alignment */
+} pool_header;
+
+/** A free small block */
+typedef struct pool_free_block {
+	struct pool_free_block *next;		/**< Next free block */
+} pool_free_block;
+
+struct css_pool {
+	pool_header *chunks;			/**< Chunks, newest first */
+	pool_header *large;			/**< Large blocks */
+
+	uint8_t *next;				/**< Next byte to allocate */
+	size_t remaining;			/**< Bytes left in chunk */
+
+	size_t footprint;			/**< Bytes held */
+
+	/** Free small blocks, by size */
+	pool_free_block *free[POOL_N_CLASSES];
+};
+
+/**
+ * Put a small block on its free list
+ *
+ * \param pool  The pool the block belongs to
+ * \param ptr   The block
+ * \param size  Size of the block, rounded
+ */
+static inline void pool_push_free(css_pool *pool, void *ptr, size_t size)
+{
+	pool_free_block *block = ptr;
+	size_t index = size / POOL_ALIGN - 1;
+
+	block->next = pool->free[index];
+	pool->free[index] = block;
+}
+
+/**
+ * Add a new chunk to a pool
+ *
+ * \param pool  The pool to extend
+ * \return true on success, false on memory exhaustion.
+ */
+static bool pool_add_chunk(css_pool *pool)
+{
+	size_t size = POOL_MIN_CHUNK;
+	pool_header *chunk;
+
+	if (pool->chunks != NULL) {
+		size = pool->chunks->link.size * 2;
+		if (size > POOL_MAX_CHUNK)
+			size = POOL_MAX_CHUNK;
+	}
+
+	chunk = malloc(size);
+	if (chunk == NULL)
+		return false;
+
+	/* Keep what is left of the current chunk for later */
+	if (pool->remaining >= POOL_ALIGN)
+		pool_push_free(pool, pool->next, pool->remaining);
+
+	chunk->link.prev = NULL;
+	chunk->link.next = pool->chunks;
+	chunk->link.size = size;
+	pool->chunks = chunk;
+
+	pool->next = (uint8_t *) chunk + POOL_HEADER_SIZE;
+	pool->remaining = size - POOL_HEADER_SIZE;
+	pool->footprint += size;
+
+	return true;
+}
+
+/* Internally exported function, documented in pool.h */
+css_error css__pool_create(css_pool **pool)
+{
+	css_pool *p = calloc(1, sizeof(css_pool));
+
+	if (p == NULL)
+		return CSS_NOMEM;
+
+	p->footprint = sizeof(css_pool);
+
+	*pool = p;
+
+	return CSS_OK;
+}
+
+/* Internally exported function, documented in pool.h */
+void css__pool_destroy(css_pool *pool)
+{
+	pool_header *block, *next;
+
+	if (pool == NULL)
+		return;
+
+	for (block = pool->chunks; block != NULL; block = next) {
+		next = block->link.next;
+		free(block);
+	}
+
+	for (block = pool->large; block != NULL; block = next) {
+		next = block->link.next;
+		free(block);
+	}
+
+	free(pool);
+}
+
+/* Internally exported function, documented in pool.h */
+void *css__pool_alloc(css_pool *pool, size_t size)
+{
+	pool_free_block *block;
+	void *ptr;
+
+	if (pool == NULL)
+		return malloc(size);
+
+	size = (size == 0) ? POOL_ALIGN : POOL_ROUND(size);
+
+	if (size > POOL_MAX_SMALL) {
+		pool_header *large = malloc(POOL_HEADER_SIZE + size);
+
+		if (large == NULL)
+			return NULL;
+
+		large->link.prev = NULL;
+		large->link.next = pool->large;
+		large->link.size = POOL_HEADER_SIZE + size;
+		if (pool->large != NULL)
+			pool->large->link.prev = large;
+		pool->large = large;
+
+		pool->footprint += large->link.size;
+
+		return (uint8_t *) large + POOL_HEADER_SIZE;
+	}
+
+	block = pool->free[size / POOL_ALIGN - 1];
+	if (block != NULL) {
+		pool->free[size / POOL_ALIGN - 1] = block->next;
+		return block;
+	}
+
+	if (pool->remaining < size && pool_add_chunk(pool) == false)
+		return NULL;
+
+	ptr = pool->next;
+	pool->next += size;
+	pool->remaining -= size;
+
+	return ptr;
+}
+
+/* Internally exported function, documented in pool.h */
+void *css__pool_realloc(css_pool *pool, void *ptr,
+		size_t old_size, size_t size)
+{
+	void *block;
+
+	if (pool == NULL)
+		return realloc(ptr, size);
+
+	if (ptr == NULL)
+		return css__pool_alloc(pool, size);
+
+	/* Small blocks are rounded, so there may be room already */
+	if (old_size <= POOL_MAX_SMALL && size <= POOL_MAX_SMALL &&
+			size != 0 && POOL_ROUND(old_size) == POOL_ROUND(size))
+		return ptr;
+
+	block = css__pool_alloc(pool, size);
+	if (block == NULL)
+		return NULL;
+
+	memcpy(block, ptr, (old_size < size) ? old_size : size);
+
+	css__pool_free(pool, ptr, old_size);
+
+	return block;
+}
+
+/* Internally exported function, documented in pool.h */
+void css__pool_free(css_pool *pool, void *ptr, size_t size)
+{
+	if (pool == NULL) {
+		free(ptr);
+		return;
+	}
+
+	if (ptr == NULL)
+		return;
+
+	size = (size == 0) ? POOL_ALIGN : POOL_ROUND(size);
+
+	if (size > POOL_MAX_SMALL) {
+		pool_header *large = (pool_header *)
+				((uint8_t *) ptr - POOL_HEADER_SIZE);
+
+		if (large->link.prev != NULL)
+			large->link.prev->link.next = large->link.next;
+		else
+			pool->large = large->link.next;
+
+		if (large->link.next != NULL)
+			large->link.next->link.prev = large->link.prev;
+
+		pool->footprint -= large->link.size;
+
+		free(large);
+		return;
+	}
+
+	pool_push_free(pool, ptr, size);
+}
+
+/* Internally exported function, documented in pool.h */
+size_t css__pool_size(const css_pool *pool)
+{
+	return pool->footprint;
+}
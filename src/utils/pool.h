@@ -0,0 +1,84 @@
+/*
+ * This file is part of LibCSS
+ * Licensed under the MIT License,
+ *                http://www.opensource.org/licenses/mit-license.php
+ * Copyright 2026 The NetSurf Project
+ */
+
+#ifndef css_utils_pool_h_
+#define css_utils_pool_h_
+
+#include <stddef.h>
+
+#include <libcss/errors.h>
+
+/**
+ * Memory pool
+ *
+ * A pool owns every block allocated from it, and frees them all at once
+ * when it is destroyed.  Small blocks are carved from large chunks; freed
+ * small blocks are kept on per-size free lists for reuse, and so are
+ * never returned to the system before the pool is destroyed.
+ *
+ * Blocks are freed and reallocated with their size, so that the pool
+ * need not store it.  Every function accepts a NULL pool, in which case
+ * it uses the system allocator.
+ */
+typedef struct css_pool css_pool;
+
+/**
+ * Create a memory pool
+ *
+ * \param pool  Updated to the new pool on success
+ * \return CSS_OK on success, CSS_NOMEM on memory exhaustion.
+ */
+css_error css__pool_create(css_pool **pool);
+
+/**
+ * Destroy a memory pool, and every block allocated from it
+ *
+ * \param pool  The pool to destroy, or NULL
+ */
+void css__pool_destroy(css_pool *pool);
+
+/**
+ * Allocate a block from a memory pool
+ *
+ * \param pool  The pool to allocate from, or NULL
+ * \param size  Size of block, in bytes
+ * \return Pointer to the block, or NULL on memory exhaustion.
+ */
+void *css__pool_alloc(css_pool *pool, size_t size);
+
+/**
+ * Resize a block allocated from a memory pool
+ *
+ * \param pool      The pool the block belongs to, or NULL
+ * \param ptr       The block to resize, or NULL to allocate a new one
+ * \param old_size  Size of the block, in bytes
+ * \param size      New size of the block, in bytes
+ * \return Pointer to the resized block, or NULL on memory exhaustion, in
+ *         which case the original block is unchanged.
+ */
+void *css__pool_realloc(css_pool *pool, void *ptr,
+		size_t old_size, size_t size);
+
+/**
+ * Free a block allocated from a memory pool
+ *
+ * \param pool  The pool the block belongs to, or NULL
+ * \param ptr   The block to free, or NULL
+ * \param size  Size of the block, in bytes
+ */
+void css__pool_free(css_pool *pool, void *ptr, size_t size);
+
+/**
+ * Get the memory held by a pool
+ *
+ * \param pool  The pool to consider
+ * \return The number of bytes the pool holds from the system allocator,
+ *         including that of blocks which are free for reuse.
+ */
+size_t css__pool_size(const css_pool *pool);
+
+#endif
@@ -0,0 +1,1084 @@
+/*
+ * Selection and parsing micro-benchmarks
+ *
+ * Usage: bench [<stylesheet> ...]
+ *
+ * A stylesheet is generated to suit a synthetic document tree, and its
+ * parsing throughput, selection throughput and style composition
+ * throughput are measured.  Each stylesheet named on the command line is
+ * then measured in the same way, against the same document tree.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <time.h>
+
+#if defined(__GLIBC__) && \
+		(__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#include <malloc.h>
+#define BENCH_HEAP_USAGE
+#endif
+
+#include <libcss/libcss.h>
+
+#include "testutils.h"
+
+/** Number of times each stylesheet is parsed */
+#define PARSE_ITERATIONS (20)
+/** Number of times styles are selected for the whole tree */
+#define SELECT_ITERATIONS (10)
+
+/** Number of nodes in the synthetic document tree */
+#define TREE_NODES (20000)
+/** Maximum depth of the synthetic document tree */
+#define TREE_DEPTH (14)
+/** Number of distinct class names used in the tree */
+#define TREE_CLASSES (64)
+/** Number of distinct ids used in the tree */
+#define TREE_IDS (256)
+
+/** Number of rules in the generated stylesheet */
+#define SHEET_RULES (2000)
+
+typedef struct node {
+	lwc_string *name;
+	lwc_string *id;
+
+	uint32_t n_classes;
+	lwc_string *classes[3];
+
+	css_select_results *sr;
+	void *libcss_node_data;
+
+	struct node *parent;
+	struct node *next;
+	struct node *prev;
+	struct node *children;
+	struct node *last_child;
+} node;
+
+typedef struct bench_ctx {
+	node *tree;
+	uint32_t n_nodes;
+
+	lwc_string *names[12];
+	lwc_string *classes[TREE_CLASSES];
+	lwc_string *ids[TREE_IDS];
+
+	css_media media;
+
+	/* Statistics for a selection run */
+	uint64_t selected;
+	uint64_t composed;
+} bench_ctx;
+
+static const char *element_names[12] = {
+	"div", "p", "span", "a", "ul", "li",
+	"table", "tr", "td", "h1", "h2", "em"
+};
+
+static const char *properties[] = {
+	"color: #123456",
+	"display: block",
+	"margin: 1px 2em",
+	"padding-left: 3%",
+	"font-size: 1.2em",
+	"border: 1px solid red",
+	"background-color: rgba(10, 20, 30, 0.5)",
+	"width: calc(100% - 2em)",
+	"line-height: 1.5",
+	"text-decoration: underline"
+};
+
+#define N_PROPERTIES (sizeof(properties) / sizeof(properties[0]))
+
+/* The only elements sibling and pseudo class selectors apply to, so that
+ * nodes with other names may share styles */
+static const char *structural_names[3] = { "li", "tr", "td" };
+
+static uint32_t random_state = 1;
+
+/* Small deterministic generator, so every run sees the same corpus */
+static uint32_t bench_random(uint32_t range)
+{
+	random_state = random_state * 1103515245 + 12345;
+
+	return ((random_state >> 16) & 0x7fff) % range;
+}
+
+static double bench_seconds(clock_t start)
+{
+	return (double) (clock() - start) / CLOCKS_PER_SEC;
+}
+
+static size_t bench_heap_usage(void)
+{
+#ifdef BENCH_HEAP_USAGE
+	return mallinfo2().uordblks;
+#else
+	return 0;
+#endif
+}
+
+static css_error node_name(void *pw, void *n, css_qname *qname)
+{
+	node *node = n;
+
+	UNUSED(pw);
+
+	qname->ns = NULL;
+	qname->name = lwc_string_ref(node->name);
+
+	return CSS_OK;
+}
+
+static css_error node_classes(void *pw, void *n,
+		lwc_string ***classes, uint32_t *n_classes)
+{
+	node *node = n;
+	uint32_t i;
+
+	UNUSED(pw);
+
+	for (i = 0; i < node->n_classes; i++)
+		lwc_string_ref(node->classes[i]);
+
+	*classes = node->classes;
+	*n_classes = node->n_classes;
+
+	return CSS_OK;
+}
+
+static css_error node_id(void *pw, void *n, lwc_string **id)
+{
+	node *node = n;
+
+	UNUSED(pw);
+
+	*id = (node->id != NULL) ? lwc_string_ref(node->id) : NULL;
+
+	return CSS_OK;
+}
+
+static bool node_is_named(const node *node, const css_qname *qname)
+{
+	bool match = false;
+
+	return lwc_string_caseless_isequal(node->name, qname->name,
+			&match) == lwc_error_ok && match;
+}
+
+static css_error named_ancestor_node(void *pw, void *n,
+		const css_qname *qname, void **ancestor)
+{
+	node *node = n;
+
+	UNUSED(pw);
+
+	for (node = node->parent; node != NULL; node = node->parent) {
+		if (node_is_named(node, qname))
+			break;
+	}
+
+	*ancestor = node;
+
+	return CSS_OK;
+}
+
+static css_error named_parent_node(void *pw, void *n,
+		const css_qname *qname, void **parent)
+{
+	node *node = n;
+
+	UNUSED(pw);
+
+	*parent = NULL;
+	if (node->parent != NULL && node_is_named(node->parent, qname))
+		*parent = node->parent;
+
+	return CSS_OK;
+}
+
+static css_error named_sibling_node(void *pw, void *n,
+		const css_qname *qname, void **sibling)
+{
+	node *node = n;
+
+	UNUSED(pw);
+
+	*sibling = NULL;
+	if (node->prev != NULL && node_is_named(node->prev, qname))
+		*sibling = node->prev;
+
+	return CSS_OK;
+}
+
+static css_error named_generic_sibling_node(void *pw, void *n,
+		const css_qname *qname, void **sibling)
+{
+	node *node = n;
+
+	UNUSED(pw);
+
+	for (node = node->prev; node != NULL; node = node->prev) {
+		if (node_is_named(node, qname))
+			break;
+	}
+
+	*sibling = node;
+
+	return CSS_OK;
+}
+
+static css_error parent_node(void *pw, void *n, void **parent)
+{
+	node *node = n;
+
+	UNUSED(pw);
+
+	*parent = node->parent;
+
+	return CSS_OK;
+}
+
+static css_error sibling_node(void *pw, void *n, void **sibling)
+{
+	node *node = n;
+
+	UNUSED(pw);
+
+	*sibling = node->prev;
+
+	return CSS_OK;
+}
+
+static css_error node_has_name(void *pw, void *n,
+		const css_qname *qname, bool *match)
+{
+	node *node = n;
+
+	UNUSED(pw);
+
+	*match = node_is_named(node, qname);
+
+	return CSS_OK;
+}
+
+static css_error node_has_class(void *pw, void *n,
+		lwc_string *name, bool *match)
+{
+	node *node = n;
+	uint32_t i;
+
+	UNUSED(pw);
+
+	*match = false;
+	for (i = 0; i < node->n_classes; i++) {
+		if (node->classes[i] == name) {
+			*match = true;
+			break;
+		}
+	}
+
+	return CSS_OK;
+}
+
+static css_error node_has_id(void *pw, void *n,
+		lwc_string *name, bool *match)
+{
+	node *node = n;
+
+	UNUSED(pw);
+
+	*match = (node->id == name);
+
+	return CSS_OK;
+}
+
+static css_error node_has_attribute(void *pw, void *n,
+		const css_qname *qname, bool *match)
+{
+	UNUSED(pw);
+	UNUSED(n);
+	UNUSED(qname);
+
+	*match = false;
+
+	return CSS_OK;
+}
+
+static css_error node_has_attribute_value(void *pw, void *n,
+		const css_qname *qname, lwc_string *value, bool *match)
+{
+	UNUSED(pw);
+	UNUSED(n);
+	UNUSED(qname);
+	UNUSED(value);
+
+	*match = false;
+
+	return CSS_OK;
+}
+
+static css_error node_is_root(void *pw, void *n, bool *match)
+{
+	node *node = n;
+
+	UNUSED(pw);
+
+	*match = (node->parent == NULL);
+
+	return CSS_OK;
+}
+
+static css_error node_count_siblings(void *pw, void *n,
+		bool same_name, bool after, int32_t *count)
+{
+	node *node = n;
+	struct node *s = after ? node->next : node->prev;
+	int32_t cnt = 0;
+
+	UNUSED(pw);
+
+	for (; s != NULL; s = after ? s->next : s->prev) {
+		if (same_name == false || s->name == node->name)
+			cnt++;
+	}
+
+	*count = cnt;
+
+	return CSS_OK;
+}
+
+static css_error node_is_empty(void *pw, void *n, bool *match)
+{
+	node *node = n;
+
+	UNUSED(pw);
+
+	*match = (node->children == NULL);
+
+	return CSS_OK;
+}
+
+static css_error node_is_state(void *pw, void *n, bool *match)
+{
+	UNUSED(pw);
+	UNUSED(n);
+
+	*match = false;
+
+	return CSS_OK;
+}
+
+static css_error node_is_lang(void *pw, void *n,
+		lwc_string *lang, bool *match)
+{
+	UNUSED(pw);
+	UNUSED(n);
+	UNUSED(lang);
+
+	*match = false;
+
+	return CSS_OK;
+}
+
+static css_error node_presentational_hint(void *pw, void *node,
+		uint32_t *nhints, css_hint **hints)
+{
+	UNUSED(pw);
+	UNUSED(node);
+
+	*nhints = 0;
+	*hints = NULL;
+
+	return CSS_OK;
+}
+
+static css_error ua_default_for_property(void *pw, uint32_t property,
+		css_hint *hint)
+{
+	UNUSED(pw);
+
+	if (property == CSS_PROP_COLOR) {
+		hint->data.color = 0xff000000;
+		hint->status = CSS_COLOR_COLOR;
+	} else if (property == CSS_PROP_FONT_FAMILY) {
+		hint->data.strings = NULL;
+		hint->status = CSS_FONT_FAMILY_SANS_SERIF;
+	} else if (property == CSS_PROP_QUOTES) {
+		hint->data.strings = NULL;
+		hint->status = CSS_QUOTES_NONE;
+	} else if (property == CSS_PROP_VOICE_FAMILY) {
+		hint->data.strings = NULL;
+		hint->status = 0;
+	} else {
+		return CSS_INVALID;
+	}
+
+	return CSS_OK;
+}
+
+static css_error set_libcss_node_data(void *pw, void *n,
+		void *libcss_node_data)
+{
+	node *node = n;
+
+	UNUSED(pw);
+
+	node->libcss_node_data = libcss_node_data;
+
+	return CSS_OK;
+}
+
+static css_error get_libcss_node_data(void *pw, void *n,
+		void **libcss_node_data)
+{
+	node *node = n;
+
+	UNUSED(pw);
+
+	*libcss_node_data = node->libcss_node_data;
+
+	return CSS_OK;
+}
+
+static css_unit_ctx unit_ctx = {
+	.font_size_default = 16 * (1 << CSS_RADIX_POINT),
+	.device_dpi = 96 * (1 << CSS_RADIX_POINT),
+};
+
+static css_select_handler select_handler = {
+	CSS_SELECT_HANDLER_VERSION_1,
+
+	node_name,
+	node_classes,
+	node_id,
+	named_ancestor_node,
+	named_parent_node,
+	named_sibling_node,
+	named_generic_sibling_node,
+	parent_node,
+	sibling_node,
+	node_has_name,
+	node_has_class,
+	node_has_id,
+	node_has_attribute,
+	node_has_attribute_value,
+	node_has_attribute_value,
+	node_has_attribute_value,
+	node_has_attribute_value,
+	node_has_attribute_value,
+	node_has_attribute_value,
+	node_is_root,
+	node_count_siblings,
+	node_is_empty,
+	node_is_state,
+	node_is_state,
+	node_is_state,
+	node_is_state,
+	node_is_state,
+	node_is_state,
+	node_is_state,
+	node_is_state,
+	node_is_state,
+	node_is_lang,
+	node_presentational_hint,
+	ua_default_for_property,
+
+	set_libcss_node_data,
+	get_libcss_node_data,
+};
+
+static css_error resolve_url(void *pw,
+		const char *base, lwc_string *rel, lwc_string **abs)
+{
+	UNUSED(pw);
+	UNUSED(base);
+
+	*abs = lwc_string_ref(rel);
+
+	return CSS_OK;
+}
+
+static lwc_string *bench_intern(const char *s)
+{
+	lwc_string *str;
+
+	assert(lwc_intern_string(s, strlen(s), &str) == lwc_error_ok);
+
+	return str;
+}
+
+static node *bench_create_node(bench_ctx *ctx, node *parent)
+{
+	node *n = calloc(1, sizeof(node));
+	uint32_t i;
+
+	assert(n != NULL);
+
+	if (parent != NULL && parent->last_child != NULL &&
+			bench_random(2) == 0) {
+		/* Repeat the previous sibling, as in lists and tables */
+		node *prev = parent->last_child;
+
+		n->name = lwc_string_ref(prev->name);
+		n->n_classes = prev->n_classes;
+		for (i = 0; i < n->n_classes; i++)
+			n->classes[i] = lwc_string_ref(prev->classes[i]);
+	} else {
+		n->name = lwc_string_ref(ctx->names[bench_random(12)]);
+
+		if (bench_random(8) == 0) {
+			n->id = lwc_string_ref(
+					ctx->ids[bench_random(TREE_IDS)]);
+		}
+
+		n->n_classes = bench_random(4);
+		for (i = 0; i < n->n_classes; i++) {
+			n->classes[i] = lwc_string_ref(ctx->classes[
+					bench_random(TREE_CLASSES)]);
+		}
+	}
+
+	n->parent = parent;
+	if (parent != NULL) {
+		n->prev = parent->last_child;
+		if (parent->last_child != NULL)
+			parent->last_child->next = n;
+		else
+			parent->children = n;
+		parent->last_child = n;
+	}
+
+	ctx->n_nodes++;
+
+	return n;
+}
+
+static void bench_create_tree(bench_ctx *ctx)
+{
+	node *stack[TREE_DEPTH];
+	uint32_t depth = 1;
+	uint32_t i;
+
+	for (i = 0; i < 12; i++)
+		ctx->names[i] = bench_intern(element_names[i]);
+
+	for (i = 0; i < TREE_CLASSES; i++) {
+		char buf[16];
+		snprintf(buf, sizeof buf, "c%"PRIu32, i);
+		ctx->classes[i] = bench_intern(buf);
+	}
+
+	for (i = 0; i < TREE_IDS; i++) {
+		char buf[16];
+		snprintf(buf, sizeof buf, "i%"PRIu32, i);
+		ctx->ids[i] = bench_intern(buf);
+	}
+
+	ctx->tree = stack[0] = bench_create_node(ctx, NULL);
+
+	/* Each new node is a child of the previous one, or of one of its
+	 * ancestors, giving a document ordered tree of bounded depth. */
+	while (ctx->n_nodes < TREE_NODES) {
+		node *n;
+
+		if (depth > 1 && (depth == TREE_DEPTH || bench_random(3) == 0))
+			depth -= 1 + bench_random(depth - 1);
+
+		n = bench_create_node(ctx, stack[depth - 1]);
+		stack[depth++] = n;
+	}
+}
+
+static void bench_reset_tree(node *root)
+{
+	node *n;
+
+	for (n = root->children; n != NULL; n = n->next)
+		bench_reset_tree(n);
+
+	if (root->sr != NULL) {
+		css_select_results_destroy(root->sr);
+		root->sr = NULL;
+	}
+
+	if (root->libcss_node_data != NULL) {
+		css_libcss_node_data_handler(&select_handler, CSS_NODE_DELETED,
+				NULL, root, NULL, root->libcss_node_data);
+		root->libcss_node_data = NULL;
+	}
+}
+
+static void bench_destroy_tree(node *root)
+{
+	node *n, *next;
+	uint32_t i;
+
+	for (n = root->children; n != NULL; n = next) {
+		next = n->next;
+		bench_destroy_tree(n);
+	}
+
+	if (root->sr != NULL)
+		css_select_results_destroy(root->sr);
+
+	if (root->libcss_node_data != NULL) {
+		css_libcss_node_data_handler(&select_handler, CSS_NODE_DELETED,
+				NULL, root, NULL, root->libcss_node_data);
+	}
+
+	for (i = 0; i < root->n_classes; i++)
+		lwc_string_unref(root->classes[i]);
+	lwc_string_unref(root->id);
+	lwc_string_unref(root->name);
+
+	free(root);
+}
+
+static void bench_destroy_ctx(bench_ctx *ctx)
+{
+	uint32_t i;
+
+	bench_destroy_tree(ctx->tree);
+
+	for (i = 0; i < 12; i++)
+		lwc_string_unref(ctx->names[i]);
+	for (i = 0; i < TREE_CLASSES; i++)
+		lwc_string_unref(ctx->classes[i]);
+	for (i = 0; i < TREE_IDS; i++)
+		lwc_string_unref(ctx->ids[i]);
+}
+
+/* Append formatted text to a growing buffer */
+static void bench_append(char **buf, size_t *len, size_t *alloc,
+		const char *text)
+{
+	size_t n = strlen(text);
+
+	if (*len + n + 1 > *alloc) {
+		*alloc = (*alloc + n + 1) * 2;
+		*buf = realloc(*buf, *alloc);
+		assert(*buf != NULL);
+	}
+
+	memcpy(*buf + *len, text, n + 1);
+	*len += n;
+}
+
+static char *bench_generate_sheet(size_t *len)
+{
+	size_t alloc = 0;
+	char *buf = NULL;
+	uint32_t i;
+
+	*len = 0;
+
+	for (i = 0; i < SHEET_RULES; i++) {
+		const char *tag = element_names[bench_random(12)];
+		const char *tag2 = element_names[bench_random(12)];
+		uint32_t c = bench_random(TREE_CLASSES);
+		uint32_t c2 = bench_random(TREE_CLASSES);
+		char rule[256];
+
+		switch (bench_random(8)) {
+		case 0:
+			snprintf(rule, sizeof rule, ".c%"PRIu32, c);
+			break;
+		case 1:
+			snprintf(rule, sizeof rule, "%s.c%"PRIu32, tag, c);
+			break;
+		case 2:
+			snprintf(rule, sizeof rule, ".c%"PRIu32" .c%"PRIu32,
+					c, c2);
+			break;
+		case 3:
+			snprintf(rule, sizeof rule, "#i%"PRIu32,
+					bench_random(TREE_IDS));
+			break;
+		case 4:
+			snprintf(rule, sizeof rule, "%s > %s", tag, tag2);
+			break;
+		case 5:
+			snprintf(rule, sizeof rule, ".c%"PRIu32" + %s",
+					c, structural_names[bench_random(3)]);
+			break;
+		case 6:
+			snprintf(rule, sizeof rule, "%s %s:first-child",
+					tag, structural_names[bench_random(3)]);
+			break;
+		default:
+			snprintf(rule, sizeof rule, "%s .c%"PRIu32" %s",
+					tag, c, tag2);
+			break;
+		}
+
+		bench_append(&buf, len, &alloc, rule);
+		bench_append(&buf, len, &alloc, " { ");
+		bench_append(&buf, len, &alloc,
+				properties[bench_random(N_PROPERTIES)]);
+		bench_append(&buf, len, &alloc, "; }\n");
+	}
+
+	return buf;
+}
+
+static css_stylesheet *bench_parse(const char *url,
+		const uint8_t *data, size_t len, bool in_place)
+{
+	css_stylesheet_params params;
+	css_stylesheet *sheet;
+	css_error error;
+
+	params.params_version = CSS_STYLESHEET_PARAMS_VERSION_1;
+	params.level = CSS_LEVEL_21;
+	params.charset = "UTF-8";
+	params.url = url;
+	params.title = NULL;
+	params.allow_quirks = false;
+	params.inline_style = false;
+	params.resolve = resolve_url;
+	params.resolve_pw = NULL;
+	params.import = NULL;
+	params.import_pw = NULL;
+	params.color = NULL;
+	params.color_pw = NULL;
+	params.font = NULL;
+	params.font_pw = NULL;
+
+	assert(css_stylesheet_create(&params, &sheet) == CSS_OK);
+
+	if (in_place) {
+		error = css_stylesheet_parse_buffer(sheet, data, len);
+		assert(error == CSS_OK || error == CSS_IMPORTS_PENDING);
+
+		return sheet;
+	}
+
+	error = css_stylesheet_append_data(sheet, data, len);
+	assert(error == CSS_OK || error == CSS_NEEDDATA);
+
+	error = css_stylesheet_data_done(sheet);
+	assert(error == CSS_OK || error == CSS_IMPORTS_PENDING);
+
+	return sheet;
+}
+
+static void bench_select_tree(css_select_ctx *select, bench_ctx *ctx,
+		node *n)
+{
+	css_select_results *sr;
+	node *child;
+
+	assert(css_select_style(select, n, &unit_ctx, &ctx->media, NULL,
+			&select_handler, ctx, &sr) == CSS_OK);
+	ctx->selected++;
+
+	if (n->parent != NULL) {
+		css_computed_style *composed;
+
+		assert(css_computed_style_compose(
+				n->parent->sr->styles[CSS_PSEUDO_ELEMENT_NONE],
+				sr->styles[CSS_PSEUDO_ELEMENT_NONE],
+				&unit_ctx, &composed) == CSS_OK);
+		css_computed_style_destroy(
+				sr->styles[CSS_PSEUDO_ELEMENT_NONE]);
+		sr->styles[CSS_PSEUDO_ELEMENT_NONE] = composed;
+	}
+
+	n->sr = sr;
+
+	if (n->parent == NULL)
+		unit_ctx.root_style = sr->styles[CSS_PSEUDO_ELEMENT_NONE];
+
+	for (child = n->children; child != NULL; child = child->next)
+		bench_select_tree(select, ctx, child);
+}
+
+static css_error first_child_node(void *pw, void *n, void **child)
+{
+	UNUSED(pw);
+
+	*child = ((node *) n)->children;
+
+	return CSS_OK;
+}
+
+static css_error next_sibling_node(void *pw, void *n, void **sibling)
+{
+	UNUSED(pw);
+
+	*sibling = ((node *) n)->next;
+
+	return CSS_OK;
+}
+
+static css_error node_inline_style(void *pw, void *n,
+		const css_stylesheet **inline_style)
+{
+	UNUSED(pw);
+	UNUSED(n);
+
+	*inline_style = NULL;
+
+	return CSS_OK;
+}
+
+static css_error node_selected(void *pw, void *n, css_select_results *sr)
+{
+	bench_ctx *ctx = pw;
+	node *node = n;
+
+	ctx->selected++;
+
+	if (node->parent != NULL) {
+		css_computed_style *composed;
+
+		assert(css_computed_style_compose(
+				node->parent->sr->styles[
+					CSS_PSEUDO_ELEMENT_NONE],
+				sr->styles[CSS_PSEUDO_ELEMENT_NONE],
+				&unit_ctx, &composed) == CSS_OK);
+		css_computed_style_destroy(
+				sr->styles[CSS_PSEUDO_ELEMENT_NONE]);
+		sr->styles[CSS_PSEUDO_ELEMENT_NONE] = composed;
+	}
+
+	node->sr = sr;
+
+	if (node->parent == NULL)
+		unit_ctx.root_style = sr->styles[CSS_PSEUDO_ELEMENT_NONE];
+
+	return CSS_OK;
+}
+
+static css_select_subtree_handler subtree_handler = {
+	CSS_SELECT_SUBTREE_HANDLER_VERSION_1,
+
+	first_child_node,
+	next_sibling_node,
+	node_inline_style,
+	node_selected,
+};
+
+static void bench_compose_tree(bench_ctx *ctx, css_compose_ctx *compose,
+		node *n)
+{
+	node *child;
+
+	for (child = n->children; child != NULL; child = child->next) {
+		css_computed_style *composed;
+
+		if (compose != NULL) {
+			assert(css_computed_style_compose_ctx(compose,
+					n->sr->styles[CSS_PSEUDO_ELEMENT_NONE],
+					child->sr->styles[
+						CSS_PSEUDO_ELEMENT_NONE],
+					&unit_ctx, &composed) == CSS_OK);
+		} else {
+			assert(css_computed_style_compose(
+					n->sr->styles[CSS_PSEUDO_ELEMENT_NONE],
+					child->sr->styles[
+						CSS_PSEUDO_ELEMENT_NONE],
+					&unit_ctx, &composed) == CSS_OK);
+		}
+		css_computed_style_destroy(composed);
+		ctx->composed++;
+
+		bench_compose_tree(ctx, compose, child);
+	}
+}
+
+static void bench_sheet(bench_ctx *ctx, const char *url,
+		const uint8_t *data, size_t len)
+{
+	css_select_arena_stats arena;
+	css_select_bloom_stats bloom;
+	css_select_sharing_stats sharing;
+	css_compose_ctx *compose;
+	css_select_ctx *select;
+	css_stylesheet *sheet;
+	size_t heap, sheet_size;
+	clock_t start;
+	double secs;
+	uint32_t i;
+
+	printf("%s: %zu bytes\n", url, len);
+
+	/* Parsing */
+	start = clock();
+	for (i = 0; i < PARSE_ITERATIONS; i++) {
+		sheet = bench_parse(url, data, len, false);
+		css_stylesheet_destroy(sheet);
+	}
+	secs = bench_seconds(start);
+	printf("  parse:    %.2f MB/s\n", secs > 0 ?
+			(double) len * PARSE_ITERATIONS / secs / 1e6 : 0);
+
+	start = clock();
+	for (i = 0; i < PARSE_ITERATIONS; i++) {
+		sheet = bench_parse(url, data, len, true);
+		css_stylesheet_destroy(sheet);
+	}
+	secs = bench_seconds(start);
+	printf("  in place: %.2f MB/s\n", secs > 0 ?
+			(double) len * PARSE_ITERATIONS / secs / 1e6 : 0);
+
+	heap = bench_heap_usage();
+	sheet = bench_parse(url, data, len, false);
+	assert(css_stylesheet_size(sheet, &sheet_size) == CSS_OK);
+
+	assert(css_select_ctx_create(&select) == CSS_OK);
+	assert(css_select_ctx_append_sheet(select, sheet, CSS_ORIGIN_AUTHOR,
+			NULL) == CSS_OK);
+
+	/* Selection */
+	ctx->selected = 0;
+	start = clock();
+	for (i = 0; i < SELECT_ITERATIONS; i++) {
+		bench_reset_tree(ctx->tree);
+		unit_ctx.root_style = NULL;
+		bench_select_tree(select, ctx, ctx->tree);
+	}
+	secs = bench_seconds(start);
+	printf("  select:   %.0f nodes/s (%"PRIu32" nodes x %d)\n",
+			secs > 0 ? ctx->selected / secs : 0,
+			ctx->n_nodes, SELECT_ITERATIONS);
+
+	/* Selection of the whole tree in one call, sharing among cousins */
+	ctx->selected = 0;
+	start = clock();
+	for (i = 0; i < SELECT_ITERATIONS; i++) {
+		bench_reset_tree(ctx->tree);
+		unit_ctx.root_style = NULL;
+		assert(css_select_style_subtree(select, ctx->tree, &unit_ctx,
+				&ctx->media, &select_handler,
+				&subtree_handler, ctx) == CSS_OK);
+	}
+	secs = bench_seconds(start);
+	printf("  subtree:  %.0f nodes/s\n",
+			secs > 0 ? ctx->selected / secs : 0);
+
+	/* Composition */
+	ctx->composed = 0;
+	start = clock();
+	for (i = 0; i < SELECT_ITERATIONS; i++)
+		bench_compose_tree(ctx, NULL, ctx->tree);
+	secs = bench_seconds(start);
+	printf("  compose:  %.0f styles/s\n",
+			secs > 0 ? ctx->composed / secs : 0);
+
+	/* Composition reusing memory and results across calls */
+	assert(css_compose_ctx_create(&compose) == CSS_OK);
+	ctx->composed = 0;
+	start = clock();
+	for (i = 0; i < SELECT_ITERATIONS; i++)
+		bench_compose_tree(ctx, compose, ctx->tree);
+	secs = bench_seconds(start);
+	printf("  with ctx: %.0f styles/s\n",
+			secs > 0 ? ctx->composed / secs : 0);
+	assert(css_compose_ctx_destroy(compose) == CSS_OK);
+
+	assert(css_select_ctx_get_arena_stats(select, &arena) == CSS_OK);
+	printf("  arena:    %"PRIu32" styles, %.1f%% of %"PRIu64
+			" lookups hit, %.2f probes/lookup\n",
+			arena.styles,
+			arena.lookups > 0 ?
+				100.0 * arena.hits / arena.lookups : 0,
+			arena.lookups,
+			arena.lookups > 0 ?
+				(double) arena.probes / arena.lookups : 0);
+
+	assert(css_select_ctx_get_bloom_stats(select, &bloom) == CSS_OK);
+	printf("  bloom:    %"PRIu32" bits, %.1f%% of %"PRIu64
+			" chains rejected\n",
+			bloom.bits,
+			bloom.tests > 0 ?
+				100.0 * bloom.rejects / bloom.tests : 0,
+			bloom.tests);
+
+	assert(css_select_ctx_get_sharing_stats(select, &sharing) == CSS_OK);
+	printf("  sharing:  %.1f%% of %"PRIu64" nodes shared: %"PRIu64
+			" siblings, %"PRIu64" cousins, %"PRIu64
+			" second cousins\n",
+			sharing.nodes > 0 ? 100.0 * (sharing.siblings +
+				sharing.cousins + sharing.second_cousins) /
+				sharing.nodes : 0,
+			sharing.nodes, sharing.siblings, sharing.cousins,
+			sharing.second_cousins);
+
+	printf("  memory:   %zu bytes of stylesheet", sheet_size);
+#ifdef BENCH_HEAP_USAGE
+	printf(", %zu bytes of heap in use",
+			bench_heap_usage() - heap);
+#else
+	UNUSED(heap);
+#endif
+	printf("\n");
+
+	bench_reset_tree(ctx->tree);
+	unit_ctx.root_style = NULL;
+
+	css_select_ctx_destroy(select);
+	css_stylesheet_destroy(sheet);
+}
+
+static uint8_t *bench_read_file(const char *filename, size_t *len)
+{
+	uint8_t *data;
+	FILE *fp;
+	long size;
+
+	fp = fopen(filename, "rb");
+	if (fp == NULL) {
+		printf("Failed opening %s\n", filename);
+		return NULL;
+	}
+
+	fseek(fp, 0, SEEK_END);
+	size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+
+	data = malloc(size > 0 ? size : 1);
+	assert(data != NULL);
+
+	*len = fread(data, 1, size, fp);
+	assert(*len == (size_t) size);
+
+	fclose(fp);
+
+	return data;
+}
+
+int main(int argc, char **argv)
+{
+	bench_ctx ctx;
+	size_t len;
+	char *generated;
+	int i;
+
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.media.type = CSS_MEDIA_SCREEN;
+
+	bench_create_tree(&ctx);
+
+	generated = bench_generate_sheet(&len);
+	bench_sheet(&ctx, "generated", (const uint8_t *) generated, len);
+	free(generated);
+
+	for (i = 1; i < argc; i++) {
+		uint8_t *data = bench_read_file(argv[i], &len);
+		if (data == NULL)
+			return 1;
+
+		bench_sheet(&ctx, argv[i], data, len);
+		free(data);
+	}
+
+	bench_destroy_ctx(&ctx);
+
+	printf("PASS\n");
+
+	return 0;
+}
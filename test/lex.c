@@ -103,6 +103,7 @@ static void printToken(const css_token *token)
 
 	case CSS_TOKEN_LAST_INTERN_LOWER:
 	case CSS_TOKEN_LAST_INTERN:
+	case CSS_TOKEN_LAST_TEXT:
 		break;
 	}
 
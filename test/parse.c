@@ -30,7 +30,7 @@ static const char *event_names[] = {
 #endif
 
 static css_error event_handler(css_parser_event type,
-		const parserutils_vector *tokens, void *pw)
+		const css_token_vector *tokens, void *pw)
 {
 #if !DUMP_EVENTS
 	UNUSED(type);
@@ -50,7 +50,7 @@ static css_error event_handler(css_parser_event type,
 	}
 
 	do {
-		token = parserutils_vector_iterate(tokens, &ctx);
+		token = css__token_vector_iterate(tokens, &ctx);
 		if (token == NULL)
 			break;
 
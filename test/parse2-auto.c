@@ -33,6 +33,7 @@ static bool handle_line(const char *data, size_t datalen, void *pw);
 static void css__parse_expected(line_ctx *ctx, const char *data, size_t len);
 static void run_test(const uint8_t *data, size_t len,
 		const char *exp, size_t explen);
+static uint32_t count_rules(css_stylesheet *sheet);
 
 static css_error resolve_url(void *pw,
 		const char *base, lwc_string *rel, lwc_string **abs)
@@ -181,6 +182,10 @@ void run_test(const uint8_t *data, size_t len, const char *exp, size_t explen)
 	css_error error;
 	char *buf;
 	size_t buflen;
+	uint8_t *image;
+	size_t imagelen;
+	uint32_t generation, last;
+	size_t i;
 	static int testnum;
 
 	buf = malloc(2 * explen);
@@ -217,6 +222,10 @@ void run_test(const uint8_t *data, size_t len, const char *exp, size_t explen)
 
 	testnum++;
 
+	/* Every top-level rule has completed */
+	assert(css_stylesheet_get_generation(sheet, &generation) == CSS_OK);
+	assert(generation == count_rules(sheet));
+
 	dump_sheet(sheet, buf, &buflen);
 
 	if (2 * explen - buflen != explen ||
@@ -230,8 +239,116 @@ void run_test(const uint8_t *data, size_t len, const char *exp, size_t explen)
 
 	css_stylesheet_destroy(sheet);
 
+	/* Rules must complete progressively as data arrives a byte at a time,
+	 * and the result must be the same */
+	assert(css_stylesheet_create(&params, &sheet) == CSS_OK);
+
+	last = 0;
+	for (i = 0; i < len; i++) {
+		error = css_stylesheet_append_data(sheet, data + i, 1);
+		assert(error == CSS_OK || error == CSS_NEEDDATA);
+
+		assert(css_stylesheet_get_generation(sheet,
+				&generation) == CSS_OK);
+		assert(generation >= last && generation <= count_rules(sheet));
+		last = generation;
+	}
+
+	assert(css_stylesheet_data_done(sheet) == CSS_OK);
+
+	assert(css_stylesheet_get_generation(sheet, &generation) == CSS_OK);
+	assert(generation == count_rules(sheet));
+
+	buflen = 2 * explen;
+	dump_sheet(sheet, buf, &buflen);
+
+	if (2 * explen - buflen != explen ||
+			(explen > 0 && memcmp(buf, exp, explen) != 0)) {
+		printf("Expected (%u):\n%.*s\n",
+				(int) explen, (int) explen, exp);
+		printf("Result progressive (%u):\n%.*s\n",
+			(int) (2 * explen - buflen),
+			(int) (2 * explen - buflen), buf);
+		assert(0 && "Result doesn't match expected");
+	}
+
+	css_stylesheet_destroy(sheet);
+
+	/* Parsing the data in place must give the same result */
+	assert(css_stylesheet_create(&params, &sheet) == CSS_OK);
+
+	assert(css_stylesheet_parse_buffer(sheet, data, len) == CSS_OK);
+
+	buflen = 2 * explen;
+	dump_sheet(sheet, buf, &buflen);
+
+	if (2 * explen - buflen != explen ||
+			(explen > 0 && memcmp(buf, exp, explen) != 0)) {
+		printf("Expected (%u):\n%.*s\n",
+				(int) explen, (int) explen, exp);
+		printf("Result in place (%u):\n%.*s\n",
+			(int) (2 * explen - buflen),
+			(int) (2 * explen - buflen), buf);
+		assert(0 && "Result doesn't match expected");
+	}
+
+	/* As must loading a serialised image of the sheet */
+	assert(css_stylesheet_serialise(sheet, NULL, &imagelen) == CSS_OK);
+
+	image = malloc(imagelen);
+	assert(image != NULL);
+
+	assert(css_stylesheet_serialise(sheet, image, &imagelen) == CSS_OK);
+
+	css_stylesheet_destroy(sheet);
+
+	/* A truncated image must be rejected */
+	assert(css_stylesheet_create(&params, &sheet) == CSS_OK);
+
+	assert(css_stylesheet_load_serialised(sheet, image,
+			imagelen - 4) == CSS_INVALID);
+
+	css_stylesheet_destroy(sheet);
+
+	assert(css_stylesheet_create(&params, &sheet) == CSS_OK);
+
+	assert(css_stylesheet_load_serialised(sheet, image,
+			imagelen) == CSS_OK);
+
+	free(image);
+
+	buflen = 2 * explen;
+	dump_sheet(sheet, buf, &buflen);
+
+	if (2 * explen - buflen != explen ||
+			(explen > 0 && memcmp(buf, exp, explen) != 0)) {
+		printf("Expected (%u):\n%.*s\n",
+				(int) explen, (int) explen, exp);
+		printf("Result loaded (%u):\n%.*s\n",
+			(int) (2 * explen - buflen),
+			(int) (2 * explen - buflen), buf);
+		assert(0 && "Result doesn't match expected");
+	}
+
+	/* A frozen sheet may not be changed */
+	assert(css_stylesheet_freeze(sheet) == CSS_OK);
+	assert(css_stylesheet_set_disabled(sheet, true) == CSS_INVALID);
+	assert(css_stylesheet_append_data(sheet, data, len) == CSS_INVALID);
+
+	css_stylesheet_destroy(sheet);
+
 	free(buf);
 
 	printf("Test %d: PASS\n", testnum);
 }
 
+static uint32_t count_rules(css_stylesheet *sheet)
+{
+	const css_rule *rule;
+	uint32_t count = 0;
+
+	for (rule = sheet->rule_list; rule != NULL; rule = rule->next)
+		count++;
+
+	return count;
+}
@@ -10,6 +10,10 @@
 #include <libcss/select.h>
 #include <libcss/stylesheet.h>
 
+#include "select/computed.h"
+#include "select/dispatch.h"
+#include "select/hash.h"
+#include "stylesheet.h"
 #include "utils/utils.h"
 
 #include "dump_computed.h"
@@ -68,6 +72,13 @@ typedef struct line_ctx {
 
 	lwc_string *attr_class;
 	lwc_string *attr_id;
+
+	char *buf;		/* Output buffer for subtree selection */
+	size_t *buflen;		/* Space remaining in output buffer */
+	css_compose_ctx *compose;	/* Composition context for callbacks */
+
+	bool check_sharing;	/* Whether sharing counts are expected */
+	css_select_sharing_stats sharing; /* Expected subtree sharing counts */
 } line_ctx;
 
 static css_error node_name(void *pw, void *n, css_qname *qname)
@@ -249,23 +260,17 @@ static css_error node_has_class(void *pw, void *n,
 {
 	node *node = n;
 	uint32_t i;
-	line_ctx *ctx = pw;
+	UNUSED(pw);
 
-	for (i = 0; i < node->n_attrs; i++) {
-		bool amatch = false;
-		assert(lwc_string_caseless_isequal(
-				node->attrs[i].name, ctx->attr_class,
-				&amatch) == lwc_error_ok);
-		if (amatch == true)
+	/* Classes are case-sensitive in HTML */
+	*match = false;
+	for (i = 0; i < node->n_classes; i++) {
+		if (name == node->classes[i]) {
+			*match = true;
 			break;
+		}
 	}
 
-	/* Classes are case-sensitive in HTML */
-	if (i != node->n_attrs && name == node->attrs[i].value)
-		*match = true;
-	else
-		*match = false;
-
 	return CSS_OK;
 }
 
@@ -1152,6 +1157,34 @@ static void css__parse_expected(line_ctx *ctx, const char *data, size_t len)
 	ctx->expused += len;
 }
 
+static void css__parse_sharing(line_ctx *ctx, const char *data, size_t len)
+{
+	const char *p = data;
+	const char *end = data + len;
+	uint64_t *counts[] = {
+		&ctx->sharing.siblings,
+		&ctx->sharing.cousins,
+		&ctx->sharing.second_cousins
+	};
+	size_t i;
+
+	/* [ <siblings> <cousins> <second cousins> ] */
+	for (i = 0; i < N_ELEMENTS(counts); i++) {
+		while (p < end && isspace((unsigned char) *p))
+			p++;
+
+		assert(p < end && '0' <= *p && *p <= '9');
+
+		*counts[i] = 0;
+		while (p < end && '0' <= *p && *p <= '9') {
+			*counts[i] = *counts[i] * 10 + (*p - '0');
+			p++;
+		}
+	}
+
+	ctx->check_sharing = true;
+}
+
 static void css__parse_tree_data(line_ctx *ctx, const char *data, size_t len)
 {
 	const char *p = data;
@@ -1263,13 +1296,17 @@ static void css__parse_tree_data(line_ctx *ctx, const char *data, size_t len)
 				n->attrs[n->n_attrs].name,
 				ctx->attr_class, &amatch) == lwc_error_ok);
 		if (amatch == true) {
-			n->classes = realloc(NULL, sizeof(lwc_string **));
-			assert(n->classes != NULL);
-
-			n->classes[0] = lwc_string_ref(
+			/* Each class attribute adds another class */
+			lwc_string **classes = realloc(n->classes,
+					(n->n_classes + 1) *
+					sizeof(lwc_string *));
+			assert(classes != NULL);
+
+			n->classes = classes;
+			n->classes[n->n_classes] = lwc_string_ref(
 					n->attrs[n->n_attrs].
 					value);
-			n->n_classes = 1;
+			n->n_classes++;
 		}
 
 		n->n_attrs++;
@@ -1319,6 +1356,303 @@ static void run_test_select_tree(css_select_ctx *select,
 	}
 }
 
+static css_error first_child_node(void *pw, void *n, void **child)
+{
+	node *node = n;
+	UNUSED(pw);
+
+	*child = node->children;
+
+	return CSS_OK;
+}
+
+static css_error next_sibling_node(void *pw, void *n, void **sibling)
+{
+	node *node = n;
+	UNUSED(pw);
+
+	*sibling = node->next;
+
+	return CSS_OK;
+}
+
+static css_error node_inline_style(void *pw, void *n,
+		const css_stylesheet **inline_style)
+{
+	UNUSED(pw);
+	UNUSED(n);
+
+	*inline_style = NULL;
+
+	return CSS_OK;
+}
+
+/**
+ * Check a composed style against one composed property by property
+ *
+ * Composition blends most properties a word at a time, as generated from
+ * the property configuration; composing each through the dispatch table
+ * must give the same bits and values.
+ */
+static void check_compose_by_property(const css_computed_style *parent,
+		const css_computed_style *child,
+		const css_computed_style *composed)
+{
+	css_computed_style *style;
+	uint32_t i;
+
+	assert(css__computed_style_create(&style, child->calc) == CSS_OK);
+
+	for (i = 0; i < CSS_N_PROPERTIES; i++) {
+		assert(prop_dispatch[i].compose(parent, child, style) ==
+				CSS_OK);
+	}
+
+	assert(css__compute_absolute_values(parent, style, &unit_ctx) ==
+			CSS_OK);
+
+	if (memcmp(&style->i, &composed->i, sizeof(style->i)) != 0) {
+		for (i = 0; i < N_ELEMENTS(style->i.bits); i++) {
+			if (style->i.bits[i] != composed->i.bits[i]) {
+				printf("bits[%u]: expected %08x, got %08x\n",
+						i, style->i.bits[i],
+						composed->i.bits[i]);
+			}
+		}
+		assert(0 && "Composition doesn't match by property");
+	}
+
+	css_computed_style_destroy(style);
+}
+
+static css_error node_selected(void *pw, void *n,
+		css_select_results *sr)
+{
+	line_ctx *ctx = pw;
+	node *node = n;
+
+	if (node->parent != NULL) {
+		const css_computed_style *parent =
+				node->parent->sr->styles[ctx->pseudo_element];
+		css_computed_style *child = sr->styles[ctx->pseudo_element];
+		css_computed_style *composed, *expected;
+		int i;
+
+		/* Compose through the context first, so that it creates the
+		 * style; it must be the one composing without a context gives */
+		assert(css_computed_style_compose_ctx(ctx->compose, parent,
+				child, &unit_ctx, &composed) == CSS_OK);
+		assert(css_computed_style_compose(parent, child,
+				&unit_ctx, &expected) == CSS_OK);
+		assert(composed == expected);
+		css_computed_style_destroy(composed);
+
+		check_compose_by_property(parent, child, expected);
+
+		/* Again, from the context's cache, and then with the composed
+		 * style as the child, which has nothing left to compose */
+		for (i = 0; i < 3; i++) {
+			assert(css_computed_style_compose_ctx(ctx->compose,
+					parent, (i == 0) ? child : expected,
+					&unit_ctx, &composed) == CSS_OK);
+			assert(composed == expected);
+			css_computed_style_destroy(composed);
+		}
+
+		/* Without a context, the composed style's values are already
+		 * absolute, so need not be computed again */
+		assert(css_computed_style_compose(parent, expected,
+				&unit_ctx, &composed) == CSS_OK);
+		assert(composed == expected);
+		css_computed_style_destroy(composed);
+
+		css_computed_style_destroy(sr->styles[ctx->pseudo_element]);
+		sr->styles[ctx->pseudo_element] = expected;
+	} else {
+		unit_ctx.root_style = NULL;
+	}
+
+	node->sr = sr;
+
+	if (node == ctx->target) {
+		dump_computed_style(sr->styles[ctx->pseudo_element],
+				ctx->buf, ctx->buflen, &unit_ctx);
+	}
+
+	if (node->parent == NULL) {
+		unit_ctx.root_style = node->sr->styles[ctx->pseudo_element];
+	}
+
+	return CSS_OK;
+}
+
+static css_select_subtree_handler subtree_handler = {
+	CSS_SELECT_SUBTREE_HANDLER_VERSION_1,
+
+	first_child_node,
+	next_sibling_node,
+	node_inline_style,
+	node_selected,
+};
+
+static void run_test_select_subtree(css_select_ctx *select,
+		node *root, line_ctx *ctx,
+		char *buf, size_t *buflen)
+{
+	css_select_sharing_stats before, sharing;
+	uint64_t shared;
+
+	ctx->buf = buf;
+	ctx->buflen = buflen;
+
+	assert(css_select_ctx_get_sharing_stats(select, &before) == CSS_OK);
+
+	assert(css_select_style_subtree(select, root, &unit_ctx, &ctx->media,
+			&select_handler, &subtree_handler, ctx) == CSS_OK);
+
+	/* Every node shared with must have been considered */
+	assert(css_select_ctx_get_sharing_stats(select, &sharing) == CSS_OK);
+	sharing.nodes -= before.nodes;
+	sharing.candidates -= before.candidates;
+	sharing.siblings -= before.siblings;
+	sharing.cousins -= before.cousins;
+	sharing.second_cousins -= before.second_cousins;
+
+	shared = sharing.siblings + sharing.cousins + sharing.second_cousins;
+	assert(shared <= sharing.candidates && shared <= sharing.nodes);
+
+	if (ctx->check_sharing) {
+		if (sharing.siblings != ctx->sharing.siblings ||
+				sharing.cousins != ctx->sharing.cousins ||
+				sharing.second_cousins !=
+						ctx->sharing.second_cousins) {
+			printf("Expected sharing: %" PRIu64 " %" PRIu64
+					" %" PRIu64 "\n",
+					ctx->sharing.siblings,
+					ctx->sharing.cousins,
+					ctx->sharing.second_cousins);
+			printf("Result sharing: %" PRIu64 " %" PRIu64
+					" %" PRIu64 "\n",
+					sharing.siblings, sharing.cousins,
+					sharing.second_cousins);
+			assert(0 && "Sharing doesn't match expected");
+		}
+	}
+
+	ctx->buf = NULL;
+	ctx->buflen = NULL;
+}
+
+static void run_test_select_siblings(css_select_ctx *select,
+		node *parent, node *first, line_ctx *ctx,
+		char *buf, size_t *buflen)
+{
+	css_select_results **sr;
+	void **nodes;
+	uint32_t n_nodes = 0, i;
+	node *n;
+
+	for (n = first; n != NULL; n = n->next) {
+		n_nodes++;
+	}
+
+	nodes = malloc(n_nodes * sizeof(*nodes));
+	sr = malloc(n_nodes * sizeof(*sr));
+	assert(nodes != NULL && sr != NULL);
+
+	for (n = first, i = 0; n != NULL; n = n->next, i++) {
+		nodes[i] = n;
+	}
+
+	assert(css_select_style_siblings(select, parent, nodes, NULL, n_nodes,
+			&unit_ctx, &ctx->media, &select_handler, ctx,
+			sr) == CSS_OK);
+
+	ctx->buf = buf;
+	ctx->buflen = buflen;
+
+	for (i = 0; i < n_nodes; i++) {
+		assert(node_selected(ctx, nodes[i], sr[i]) == CSS_OK);
+	}
+
+	ctx->buf = NULL;
+	ctx->buflen = NULL;
+
+	for (n = first; n != NULL; n = n->next) {
+		if (n->children != NULL) {
+			run_test_select_siblings(select, n, n->children,
+					ctx, buf, buflen);
+		}
+	}
+
+	free(nodes);
+	free(sr);
+}
+
+static void run_test_reselect_target(css_select_ctx *select,
+		line_ctx *ctx, char *buf, size_t *buflen)
+{
+	css_select_results *sr;
+	node *target = ctx->target;
+	node *n;
+
+	/* Drop the node data of the target and its ancestors, as a client
+	 * would after modifying the DOM */
+	for (n = target; n != NULL; n = n->parent) {
+		if (n->libcss_node_data != NULL) {
+			assert(css_libcss_node_data_handler(&select_handler,
+					CSS_NODE_MODIFIED, ctx, n, NULL,
+					n->libcss_node_data) == CSS_OK);
+		}
+	}
+
+	if (target->parent == NULL) {
+		unit_ctx.root_style = NULL;
+	}
+
+	assert(css_select_style(select, target, &unit_ctx, &ctx->media, NULL,
+			&select_handler, ctx, &sr) == CSS_OK);
+
+	if (target->parent != NULL) {
+		css_computed_style *composed;
+		assert(css_computed_style_compose(
+				target->parent->sr->styles[ctx->pseudo_element],
+				sr->styles[ctx->pseudo_element],
+				&unit_ctx,
+				&composed) == CSS_OK);
+		css_computed_style_destroy(sr->styles[ctx->pseudo_element]);
+		sr->styles[ctx->pseudo_element] = composed;
+	}
+
+	css_select_results_destroy(target->sr);
+	target->sr = sr;
+
+	if (target->parent == NULL) {
+		unit_ctx.root_style = sr->styles[ctx->pseudo_element];
+	}
+
+	dump_computed_style(sr->styles[ctx->pseudo_element],
+			buf, buflen, &unit_ctx);
+}
+
+static void reset_tree(node *root)
+{
+	node *n;
+
+	for (n = root->children; n != NULL; n = n->next) {
+		reset_tree(n);
+	}
+
+	css_select_results_destroy(root->sr);
+	root->sr = NULL;
+
+	if (root->libcss_node_data != NULL) {
+		css_libcss_node_data_handler(&select_handler, CSS_NODE_DELETED,
+				NULL, root, NULL, root->libcss_node_data);
+		root->libcss_node_data = NULL;
+	}
+}
+
 static void show_differences(size_t len, const char *exp, const char *res)
 {
 	const char *pos_exp, *opos_exp;
@@ -1389,10 +1723,419 @@ static void destroy_tree(node *root)
 	free(root);
 }
 
+static void check_result(line_ctx *ctx, const char *exp, size_t explen,
+		const char *buf, size_t buflen)
+{
+	css_select_results *results;
+
+	results = ctx->target->sr;
+	assert(results->styles[ctx->pseudo_element] != NULL);
+
+	if (8192 - buflen != explen || memcmp(buf, exp, explen) != 0) {
+		size_t len = 8192 - buflen < explen ? 8192 - buflen : explen;
+		printf("Expected (%u):\n%.*s\n",
+				(int) explen, (int) explen, exp);
+		printf("Result (%u):\n%.*s\n", (int) (8192 - buflen),
+			(int) (8192 - buflen), buf);
+
+		show_differences(len, exp, buf);
+		assert(0 && "Result doesn't match expected");
+	}
+}
+
+static void check_class_restyle(css_select_ctx *select, line_ctx *ctx,
+		node *n, uint32_t restyle_target,
+		const char *exp, size_t explen, char *buf)
+{
+	uint32_t i;
+
+	for (i = 0; i < n->n_classes; i++) {
+		lwc_string *class = n->classes[i];
+		uint32_t restyle;
+		size_t buflen = 8192;
+
+		assert(css_select_ctx_get_restyle(select,
+				CSS_SELECT_CHANGE_CLASS, class,
+				&restyle) == CSS_OK);
+		if (restyle & restyle_target)
+			continue;
+
+		/* The target must be unaffected by removing the class */
+		n->classes[i] = n->classes[n->n_classes - 1];
+		n->classes[n->n_classes - 1] = class;
+		n->n_classes--;
+
+		/* Drop the node's data, as a client would after modifying
+		 * it, so that its old style isn't shared */
+		if (n->libcss_node_data != NULL) {
+			assert(css_libcss_node_data_handler(&select_handler,
+					CSS_NODE_MODIFIED, ctx, n, NULL,
+					n->libcss_node_data) == CSS_OK);
+		}
+
+		run_test_reselect_target(select, ctx, buf, &buflen);
+		check_result(ctx, exp, explen, buf, buflen);
+
+		n->n_classes++;
+		n->classes[n->n_classes - 1] = n->classes[i];
+		n->classes[i] = class;
+	}
+}
+
+static void run_test_restyle(css_select_ctx *select, line_ctx *ctx,
+		const char *exp, size_t explen, char *buf)
+{
+	node *n, *s;
+
+	check_class_restyle(select, ctx, ctx->target,
+			CSS_SELECT_RESTYLE_SELF, exp, explen, buf);
+
+	for (n = ctx->target; n != NULL; n = n->parent) {
+		if (n != ctx->target) {
+			check_class_restyle(select, ctx, n,
+					CSS_SELECT_RESTYLE_DESCENDANTS,
+					exp, explen, buf);
+		}
+
+		for (s = n->prev; s != NULL; s = s->prev) {
+			check_class_restyle(select, ctx, s,
+					CSS_SELECT_RESTYLE_SIBLINGS,
+					exp, explen, buf);
+		}
+	}
+}
+
+/** Number of distinct styles selected by the arena test; enough for the
+ * arena's hash table to grow */
+#define ARENA_TEST_STYLES 300
+
+/** Number of styles after which the arena test starts removing some */
+#define ARENA_TEST_GROWN 200
+
+static node *create_arena_test_node(uint32_t index)
+{
+	node *n = calloc(1, sizeof(node));
+	char name[16];
+
+	assert(n != NULL);
+
+	lwc_intern_string("div", SLEN("div"), &n->name);
+
+	n->classes = malloc(sizeof(lwc_string *));
+	assert(n->classes != NULL);
+	snprintf(name, sizeof name, "c%u", index);
+	lwc_intern_string(name, strlen(name), &n->classes[0]);
+	n->n_classes = 1;
+
+	return n;
+}
+
+/**
+ * Intern enough distinct styles to grow the arena's hash table, and look
+ * up and remove styles while its bins are being migrated
+ */
+static void run_test_arena(line_ctx *ctx)
+{
+	node *nodes[ARENA_TEST_STYLES], *n;
+	css_select_arena_stats stats;
+	css_select_ctx *select;
+	css_stylesheet *sheet;
+	css_error error;
+	uint32_t i;
+
+	/* One rule per class, so each node has a distinct style */
+	css__parse_sheet(ctx, "author", SLEN("author"));
+	sheet = ctx->sheets[0].sheet;
+
+	for (i = 0; i < ARENA_TEST_STYLES; i++) {
+		char rule[64];
+
+		snprintf(rule, sizeof rule, ".c%u { z-index: %u; }\n", i, i);
+		error = css_stylesheet_append_data(sheet,
+				(const uint8_t *) rule, strlen(rule));
+		assert(error == CSS_OK || error == CSS_NEEDDATA);
+	}
+	assert(css_stylesheet_data_done(sheet) == CSS_OK);
+
+	assert(css_select_ctx_create(&select) == CSS_OK);
+	assert(css_select_ctx_append_sheet(select, sheet,
+			CSS_ORIGIN_AUTHOR, NULL) == CSS_OK);
+
+	ctx->media.type = CSS_MEDIA_ALL;
+
+	/* Fill the table past its load factor, which starts it growing */
+	for (i = 0; i < ARENA_TEST_GROWN; i++) {
+		nodes[i] = create_arena_test_node(i);
+		assert(css_select_style(select, nodes[i], &unit_ctx,
+				&ctx->media, NULL, &select_handler, ctx,
+				&nodes[i]->sr) == CSS_OK);
+	}
+
+	/* While the old table's bins are still being moved, remove some
+	 * styles, and find others again */
+	for (i = 0; i < 20; i++) {
+		if (i % 2 == 1) {
+			destroy_tree(nodes[i]);
+			nodes[i] = NULL;
+			continue;
+		}
+
+		n = create_arena_test_node(i);
+		assert(css_select_style(select, n, &unit_ctx,
+				&ctx->media, NULL, &select_handler, ctx,
+				&n->sr) == CSS_OK);
+		assert(n->sr->styles[CSS_PSEUDO_ELEMENT_NONE] ==
+				nodes[i]->sr->styles[CSS_PSEUDO_ELEMENT_NONE]);
+		destroy_tree(n);
+	}
+
+	for (i = ARENA_TEST_GROWN; i < ARENA_TEST_STYLES; i++) {
+		nodes[i] = create_arena_test_node(i);
+		assert(css_select_style(select, nodes[i], &unit_ctx,
+				&ctx->media, NULL, &select_handler, ctx,
+				&nodes[i]->sr) == CSS_OK);
+	}
+
+	assert(css_select_ctx_get_arena_stats(select, &stats) == CSS_OK);
+	assert(stats.styles == ARENA_TEST_STYLES - 10);
+	assert(stats.bins == 512);
+	assert(stats.lookups == ARENA_TEST_STYLES + 10);
+	assert(stats.hits == 10);
+	assert(stats.used_bins <= stats.styles);
+	assert(stats.longest_chain >= 1);
+
+	for (i = 0; i < ARENA_TEST_STYLES; i++) {
+		if (nodes[i] != NULL)
+			destroy_tree(nodes[i]);
+	}
+
+	assert(css_select_ctx_get_arena_stats(select, &stats) == CSS_OK);
+	assert(stats.styles == 0 && stats.used_bins == 0);
+
+	css_select_ctx_destroy(select);
+
+	css_stylesheet_destroy(sheet);
+	free(ctx->sheets[0].media);
+	free(ctx->sheets);
+	ctx->sheets = NULL;
+	ctx->n_sheets = 0;
+}
+
+static uint32_t get_restyle(css_select_ctx *select,
+		css_select_change change, const char *name)
+{
+	lwc_string *string;
+	uint32_t restyle;
+
+	lwc_intern_string(name, strlen(name), &string);
+	assert(css_select_ctx_get_restyle(select, change, string,
+			&restyle) == CSS_OK);
+	lwc_string_unref(string);
+
+	return restyle;
+}
+
+/**
+ * Check that attribute selectors on "class" and "id" are found when a
+ * class or the id changes
+ */
+static void run_test_attribute_restyle(line_ctx *ctx)
+{
+	static const char rules[] =
+			"[class~=x] p { z-index: 1; }\n"
+			"[id=y] { z-index: 2; }\n";
+	static const char wild[] = "[class^=a] + p { z-index: 3; }\n";
+	css_select_ctx *select;
+	css_stylesheet *sheet;
+	css_error error;
+
+	css__parse_sheet(ctx, "author", SLEN("author"));
+	sheet = ctx->sheets[0].sheet;
+
+	error = css_stylesheet_append_data(sheet,
+			(const uint8_t *) rules, SLEN(rules));
+	assert(error == CSS_OK || error == CSS_NEEDDATA);
+	assert(css_stylesheet_data_done(sheet) == CSS_OK);
+
+	assert(css_select_ctx_create(&select) == CSS_OK);
+	assert(css_select_ctx_append_sheet(select, sheet,
+			CSS_ORIGIN_AUTHOR, NULL) == CSS_OK);
+
+	assert(get_restyle(select, CSS_SELECT_CHANGE_CLASS, "x") ==
+			CSS_SELECT_RESTYLE_DESCENDANTS);
+	assert(get_restyle(select, CSS_SELECT_CHANGE_ID, "y") ==
+			CSS_SELECT_RESTYLE_SELF);
+	assert(get_restyle(select, CSS_SELECT_CHANGE_ATTRIBUTE, "class") ==
+			CSS_SELECT_RESTYLE_DESCENDANTS);
+
+	/* Other classes and ids are not used by these selectors */
+	assert(get_restyle(select, CSS_SELECT_CHANGE_CLASS, "y") ==
+			CSS_SELECT_RESTYLE_NONE);
+	assert(get_restyle(select, CSS_SELECT_CHANGE_ID, "x") ==
+			CSS_SELECT_RESTYLE_NONE);
+
+	/* A prefix match on the class attribute may be affected by any
+	 * class */
+	css__parse_sheet(ctx, "author", SLEN("author"));
+
+	error = css_stylesheet_append_data(ctx->sheets[1].sheet,
+			(const uint8_t *) wild, SLEN(wild));
+	assert(error == CSS_OK || error == CSS_NEEDDATA);
+	assert(css_stylesheet_data_done(ctx->sheets[1].sheet) == CSS_OK);
+	assert(css_select_ctx_append_sheet(select, ctx->sheets[1].sheet,
+			CSS_ORIGIN_AUTHOR, NULL) == CSS_OK);
+
+	assert(get_restyle(select, CSS_SELECT_CHANGE_CLASS, "y") ==
+			CSS_SELECT_RESTYLE_SIBLINGS);
+	assert(get_restyle(select, CSS_SELECT_CHANGE_ID, "x") ==
+			CSS_SELECT_RESTYLE_NONE);
+
+	css_select_ctx_destroy(select);
+
+	css_stylesheet_destroy(ctx->sheets[0].sheet);
+	css_stylesheet_destroy(ctx->sheets[1].sheet);
+	free(ctx->sheets[0].media);
+	free(ctx->sheets[1].media);
+	free(ctx->sheets);
+	ctx->sheets = NULL;
+	ctx->n_sheets = 0;
+}
+
+/** Number of distinct element, class and id selectors added by the hash
+ * growth test; each appears in two rules, so every table grows several
+ * times */
+#define HASH_TEST_NAMES 1500
+
+static node *create_hash_test_node(line_ctx *ctx, uint32_t index)
+{
+	node *n = calloc(1, sizeof(node));
+	char name[16];
+
+	assert(n != NULL);
+
+	snprintf(name, sizeof name, "e%u", index);
+	lwc_intern_string(name, strlen(name), &n->name);
+
+	n->classes = malloc(sizeof(lwc_string *));
+	assert(n->classes != NULL);
+	snprintf(name, sizeof name, "c%u", index);
+	lwc_intern_string(name, strlen(name), &n->classes[0]);
+	n->n_classes = 1;
+
+	n->attrs = malloc(sizeof(attribute));
+	assert(n->attrs != NULL);
+	n->attrs[0].name = lwc_string_ref(ctx->attr_id);
+	snprintf(name, sizeof name, "i%u", index);
+	lwc_intern_string(name, strlen(name), &n->attrs[0].value);
+	n->n_attrs = 1;
+
+	return n;
+}
+
+/**
+ * Select every node of the hash growth test, and check that each picked
+ * up the value from the expected rule for its element, class and id
+ */
+static void check_hash_test_values(css_select_ctx *select, line_ctx *ctx,
+		uint32_t offset)
+{
+	const css_computed_style *style;
+	int32_t value;
+	uint32_t i;
+	node *n;
+
+	for (i = 0; i < HASH_TEST_NAMES; i++) {
+		n = create_hash_test_node(ctx, i);
+		assert(css_select_style(select, n, &unit_ctx,
+				&ctx->media, NULL, &select_handler, ctx,
+				&n->sr) == CSS_OK);
+		style = n->sr->styles[CSS_PSEUDO_ELEMENT_NONE];
+
+		assert(css_computed_z_index(style, &value) ==
+				CSS_Z_INDEX_SET);
+		assert(FIXTOINT(value) == (int32_t) (i + offset));
+		assert(css_computed_order(style, &value) == CSS_ORDER_SET);
+		assert(value == (int32_t) (i + offset));
+		assert(css_computed_column_count(style, &value) ==
+				CSS_COLUMN_COUNT_SET);
+		assert(FIXTOINT(value) == (int32_t) (i + offset));
+
+		destroy_tree(n);
+	}
+}
+
+/**
+ * Add enough element, class and id selectors to grow the selector hash,
+ * then check that rules still cascade in sheet order, and that selectors
+ * removed after growth no longer match
+ */
+static void run_test_hash_growth(line_ctx *ctx)
+{
+	css_select_ctx *select;
+	css_stylesheet *sheet;
+	size_t initial, grown;
+	css_error error;
+	uint32_t i, pass;
+
+	css__parse_sheet(ctx, "author", SLEN("author"));
+	sheet = ctx->sheets[0].sheet;
+
+	assert(css__selector_hash_size(sheet->selectors, &initial) == CSS_OK);
+
+	/* The second pass has the same specificity as the first, so its
+	 * values only win if the grown chains keep sheet order */
+	for (pass = 0; pass < 2; pass++) {
+		for (i = 0; i < HASH_TEST_NAMES; i++) {
+			char rule[128];
+			uint32_t value = i + 1 + pass;
+
+			snprintf(rule, sizeof rule,
+					"e%u { z-index: %u; }\n"
+					".c%u { order: %u; }\n"
+					"#i%u { column-count: %u; }\n",
+					i, value, i, value, i, value);
+			error = css_stylesheet_append_data(sheet,
+					(const uint8_t *) rule, strlen(rule));
+			assert(error == CSS_OK || error == CSS_NEEDDATA);
+		}
+	}
+	assert(css_stylesheet_data_done(sheet) == CSS_OK);
+
+	assert(css__selector_hash_size(sheet->selectors, &grown) == CSS_OK);
+	assert(grown > initial);
+
+	assert(css_select_ctx_create(&select) == CSS_OK);
+	assert(css_select_ctx_append_sheet(select, sheet,
+			CSS_ORIGIN_AUTHOR, NULL) == CSS_OK);
+
+	ctx->media.type = CSS_MEDIA_ALL;
+
+	check_hash_test_values(select, ctx, 2);
+
+	/* Remove the second pass's rules, which leaves the first pass's
+	 * values to match */
+	for (i = 0; i < 3 * HASH_TEST_NAMES; i++) {
+		css_rule *rule = sheet->last_rule;
+
+		assert(rule != NULL);
+		assert(css__stylesheet_remove_rule(sheet, rule) == CSS_OK);
+		assert(css__stylesheet_rule_destroy(sheet, rule) == CSS_OK);
+	}
+
+	check_hash_test_values(select, ctx, 1);
+
+	css_select_ctx_destroy(select);
+
+	css_stylesheet_destroy(sheet);
+	free(ctx->sheets[0].media);
+	free(ctx->sheets);
+	ctx->sheets = NULL;
+	ctx->n_sheets = 0;
+}
+
 static void run_test(line_ctx *ctx, const char *exp, size_t explen)
 {
 	css_select_ctx *select;
-	css_select_results *results;
 	uint32_t i;
 	char *buf;
 	size_t buflen;
@@ -1407,35 +2150,66 @@ static void run_test(line_ctx *ctx, const char *exp, size_t explen)
 	buflen = 8192;
 
 	assert(css_select_ctx_create(&select) == CSS_OK);
+	assert(css_compose_ctx_create(&ctx->compose) == CSS_OK);
 
 	for (i = 0; i < ctx->n_sheets; i++) {
 		assert(css_select_ctx_append_sheet(select,
 				ctx->sheets[i].sheet, ctx->sheets[i].origin,
 				ctx->sheets[i].media) == CSS_OK);
+
+		/* The context takes no reference, so hold one for as long
+		 * as the sheet is in the context */
+		assert(css_stylesheet_ref(ctx->sheets[i].sheet) == CSS_OK);
 	}
 
 	testnum++;
 
 	run_test_select_tree(select, ctx->tree, ctx, buf, &buflen);
+	check_result(ctx, exp, explen, buf, buflen);
 
-	results = ctx->target->sr;
-	assert(results->styles[ctx->pseudo_element] != NULL);
+	/* Repeat, selecting for the whole tree in one call */
+	reset_tree(ctx->tree);
+	buflen = 8192;
 
-	if (8192 - buflen != explen || memcmp(buf, exp, explen) != 0) {
-		size_t len = 8192 - buflen < explen ? 8192 - buflen : explen;
-		printf("Expected (%u):\n%.*s\n",
-				(int) explen, (int) explen, exp);
-		printf("Result (%u):\n%.*s\n", (int) (8192 - buflen),
-			(int) (8192 - buflen), buf);
+	run_test_select_subtree(select, ctx->tree, ctx, buf, &buflen);
+	check_result(ctx, exp, explen, buf, buflen);
 
-		show_differences(len, exp, buf);
-		assert(0 && "Result doesn't match expected");
-	}
+	/* Repeat, selecting for each run of siblings in one call */
+	reset_tree(ctx->tree);
+	buflen = 8192;
+
+	run_test_select_siblings(select, NULL, ctx->tree, ctx, buf, &buflen);
+	check_result(ctx, exp, explen, buf, buflen);
+
+	/* Repeat, selecting with the context's style index */
+	reset_tree(ctx->tree);
+	buflen = 8192;
+
+	assert(css_select_ctx_enable_index(select, true) == CSS_OK);
+	run_test_select_tree(select, ctx->tree, ctx, buf, &buflen);
+	check_result(ctx, exp, explen, buf, buflen);
+
+	/* Reselect the target after its ancestors' node data is dropped */
+	buflen = 8192;
+
+	run_test_reselect_target(select, ctx, buf, &buflen);
+	check_result(ctx, exp, explen, buf, buflen);
+
+	/* Drop the original references: those held for the context keep
+	 * the sheets alive */
+	for (i = 0; i < ctx->n_sheets; i++)
+		css_stylesheet_destroy(ctx->sheets[i].sheet);
+
+	/* Check classes reported not to affect the target do not */
+	run_test_restyle(select, ctx, exp, explen, buf);
 
-	/* Clean up */
+	/* Clean up; composed styles outlive the selection context */
 	css_select_ctx_destroy(select);
 	destroy_tree(ctx->tree);
+	assert(css_compose_ctx_destroy(ctx->compose) == CSS_OK);
+	ctx->compose = NULL;
 
+	/* Release the references held for the context */
 	for (i = 0; i < ctx->n_sheets; i++) {
 		css_stylesheet_destroy(ctx->sheets[i].sheet);
 		free(ctx->sheets[i].media);
@@ -1448,6 +2222,7 @@ static void run_test(line_ctx *ctx, const char *exp, size_t explen)
 	free(ctx->sheets);
 	ctx->sheets = NULL;
 	ctx->target = NULL;
+	ctx->check_sharing = false;
 
 	free(buf);
 
@@ -1480,6 +2255,9 @@ static bool handle_line(const char *data, size_t datalen, void *pw)
 				assert(css_stylesheet_data_done(
 					ctx->sheets[ctx->n_sheets - 1].sheet)
 					== CSS_OK);
+				assert(css_stylesheet_freeze(
+					ctx->sheets[ctx->n_sheets - 1].sheet)
+					== CSS_OK);
 
 				ctx->intree = false;
 				ctx->insheet = false;
@@ -1491,6 +2269,9 @@ static bool handle_line(const char *data, size_t datalen, void *pw)
 				assert(css_stylesheet_data_done(
 					ctx->sheets[ctx->n_sheets - 1].sheet)
 					== CSS_OK);
+				assert(css_stylesheet_freeze(
+					ctx->sheets[ctx->n_sheets - 1].sheet)
+					== CSS_OK);
 
 				css__parse_sheet(ctx, data + 1, datalen - 1);
 			} else {
@@ -1501,6 +2282,9 @@ static bool handle_line(const char *data, size_t datalen, void *pw)
 				assert(error == CSS_OK ||
 						error == CSS_NEEDDATA);
 			}
+		} else if (ctx->inerrors &&
+				strncasecmp(data+1, "sharing", 7) == 0) {
+			css__parse_sharing(ctx, data + 8, datalen - 8);
 		} else if (ctx->inerrors) {
 			ctx->intree = false;
 			ctx->insheet = false;
@@ -1559,6 +2343,10 @@ int main(int argc, char **argv)
 	lwc_intern_string("class", SLEN("class"), &ctx.attr_class);
 	lwc_intern_string("id", SLEN("id"), &ctx.attr_id);
 
+	run_test_arena(&ctx);
+	run_test_attribute_restyle(&ctx);
+	run_test_hash_growth(&ctx);
+
 	assert(css__parse_testfile(argv[1], handle_line, &ctx) == true);
 
 	/* and run final test */